@@ -59,15 +59,15 @@ list *listCreate(void)
     return list;
 }
 
-/* Free the whole list.
+/* Remove all the elements from the list without destroying the list itself.
  *
  * This function can't fail. */
 /*
- * 释放整个链表，以及链表中所有节点
+ * 释放链表中所有节点，但保留链表结构本身，清空后的链表可以继续使用
  *
  * T = O(N)
  */
-void listRelease(list *list)
+void listEmpty(list *list)
 {
     unsigned long len;
     listNode *current, *next;
@@ -85,7 +85,21 @@ void listRelease(list *list)
         zfree(current);
         current = next;
     }
+    list->head = list->tail = NULL;
+    list->len = 0;
+}
 
+/* Free the whole list.
+ *
+ * This function can't fail. */
+/*
+ * 释放整个链表，以及链表中所有节点
+ *
+ * T = O(N)
+ */
+void listRelease(list *list)
+{
+    listEmpty(list);
     // 释放整个链表结构
     zfree(list);
 }
@@ -538,3 +552,26 @@ void listRotate(list *list) {
     tail->next = list->head;
     list->head = tail;
 }
+
+/* Add all the elements of the list 'o' at the end of the list 'l'.
+ * The list 'o' remains empty but otherwise valid. */
+/*
+ * 把链表 o 的所有节点移动到链表 l 的表尾，之后 o 为空链表。
+ *
+ * T = O(1)
+ */
+void listJoin(list *l, list *o) {
+    if (o->head == NULL) return;
+
+    if (l->tail)
+        l->tail->next = o->head;
+    else
+        l->head = o->head;
+    o->head->prev = l->tail;
+    l->tail = o->tail;
+    l->len += o->len;
+
+    /* Setup other as an empty list. */
+    o->head = o->tail = NULL;
+    o->len = 0;
+}
@@ -80,8 +80,10 @@ aeEventLoop *aeCreateEventLoop(int setsize) {
     // 初始化执行最近一次执行时间
     eventLoop->lastTime = time(NULL);
 
-    // 初始化时间事件结构
-    eventLoop->timeEventHead = NULL;
+    // 初始化时间事件结构，堆数组在第一次添加时间事件时才分配
+    eventLoop->timeEventHeap = NULL;
+    eventLoop->timeEventHeapSize = 0;
+    eventLoop->timeEventHeapCap = 0;
     eventLoop->timeEventNextId = 0;
 
     eventLoop->stop = 0;
@@ -154,7 +156,12 @@ int aeResizeSetSize(aeEventLoop *eventLoop, int setsize) {
  * 删除事件处理器，依次释放events、fired和整个eventLoop
  */
 void aeDeleteEventLoop(aeEventLoop *eventLoop) {
+    int j;
+
     aeApiFree(eventLoop);
+    for (j = 0; j < eventLoop->timeEventHeapSize; j++)
+        zfree(eventLoop->timeEventHeap[j]);
+    zfree(eventLoop->timeEventHeap);
     zfree(eventLoop->events);
     zfree(eventLoop->fired);
     zfree(eventLoop);
@@ -285,6 +292,104 @@ static void aeAddMillisecondsToNow(long long milliseconds, long *sec, long *ms)
     *ms = when_ms;
 }
 
+/* ----------------------------- Time events heap ----------------------------
+ *
+ * Time events are stored in a binary min-heap ordered by fire time, so that
+ * the nearest timer is always at timeEventHeap[0] (O(1) lookup) and both
+ * insertion and removal of a timer are O(log(N)). Every event remembers its
+ * position inside the heap array in te->heap_index, so that it can be moved
+ * or removed without searching for it.
+ *
+ * 时间事件保存在按到达时间排序的最小堆中：
+ * 堆顶就是最近的时间事件，查找为 O(1) ，添加和删除为 O(log(N)) 。
+ * -------------------------------------------------------------------------- */
+
+/* Initial number of slots of the heap array, doubled every time it is full. */
+#define AE_TIME_HEAP_INITIAL_SIZE 16
+
+/*
+ * 比较两个时间事件的到达时间，a 早于 b 时返回非 0 。
+ * 到达时间相同时按 id 比较，保证先创建的事件先执行。
+ */
+static int aeTimeEventBefore(aeTimeEvent *a, aeTimeEvent *b) {
+    if (a->when_sec != b->when_sec) return a->when_sec < b->when_sec;
+    if (a->when_ms != b->when_ms) return a->when_ms < b->when_ms;
+    return a->id < b->id;
+}
+
+/*
+ * 将 te 放到堆数组的 idx 位置，并同步更新 te 记录的下标
+ */
+static void aeTimeHeapSet(aeEventLoop *eventLoop, int idx, aeTimeEvent *te) {
+    eventLoop->timeEventHeap[idx] = te;
+    te->heap_index = idx;
+}
+
+/*
+ * 将 idx 处的事件向上移动，直到父节点不晚于它
+ */
+static void aeTimeHeapSiftUp(aeEventLoop *eventLoop, int idx) {
+    aeTimeEvent **heap = eventLoop->timeEventHeap;
+    aeTimeEvent *te = heap[idx];
+
+    while (idx > 0) {
+        int parent = (idx-1)/2;
+
+        if (!aeTimeEventBefore(te,heap[parent])) break;
+        aeTimeHeapSet(eventLoop,idx,heap[parent]);
+        idx = parent;
+    }
+    aeTimeHeapSet(eventLoop,idx,te);
+}
+
+/*
+ * 将 idx 处的事件向下移动，直到子节点都不早于它
+ */
+static void aeTimeHeapSiftDown(aeEventLoop *eventLoop, int idx) {
+    aeTimeEvent **heap = eventLoop->timeEventHeap;
+    aeTimeEvent *te = heap[idx];
+    int size = eventLoop->timeEventHeapSize;
+
+    while (1) {
+        int child = idx*2+1;
+
+        if (child >= size) break;
+        // 选出两个子节点中较早的那个
+        if (child+1 < size && aeTimeEventBefore(heap[child+1],heap[child]))
+            child++;
+        if (!aeTimeEventBefore(heap[child],te)) break;
+        aeTimeHeapSet(eventLoop,idx,heap[child]);
+        idx = child;
+    }
+    aeTimeHeapSet(eventLoop,idx,te);
+}
+
+/* Restore the heap property for the event at 'idx' after its fire time
+ * was changed in either direction.
+ *
+ * 事件的到达时间被修改之后，调整它在堆中的位置 */
+static void aeTimeHeapFix(aeEventLoop *eventLoop, int idx) {
+    if (idx > 0 && aeTimeEventBefore(eventLoop->timeEventHeap[idx],
+                                     eventLoop->timeEventHeap[(idx-1)/2]))
+        aeTimeHeapSiftUp(eventLoop,idx);
+    else
+        aeTimeHeapSiftDown(eventLoop,idx);
+}
+
+/* Remove the event at position 'idx' from the heap, without freeing it.
+ *
+ * 从堆中移除 idx 位置的事件（不释放事件本身）：
+ * 用堆的最后一个元素填补空位，然后调整它的位置 */
+static void aeTimeHeapRemove(aeEventLoop *eventLoop, int idx) {
+    int last = --eventLoop->timeEventHeapSize;
+
+    if (idx != last) {
+        aeTimeHeapSet(eventLoop,idx,eventLoop->timeEventHeap[last]);
+        aeTimeHeapFix(eventLoop,idx);
+    }
+    eventLoop->timeEventHeap[last] = NULL;
+}
+
 /*
  * 创建时间事件
  */
@@ -298,6 +403,18 @@ long long aeCreateTimeEvent(aeEventLoop *eventLoop, long long milliseconds,
     // 创建时间事件结构
     aeTimeEvent *te;
 
+    // 堆数组已满，容量翻倍
+    if (eventLoop->timeEventHeapSize == eventLoop->timeEventHeapCap) {
+        int cap = eventLoop->timeEventHeapCap ?
+                  eventLoop->timeEventHeapCap*2 : AE_TIME_HEAP_INITIAL_SIZE;
+        aeTimeEvent **heap = zrealloc(eventLoop->timeEventHeap,
+                                      sizeof(aeTimeEvent*)*cap);
+
+        if (heap == NULL) return AE_ERR;
+        eventLoop->timeEventHeap = heap;
+        eventLoop->timeEventHeapCap = cap;
+    }
+
     te = zmalloc(sizeof(*te)); //为时间事件结构分配内存
     if (te == NULL) return AE_ERR;
 
@@ -312,31 +429,31 @@ long long aeCreateTimeEvent(aeEventLoop *eventLoop, long long milliseconds,
     // 设置私有数据
     te->clientData = clientData;
 
-    // 将新的时间事件放入eventLoop中的链表头上
-    te->next = eventLoop->timeEventHead;
-    eventLoop->timeEventHead = te;
+    // 将新的时间事件放到堆的末尾，然后向上调整到正确的位置
+    aeTimeHeapSet(eventLoop,eventLoop->timeEventHeapSize++,te);
+    aeTimeHeapSiftUp(eventLoop,te->heap_index);
 
     return id; //返回时间事件id
 }
 
 /*
  * 删除给定 id 的时间事件
+ *
+ * Finding the event by ID is a linear scan of the heap array: deletions
+ * are rare compared to lookups of the nearest timer, and the array is
+ * compact enough that the scan is cheap. The removal itself is O(log(N)).
  */
 int aeDeleteTimeEvent(aeEventLoop *eventLoop, long long id)
 {
-    aeTimeEvent *te, *prev = NULL; 
+    int j;
+
+    // 在堆数组中查找目标事件
+    for (j = 0; j < eventLoop->timeEventHeapSize; j++) {
+        aeTimeEvent *te = eventLoop->timeEventHeap[j];
 
-    // 遍历时间事件链表
-    te = eventLoop->timeEventHead;
-    while(te) {
-	 //prev记录遍历的前一个节点
         // 发现目标事件，删除
         if (te->id == id) {
-            if (prev == NULL)
-		//说明删除的是链表头，更新表头
-                eventLoop->timeEventHead = te->next;
-            else
-                prev->next = te->next;
+            aeTimeHeapRemove(eventLoop,j);
 
             // 执行清理处理器
             if (te->finalizerProc)
@@ -347,8 +464,6 @@ int aeDeleteTimeEvent(aeEventLoop *eventLoop, long long id)
 
             return AE_OK;
         }
-        prev = te;
-        te = te->next;
     }
 
     return AE_ERR; /* NO event with the specified ID found */
@@ -359,27 +474,13 @@ int aeDeleteTimeEvent(aeEventLoop *eventLoop, long long id)
  * put in sleep without to delay any event.
  * If there are no timers NULL is returned.
  *
- * Note that's O(N) since time events are unsorted.
- * Possible optimizations (not needed by Redis so far, but...):
- * 1) Insert the event in order, so that the nearest is just the head.
- *    Much better but still insertion or deletion of timers is O(N).
- * 2) Use a skiplist to have this operation as O(1) and insertion as O(log(N)).
+ * Since time events are kept in a min-heap this is O(1).
  */
-// 寻找里目前时间最近的时间事件, 因为链表是乱序的，所以查找复杂度为 O（N）
+// 寻找里目前时间最近的时间事件，也就是堆顶元素，复杂度为 O(1)
 static aeTimeEvent *aeSearchNearestTimer(aeEventLoop *eventLoop)
 {
-    aeTimeEvent *te = eventLoop->timeEventHead;
-    aeTimeEvent *nearest = NULL;
-
-    while(te) {
-	//如果nearest是空 或 nearest时间小于te，那么更新nearest为te
-        if (!nearest || te->when_sec < nearest->when_sec ||
-                (te->when_sec == nearest->when_sec &&
-                 te->when_ms < nearest->when_ms))
-            nearest = te;
-        te = te->next;
-    }
-    return nearest;
+    if (eventLoop->timeEventHeapSize == 0) return NULL;
+    return eventLoop->timeEventHeap[0];
 }
 
 /* Process time events
@@ -401,70 +502,56 @@ static int processTimeEvents(aeEventLoop *eventLoop) {
      * indefinitely, and practice suggests it is. */
     // 通过重置事件的运行时间，防止因时间穿插（skew）而造成的事件处理混乱
     if (now < eventLoop->lastTime) {
-        te = eventLoop->timeEventHead;
-        while(te) {
+        int j;
+
+        // 所有事件的到达时间都被清零，此时按 id 排序，需要重新建堆
+        for (j = 0; j < eventLoop->timeEventHeapSize; j++) {
+            te = eventLoop->timeEventHeap[j];
             te->when_sec = 0;
-            te = te->next;
+            te->when_ms = 0;
         }
+        for (j = eventLoop->timeEventHeapSize/2-1; j >= 0; j--)
+            aeTimeHeapSiftDown(eventLoop,j);
     }
     // 更新最后一次处理时间事件的时间
     eventLoop->lastTime = now;
 
-    // 遍历链表，执行那些已经到达的事件
-    te = eventLoop->timeEventHead;
+    // 不断取出堆顶，执行那些已经到达的事件
     maxId = eventLoop->timeEventNextId-1; //timeEventNextId是下个可用的时间事件id，获取当前最大时间事件id
-    while(te) {
+    while((te = aeSearchNearestTimer(eventLoop)) != NULL) {
         long now_sec, now_ms;
         long long id;
+        int retval;
+
+        /* Events registered by the handlers we are running are not
+         * processed in this call, in order to don't loop forever. Since
+         * the heap breaks ties by ID, if such an event is at the top every
+         * other event is due later and will be handled at the next
+         * iteration, so we can stop here. */
+        // 堆顶是本次处理过程中新创建的事件，留到下次再处理
+        if (te->id > maxId) break;
 
-        // 如果id大于最大时间事件id，那么说明这个时间事件是在当前遍历链表时产生的，那么跳过这个时间事件
-        if (te->id > maxId) {
-            te = te->next;
-            continue;
-        }
-        
         // 获取当前时间
         aeGetTime(&now_sec, &now_ms);
 
-        // 如果当前时间等于或大于事件的执行时间，那么说明事件已到达，执行这个事件
-        if (now_sec > te->when_sec ||
-            (now_sec == te->when_sec && now_ms >= te->when_ms))
-        {
-            int retval;
-
-            id = te->id;
-            // 执行事件处理器，并获取返回值
-            retval = te->timeProc(eventLoop, id, te->clientData);
-            processed++;
-            /* After an event is processed our time event list may
-             * no longer be the same, so we restart from head.
-             * Still we make sure to don't process events registered
-             * by event handlers itself in order to don't loop forever.
-             * To do so we saved the max ID we want to handle.
-             *
-             * FUTURE OPTIMIZATIONS:
-             * Note that this is NOT great algorithmically. Redis uses
-             * a single time event so it's not a problem but the right
-             * way to do this is to add the new elements on head, and
-             * to flag deleted elements in a special way for later
-             * deletion (putting references to the nodes to delete into
-             * another linked list). */
-	    //todo：这里有点没理解？新加入的时间事件难道不仅仅是当前执行是的时间事件内添加的吗？因为如果仅仅是当前时间事件内添加的，
-	    //那么这个新的时间事件肯定加在链表头，它的id是会大于maxId，感觉不需要再从链表头遍历了？？？
-
-            // 记录是否有需要循环执行这个事件时间
-            if (retval != AE_NOMORE) {
-                // 是的， retval 毫秒之后继续执行这个时间事件
-                aeAddMillisecondsToNow(retval,&te->when_sec,&te->when_ms);
-            } else {
-                // 不，将这个事件删除
-                aeDeleteTimeEvent(eventLoop, id);
-            }
-
-            // 因为执行事件之后，事件列表可能已经被改变了。因此需要将 te 放回表头，继续开始执行事件
-            te = eventLoop->timeEventHead;
+        // 堆顶事件还未到达，那么其他事件也都未到达
+        if (now_sec < te->when_sec ||
+            (now_sec == te->when_sec && now_ms < te->when_ms)) break;
+
+        id = te->id;
+        // 执行事件处理器，并获取返回值
+        retval = te->timeProc(eventLoop, id, te->clientData);
+        processed++;
+
+        // 记录是否有需要循环执行这个事件时间
+        if (retval != AE_NOMORE) {
+            // 是的， retval 毫秒之后继续执行这个时间事件，并调整它在堆中的位置。
+            // 处理器可能修改了堆，所以使用事件自己记录的下标
+            aeAddMillisecondsToNow(retval,&te->when_sec,&te->when_ms);
+            aeTimeHeapFix(eventLoop,te->heap_index);
         } else {
-            te = te->next;
+            // 不，将这个事件删除
+            aeDeleteTimeEvent(eventLoop, id);
         }
     }
     return processed;
@@ -650,3 +737,130 @@ char *aeGetApiName(void) {
 void aeSetBeforeSleepProc(aeEventLoop *eventLoop, aeBeforeSleepProc *beforesleep) {
     eventLoop->beforesleep = beforesleep;
 }
+
+#ifdef AE_TEST_MAIN
+/* Time events micro benchmark and heap checks. Build with:
+ *
+ *   cc -DAE_TEST_MAIN -o ae-test ae.c zmalloc.c
+ *
+ * 时间事件的性能测试：注册大量时间事件，测量创建、查找最近事件、
+ * 触发以及删除的耗时，并检查触发顺序、重新调度以及在处理器中删除事件。 */
+#include <assert.h>
+
+#define AE_TEST_TIMERS 10000
+
+static long long usec(void) {
+    struct timeval tv;
+    gettimeofday(&tv,NULL);
+    return (((long long)tv.tv_sec)*1000000)+tv.tv_usec;
+}
+
+static int fired;
+static long last_sec, last_ms;
+
+/* The timer being fired is the heap top, and timers fire in order of
+ * their scheduled time. */
+static int testTimeProc(aeEventLoop *eventLoop, long long id, void *clientData) {
+    aeTimeEvent *te = aeSearchNearestTimer(eventLoop);
+    AE_NOTUSED(clientData);
+    assert(te->id == id);
+    assert(te->when_sec > last_sec ||
+           (te->when_sec == last_sec && te->when_ms >= last_ms));
+    last_sec = te->when_sec;
+    last_ms = te->when_ms;
+    fired++;
+    return AE_NOMORE;
+}
+
+static int repeats;
+
+/* Rescheduled 10 times, every 10 milliseconds. */
+static int testRepeatProc(aeEventLoop *eventLoop, long long id, void *clientData) {
+    AE_NOTUSED(eventLoop);
+    AE_NOTUSED(id);
+    AE_NOTUSED(clientData);
+    return ++repeats < 10 ? 10 : AE_NOMORE;
+}
+
+/* Deletes the timer whose id is passed as client data. */
+static int testDeleteProc(aeEventLoop *eventLoop, long long id, void *clientData) {
+    AE_NOTUSED(id);
+    assert(aeDeleteTimeEvent(eventLoop,*(long long*)clientData) == AE_OK);
+    return AE_NOMORE;
+}
+
+static int testFailProc(aeEventLoop *eventLoop, long long id, void *clientData) {
+    AE_NOTUSED(eventLoop);
+    AE_NOTUSED(id);
+    AE_NOTUSED(clientData);
+    assert(NULL == "deleted timer fired");
+    return AE_NOMORE;
+}
+
+/* Check that every node is not earlier than its parent and that the
+ * stored heap indexes are in sync with the array. */
+static void checkHeap(aeEventLoop *eventLoop) {
+    int j;
+
+    for (j = 0; j < eventLoop->timeEventHeapSize; j++) {
+        aeTimeEvent *te = eventLoop->timeEventHeap[j];
+        assert(te->heap_index == j);
+        if (j > 0)
+            assert(!aeTimeEventBefore(te,eventLoop->timeEventHeap[(j-1)/2]));
+    }
+}
+
+int main(void) {
+    aeEventLoop *el = aeCreateEventLoop(64);
+    long long ids[AE_TEST_TIMERS], start;
+    int j, deleted = 0;
+
+    srand(time(NULL));
+
+    start = usec();
+    for (j = 0; j < AE_TEST_TIMERS; j++)
+        ids[j] = aeCreateTimeEvent(el,rand()%1000,testTimeProc,NULL,NULL);
+    printf("Create %d timers: %lld usec\n", AE_TEST_TIMERS, usec()-start);
+    checkHeap(el);
+
+    start = usec();
+    for (j = 0; j < 1000000; j++)
+        assert(aeSearchNearestTimer(el) != NULL);
+    printf("1000000 nearest timer lookups: %lld usec\n", usec()-start);
+
+    start = usec();
+    for (j = 0; j < AE_TEST_TIMERS; j += 10) {
+        assert(aeDeleteTimeEvent(el,ids[j]) == AE_OK);
+        deleted++;
+    }
+    printf("Delete %d timers: %lld usec\n", deleted, usec()-start);
+    checkHeap(el);
+    assert(aeDeleteTimeEvent(el,ids[0]) == AE_ERR);
+
+    start = usec();
+    while (el->timeEventHeapSize)
+        aeProcessEvents(el,AE_TIME_EVENTS);
+    printf("Fire %d timers: %lld usec (including waiting ~1 sec)\n",
+        fired, usec()-start);
+    assert(fired == AE_TEST_TIMERS-deleted);
+
+    /* A rescheduled timer goes back to its place in the heap, and a
+     * timer deleted by the handler of another one never fires. */
+    ids[0] = aeCreateTimeEvent(el,50,testFailProc,NULL,NULL);
+    aeCreateTimeEvent(el,5,testDeleteProc,&ids[0],NULL);
+    aeCreateTimeEvent(el,0,testRepeatProc,NULL,NULL);
+    for (j = 0; j < 100; j++)
+        aeCreateTimeEvent(el,rand()%200,testTimeProc,NULL,NULL);
+    last_sec = last_ms = 0;
+    while (el->timeEventHeapSize) {
+        aeProcessEvents(el,AE_TIME_EVENTS);
+        checkHeap(el);
+    }
+    assert(repeats == 10);
+    assert(fired == AE_TEST_TIMERS-deleted+100);
+    printf("Reschedule and delete from handlers: ok\n");
+
+    aeDeleteEventLoop(el);
+    return 0;
+}
+#endif
@@ -125,8 +125,8 @@ typedef struct aeTimeEvent {
     // 多路复用库的私有数据
     void *clientData;
 
-    // 指向下个时间事件结构，形成链表
-    struct aeTimeEvent *next;
+    // 事件在最小堆数组中的下标，堆中元素移动时同步更新
+    int heap_index; /* position inside eventLoop->timeEventHeap */
 
 } aeTimeEvent;
 
@@ -164,8 +164,12 @@ typedef struct aeEventLoop {
     // 已就绪的文件事件，数组，每个数据成员包含fd和就绪的mask
     aeFiredEvent *fired; /* Fired events */
 
-    // 时间事件链表。新的时间事件加入会放入链表头部
-    aeTimeEvent *timeEventHead;
+    // 时间事件最小堆，按到达时间排序，堆顶就是最近要执行的时间事件
+    aeTimeEvent **timeEventHeap; /* Binary min-heap ordered by fire time */
+
+    // 堆中已有的时间事件数量，以及堆数组的容量
+    int timeEventHeapSize;
+    int timeEventHeapCap;
 
     // 事件处理器的开关，1表示停止事件处理器
     int stop;
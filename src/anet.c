@@ -241,6 +241,25 @@ static int anetSetReuseAddr(char *err, int fd) {
     return ANET_OK;
 }
 
+/* Allow several sockets to bind the same address and port, so that the
+ * kernel spreads incoming connections across their accept queues. */
+// 设置 SO_REUSEPORT ，多个监听套接字可以绑定同一个地址和端口，
+// 内核把新连接分散到各个套接字的 accept 队列中
+static int anetSetReusePort(char *err, int fd) {
+#ifdef SO_REUSEPORT
+    int yes = 1;
+    if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &yes, sizeof(yes)) == -1) {
+        anetSetError(err, "setsockopt SO_REUSEPORT: %s", strerror(errno));
+        return ANET_ERR;
+    }
+    return ANET_OK;
+#else
+    (void) fd;
+    anetSetError(err, "SO_REUSEPORT is not supported on this platform");
+    return ANET_ERR;
+#endif
+}
+
 /*
  * 创建并返回 socket
  */
@@ -435,13 +454,29 @@ int anetWrite(int fd, char *buf, int count)
 /*
  * 绑定并创建监听套接字
  */
-static int anetListen(char *err, int s, struct sockaddr *sa, socklen_t len, int backlog) {
+/* How _anetTcpServer() uses SO_REUSEPORT. */
+#define ANET_REUSEPORT_NONE 0   /* Not used. */
+#define ANET_REUSEPORT_FIRST 1  /* Set after bind: the port must be free. */
+#define ANET_REUSEPORT_JOIN 2   /* Set before bind: join the first socket. */
+
+static int anetListen(char *err, int s, struct sockaddr *sa, socklen_t len, int backlog, int reuseport) {
     if (bind(s,sa,len) == -1) {
         anetSetError(err, "bind: %s", strerror(errno));
         close(s);
         return ANET_ERR;
     }
 
+    /* The first socket of a SO_REUSEPORT group is bound without the option,
+     * so the bind fails if any other socket, of this or another process,
+     * already holds the address. The option is set before listen(), that
+     * is when the socket enters the group the next sockets join. */
+    // 第一个套接字在 bind 成功之后才设置 SO_REUSEPORT ，
+    // 这样端口已被其他套接字占用时 bind 会失败
+    if (reuseport == ANET_REUSEPORT_FIRST && anetSetReusePort(err,s) == ANET_ERR) {
+        close(s);
+        return ANET_ERR;
+    }
+
     if (listen(s, backlog) == -1) {
         anetSetError(err, "listen: %s", strerror(errno));
         close(s);
@@ -460,7 +495,7 @@ static int anetV6Only(char *err, int s) {
     return ANET_OK;
 }
 
-static int _anetTcpServer(char *err, int port, char *bindaddr, int af, int backlog)
+static int _anetTcpServer(char *err, int port, char *bindaddr, int af, int backlog, int reuseport)
 {
     int s, rv;
     char _port[6];  /* strlen("65535") */
@@ -482,7 +517,9 @@ static int _anetTcpServer(char *err, int port, char *bindaddr, int af, int backl
 
         if (af == AF_INET6 && anetV6Only(err,s) == ANET_ERR) goto error;
         if (anetSetReuseAddr(err,s) == ANET_ERR) goto error;
-        if (anetListen(err,s,p->ai_addr,p->ai_addrlen,backlog) == ANET_ERR) goto error;
+        if (reuseport == ANET_REUSEPORT_JOIN &&
+            anetSetReusePort(err,s) == ANET_ERR) goto error;
+        if (anetListen(err,s,p->ai_addr,p->ai_addrlen,backlog,reuseport) == ANET_ERR) goto error;
         goto end;
     }
     if (p == NULL) {
@@ -499,12 +536,30 @@ end:
 
 int anetTcpServer(char *err, int port, char *bindaddr, int backlog)
 {
-    return _anetTcpServer(err, port, bindaddr, AF_INET, backlog);
+    return _anetTcpServer(err, port, bindaddr, AF_INET, backlog, ANET_REUSEPORT_NONE);
 }
 
 int anetTcp6Server(char *err, int port, char *bindaddr, int backlog)
 {
-    return _anetTcpServer(err, port, bindaddr, AF_INET6, backlog);
+    return _anetTcpServer(err, port, bindaddr, AF_INET6, backlog, ANET_REUSEPORT_NONE);
+}
+
+/* Like anetTcpServer() / anetTcp6Server() but the socket is created with
+ * SO_REUSEPORT, so that more sockets can listen on the same address.
+ * With 'join' set to 0 the socket is the first one of the group and the
+ * call fails if the address is already bound by any socket. With 'join'
+ * set to 1 the socket is added to the group of an existing socket. */
+// 创建设置了 SO_REUSEPORT 的监听套接字，join 为 0 时创建第一个套接字
+int anetTcpReusePortServer(char *err, int port, char *bindaddr, int backlog, int join)
+{
+    return _anetTcpServer(err, port, bindaddr, AF_INET, backlog,
+        join ? ANET_REUSEPORT_JOIN : ANET_REUSEPORT_FIRST);
+}
+
+int anetTcp6ReusePortServer(char *err, int port, char *bindaddr, int backlog, int join)
+{
+    return _anetTcpServer(err, port, bindaddr, AF_INET6, backlog,
+        join ? ANET_REUSEPORT_JOIN : ANET_REUSEPORT_FIRST);
 }
 
 /*
@@ -521,7 +576,7 @@ int anetUnixServer(char *err, char *path, mode_t perm, int backlog)
     memset(&sa,0,sizeof(sa));
     sa.sun_family = AF_LOCAL;
     strncpy(sa.sun_path,path,sizeof(sa.sun_path)-1);
-    if (anetListen(err,s,(struct sockaddr*)&sa,sizeof(sa),backlog) == ANET_ERR)
+    if (anetListen(err,s,(struct sockaddr*)&sa,sizeof(sa),backlog,ANET_REUSEPORT_NONE) == ANET_ERR)
         return ANET_ERR;
     if (perm)
         chmod(sa.sun_path, perm);
@@ -714,6 +714,9 @@ struct redisClient *createFakeClient(void) {
     c->name = NULL;
     c->querybuf = sdsempty();
     c->querybuf_peak = 0;
+    c->read_error = REDIS_READ_ERR_NONE;
+    c->read_errno = 0;
+    respScannerInit(&c->respscan);
     c->argc = 0;
     c->argv = NULL;
     c->bufpos = 0;
@@ -1024,6 +1027,32 @@ int rewriteListObject(rio *r, robj *key, robj *o) {
             if (++count == REDIS_AOF_REWRITE_ITEMS_PER_CMD) count = 0;
             items--;
         }
+    } else if (o->encoding == REDIS_ENCODING_QUICKLIST) {
+        //和ziplist很相似，依次迭代每个节点的ziplist
+        quicklistIter *iter = quicklistGetIterator(o->ptr,QUICKLIST_START_HEAD);
+        quicklistEntry entry;
+
+        while(quicklistNext(iter,&entry)) {
+            if (count == 0) {
+                int cmd_items = (items > REDIS_AOF_REWRITE_ITEMS_PER_CMD) ?
+                    REDIS_AOF_REWRITE_ITEMS_PER_CMD : items;
+
+                if (rioWriteBulkCount(r,'*',2+cmd_items) == 0 ||
+                    rioWriteBulkString(r,"RPUSH",5) == 0 ||
+                    rioWriteBulkObject(r,key) == 0) break;
+            }
+            if (entry.value) {
+                if (rioWriteBulkString(r,(char*)entry.value,entry.sz) == 0)
+                    break;
+            } else {
+                if (rioWriteBulkLongLong(r,entry.longval) == 0) break;
+            }
+            if (++count == REDIS_AOF_REWRITE_ITEMS_PER_CMD) count = 0;
+            items--;
+        }
+        quicklistReleaseIterator(iter);
+        // 写入出错时还有没写入的元素
+        if (items != 0) return 0;
     } else {
         redisPanic("Unknown list encoding");
     }
@@ -1459,6 +1488,11 @@ int rewriteAppendOnlyFileBackground(void) {
         // 关闭网络连接 fd
         closeListeningSockets(0);
 
+        /* The child has no bio threads: release retired tables in
+         * place if a lookup completes a rehashing. */
+        // 子进程没有后台线程，rehash 完成时直接释放退役的表
+        dictSetTableFreeHook(NULL);
+
         // 为进程设置名字，方便记认
         redisSetProcTitle("redis-aof-rewrite");
 
@@ -103,12 +103,6 @@ struct bio_job {
 
 void *bioProcessBackgroundJobs(void *arg);
 
-/* Make sure we have enough stack to perform all the things we do in the
- * main thread. 
- * 子线程栈大小
- */
-#define REDIS_THREAD_STACK_SIZE (1024*1024*4) //4M
-
 /* Initialize the background system, spawning the thread. 
  * 初始化后台任务系统，生成线程
  */
@@ -228,6 +222,17 @@ void *bioProcessBackgroundJobs(void *arg) {
             //刷新缓存到磁盘文件
             aof_fsync((long)job->arg1);
 
+        } else if (type == REDIS_BIO_FREE_TABLE) {
+            //释放退役的哈希表
+            dictFreeTableMemory(job->arg1,(unsigned long)job->arg2);
+        } else if (type == REDIS_BIO_LAZY_FREE) {
+            //释放对象，或者被清空数据库的 dict 和 expires 字典，或者过期索引
+            if (job->arg1)
+                lazyfreeFreeObjectFromBioThread(job->arg1);
+            else if (job->arg3)
+                lazyfreeFreeDatabaseFromBioThread(job->arg2,job->arg3);
+            else
+                lazyfreeFreeExpireIndexFromBioThread(job->arg2);
         } else {
             redisPanic("Wrong job type in bioProcessBackgroundJobs().");
         }
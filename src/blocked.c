@@ -119,8 +119,11 @@ void processUnblockedClients(void) {
         c->flags &= ~REDIS_UNBLOCKED;
         c->btype = REDIS_BLOCKED_NONE;
 
-        /* Process remaining data in the input buffer. */
-        if (c->querybuf && sdslen(c->querybuf) > 0) {
+        /* Process remaining data in the input buffer, or the command
+         * already parsed by an I/O thread. */
+        if ((c->querybuf && sdslen(c->querybuf) > 0) ||
+            (c->flags & REDIS_PENDING_COMMAND))
+        {
             server.current_client = c;
             processInputBuffer(c);
             server.current_client = NULL;
@@ -514,7 +514,7 @@ void clusterInit(void) {
 
     //开始监听.让server.cfd[16]中每个fd都监听在这个端口上
     if (listenToPort(server.port+REDIS_CLUSTER_PORT_INCR,
-        server.cfd,&server.cfd_count) == REDIS_ERR)
+        server.cfd,&server.cfd_count,1) == REDIS_ERR)
     {
         exit(1);
     } else {
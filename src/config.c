@@ -139,6 +139,13 @@ void loadServerConfigFromString(char *config) {
             if (server.tcp_backlog < 0) {
                 err = "Invalid backlog value"; goto loaderr;
             }
+        } else if (!strcasecmp(argv[0],"tcp-listeners") && argc == 2) {
+            server.tcp_listeners = atoi(argv[1]);
+            if (server.tcp_listeners < 1 ||
+                server.tcp_listeners > REDIS_TCP_LISTENERS_MAX)
+            {
+                err = "Invalid number of TCP listeners"; goto loaderr;
+            }
         } else if (!strcasecmp(argv[0],"bind") && argc >= 2) {
             int j, addresses = argc-1;
 
@@ -224,6 +231,15 @@ void loadServerConfigFromString(char *config) {
             if (server.dbnum < 1) {
                 err = "Invalid number of databases"; goto loaderr;
             }
+        } else if (!strcasecmp(argv[0],"keyspace-layout") && argc == 2) {
+            if (!strcasecmp(argv[1],"chained")) {
+                server.keyspace_layout = DICT_LAYOUT_CHAINED;
+            } else if (!strcasecmp(argv[1],"open-addressing")) {
+                server.keyspace_layout = DICT_LAYOUT_OPEN;
+            } else {
+                err = "Invalid keyspace layout, must be chained or open-addressing";
+                goto loaderr;
+            }
         } else if (!strcasecmp(argv[0],"include") && argc == 2) {
             loadServerConfig(argv[1],NULL);
         } else if (!strcasecmp(argv[0],"maxclients") && argc == 2) {
@@ -242,6 +258,10 @@ void loadServerConfigFromString(char *config) {
                 server.maxmemory_policy = REDIS_MAXMEMORY_VOLATILE_TTL;
             } else if (!strcasecmp(argv[1],"allkeys-lru")) {
                 server.maxmemory_policy = REDIS_MAXMEMORY_ALLKEYS_LRU;
+            } else if (!strcasecmp(argv[1],"volatile-lfu")) {
+                server.maxmemory_policy = REDIS_MAXMEMORY_VOLATILE_LFU;
+            } else if (!strcasecmp(argv[1],"allkeys-lfu")) {
+                server.maxmemory_policy = REDIS_MAXMEMORY_ALLKEYS_LFU;
             } else if (!strcasecmp(argv[1],"allkeys-random")) {
                 server.maxmemory_policy = REDIS_MAXMEMORY_ALLKEYS_RANDOM;
             } else if (!strcasecmp(argv[1],"noeviction")) {
@@ -256,6 +276,96 @@ void loadServerConfigFromString(char *config) {
                 err = "maxmemory-samples must be 1 or greater";
                 goto loaderr;
             }
+        } else if (!strcasecmp(argv[0],"lfu-log-factor") && argc == 2) {
+            server.lfu_log_factor = atoi(argv[1]);
+            if (server.lfu_log_factor < 0) {
+                err = "lfu-log-factor must be 0 or greater";
+                goto loaderr;
+            }
+        } else if (!strcasecmp(argv[0],"lfu-decay-time") && argc == 2) {
+            server.lfu_decay_time = atoi(argv[1]);
+            if (server.lfu_decay_time < 0) {
+                err = "lfu-decay-time must be 0 or greater";
+                goto loaderr;
+            }
+        } else if (!strcasecmp(argv[0],"maxmemory-eviction-pool-size") &&
+                   argc == 2)
+        {
+            server.maxmemory_eviction_pool_size = atoi(argv[1]);
+            if (server.maxmemory_eviction_pool_size <= 0) {
+                err = "maxmemory-eviction-pool-size must be 1 or greater";
+                goto loaderr;
+            }
+        } else if (!strcasecmp(argv[0],"maxmemory-precision-samples") &&
+                   argc == 2)
+        {
+            server.maxmemory_precision_samples = atoi(argv[1]);
+            if (server.maxmemory_precision_samples < 0) {
+                err = "maxmemory-precision-samples must be 0 or greater";
+                goto loaderr;
+            }
+        } else if (!strcasecmp(argv[0],"maxmemory-background-eviction") &&
+                   argc == 2)
+        {
+            if ((server.maxmemory_background_eviction =
+                 yesnotoi(argv[1])) == -1)
+            {
+                err = "argument must be 'yes' or 'no'"; goto loaderr;
+            }
+        } else if (!strcasecmp(argv[0],"maxmemory-hard-limit-perc") &&
+                   argc == 2)
+        {
+            server.maxmemory_hard_limit_perc = atoi(argv[1]);
+            if (server.maxmemory_hard_limit_perc < 0) {
+                err = "maxmemory-hard-limit-perc must be 0 or greater";
+                goto loaderr;
+            }
+        } else if (!strcasecmp(argv[0],"maxmemory-eviction-budget") &&
+                   argc == 2)
+        {
+            server.maxmemory_eviction_budget = strtoll(argv[1],NULL,10);
+            if (server.maxmemory_eviction_budget <= 0) {
+                err = "maxmemory-eviction-budget must be 1 or greater";
+                goto loaderr;
+            }
+        } else if (!strcasecmp(argv[0],"active-expire-effort") && argc == 2) {
+            server.active_expire_effort = atoi(argv[1]);
+            if (server.active_expire_effort < 1 ||
+                server.active_expire_effort > ACTIVE_EXPIRE_EFFORT_MAX)
+            {
+                err = "active-expire-effort must be between 1 and 10";
+                goto loaderr;
+            }
+        } else if (!strcasecmp(argv[0],"active-expire-pressure-perc") &&
+                   argc == 2)
+        {
+            server.active_expire_pressure_perc = atoi(argv[1]);
+            if (server.active_expire_pressure_perc < 0 ||
+                server.active_expire_pressure_perc > 100)
+            {
+                err = "active-expire-pressure-perc must be between 0 and 100";
+                goto loaderr;
+            }
+        } else if (!strcasecmp(argv[0],"active-expire-index") && argc == 2) {
+            if ((server.active_expire_index = yesnotoi(argv[1])) == -1) {
+                err = "argument must be 'yes' or 'no'"; goto loaderr;
+            }
+        } else if (!strcasecmp(argv[0],"lazyfree-lazy-eviction") &&
+                   argc == 2)
+        {
+            if ((server.lazyfree_lazy_eviction = yesnotoi(argv[1])) == -1) {
+                err = "argument must be 'yes' or 'no'"; goto loaderr;
+            }
+        } else if (!strcasecmp(argv[0],"lazyfree-lazy-expire") && argc == 2) {
+            if ((server.lazyfree_lazy_expire = yesnotoi(argv[1])) == -1) {
+                err = "argument must be 'yes' or 'no'"; goto loaderr;
+            }
+        } else if (!strcasecmp(argv[0],"lazyfree-lazy-server-del") &&
+                   argc == 2)
+        {
+            if ((server.lazyfree_lazy_server_del = yesnotoi(argv[1])) == -1) {
+                err = "argument must be 'yes' or 'no'"; goto loaderr;
+            }
         } else if (!strcasecmp(argv[0],"slaveof") && argc == 3) {
             slaveof_linenum = linenum;
             server.masterhost = sdsnew(argv[1]);
@@ -312,6 +422,13 @@ void loadServerConfigFromString(char *config) {
             if ((server.activerehashing = yesnotoi(argv[1])) == -1) {
                 err = "argument must be 'yes' or 'no'"; goto loaderr;
             }
+        } else if (!strcasecmp(argv[0],"active-rehashing-budget") &&
+                   argc == 2)
+        {
+            server.active_rehashing_budget = strtoll(argv[1],NULL,10);
+            if (server.active_rehashing_budget < 1) {
+                err = "Invalid active rehashing budget"; goto loaderr;
+            }
         } else if (!strcasecmp(argv[0],"daemonize") && argc == 2) {
             if ((server.daemonize = yesnotoi(argv[1])) == -1) {
                 err = "argument must be 'yes' or 'no'"; goto loaderr;
@@ -320,6 +437,18 @@ void loadServerConfigFromString(char *config) {
             server.hz = atoi(argv[1]);
             if (server.hz < REDIS_MIN_HZ) server.hz = REDIS_MIN_HZ;
             if (server.hz > REDIS_MAX_HZ) server.hz = REDIS_MAX_HZ;
+        } else if (!strcasecmp(argv[0],"io-threads") && argc == 2) {
+            server.io_threads_num = atoi(argv[1]);
+            if (server.io_threads_num < 1 ||
+                server.io_threads_num > REDIS_IO_THREADS_MAX_NUM)
+            {
+                err = "Invalid number of I/O threads"; goto loaderr;
+            }
+        } else if (!strcasecmp(argv[0],"client-pool-size") && argc == 2) {
+            server.client_pool_size = atoi(argv[1]);
+            if (server.client_pool_size < 0) {
+                err = "Invalid client pool size"; goto loaderr;
+            }
         } else if (!strcasecmp(argv[0],"appendonly") && argc == 2) {
             int yes;
 
@@ -392,6 +521,14 @@ void loadServerConfigFromString(char *config) {
             server.list_max_ziplist_entries = memtoll(argv[1], NULL);
         } else if (!strcasecmp(argv[0],"list-max-ziplist-value") && argc == 2) {
             server.list_max_ziplist_value = memtoll(argv[1], NULL);
+        } else if (!strcasecmp(argv[0],"list-quicklist-fill") && argc == 2) {
+            server.list_quicklist_fill = atoi(argv[1]);
+            if (server.list_quicklist_fill < QUICKLIST_MIN_FILL ||
+                server.list_quicklist_fill > QUICKLIST_MAX_FILL)
+            {
+                err = "list-quicklist-fill must be between -5 and 32767";
+                goto loaderr;
+            }
         } else if (!strcasecmp(argv[0],"set-max-intset-entries") && argc == 2) {
             server.set_max_intset_entries = memtoll(argv[1], NULL);
         } else if (!strcasecmp(argv[0],"zset-max-ziplist-entries") && argc == 2) {
@@ -664,6 +801,10 @@ void configSetCommand(redisClient *c) {
             server.maxmemory_policy = REDIS_MAXMEMORY_VOLATILE_TTL;
         } else if (!strcasecmp(o->ptr,"allkeys-lru")) {
             server.maxmemory_policy = REDIS_MAXMEMORY_ALLKEYS_LRU;
+        } else if (!strcasecmp(o->ptr,"volatile-lfu")) {
+            server.maxmemory_policy = REDIS_MAXMEMORY_VOLATILE_LFU;
+        } else if (!strcasecmp(o->ptr,"allkeys-lfu")) {
+            server.maxmemory_policy = REDIS_MAXMEMORY_ALLKEYS_LFU;
         } else if (!strcasecmp(o->ptr,"allkeys-random")) {
             server.maxmemory_policy = REDIS_MAXMEMORY_ALLKEYS_RANDOM;
         } else if (!strcasecmp(o->ptr,"noeviction")) {
@@ -675,6 +816,58 @@ void configSetCommand(redisClient *c) {
         if (getLongLongFromObject(o,&ll) == REDIS_ERR ||
             ll <= 0) goto badfmt;
         server.maxmemory_samples = ll;
+    } else if (!strcasecmp(c->argv[2]->ptr,"lfu-log-factor")) {
+        if (getLongLongFromObject(o,&ll) == REDIS_ERR ||
+            ll < 0 || ll > INT_MAX) goto badfmt;
+        server.lfu_log_factor = ll;
+    } else if (!strcasecmp(c->argv[2]->ptr,"lfu-decay-time")) {
+        if (getLongLongFromObject(o,&ll) == REDIS_ERR ||
+            ll < 0 || ll > INT_MAX) goto badfmt;
+        server.lfu_decay_time = ll;
+    } else if (!strcasecmp(c->argv[2]->ptr,"maxmemory-eviction-pool-size")) {
+        if (getLongLongFromObject(o,&ll) == REDIS_ERR ||
+            ll <= 0 || ll > INT_MAX) goto badfmt;
+        if (ll != server.maxmemory_eviction_pool_size) evictionPoolResize(ll);
+    } else if (!strcasecmp(c->argv[2]->ptr,"maxmemory-precision-samples")) {
+        if (getLongLongFromObject(o,&ll) == REDIS_ERR ||
+            ll < 0 || ll > INT_MAX) goto badfmt;
+        server.maxmemory_precision_samples = ll;
+    } else if (!strcasecmp(c->argv[2]->ptr,"active-expire-effort")) {
+        if (getLongLongFromObject(o,&ll) == REDIS_ERR ||
+            ll < 1 || ll > ACTIVE_EXPIRE_EFFORT_MAX) goto badfmt;
+        server.active_expire_effort = ll;
+    } else if (!strcasecmp(c->argv[2]->ptr,"active-expire-pressure-perc")) {
+        if (getLongLongFromObject(o,&ll) == REDIS_ERR ||
+            ll < 0 || ll > 100) goto badfmt;
+        server.active_expire_pressure_perc = ll;
+    } else if (!strcasecmp(c->argv[2]->ptr,"maxmemory-background-eviction")) {
+        int yn = yesnotoi(o->ptr);
+
+        if (yn == -1) goto badfmt;
+        server.maxmemory_background_eviction = yn;
+    } else if (!strcasecmp(c->argv[2]->ptr,"maxmemory-hard-limit-perc")) {
+        if (getLongLongFromObject(o,&ll) == REDIS_ERR ||
+            ll < 0 || ll > INT_MAX) goto badfmt;
+        server.maxmemory_hard_limit_perc = ll;
+    } else if (!strcasecmp(c->argv[2]->ptr,"maxmemory-eviction-budget")) {
+        if (getLongLongFromObject(o,&ll) == REDIS_ERR ||
+            ll <= 0) goto badfmt;
+        server.maxmemory_eviction_budget = ll;
+    } else if (!strcasecmp(c->argv[2]->ptr,"lazyfree-lazy-eviction")) {
+        int yn = yesnotoi(o->ptr);
+
+        if (yn == -1) goto badfmt;
+        server.lazyfree_lazy_eviction = yn;
+    } else if (!strcasecmp(c->argv[2]->ptr,"lazyfree-lazy-expire")) {
+        int yn = yesnotoi(o->ptr);
+
+        if (yn == -1) goto badfmt;
+        server.lazyfree_lazy_expire = yn;
+    } else if (!strcasecmp(c->argv[2]->ptr,"lazyfree-lazy-server-del")) {
+        int yn = yesnotoi(o->ptr);
+
+        if (yn == -1) goto badfmt;
+        server.lazyfree_lazy_server_del = yn;
     } else if (!strcasecmp(c->argv[2]->ptr,"timeout")) {
         if (getLongLongFromObject(o,&ll) == REDIS_ERR ||
             ll < 0 || ll > LONG_MAX) goto badfmt;
@@ -683,6 +876,18 @@ void configSetCommand(redisClient *c) {
         if (getLongLongFromObject(o,&ll) == REDIS_ERR ||
             ll < 0 || ll > INT_MAX) goto badfmt;
         server.tcpkeepalive = ll;
+    } else if (!strcasecmp(c->argv[2]->ptr,"activerehashing")) {
+        int yn = yesnotoi(o->ptr);
+
+        if (yn == -1) goto badfmt;
+        server.activerehashing = yn;
+    } else if (!strcasecmp(c->argv[2]->ptr,"active-rehashing-budget")) {
+        if (getLongLongFromObject(o,&ll) == REDIS_ERR || ll < 1) goto badfmt;
+        server.active_rehashing_budget = ll;
+    } else if (!strcasecmp(c->argv[2]->ptr,"client-pool-size")) {
+        if (getLongLongFromObject(o,&ll) == REDIS_ERR ||
+            ll < 0 || ll > INT_MAX) goto badfmt;
+        clientPoolResize(ll);
     } else if (!strcasecmp(c->argv[2]->ptr,"appendfsync")) {
         if (!strcasecmp(o->ptr,"no")) {
             server.aof_fsync = AOF_FSYNC_NO;
@@ -783,6 +988,10 @@ void configSetCommand(redisClient *c) {
     } else if (!strcasecmp(c->argv[2]->ptr,"list-max-ziplist-value")) {
         if (getLongLongFromObject(o,&ll) == REDIS_ERR || ll < 0) goto badfmt;
         server.list_max_ziplist_value = ll;
+    } else if (!strcasecmp(c->argv[2]->ptr,"list-quicklist-fill")) {
+        if (getLongLongFromObject(o,&ll) == REDIS_ERR ||
+            ll < QUICKLIST_MIN_FILL || ll > QUICKLIST_MAX_FILL) goto badfmt;
+        server.list_quicklist_fill = ll;
     } else if (!strcasecmp(c->argv[2]->ptr,"set-max-intset-entries")) {
         if (getLongLongFromObject(o,&ll) == REDIS_ERR || ll < 0) goto badfmt;
         server.set_max_intset_entries = ll;
@@ -984,6 +1193,20 @@ void configGetCommand(redisClient *c) {
     /* Numerical values */
     config_get_numerical_field("maxmemory",server.maxmemory);
     config_get_numerical_field("maxmemory-samples",server.maxmemory_samples);
+    config_get_numerical_field("lfu-log-factor",server.lfu_log_factor);
+    config_get_numerical_field("lfu-decay-time",server.lfu_decay_time);
+    config_get_numerical_field("maxmemory-eviction-pool-size",
+            server.maxmemory_eviction_pool_size);
+    config_get_numerical_field("maxmemory-precision-samples",
+            server.maxmemory_precision_samples);
+    config_get_numerical_field("active-expire-effort",
+            server.active_expire_effort);
+    config_get_numerical_field("active-expire-pressure-perc",
+            server.active_expire_pressure_perc);
+    config_get_numerical_field("maxmemory-hard-limit-perc",
+            server.maxmemory_hard_limit_perc);
+    config_get_numerical_field("maxmemory-eviction-budget",
+            server.maxmemory_eviction_budget);
     config_get_numerical_field("timeout",server.maxidletime);
     config_get_numerical_field("tcp-keepalive",server.tcpkeepalive);
     config_get_numerical_field("auto-aof-rewrite-percentage",
@@ -998,6 +1221,8 @@ void configGetCommand(redisClient *c) {
             server.list_max_ziplist_entries);
     config_get_numerical_field("list-max-ziplist-value",
             server.list_max_ziplist_value);
+    config_get_numerical_field("list-quicklist-fill",
+            server.list_quicklist_fill);
     config_get_numerical_field("set-max-intset-entries",
             server.set_max_intset_entries);
     config_get_numerical_field("zset-max-ziplist-entries",
@@ -1013,6 +1238,7 @@ void configGetCommand(redisClient *c) {
             server.slowlog_max_len);
     config_get_numerical_field("port",server.port);
     config_get_numerical_field("tcp-backlog",server.tcp_backlog);
+    config_get_numerical_field("tcp-listeners",server.tcp_listeners);
     config_get_numerical_field("databases",server.dbnum);
     config_get_numerical_field("repl-ping-slave-period",server.repl_ping_slave_period);
     config_get_numerical_field("repl-timeout",server.repl_timeout);
@@ -1024,6 +1250,10 @@ void configGetCommand(redisClient *c) {
     config_get_numerical_field("min-slaves-to-write",server.repl_min_slaves_to_write);
     config_get_numerical_field("min-slaves-max-lag",server.repl_min_slaves_max_lag);
     config_get_numerical_field("hz",server.hz);
+    config_get_numerical_field("io-threads",server.io_threads_num);
+    config_get_numerical_field("client-pool-size",server.client_pool_size);
+    config_get_numerical_field("active-rehashing-budget",
+            server.active_rehashing_budget);
     config_get_numerical_field("cluster-node-timeout",server.cluster_node_timeout);
     config_get_numerical_field("cluster-migration-barrier",server.cluster_migration_barrier);
 
@@ -1040,6 +1270,16 @@ void configGetCommand(redisClient *c) {
     config_get_bool_field("rdbcompression", server.rdb_compression);
     config_get_bool_field("rdbchecksum", server.rdb_checksum);
     config_get_bool_field("activerehashing", server.activerehashing);
+    config_get_bool_field("active-expire-index",
+            server.active_expire_index);
+    config_get_bool_field("maxmemory-background-eviction",
+            server.maxmemory_background_eviction);
+    config_get_bool_field("lazyfree-lazy-eviction",
+            server.lazyfree_lazy_eviction);
+    config_get_bool_field("lazyfree-lazy-expire",
+            server.lazyfree_lazy_expire);
+    config_get_bool_field("lazyfree-lazy-server-del",
+            server.lazyfree_lazy_server_del);
     config_get_bool_field("repl-disable-tcp-nodelay",
             server.repl_disable_tcp_nodelay);
     config_get_bool_field("aof-rewrite-incremental-fsync",
@@ -1070,6 +1310,8 @@ void configGetCommand(redisClient *c) {
         case REDIS_MAXMEMORY_VOLATILE_TTL: s = "volatile-ttl"; break;
         case REDIS_MAXMEMORY_VOLATILE_RANDOM: s = "volatile-random"; break;
         case REDIS_MAXMEMORY_ALLKEYS_LRU: s = "allkeys-lru"; break;
+        case REDIS_MAXMEMORY_VOLATILE_LFU: s = "volatile-lfu"; break;
+        case REDIS_MAXMEMORY_ALLKEYS_LFU: s = "allkeys-lfu"; break;
         case REDIS_MAXMEMORY_ALLKEYS_RANDOM: s = "allkeys-random"; break;
         case REDIS_MAXMEMORY_NO_EVICTION: s = "noeviction"; break;
         default: s = "unknown"; break; /* too harmless to panic */
@@ -1078,6 +1320,12 @@ void configGetCommand(redisClient *c) {
         addReplyBulkCString(c,s);
         matches++;
     }
+    if (stringmatch(pattern,"keyspace-layout",0)) {
+        addReplyBulkCString(c,"keyspace-layout");
+        addReplyBulkCString(c,server.keyspace_layout == DICT_LAYOUT_OPEN ?
+            "open-addressing" : "chained");
+        matches++;
+    }
     if (stringmatch(pattern,"appendfsync",0)) {
         char *policy;
 
@@ -1734,6 +1982,7 @@ int rewriteConfig(char *path) {
     rewriteConfigStringOption(state,"pidfile",server.pidfile,REDIS_DEFAULT_PID_FILE);
     rewriteConfigNumericalOption(state,"port",server.port,REDIS_SERVERPORT);
     rewriteConfigNumericalOption(state,"tcp-backlog",server.tcp_backlog,REDIS_TCP_BACKLOG);
+    rewriteConfigNumericalOption(state,"tcp-listeners",server.tcp_listeners,REDIS_DEFAULT_TCP_LISTENERS);
     rewriteConfigBindOption(state);
     rewriteConfigStringOption(state,"unixsocket",server.unixsocket,NULL);
     rewriteConfigOctalOption(state,"unixsocketperm",server.unixsocketperm,REDIS_DEFAULT_UNIX_SOCKET_PERM);
@@ -1751,6 +2000,10 @@ int rewriteConfig(char *path) {
     rewriteConfigSyslogfacilityOption(state);
     rewriteConfigSaveOption(state);
     rewriteConfigNumericalOption(state,"databases",server.dbnum,REDIS_DEFAULT_DBNUM);
+    rewriteConfigEnumOption(state,"keyspace-layout",server.keyspace_layout,
+        "chained", DICT_LAYOUT_CHAINED,
+        "open-addressing", DICT_LAYOUT_OPEN,
+        NULL, REDIS_DEFAULT_KEYSPACE_LAYOUT);
     rewriteConfigYesNoOption(state,"stop-writes-on-bgsave-error",server.stop_writes_on_bgsave_err,REDIS_DEFAULT_STOP_WRITES_ON_BGSAVE_ERROR);
     rewriteConfigYesNoOption(state,"rdbcompression",server.rdb_compression,REDIS_DEFAULT_RDB_COMPRESSION);
     rewriteConfigYesNoOption(state,"rdbchecksum",server.rdb_checksum,REDIS_DEFAULT_RDB_CHECKSUM);
@@ -1774,12 +2027,27 @@ int rewriteConfig(char *path) {
     rewriteConfigEnumOption(state,"maxmemory-policy",server.maxmemory_policy,
         "volatile-lru", REDIS_MAXMEMORY_VOLATILE_LRU,
         "allkeys-lru", REDIS_MAXMEMORY_ALLKEYS_LRU,
+        "volatile-lfu", REDIS_MAXMEMORY_VOLATILE_LFU,
+        "allkeys-lfu", REDIS_MAXMEMORY_ALLKEYS_LFU,
         "volatile-random", REDIS_MAXMEMORY_VOLATILE_RANDOM,
         "allkeys-random", REDIS_MAXMEMORY_ALLKEYS_RANDOM,
         "volatile-ttl", REDIS_MAXMEMORY_VOLATILE_TTL,
         "noeviction", REDIS_MAXMEMORY_NO_EVICTION,
         NULL, REDIS_DEFAULT_MAXMEMORY_POLICY);
     rewriteConfigNumericalOption(state,"maxmemory-samples",server.maxmemory_samples,REDIS_DEFAULT_MAXMEMORY_SAMPLES);
+    rewriteConfigNumericalOption(state,"lfu-log-factor",server.lfu_log_factor,REDIS_DEFAULT_LFU_LOG_FACTOR);
+    rewriteConfigNumericalOption(state,"lfu-decay-time",server.lfu_decay_time,REDIS_DEFAULT_LFU_DECAY_TIME);
+    rewriteConfigNumericalOption(state,"maxmemory-eviction-pool-size",server.maxmemory_eviction_pool_size,REDIS_DEFAULT_MAXMEMORY_EVICTION_POOL_SIZE);
+    rewriteConfigNumericalOption(state,"maxmemory-precision-samples",server.maxmemory_precision_samples,REDIS_DEFAULT_MAXMEMORY_PRECISION_SAMPLES);
+    rewriteConfigYesNoOption(state,"maxmemory-background-eviction",server.maxmemory_background_eviction,REDIS_DEFAULT_MAXMEMORY_BACKGROUND_EVICTION);
+    rewriteConfigNumericalOption(state,"maxmemory-hard-limit-perc",server.maxmemory_hard_limit_perc,REDIS_DEFAULT_MAXMEMORY_HARD_LIMIT_PERC);
+    rewriteConfigNumericalOption(state,"maxmemory-eviction-budget",server.maxmemory_eviction_budget,REDIS_DEFAULT_MAXMEMORY_EVICTION_BUDGET);
+    rewriteConfigNumericalOption(state,"active-expire-effort",server.active_expire_effort,REDIS_DEFAULT_ACTIVE_EXPIRE_EFFORT);
+    rewriteConfigNumericalOption(state,"active-expire-pressure-perc",server.active_expire_pressure_perc,REDIS_DEFAULT_ACTIVE_EXPIRE_PRESSURE_PERC);
+    rewriteConfigYesNoOption(state,"active-expire-index",server.active_expire_index,REDIS_DEFAULT_ACTIVE_EXPIRE_INDEX);
+    rewriteConfigYesNoOption(state,"lazyfree-lazy-eviction",server.lazyfree_lazy_eviction,REDIS_DEFAULT_LAZYFREE_LAZY_EVICTION);
+    rewriteConfigYesNoOption(state,"lazyfree-lazy-expire",server.lazyfree_lazy_expire,REDIS_DEFAULT_LAZYFREE_LAZY_EXPIRE);
+    rewriteConfigYesNoOption(state,"lazyfree-lazy-server-del",server.lazyfree_lazy_server_del,REDIS_DEFAULT_LAZYFREE_LAZY_SERVER_DEL);
     rewriteConfigYesNoOption(state,"appendonly",server.aof_state != REDIS_AOF_OFF,0);
     rewriteConfigStringOption(state,"appendfilename",server.aof_filename,REDIS_DEFAULT_AOF_FILENAME);
     rewriteConfigEnumOption(state,"appendfsync",server.aof_fsync,
@@ -1802,13 +2070,17 @@ int rewriteConfig(char *path) {
     rewriteConfigNumericalOption(state,"hash-max-ziplist-value",server.hash_max_ziplist_value,REDIS_HASH_MAX_ZIPLIST_VALUE);
     rewriteConfigNumericalOption(state,"list-max-ziplist-entries",server.list_max_ziplist_entries,REDIS_LIST_MAX_ZIPLIST_ENTRIES);
     rewriteConfigNumericalOption(state,"list-max-ziplist-value",server.list_max_ziplist_value,REDIS_LIST_MAX_ZIPLIST_VALUE);
+    rewriteConfigNumericalOption(state,"list-quicklist-fill",server.list_quicklist_fill,REDIS_LIST_QUICKLIST_FILL);
     rewriteConfigNumericalOption(state,"set-max-intset-entries",server.set_max_intset_entries,REDIS_SET_MAX_INTSET_ENTRIES);
     rewriteConfigNumericalOption(state,"zset-max-ziplist-entries",server.zset_max_ziplist_entries,REDIS_ZSET_MAX_ZIPLIST_ENTRIES);
     rewriteConfigNumericalOption(state,"zset-max-ziplist-value",server.zset_max_ziplist_value,REDIS_ZSET_MAX_ZIPLIST_VALUE);
     rewriteConfigNumericalOption(state,"hll-sparse-max-bytes",server.hll_sparse_max_bytes,REDIS_DEFAULT_HLL_SPARSE_MAX_BYTES);
     rewriteConfigYesNoOption(state,"activerehashing",server.activerehashing,REDIS_DEFAULT_ACTIVE_REHASHING);
+    rewriteConfigNumericalOption(state,"active-rehashing-budget",server.active_rehashing_budget,REDIS_DEFAULT_ACTIVE_REHASHING_BUDGET);
     rewriteConfigClientoutputbufferlimitOption(state);
     rewriteConfigNumericalOption(state,"hz",server.hz,REDIS_DEFAULT_HZ);
+    rewriteConfigNumericalOption(state,"io-threads",server.io_threads_num,REDIS_DEFAULT_IO_THREADS);
+    rewriteConfigNumericalOption(state,"client-pool-size",server.client_pool_size,REDIS_DEFAULT_CLIENT_POOL_SIZE);
     rewriteConfigYesNoOption(state,"aof-rewrite-incremental-fsync",server.aof_rewrite_incremental_fsync,REDIS_DEFAULT_AOF_REWRITE_INCREMENTAL_FSYNC);
     if (server.sentinel_mode) rewriteConfigSentinelOption(state);
 
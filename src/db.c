@@ -37,35 +37,62 @@ void slotToKeyAdd(robj *key);
 void slotToKeyDel(robj *key);
 void slotToKeyFlush(void);
 
+static long long getExpireWithHash(redisDb *db, robj *key, unsigned int h);
+static int expireIfNeededWithHash(redisDb *db, robj *key, unsigned int h);
+static int dbDeleteWithHash(redisDb *db, robj *key, unsigned int h,
+                            int async);
+
+/* db->dict and db->expires hash keys with the same function, so a key is
+ * hashed once and the value passed to the *WithHash() variants below,
+ * instead of hashing it again for every lookup of an operation (expire
+ * check, lookup, overwrite, expire removal...).
+ *
+ * 键空间和过期字典使用相同的哈希函数，一个操作中键只计算一次哈希值
+ */
+static unsigned int dbKeyHash(redisDb *db, robj *key) {
+    return dictGetHash(db->dict,key->ptr);
+}
+
 /*-----------------------------------------------------------------------------
  * C-level DB API
  *----------------------------------------------------------------------------*/
 
+/*
+ * 取出键空间节点 de 的值，并更新值的访问时间（LFU 策略下更新访问频率）
+ */
+static robj *lookupKeyEntry(dictEntry *de) {
+    // 取出值
+    robj *val = dictGetVal(de);
+
+    /* Update the access time (or the access counter with the LFU
+     * policies) for the ageing algorithm.
+     * Don't do it if we have a saving child, as this will trigger
+     * a copy on write madness. */
+    // 更新时间信息（只在不存在子进程时执行，防止破坏 copy-on-write 机制）
+    if (server.rdb_child_pid == -1 && server.aof_child_pid == -1) {
+        if (REDIS_MAXMEMORY_POLICY_LFU(server.maxmemory_policy))
+            updateLFU(val);
+        else
+            val->lru = LRU_CLOCK();
+    }
+
+    // 返回值
+    return val;
+}
+
 /*
  * 从数据库 db 中取出键 key 的值（对象）。如果 key 的值存在，那么返回该值；否则，返回 NULL 。
  */
-robj *lookupKey(redisDb *db, robj *key) {
+static robj *lookupKeyWithHash(redisDb *db, robj *key, unsigned int h) {
     // 查找键空间
-    dictEntry *de = dictFind(db->dict,key->ptr);
-
-    // 节点存在
-    if (de) {
-        // 取出值
-        robj *val = dictGetVal(de);
-
-        /* Update the access time for the ageing algorithm.
-         * Don't do it if we have a saving child, as this will trigger
-         * a copy on write madness. */
-        // 更新时间信息（只在不存在子进程时执行，防止破坏 copy-on-write 机制）
-        if (server.rdb_child_pid == -1 && server.aof_child_pid == -1)
-            val->lru = LRU_CLOCK();
+    dictEntry *de = dictFindWithHash(db->dict,key->ptr,h);
 
-        // 返回值
-        return val;
-    } else {
-        // 节点不存在返回NULL
-        return NULL;
-    }
+    // 节点存在返回值，不存在返回NULL
+    return de ? lookupKeyEntry(de) : NULL;
+}
+
+robj *lookupKey(redisDb *db, robj *key) {
+    return lookupKeyWithHash(db,key,dbKeyHash(db,key));
 }
 
 /*
@@ -74,13 +101,14 @@ robj *lookupKey(redisDb *db, robj *key) {
  * 找到时返回值对象，没找到返回 NULL 。
  */
 robj *lookupKeyRead(redisDb *db, robj *key) {
+    unsigned int h = dbKeyHash(db,key);
     robj *val;
 
     // 检查 key 释放已经过期
-    expireIfNeeded(db,key);
+    expireIfNeededWithHash(db,key,h);
 
     // 从数据库中取出键的值对象
-    val = lookupKey(db,key);
+    val = lookupKeyWithHash(db,key,h);
 
     // 更新命中/不命中信息
     if (val == NULL)
@@ -92,16 +120,86 @@ robj *lookupKeyRead(redisDb *db, robj *key) {
     return val;
 }
 
+/* Like calling lookupKeyRead() on keys[0..count-1], storing the values in
+ * 'vals', but the keys are looked up DICT_FIND_BATCH at a time with
+ * dictFindBatch(), so their cache misses overlap.
+ *
+ * 批量版本的 lookupKeyRead() ，查找结果保存在 vals 中
+ */
+void lookupKeysRead(redisDb *db, robj **keys, int count, robj **vals) {
+    void *names[DICT_FIND_BATCH];
+    dictEntry *des[DICT_FIND_BATCH];
+    int i, j, n;
+
+    for (i = 0; i < count; i += n) {
+        n = count-i < DICT_FIND_BATCH ? count-i : DICT_FIND_BATCH;
+        for (j = 0; j < n; j++) names[j] = keys[i+j]->ptr;
+
+        /* Expired keys are deleted before collecting the entries, as
+         * deleting invalidates them. The batch on db->expires only
+         * warms the cache for expireIfNeeded(). */
+        // 先删除过期键，再批量查找键空间
+        if (dictSize(db->expires)) dictFindBatch(db->expires,names,des,n);
+        for (j = 0; j < n; j++) expireIfNeeded(db,keys[i+j]);
+
+        dictFindBatch(db->dict,names,des,n);
+        for (j = 0; j < n; j++)
+            if (des[j]) dictPrefetch(dictGetVal(des[j]));
+
+        // 取出值并更新命中/不命中信息
+        for (j = 0; j < n; j++) {
+            if (des[j]) {
+                vals[i+j] = lookupKeyEntry(des[j]);
+                server.stat_keyspace_hits++;
+            } else {
+                vals[i+j] = NULL;
+                server.stat_keyspace_misses++;
+            }
+        }
+    }
+}
+
+/* Bring into the CPU cache the entries, keys and values of 'count' keys,
+ * found at keys[0], keys[step], keys[2*step], ... using batched lookups.
+ * Commands call it before handling the keys one by one with the usual
+ * functions, that then find everything already cached.
+ *
+ * 使用批量查找把 count 个键的节点、键和值预取到 CPU 缓存中
+ */
+void dbPrefetchKeys(redisDb *db, robj **keys, int count, int step) {
+    void *names[DICT_FIND_BATCH];
+    dictEntry *des[DICT_FIND_BATCH];
+    int i, j, n;
+
+    /* A single lookup has nothing to overlap with. */
+    if (count < 2) return;
+    server.stat_prefetched_keys += count;
+
+    for (i = 0; i < count; i += n) {
+        n = count-i < DICT_FIND_BATCH ? count-i : DICT_FIND_BATCH;
+        for (j = 0; j < n; j++) names[j] = keys[(i+j)*step]->ptr;
+
+        if (dictSize(db->expires)) dictFindBatch(db->expires,names,des,n);
+        dictFindBatch(db->dict,names,des,n);
+        for (j = 0; j < n; j++)
+            if (des[j]) dictPrefetch(dictGetVal(des[j]));
+    }
+}
+
 /*
  * 为执行写入操作而取出键 key 在数据库 db 中的值。 和 lookupKeyRead 不同，这个函数不会更新服务器的命中/不命中信息。
  * 找到时返回值对象，没找到返回 NULL 。
  */
-robj *lookupKeyWrite(redisDb *db, robj *key) {
+static robj *lookupKeyWriteWithHash(redisDb *db, robj *key, unsigned int h) {
     // 删除过期键
-    expireIfNeeded(db,key);
+    expireIfNeededWithHash(db,key,h);
 
     // 查找并返回 key 的值对象
-    return lookupKey(db,key);
+    return lookupKeyWithHash(db,key,h);
+}
+
+robj *lookupKeyWrite(redisDb *db, robj *key) {
+    return lookupKeyWriteWithHash(db,key,dbKeyHash(db,key));
 }
 
 /*
@@ -139,19 +237,22 @@ robj *lookupKeyWriteOrReply(redisClient *c, robj *key, robj *reply) {
  * The program is aborted if the key already exists. 
  * 程序在键已经存在时会停止。
  */
-void dbAdd(redisDb *db, robj *key, robj *val) {
-    // 复制键名到sdshdr
-    sds copy = sdsdup(key->ptr);
-
-    // 尝试添加键值对，如果键已存在那么retval=DICT_ERR
-    int retval = dictAdd(db->dict, copy, val);
+static void dbAddWithHash(redisDb *db, robj *key, robj *val, unsigned int h) {
+    // 尝试添加键，如果键已存在那么返回NULL
+    // 键名由字典自己复制（嵌入节点或者 sdsdup ）
+    dictEntry *de = dictAddRawWithHash(db->dict,key->ptr,h);
 
     // 如果键已经存在，那么直接挂进程
-    redisAssertWithInfo(NULL,key,retval == REDIS_OK);
+    redisAssertWithInfo(NULL,key,de != NULL);
+    dictSetVal(db->dict,de,val);
 
     // 如果开启了集群模式，那么将键保存到槽里面
     if (server.cluster_enabled) slotToKeyAdd(key);
- }
+}
+
+void dbAdd(redisDb *db, robj *key, robj *val) {
+    dbAddWithHash(db,key,val,dbKeyHash(db,key));
+}
 
 /* Overwrite an existing key with a new value. Incrementing the reference
  * count of the new value is up to the caller.
@@ -162,14 +263,40 @@ void dbAdd(redisDb *db, robj *key, robj *val) {
  * 如果键不存在，那么函数停止。
  */
 //更新键对应的值对象
-void dbOverwrite(redisDb *db, robj *key, robj *val) {
-    dictEntry *de = dictFind(db->dict,key->ptr); //找到字典中的entry
-    
+static void dbOverwriteWithHash(redisDb *db, robj *key, robj *val,
+                                unsigned int h)
+{
+    dictEntry *de = dictFindWithHash(db->dict,key->ptr,h); //找到字典中的entry
+    dictEntry auxentry;
+
     // 节点必须存在，否则中止进程
     redisAssertWithInfo(NULL,key,de != NULL);
 
-    // 覆写旧值，替换val
-    dictReplace(db->dict, key->ptr, val);
+    // 覆写旧值，替换val。先设置新值再释放旧值，和 dictReplace() 一样
+    auxentry.v = de->v;
+    dictSetVal(db->dict,de,val);
+    // 开启 lazyfree-lazy-server-del 时旧值可能在后台释放
+    if (server.lazyfree_lazy_server_del)
+        freeObjAsync(dictGetVal(&auxentry));
+    else
+        dictFreeVal(db->dict,&auxentry);
+}
+
+void dbOverwrite(redisDb *db, robj *key, robj *val) {
+    dbOverwriteWithHash(db,key,val,dbKeyHash(db,key));
+}
+
+/* Remove the expire of 'key' from db->expires, and from the expire index
+ * if enabled. Returns DICT_OK if the key had an expire. */
+// 删除键的过期时间，同时从过期索引中删除
+static int dbDeleteExpireWithHash(redisDb *db, robj *key, unsigned int h) {
+    if (db->expire_index) {
+        dictEntry *de = dictFindWithHash(db->expires,key->ptr,h);
+
+        if (de == NULL) return DICT_ERR;
+        expireIndexDelete(db,dictGetKey(de),dictGetSignedIntegerVal(de));
+    }
+    return dictDeleteWithHash(db->expires,key->ptr,h);
 }
 
 /* High level Set operation. This function can be used in order to set
@@ -185,19 +312,21 @@ void dbOverwrite(redisDb *db, robj *key, robj *val) {
  *    键的过期时间会被移除（键变为持久的）
  */
 void setKey(redisDb *db, robj *key, robj *val) {
+    unsigned int h = dbKeyHash(db,key);
+
     // 添加或覆写数据库中的键值对
-    if (lookupKeyWrite(db,key) == NULL) {
+    if (lookupKeyWriteWithHash(db,key,h) == NULL) {
         //如果键不存在，那么添加键值对key-val到字典中
-        dbAdd(db,key,val);
+        dbAddWithHash(db,key,val,h);
     } else {
         //如果键已存在，那么覆盖旧的值对象
-        dbOverwrite(db,key,val);
+        dbOverwriteWithHash(db,key,val,h);
     }
 
     incrRefCount(val);
 
     // 移除键的过期时间
-    removeExpire(db,key);
+    if (dictSize(db->expires)) dbDeleteExpireWithHash(db,key,h);
 
     // 发送键修改通知
     signalModifiedKey(db,key);
@@ -252,15 +381,33 @@ robj *dbRandomKey(redisDb *db) {
 /* Delete a key, value, and associated expiration entry if any, from the DB 
  * 从数据库中删除给定的键，键的值，以及键的过期时间。
  * 删除成功返回 1 ，因为键不存在而导致删除失败时，返回 0 。
+ * If 'async' is true a big value is released by the lazyfree thread.
+ * async 为真时，大的值交给后台线程释放。
  */
-int dbDelete(redisDb *db, robj *key) {
+static int dbDeleteWithHash(redisDb *db, robj *key, unsigned int h,
+                            int async)
+{
     /* Deleting an entry from the expires dict will not free the sds of
      * the key, because it is shared with the main dictionary. */
     // 如果过期字典不为空，先从过期字典删除键
-    if (dictSize(db->expires) > 0) dictDelete(db->expires,key->ptr);
+    if (dictSize(db->expires) > 0) dbDeleteExpireWithHash(db,key,h);
+
+    /* Take the value out of the entry, so that deleting the entry only
+     * releases the key. */
+    // 先把值从节点中取出，删除节点时只释放键
+    if (async) {
+        dictEntry *de = dictFindWithHash(db->dict,key->ptr,h);
+
+        if (de) {
+            robj *val = dictGetVal(de);
+
+            dictSetVal(db->dict,de,NULL);
+            freeObjAsync(val);
+        }
+    }
 
     // 删除键值对
-    if (dictDelete(db->dict,key->ptr) == DICT_OK) {
+    if (dictDeleteWithHash(db->dict,key->ptr,h) == DICT_OK) {
         // 如果开启了集群模式，那么从槽中删除给定的键
         if (server.cluster_enabled) slotToKeyDel(key);
         return 1; //成功删除，返回1
@@ -270,6 +417,21 @@ int dbDelete(redisDb *db, robj *key) {
     }
 }
 
+int dbSyncDelete(redisDb *db, robj *key) {
+    return dbDeleteWithHash(db,key,dbKeyHash(db,key),0);
+}
+
+int dbAsyncDelete(redisDb *db, robj *key) {
+    return dbDeleteWithHash(db,key,dbKeyHash(db,key),1);
+}
+
+/* Delete a key removed implicitly by the server, not by DEL or UNLINK. */
+// 删除被服务器隐式移除的键，是否在后台释放由 lazyfree-lazy-server-del 决定
+int dbDelete(redisDb *db, robj *key) {
+    return dbDeleteWithHash(db,key,dbKeyHash(db,key),
+                            server.lazyfree_lazy_server_del);
+}
+
 /* Prepare the string object stored at 'key' to be modified destructively
  * to implement commands like SETBIT or APPEND.
  *
@@ -312,8 +474,11 @@ robj *dbUnshareStringValue(redisDb *db, robj *key, robj *o) {
 
 /*
  * 清空服务器的所有数据。（从dict和expires字典删除所有键值对）
+ * With REDIS_EMPTYDB_ASYNC in 'flags' the memory is reclaimed by the
+ * lazyfree thread, and 'callback' is not used.
+ * flags 带有 REDIS_EMPTYDB_ASYNC 时，内存由后台线程释放。
  */
-long long emptyDb(void(callback)(void*)) {
+long long emptyDb(int flags, void(callback)(void*)) {
     int j;
     long long removed = 0;
 
@@ -322,10 +487,15 @@ long long emptyDb(void(callback)(void*)) {
         // 记录被删除键的数量
         removed += dictSize(server.db[j].dict);
 
+        if (flags & REDIS_EMPTYDB_ASYNC) {
+            emptyDbAsync(&server.db[j]);
+            continue;
+        }
         // 删除所有键值对（）
         dictEmpty(server.db[j].dict,callback);
         // 删除所有键的过期时间
         dictEmpty(server.db[j].expires,callback);
+        if (server.db[j].expire_index) expireIndexEmpty(&server.db[j]);
     }
 
     // 如果开启了集群模式，那么还要移除槽记录
@@ -371,17 +541,43 @@ void signalFlushedDb(int dbid) {
  * 与类型无关的数据库命令操作。
  *----------------------------------------------------------------------------*/
 
+/* Parse the optional ASYNC argument of FLUSHDB and FLUSHALL into the
+ * emptyDb() flags. Returns REDIS_ERR after replying with an error if the
+ * syntax is wrong. */
+// 解析 FLUSHDB 和 FLUSHALL 的可选参数 ASYNC
+static int getFlushCommandFlags(redisClient *c, int *flags) {
+    if (c->argc > 1) {
+        if (c->argc > 2 || strcasecmp(c->argv[1]->ptr,"async")) {
+            addReply(c,shared.syntaxerr);
+            return REDIS_ERR;
+        }
+        *flags = REDIS_EMPTYDB_ASYNC;
+    } else {
+        *flags = REDIS_EMPTYDB_NO_FLAGS;
+    }
+    return REDIS_OK;
+}
+
 /*
  * 清空客户端指定的数据库（包括dict和expires字典）
+ * FLUSHDB [ASYNC]
  */
 void flushdbCommand(redisClient *c) {
+    int flags;
+
+    if (getFlushCommandFlags(c,&flags) == REDIS_ERR) return;
     server.dirty += dictSize(c->db->dict);
     // 发送通知
     signalFlushedDb(c->db->id);
 
     // 清空指定数据库中的 dict 和 expires 字典
-    dictEmpty(c->db->dict,NULL);
-    dictEmpty(c->db->expires,NULL);
+    if (flags & REDIS_EMPTYDB_ASYNC) {
+        emptyDbAsync(c->db);
+    } else {
+        dictEmpty(c->db->dict,NULL);
+        dictEmpty(c->db->expires,NULL);
+        if (c->db->expire_index) expireIndexEmpty(c->db);
+    }
 
     // 如果开启了集群模式，那么还要移除槽记录
     if (server.cluster_enabled) slotToKeyFlush();
@@ -391,14 +587,18 @@ void flushdbCommand(redisClient *c) {
 
 /*
  * 清空服务器中的所有数据库
+ * FLUSHALL [ASYNC]
  */
 void flushallCommand(redisClient *c) {
+    int flags;
+
+    if (getFlushCommandFlags(c,&flags) == REDIS_ERR) return;
 
     // 发送通知
     signalFlushedDb(-1);
 
     // 清空所有数据库
-    server.dirty += emptyDb(NULL);
+    server.dirty += emptyDb(flags,NULL);
     addReply(c,shared.ok);
 
     // 如果正在保存新的 RDB ，那么取消保存操作
@@ -423,18 +623,26 @@ void flushallCommand(redisClient *c) {
     server.dirty++;
 }
 
+/* Implements DEL and UNLINK: with 'lazy' set, big values are released by
+ * the lazyfree thread. */
 //del key1 key2 删除键（过期字典和键值对字典都要删除键）
-void delCommand(redisClient *c) {
+static void delGenericCommand(redisClient *c, int lazy) {
     int deleted = 0, j;
 
     // 遍历所有输入键
     for (j = 1; j < c->argc; j++) {
 
+        // 每 DICT_FIND_BATCH 个键批量预取一次
+        if ((j-1) % DICT_FIND_BATCH == 0)
+            dbPrefetchKeys(c->db,c->argv+j,c->argc-j < DICT_FIND_BATCH ?
+                           c->argc-j : DICT_FIND_BATCH,1);
+
         // 先删除过期的键
         expireIfNeeded(c->db,c->argv[j]);
 
         // 尝试删除键
-        if (dbDelete(c->db,c->argv[j])) {
+        if (lazy ? dbAsyncDelete(c->db,c->argv[j]) :
+                   dbSyncDelete(c->db,c->argv[j])) {
             // 删除键成功，发送通知
 
             signalModifiedKey(c->db,c->argv[j]);
@@ -450,6 +658,15 @@ void delCommand(redisClient *c) {
     addReplyLongLong(c,deleted);
 }
 
+void delCommand(redisClient *c) {
+    delGenericCommand(c,0);
+}
+
+//unlink key1 key2 和 del 相同，但大的值在后台释放
+void unlinkCommand(redisClient *c) {
+    delGenericCommand(c,1);
+}
+
 //exists命令实现
 void existsCommand(redisClient *c) {
     // 检查键是否已经过期，如果已过期的话，那么将它删除。这可以避免已过期的键被误认为存在
@@ -1012,56 +1229,71 @@ void moveCommand(redisClient *c) {
  * 移除键 key 的过期时间（从expires词典中删除key）
  */
 int removeExpire(redisDb *db, robj *key) {
+    unsigned int h = dbKeyHash(db,key);
+
     /* An expire may only be removed if there is a corresponding entry in the
      * main dict. Otherwise, the key will never be freed. */
     // 确保键存在dict中
-    redisAssertWithInfo(NULL,key,dictFind(db->dict,key->ptr) != NULL);
+    redisAssertWithInfo(NULL,key,dictFindWithHash(db->dict,key->ptr,h) != NULL);
     // 删除过期时间
-    return dictDelete(db->expires,key->ptr) == DICT_OK;
+    return dbDeleteExpireWithHash(db,key,h) == DICT_OK;
 }
 
 /*
  * 将键 key 的过期时间设为 when
  */
 void setExpire(redisDb *db, robj *key, long long when) {
+    unsigned int h = dbKeyHash(db,key);
     dictEntry *kde, *de;
 
     /* Reuse the sds from the main dict in the expire dict */
     // 取出键
-    kde = dictFind(db->dict,key->ptr);
+    kde = dictFindWithHash(db->dict,key->ptr,h);
     //确保键肯定在dict中
     redisAssertWithInfo(NULL,key,kde != NULL);
 
-    // 根据键取出键的过期时间，放在de中
-    de = dictReplaceRaw(db->expires,dictGetKey(kde));
+    // 根据键取出键的过期时间，放在de中，不存在则添加（和 dictReplaceRaw() 一样）
+    de = dictFindWithHash(db->expires,key->ptr,h);
+    if (de == NULL) {
+        de = dictAddRawWithHash(db->expires,dictGetKey(kde),h);
+    } else if (db->expire_index) {
+        expireIndexDelete(db,dictGetKey(de),dictGetSignedIntegerVal(de));
+    }
 
     // 设置键的过期时间
     // 这里是直接使用整数值来保存过期时间，不是用 INT 编码的 String 对象（用dict的value的union里的s64）
     dictSetSignedIntegerVal(de,when);
+    if (db->expire_index) expireIndexAdd(db,dictGetKey(de),when);
 }
 
 /* Return the expire time of the specified key, or -1 if no expire
  * is associated with this key (i.e. the key is non volatile) 
  * 返回给定 key 的过期时间。如果键没有设置过期时间，那么返回 -1 。
  */
-long long getExpire(redisDb *db, robj *key) {
+static long long getExpireWithHash(redisDb *db, robj *key, unsigned int h) {
     dictEntry *de;
 
     /* No expire? return ASAP */
     // 获取键的过期时间。如果过期时间不存在，那么直接返回
     if (dictSize(db->expires) == 0 ||
-       (de = dictFind(db->expires,key->ptr)) == NULL) return -1;
+       (de = dictFindWithHash(db->expires,key->ptr,h)) == NULL) return -1;
 
     /* The entry was found in the expire dict, this means it should also
      * be present in the main dict (safety check). */
     //确保键肯定在dict中
-    redisAssertWithInfo(NULL,key,dictFind(db->dict,key->ptr) != NULL);
+    redisAssertWithInfo(NULL,key,dictFindWithHash(db->dict,key->ptr,h) != NULL);
 
     // 返回过期时间
     //这个函数是个宏定义，返回de->v.s64
     return dictGetSignedIntegerVal(de);
 }
 
+long long getExpire(redisDb *db, robj *key) {
+    /* Keys without expire are the common case: don't hash them at all. */
+    if (dictSize(db->expires) == 0) return -1;
+    return getExpireWithHash(db,key,dbKeyHash(db,key));
+}
+
 /* Propagate expires into slaves and the AOF file.
  * When a key expires in the master, a DEL operation for this key is sent
  * to all the slaves and the AOF file if enabled.
@@ -1102,9 +1334,9 @@ void propagateExpire(redisDb *db, robj *key) {
  * 返回 1 表示键已经因为过期而被删除了。
  */
 //看是否过期，如果已过期那么删除该键
-int expireIfNeeded(redisDb *db, robj *key) {
+static int expireIfNeededWithHash(redisDb *db, robj *key, unsigned int h) {
     // 取出键的过期时间
-    mstime_t when = getExpire(db,key);
+    mstime_t when = getExpireWithHash(db,key,h);
     mstime_t now;
 
     // 没有过期时间
@@ -1152,7 +1384,11 @@ int expireIfNeeded(redisDb *db, robj *key) {
         "expired",key,db->id);
 
     // 将过期键从数据库中删除（从dict和expires字典中删除该键）
-    return dbDelete(db,key);
+    return dbDeleteWithHash(db,key,h,server.lazyfree_lazy_expire);
+}
+
+int expireIfNeeded(redisDb *db, robj *key) {
+    return expireIfNeededWithHash(db,key,dbKeyHash(db,key));
 }
 
 /*-----------------------------------------------------------------------------
@@ -37,16 +37,25 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <stdarg.h>
 #include <limits.h>
 #include <sys/time.h>
 #include <ctype.h>
+#include <pthread.h>
 
 #include "dict.h"
 #include "zmalloc.h"
 #include "redisassert.h"
 
+/* Control bytes of the open addressing layout are matched 16 at a time with
+ * SSE2 when available, that is always the case on x86_64. */
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define DICT_OA_SSE2
+#endif
+
 /* Using dictEnableResize() / dictDisableResize() we make possible to
  * enable/disable resizing of the hash table as needed. This is very important
  * for Redis, as we use copy-on-write and don't want to move too much memory
@@ -74,8 +83,13 @@ static unsigned int dict_force_resize_ratio = 5;
 
 static int _dictExpandIfNeeded(dict *ht);
 static unsigned long _dictNextPower(unsigned long size);
-static int _dictKeyIndex(dict *ht, const void *key);
+static int _dictKeyIndex(dict *ht, const void *key, unsigned int h);
 static int _dictInit(dict *ht, dictType *type, void *privDataPtr);
+static void _dictReset(dictht *ht);
+static void _dictRehashingStarted(dict *d);
+static void _dictRehashingStopped(dict *d);
+static unsigned long rev(unsigned long v);
+long long dictFingerprint(dict *d);
 
 /* -------------------------- hash functions -------------------------------- */
 
@@ -110,6 +124,9 @@ uint32_t dictGetHashFunctionSeed(void) {
     return dict_hash_function_seed;
 }
 
+/* Only the hash function selected at build time is compiled in, the
+ * micro benchmark at the end of the file needs both. */
+#if !defined(USE_XXHASH) || defined(DICT_BENCHMARK_MAIN)
 /* MurmurHash2, by Austin Appleby
  * Note - This code makes a few assumptions about how your machine behaves -
  * 1. We can read a 4-byte value from any address without crashing
@@ -122,7 +139,7 @@ uint32_t dictGetHashFunctionSeed(void) {
  *    machines.
  */
 //使用murmurhash2计算（key, len)的哈希值
-unsigned int dictGenHashFunction(const void *key, int len) {
+static unsigned int _dictMurmur2Hash(const void *key, int len) {
     /* 'm' and 'r' are mixing constants generated offline.
      They're not really 'magic', they just happen to work well.  */
     uint32_t seed = dict_hash_function_seed;
@@ -164,6 +181,130 @@ unsigned int dictGenHashFunction(const void *key, int len) {
 
     return (unsigned int)h;
 }
+#endif
+
+#if defined(USE_XXHASH) || defined(DICT_BENCHMARK_MAIN)
+/* xxHash64, by Yann Collet, truncated to 32 bits.
+ *
+ * Inputs of 32 bytes or more are consumed by four independent lanes of 8
+ * bytes each: the multiplications of different lanes don't depend on each
+ * other, so the CPU (or the compiler, with vector instructions) runs them
+ * in parallel. MurmurHash2 instead mixes 4 bytes at a time into a single
+ * state, which makes it noticeably slower on long keys.
+ *
+ * Like MurmurHash2 the result differs on little and big endian machines.
+ */
+//使用xxhash64计算（key, len)的哈希值，32字节以上的输入分成4路并行计算
+#define XXH_PRIME64_1 0x9E3779B185EBCA87ULL
+#define XXH_PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define XXH_PRIME64_3 0x165667B19E3779F9ULL
+#define XXH_PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define XXH_PRIME64_5 0x27D4EB2F165667C5ULL
+#define XXH_ROTL64(x,r) (((x) << (r)) | ((x) >> (64-(r))))
+
+static inline uint64_t _dictXXRead64(const unsigned char *p) {
+    uint64_t v;
+
+    memcpy(&v,p,sizeof(v));
+    return v;
+}
+
+static inline uint32_t _dictXXRead32(const unsigned char *p) {
+    uint32_t v;
+
+    memcpy(&v,p,sizeof(v));
+    return v;
+}
+
+static inline uint64_t _dictXXRound(uint64_t acc, uint64_t input) {
+    acc += input*XXH_PRIME64_2;
+    acc = XXH_ROTL64(acc,31);
+    return acc*XXH_PRIME64_1;
+}
+
+static inline uint64_t _dictXXMerge(uint64_t acc, uint64_t val) {
+    acc ^= _dictXXRound(0,val);
+    return acc*XXH_PRIME64_1+XXH_PRIME64_4;
+}
+
+static unsigned int _dictXXHash64(const void *key, int len) {
+    const unsigned char *p = key, *end = p+len;
+    uint64_t seed = dict_hash_function_seed;
+    uint64_t h;
+
+    if (len >= 32) {
+        const unsigned char *limit = end-32;
+        uint64_t v1 = seed+XXH_PRIME64_1+XXH_PRIME64_2;
+        uint64_t v2 = seed+XXH_PRIME64_2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed-XXH_PRIME64_1;
+
+        do {
+            v1 = _dictXXRound(v1,_dictXXRead64(p));
+            v2 = _dictXXRound(v2,_dictXXRead64(p+8));
+            v3 = _dictXXRound(v3,_dictXXRead64(p+16));
+            v4 = _dictXXRound(v4,_dictXXRead64(p+24));
+            p += 32;
+        } while (p <= limit);
+
+        h = XXH_ROTL64(v1,1)+XXH_ROTL64(v2,7)+
+            XXH_ROTL64(v3,12)+XXH_ROTL64(v4,18);
+        h = _dictXXMerge(h,v1);
+        h = _dictXXMerge(h,v2);
+        h = _dictXXMerge(h,v3);
+        h = _dictXXMerge(h,v4);
+    } else {
+        h = seed+XXH_PRIME64_5;
+    }
+    h += (uint64_t)len;
+
+    /* Tail: 8, then 4, then 1 byte at a time. */
+    while (p+8 <= end) {
+        h ^= _dictXXRound(0,_dictXXRead64(p));
+        h = XXH_ROTL64(h,27)*XXH_PRIME64_1+XXH_PRIME64_4;
+        p += 8;
+    }
+    if (p+4 <= end) {
+        h ^= (uint64_t)_dictXXRead32(p)*XXH_PRIME64_1;
+        h = XXH_ROTL64(h,23)*XXH_PRIME64_2+XXH_PRIME64_3;
+        p += 4;
+    }
+    while (p < end) {
+        h ^= (*p)*XXH_PRIME64_5;
+        h = XXH_ROTL64(h,11)*XXH_PRIME64_1;
+        p++;
+    }
+
+    /* Final avalanche. */
+    h ^= h >> 33;
+    h *= XXH_PRIME64_2;
+    h ^= h >> 29;
+    h *= XXH_PRIME64_3;
+    h ^= h >> 32;
+    return (unsigned int)h;
+}
+#endif
+
+/* The hash function of the dictionaries is selected at build time: the
+ * default is MurmurHash2, "make USE_XXHASH=yes" switches to xxHash64.
+ * Both are seeded with dict_hash_function_seed. */
+// 字典使用的哈希函数在编译时选择
+unsigned int dictGenHashFunction(const void *key, int len) {
+#if defined(USE_XXHASH)
+    return _dictXXHash64(key,len);
+#else
+    return _dictMurmur2Hash(key,len);
+#endif
+}
+
+/* Name of the hash function selected at build time, for INFO. */
+const char *dictGenHashFunctionName(void) {
+#if defined(USE_XXHASH)
+    return "xxhash64";
+#else
+    return "murmur2";
+#endif
+}
 
 /* And a case insensitive hash function (based on djb hash) */
 //对buf大小写不敏感的hash函数，大小写不敏感就是全部字母转成小写处理，这样就统一了大小写
@@ -175,6 +316,653 @@ unsigned int dictGenCaseHashFunction(const unsigned char *buf, int len) {
     return hash;
 }
 
+/* --------------------------- Table memory ---------------------------------
+ *
+ * Buckets of chained tables are accessed with _dictBucket() (read) and
+ * _dictBucketRef() (write), that hide the chunked representation of big
+ * tables described near DICT_TABLE_CHUNK in dict.h.
+ *
+ * Tables of at least DICT_TABLE_CHUNK buckets that are retired (the old
+ * table at the end of a rehashing, or the tables of a cleared dict) are
+ * passed to the hook set with dictSetTableFreeHook(), if any, so that the
+ * server can release them in a background thread. The hook must
+ * eventually call dictFreeTableMemory().
+ *
+ * 表内存管理：分块表的桶访问，以及把退役的大表交给后台线程释放。
+ * -------------------------------------------------------------------------- */
+
+static dictTableStats dict_table_stats;
+static void (*dict_table_free_hook)(void *table, unsigned long chunks) = NULL;
+
+static long long _dictUstime(void) {
+    struct timeval tv;
+
+    gettimeofday(&tv,NULL);
+    return (((long long)tv.tv_sec)*1000000)+tv.tv_usec;
+}
+
+/* Account 'usec' of main thread time spent on big table memory. */
+static void _dictTableStall(long long usec) {
+    dict_table_stats.stall_usec += usec;
+    if (usec > dict_table_stats.stall_max_usec)
+        dict_table_stats.stall_max_usec = usec;
+}
+
+static unsigned long _dictTableChunks(dictht *ht) {
+    return ht->size >> DICT_TABLE_CHUNK_BITS;
+}
+
+/* Allocate the bucket array of a chained table of 'size' buckets: only the
+ * chunk pointers if the table is chunked. */
+// 分配链地址表的桶数组，分块表只分配分块指针数组
+static dictEntry **_dictTableAlloc(unsigned long size) {
+    long long start;
+    dictEntry **table;
+
+    if (size < DICT_TABLE_CHUNK) return zcalloc(size*sizeof(dictEntry*));
+    start = _dictUstime();
+    if (size > DICT_TABLE_CHUNK)
+        table = zcalloc((size >> DICT_TABLE_CHUNK_BITS)*sizeof(dictEntry**));
+    else
+        table = zcalloc(size*sizeof(dictEntry*));
+    _dictTableStall(_dictUstime()-start);
+    return table;
+}
+
+/* Return the address of bucket 'idx', or NULL if its chunk is not
+ * allocated (the bucket is empty). */
+static inline dictEntry **_dictBucketAddr(dictht *ht, unsigned long idx) {
+    dictEntry **chunk;
+
+    if (!dictTableIsChunked(ht)) return ht->table+idx;
+    chunk = ((dictEntry***)ht->table)[idx >> DICT_TABLE_CHUNK_BITS];
+    return chunk ? chunk+(idx & (DICT_TABLE_CHUNK-1)) : NULL;
+}
+
+// 返回桶 idx 的链表头节点
+static inline dictEntry *_dictBucket(dictht *ht, unsigned long idx) {
+    dictEntry **bucket = _dictBucketAddr(ht,idx);
+
+    return bucket ? *bucket : NULL;
+}
+
+/* Return the address of bucket 'idx' to modify it, allocating its chunk
+ * if needed. */
+// 返回桶 idx 的地址以便修改，必要时分配所在的分块
+static dictEntry **_dictBucketRef(dictht *ht, unsigned long idx) {
+    dictEntry ***chunks, **chunk;
+
+    if (!dictTableIsChunked(ht)) return ht->table+idx;
+    chunks = (dictEntry***)ht->table;
+    chunk = chunks[idx >> DICT_TABLE_CHUNK_BITS];
+    if (chunk == NULL) {
+        long long start = _dictUstime();
+
+        chunk = zcalloc(DICT_TABLE_CHUNK*sizeof(dictEntry*));
+        chunks[idx >> DICT_TABLE_CHUNK_BITS] = chunk;
+        dict_table_stats.chunks++;
+        _dictTableStall(_dictUstime()-start);
+    }
+    return chunk+(idx & (DICT_TABLE_CHUNK-1));
+}
+
+/* Free the chunk holding bucket 'idx', whose buckets are all empty. */
+static void _dictChunkRelease(dictht *ht, unsigned long idx) {
+    dictEntry ***chunks = (dictEntry***)ht->table;
+    long long start;
+
+    if (chunks[idx >> DICT_TABLE_CHUNK_BITS] == NULL) return;
+    start = _dictUstime();
+    zfree(chunks[idx >> DICT_TABLE_CHUNK_BITS]);
+    chunks[idx >> DICT_TABLE_CHUNK_BITS] = NULL;
+    _dictTableStall(_dictUstime()-start);
+}
+
+/* Free a table: 'chunks' is the length of the chunk pointers array
+ * 'table' of a chunked table, or zero for a single allocation. */
+// 释放一个表：分块表先释放所有分块，再释放分块指针数组
+void dictFreeTableMemory(void *table, unsigned long chunks) {
+    unsigned long j;
+
+    for (j = 0; j < chunks; j++) zfree(((dictEntry***)table)[j]);
+    zfree(table);
+}
+
+/* Release the memory of 'ht', a chained table of 'd' if 'chained' is true,
+ * otherwise an open addressing one. The elements must be already gone. */
+// 释放表 ht 的内存，大表交给 dictSetTableFreeHook() 设置的函数处理
+static void _dictTableRelease(dict *d, dictht *ht, int chained) {
+    void *table = chained ? (void*)ht->table : (void*)ht->ctrl;
+    unsigned long chunks = chained && dictTableIsChunked(ht) ?
+                           _dictTableChunks(ht) : 0;
+    long long start;
+
+    /* A detached dict is released by another thread: no hook, no stats. */
+    if (d->detached) {
+        dictFreeTableMemory(table,chunks);
+        return;
+    }
+    if (ht->size < DICT_TABLE_CHUNK) {
+        zfree(table);
+        return;
+    }
+    start = _dictUstime();
+    if (dict_table_free_hook) {
+        dict_table_free_hook(table,chunks);
+        dict_table_stats.freed_async++;
+    } else {
+        dictFreeTableMemory(table,chunks);
+    }
+    _dictTableStall(_dictUstime()-start);
+}
+
+/* Set the function releasing retired big tables, NULL to free them
+ * synchronously. */
+void dictSetTableFreeHook(void (*hook)(void *table, unsigned long chunks)) {
+    dict_table_free_hook = hook;
+}
+
+void dictGetTableStats(dictTableStats *stats) {
+    *stats = dict_table_stats;
+}
+
+void dictResetTableStats(void) {
+    memset(&dict_table_stats,0,sizeof(dict_table_stats));
+}
+
+/* ----------------------- Open addressing layout --------------------------
+ *
+ * Tables using DICT_LAYOUT_OPEN are a single allocation of 'size' control
+ * bytes followed by 'size' slots. A slot stores the key and the value of an
+ * element, that is the dictEntry fields before 'next', so there is no
+ * per-element allocation and no pointer to chase to reach the key.
+ *
+ * The slots are divided in groups of DICT_OA_GROUP. The control byte of a
+ * slot is DICT_OA_EMPTY, DICT_OA_DELETED, or, when the slot is in use, 7
+ * bits of the hash of the key (the tag). A lookup starts from the home
+ * group of the key (hash & number of groups - 1), compares the tag against
+ * the 16 control bytes of the group with a single vector instruction, and
+ * compares the keys only for the matching slots. Probing proceeds to the
+ * next group only if the current group has no empty slot.
+ *
+ * Deleting an element in a group that still has an empty slot sets its
+ * control byte back to DICT_OA_EMPTY: no probe sequence ever went past such
+ * a group. Otherwise the slot is marked DELETED (a tombstone), and it is
+ * reused by the next insertions. The table is resized when used plus
+ * deleted slots reach 7/8 of the size (15/16 while resizing is disabled
+ * because of a child process), rebuilding it with the same size when most
+ * of the occupied slots are tombstones.
+ *
+ * Incremental rehashing moves one group of the old table per step, marking
+ * the moved slots as deleted, so that keys still in the old table can be
+ * found until the old table is released.
+ *
+ * 开放寻址布局：表由 size 个控制字节和 size 个槽位组成，只需要一次分配，
+ * 槽位直接保存键和值，不需要为每个元素单独分配 dictEntry 。
+ * 槽位每 16 个一组，查找时用一条向量指令比较一组中所有控制字节的标签，
+ * 只对标签相同的槽位比较键；当前组没有空槽位时，才继续查找下一组。
+ */
+
+/* Bytes used by a slot: the dictEntry fields before 'next'. */
+#define DICT_OA_SLOT_SIZE offsetof(dictEntry,next)
+/* Control bytes of free slots have the high bit set, used ones hold a tag. */
+#define DICT_OA_EMPTY 0x80
+#define DICT_OA_DELETED 0xfe
+
+/* Return the slot at index 'i' of the open addressing table 'ht'. */
+#define dictOaSlot(ht,i) \
+    ((dictEntry*)((ht)->ctrl+(ht)->size+(i)*DICT_OA_SLOT_SIZE))
+/* Number of groups of the table, always a power of two. */
+#define dictOaGroups(ht) ((ht)->size/DICT_OA_GROUP)
+/* 7 bits of the hash stored in the control byte. The group is selected by
+ * the low bits of the hash, so the tag is taken from the high ones. */
+#define dictOaTag(h) ((unsigned char)(((h) >> 25) & 0x7f))
+#define dictOaSlotUsed(ht,i) (!((ht)->ctrl[i] & DICT_OA_EMPTY))
+
+/* Return a mask with bit N set if ctrl[N] == c, for the DICT_OA_GROUP
+ * control bytes of a group. */
+// 返回一组控制字节中等于 c 的位置的位图
+static inline unsigned int _dictOaMatch(const unsigned char *ctrl,
+                                        unsigned char c)
+{
+#if defined(DICT_OA_SSE2)
+    __m128i g = _mm_loadu_si128((const __m128i*)ctrl);
+    return (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(g,_mm_set1_epi8(c)));
+#else
+    unsigned int mask = 0;
+    int j;
+
+    for (j = 0; j < DICT_OA_GROUP; j++)
+        if (ctrl[j] == c) mask |= 1u << j;
+    return mask;
+#endif
+}
+
+/* Return a mask with bit N set if slot N of the group is empty or deleted. */
+// 返回一组中空槽位或已删除槽位的位图
+static inline unsigned int _dictOaMatchFree(const unsigned char *ctrl) {
+#if defined(DICT_OA_SSE2)
+    __m128i g = _mm_loadu_si128((const __m128i*)ctrl);
+    return (unsigned int)_mm_movemask_epi8(g);
+#else
+    unsigned int mask = 0;
+    int j;
+
+    for (j = 0; j < DICT_OA_GROUP; j++)
+        if (ctrl[j] & DICT_OA_EMPTY) mask |= 1u << j;
+    return mask;
+#endif
+}
+
+/* Index of the lowest bit set in a non zero mask. */
+static inline int _dictOaFirst(unsigned int mask) {
+#if defined(__GNUC__)
+    return __builtin_ctz(mask);
+#else
+    int j = 0;
+
+    while (!(mask & 1)) {
+        mask >>= 1;
+        j++;
+    }
+    return j;
+#endif
+}
+
+/* Allocate an empty open addressing table of 'size' slots. */
+// 分配一个有 size 个槽位的开放寻址表，所有槽位都是空的
+static void _dictOaAlloc(dictht *ht, unsigned long size) {
+    long long start = size >= DICT_TABLE_CHUNK ? _dictUstime() : 0;
+
+    /* Only the control bytes are written here: the pages of the slots are
+     * touched as elements are added. */
+    ht->table = NULL;
+    ht->ctrl = zmalloc(size+size*DICT_OA_SLOT_SIZE);
+    memset(ht->ctrl,DICT_OA_EMPTY,size);
+    if (start) _dictTableStall(_dictUstime()-start);
+    ht->size = size;
+    ht->sizemask = size-1;
+    ht->used = 0;
+    ht->deleted = 0;
+}
+
+/* Return the index of the slot holding 'key' in 'ht', or -1. */
+// 在表 ht 中查找 key ，返回槽位索引，找不到返回 -1
+static long _dictOaLookup(dict *d, dictht *ht, const void *key,
+                          unsigned int h)
+{
+    unsigned long gmask = dictOaGroups(ht)-1;
+    unsigned long g = h & gmask;
+    unsigned char tag = dictOaTag(h);
+
+    while(1) {
+        const unsigned char *ctrl = ht->ctrl+g*DICT_OA_GROUP;
+        unsigned int m = _dictOaMatch(ctrl,tag);
+
+        while(m) {
+            unsigned long idx = g*DICT_OA_GROUP+_dictOaFirst(m);
+
+            if (dictCompareKeys(d, key, dictOaSlot(ht,idx)->key))
+                return idx;
+            m &= m-1;
+        }
+        /* A group with an empty slot terminates every probe sequence. */
+        if (_dictOaMatch(ctrl,DICT_OA_EMPTY)) return -1;
+        g = (g+1) & gmask;
+    }
+}
+
+/* Return the index of the first free slot in the probe sequence of hash 'h',
+ * marking it as used with the tag of 'h'. The caller sets key and value. */
+// 在 h 的探测序列中找到第一个空闲槽位，并把它标记为已使用
+static unsigned long _dictOaClaim(dictht *ht, unsigned int h) {
+    unsigned long gmask = dictOaGroups(ht)-1;
+    unsigned long g = h & gmask;
+    unsigned long idx;
+    unsigned int m;
+
+    while((m = _dictOaMatchFree(ht->ctrl+g*DICT_OA_GROUP)) == 0)
+        g = (g+1) & gmask;
+    idx = g*DICT_OA_GROUP+_dictOaFirst(m);
+    if (ht->ctrl[idx] == DICT_OA_DELETED) ht->deleted--;
+    ht->ctrl[idx] = dictOaTag(h);
+    ht->used++;
+    return idx;
+}
+
+/* Mark the slot 'idx' as free. See the comment at the top of this section
+ * for the reason why this is not always DICT_OA_EMPTY. */
+// 释放槽位 idx ：所在组还有空槽位时直接标记为空，否则标记为已删除
+static void _dictOaRelease(dictht *ht, unsigned long idx) {
+    const unsigned char *group = ht->ctrl+(idx & ~(DICT_OA_GROUP-1UL));
+
+    if (_dictOaMatch(group,DICT_OA_EMPTY)) {
+        ht->ctrl[idx] = DICT_OA_EMPTY;
+    } else {
+        ht->ctrl[idx] = DICT_OA_DELETED;
+        ht->deleted++;
+    }
+    ht->used--;
+}
+
+/* Create a table of at least 'size' slots, as ht[0] if the dict is empty,
+ * otherwise as ht[1] starting an incremental rehashing. */
+// 创建一个至少有 size 个槽位的开放寻址表
+/* Number of slots of an open addressing table of at least 'size' slots. */
+static unsigned long _dictOaSlots(unsigned long size) {
+    unsigned long realsize = DICT_OA_GROUP;
+
+    while(realsize < size) realsize *= 2;
+    return realsize;
+}
+
+static int _dictOaExpand(dict *d, unsigned long size) {
+    unsigned long realsize = _dictOaSlots(size);
+    dictht n;
+
+    if (dictIsRehashing(d) || d->ht[0].used > realsize/8*7)
+        return DICT_ERR;
+
+    /* ht[1] receives the elements of ht[0] and the keys added before the
+     * rehashing completes. Every add runs a rehashing step first (adds are
+     * not allowed under a safe iterator, see _dictOaAddRaw()), and every
+     * step moves a group of ht[0] holding at least one element, so at most
+     * min(used, groups) + 1 keys are added meanwhile. Size ht[1] so that
+     * all of them fit under its max load: it never has to be resized
+     * while the rehashing is in progress. */
+    // 1 号表要能在最大装载率下容纳 0 号表的元素，以及 rehash 完成前新增的键
+    if (d->ht[0].ctrl != NULL) {
+        unsigned long steps = dictOaGroups(&d->ht[0]);
+
+        if (steps > d->ht[0].used) steps = d->ht[0].used;
+        while(realsize/16*15 <= d->ht[0].used+steps+1) realsize *= 2;
+    }
+
+    _dictOaAlloc(&n,realsize);
+    if (d->ht[0].ctrl == NULL) {
+        d->ht[0] = n;
+        return DICT_OK;
+    }
+    d->ht[1] = n;
+    d->rehashidx = 0;
+    _dictRehashingStarted(d);
+    return DICT_OK;
+}
+
+/* Open addressing version of dictRehash(): every step moves one group. */
+// 开放寻址表的渐进式 rehash ，每一步迁移一组槽位
+static int _dictOaRehash(dict *d, int n) {
+    while(n--) {
+        dictht *t0 = &d->ht[0], *t1 = &d->ht[1];
+        unsigned long idx;
+        int j;
+
+        if (t0->used == 0) {
+            _dictTableRelease(d,t0,0);
+            d->ht[0] = d->ht[1];
+            _dictReset(&d->ht[1]);
+            d->rehashidx = -1;
+            _dictRehashingStopped(d);
+            return 0;
+        }
+        assert(dictOaGroups(t0) > (unsigned)d->rehashidx);
+
+        /* Skip groups without elements. */
+        while(_dictOaMatchFree(t0->ctrl+
+              (unsigned long)d->rehashidx*DICT_OA_GROUP) == 0xffff)
+            d->rehashidx++;
+
+        idx = (unsigned long)d->rehashidx*DICT_OA_GROUP;
+        for (j = 0; j < DICT_OA_GROUP; j++, idx++) {
+            dictEntry *src, *dst;
+
+            if (!dictOaSlotUsed(t0,idx)) continue;
+            src = dictOaSlot(t0,idx);
+            dst = dictOaSlot(t1,_dictOaClaim(t1,dictHashKey(d,src->key)));
+            dst->key = src->key;
+            dst->v = src->v;
+            /* Keep probe sequences of ht[0] intact for the keys that are
+             * still there: the moved slot becomes a tombstone. */
+            t0->ctrl[idx] = DICT_OA_DELETED;
+            t0->deleted++;
+            t0->used--;
+        }
+        d->rehashidx++;
+    }
+    return 1;
+}
+
+/* Grow the table when used plus deleted slots reach the max load, or
+ * rebuild it with the same size if most of them are tombstones. */
+// 根据装载率扩展开放寻址表，或者在已删除槽位太多时以相同大小重建
+static int _dictOaExpandIfNeeded(dict *d) {
+    dictht *ht = &d->ht[0];
+    unsigned long limit;
+
+    /* New keys go to ht[1], that _dictOaExpand() sized so that it can't
+     * reach its max load before the rehashing completes. */
+    // 1 号表在创建时已经留出足够空间，rehash 期间不需要扩展
+    if (dictIsRehashing(d)) return DICT_OK;
+    if (ht->size == 0) return _dictOaExpand(d,DICT_OA_GROUP);
+
+    limit = dict_can_resize ? ht->size/8*7 : ht->size/16*15;
+    if (ht->used+ht->deleted < limit) return DICT_OK;
+    if (ht->used < ht->size/2)
+        return _dictOaExpand(d,ht->size);
+    return _dictOaExpand(d,ht->size*2);
+}
+
+/* Open addressing versions of the API functions, called after the common
+ * part (empty dict checks and rehashing step) is done. */
+
+static dictEntry *_dictOaFind(dict *d, const void *key, unsigned int h) {
+    int table;
+
+    for (table = 0; table <= 1; table++) {
+        long idx = _dictOaLookup(d,&d->ht[table],key,h);
+
+        if (idx != -1) return dictOaSlot(&d->ht[table],idx);
+        if (!dictIsRehashing(d)) break;
+    }
+    return NULL;
+}
+
+/* Return the first slot of the home group of 'h' with a matching tag, or
+ * NULL. It is where the key most likely lives, used to prefetch it. */
+// 返回 h 所在组中第一个标签匹配的槽位，用于预取
+static dictEntry *_dictOaCandidate(dictht *ht, unsigned int h) {
+    unsigned long g = h & (dictOaGroups(ht)-1);
+    unsigned int m = _dictOaMatch(ht->ctrl+g*DICT_OA_GROUP,dictOaTag(h));
+
+    return m ? dictOaSlot(ht,g*DICT_OA_GROUP+_dictOaFirst(m)) : NULL;
+}
+
+static dictEntry *_dictOaAddRaw(dict *d, void *key, unsigned int h) {
+    dictht *ht;
+    dictEntry *entry;
+
+    /* Adding keys may resize the table and move the slots under a safe
+     * iterator, and with the rehashing paused by the iterator ht[1] could
+     * fill up. The keyspace never adds keys while iterating it. */
+    // 开放寻址表不允许在安全迭代器存在时添加新键
+    assert(d->iterators == 0);
+    if (_dictOaExpandIfNeeded(d) == DICT_ERR) return NULL;
+    if (_dictOaLookup(d,&d->ht[0],key,h) != -1) return NULL;
+    if (dictIsRehashing(d) && _dictOaLookup(d,&d->ht[1],key,h) != -1)
+        return NULL;
+
+    ht = dictIsRehashing(d) ? &d->ht[1] : &d->ht[0];
+    entry = dictOaSlot(ht,_dictOaClaim(ht,h));
+    dictSetKey(d, entry, key);
+    return entry;
+}
+
+static int _dictOaDelete(dict *d, const void *key, unsigned int h,
+                         int nofree)
+{
+    int table;
+
+    for (table = 0; table <= 1; table++) {
+        dictht *ht = &d->ht[table];
+        long idx = _dictOaLookup(d,ht,key,h);
+
+        if (idx != -1) {
+            if (!nofree) {
+                dictFreeKey(d, dictOaSlot(ht,idx));
+                dictFreeVal(d, dictOaSlot(ht,idx));
+            }
+            _dictOaRelease(ht,idx);
+            return DICT_OK;
+        }
+        if (!dictIsRehashing(d)) break;
+    }
+    return DICT_ERR;
+}
+
+static void _dictOaClear(dict *d, dictht *ht, void(callback)(void *)) {
+    unsigned long i;
+
+    for (i = 0; i < ht->size && ht->used > 0; i++) {
+        if (callback && (i & 65535) == 0) callback(d->privdata);
+        if (!dictOaSlotUsed(ht,i)) continue;
+        dictFreeKey(d, dictOaSlot(ht,i));
+        dictFreeVal(d, dictOaSlot(ht,i));
+        ht->used--;
+    }
+    _dictTableRelease(d,ht,0);
+    _dictReset(ht);
+}
+
+static dictEntry *_dictOaNext(dictIterator *iter) {
+    while(1) {
+        dictht *ht = &iter->d->ht[iter->table];
+
+        if (iter->index == -1 && iter->table == 0) {
+            if (iter->safe)
+                iter->d->iterators++;
+            else
+                iter->fingerprint = dictFingerprint(iter->d);
+        }
+        iter->index++;
+        if (iter->index >= (signed) ht->size) {
+            if (dictIsRehashing(iter->d) && iter->table == 0) {
+                iter->table++;
+                iter->index = -1;
+                continue;
+            }
+            break;
+        }
+        /* Deleting the returned element only changes its control byte,
+         * so there is no need to remember the next one. */
+        if (dictOaSlotUsed(ht,iter->index)) {
+            iter->entry = dictOaSlot(ht,iter->index);
+            return iter->entry;
+        }
+    }
+    return NULL;
+}
+
+static dictEntry *_dictOaGetRandomKey(dict *d) {
+    dictht *ht;
+    unsigned long h;
+
+    do {
+        if (dictIsRehashing(d)) {
+            h = random() % (d->ht[0].size+d->ht[1].size);
+            ht = &d->ht[0];
+            if (h >= ht->size) {
+                h -= ht->size;
+                ht = &d->ht[1];
+            }
+        } else {
+            ht = &d->ht[0];
+            h = random() & ht->sizemask;
+        }
+    } while(!dictOaSlotUsed(ht,h));
+    return dictOaSlot(ht,h);
+}
+
+static int _dictOaGetRandomKeys(dict *d, dictEntry **des, int count) {
+    int j, stored = 0;
+
+    for (j = 0; j < 2; j++) {
+        dictht *ht = &d->ht[j];
+        unsigned long i = random() & ht->sizemask;
+        unsigned long size = ht->size;
+
+        while(size--) {
+            if (dictOaSlotUsed(ht,i)) {
+                des[stored++] = dictOaSlot(ht,i);
+                if (stored == count) return stored;
+            }
+            i = (i+1) & ht->sizemask;
+        }
+    }
+    return stored;
+}
+
+/* Emit the elements whose home group is 'g'. Linear probing over groups
+ * places them between 'g' and the first group that has an empty slot, so
+ * a group of the open addressing table plays the role of a bucket of the
+ * chained table for dictScan(). */
+// 返回所有以 g 为起始组的元素，它们一定位于 g 和之后第一个有空槽位的组之间
+static void _dictOaScanGroup(dict *d, dictht *ht, unsigned long g,
+                             dictScanFunction *fn, void *privdata)
+{
+    unsigned long gmask = dictOaGroups(ht)-1;
+    unsigned long k = g;
+
+    while(1) {
+        unsigned long idx = k*DICT_OA_GROUP;
+        int j;
+
+        for (j = 0; j < DICT_OA_GROUP; j++, idx++) {
+            dictEntry *de;
+
+            if (!dictOaSlotUsed(ht,idx)) continue;
+            de = dictOaSlot(ht,idx);
+            if ((dictHashKey(d, de->key) & gmask) == g) fn(privdata, de);
+        }
+        if (_dictOaMatch(ht->ctrl+k*DICT_OA_GROUP,DICT_OA_EMPTY)) break;
+        k = (k+1) & gmask;
+        if (k == g) break;
+    }
+}
+
+/* Open addressing version of dictScan(): the cursor addresses groups. */
+static unsigned long _dictOaScan(dict *d, unsigned long v,
+                                 dictScanFunction *fn, void *privdata)
+{
+    dictht *t0, *t1;
+    unsigned long m0, m1;
+
+    if (!dictIsRehashing(d)) {
+        t0 = &d->ht[0];
+        m0 = dictOaGroups(t0)-1;
+        _dictOaScanGroup(d,t0,v & m0,fn,privdata);
+    } else {
+        t0 = &d->ht[0];
+        t1 = &d->ht[1];
+        if (t0->size > t1->size) {
+            t0 = &d->ht[1];
+            t1 = &d->ht[0];
+        }
+        m0 = dictOaGroups(t0)-1;
+        m1 = dictOaGroups(t1)-1;
+        _dictOaScanGroup(d,t0,v & m0,fn,privdata);
+        do {
+            _dictOaScanGroup(d,t1,v & m1,fn,privdata);
+            v = (((v | m0) + 1) & ~m0) | (v & m0);
+        } while (v & (m0 ^ m1));
+    }
+
+    v |= ~m0;
+    v = rev(v);
+    v++;
+    v = rev(v);
+    return v;
+}
+
 /* ----------------------------- API implementation ------------------------- */
 
 /* Reset a hash table already initialized with ht_init().
@@ -187,9 +975,11 @@ unsigned int dictGenCaseHashFunction(const unsigned char *buf, int len) {
 static void _dictReset(dictht *ht)
 {
     ht->table = NULL;
+    ht->ctrl = NULL;
     ht->size = 0;
     ht->sizemask = 0;
     ht->used = 0;
+    ht->deleted = 0;
 }
 
 /* Create a new hash table */
@@ -201,9 +991,21 @@ static void _dictReset(dictht *ht)
 dict *dictCreate(dictType *type,
         void *privDataPtr)
 {
+    return dictCreateLayout(type,privDataPtr,DICT_LAYOUT_CHAINED);
+}
+
+/* Create a new hash table using the specified layout, DICT_LAYOUT_CHAINED
+ * or DICT_LAYOUT_OPEN. */
+/*
+ * 创建一个使用指定布局的字典
+ *
+ * T = O(1)
+ */
+dict *dictCreateLayout(dictType *type, void *privDataPtr, int layout) {
     dict *d = zmalloc(sizeof(*d)); //为dict分配内存
 
     _dictInit(d,type,privDataPtr); //初始化dict
+    d->layout = layout;
 
     return d;
 }
@@ -233,6 +1035,12 @@ int _dictInit(dict *d, dictType *type,
     // 设置字典的安全迭代器数量
     d->iterators = 0;
 
+    d->registered = 0;
+    d->rehashing_prev = d->rehashing_next = NULL;
+    d->detached = 0;
+
+    d->layout = DICT_LAYOUT_CHAINED;
+
     return DICT_OK;
 }
 
@@ -281,6 +1089,20 @@ int dictExpand(dict *d, unsigned long size)
     // T = O(1)
     unsigned long realsize = _dictNextPower(size);
 
+    /* Open addressing tables need room for 'size' elements at the max
+     * load factor of 7/8. */
+    // 开放寻址表按 7/8 的最大装载率计算槽位数量
+    if (dictIsOpenAddressing(d)) {
+        if (d->ht[0].used > size) return DICT_ERR;
+        size += size/7;
+        /* Rebuilding a table of the same size is not a resize: the cron
+         * would do it on every run for dicts at the minimal size. */
+        // 新表和 0 号表一样大时不进行 resize
+        if (d->ht[0].ctrl != NULL && _dictOaSlots(size) == d->ht[0].size)
+            return DICT_ERR;
+        return _dictOaExpand(d,size);
+    }
+
     /* the size is invalid if it is smaller than the number of
      * elements already inside the hash table */
     // 不能在字典正在 rehash 时进行
@@ -290,11 +1112,11 @@ int dictExpand(dict *d, unsigned long size)
 
     /* Allocate the new hash table and initialize all pointers to NULL */
     // 为哈希表分配空间，并将所有指针指向 NULL
+    _dictReset(&n);
     n.size = realsize;
     n.sizemask = realsize-1;
-    // T = O(N)
-    n.table = zcalloc(realsize*sizeof(dictEntry*));
-    n.used = 0;
+    // 大表只分配分块指针数组，分块在写入时再分配
+    n.table = _dictTableAlloc(realsize);
 
     /* Is this the first initialization? If so it's not really a rehashing
      * we just set the first hash table so that it can accept keys. */
@@ -311,6 +1133,7 @@ int dictExpand(dict *d, unsigned long size)
     // 并将字典的 rehash 标识打开，让程序可以开始对字典进行 rehash
     d->ht[1] = n;
     d->rehashidx = 0;
+    _dictRehashingStarted(d);
     return DICT_OK;
 
     /* 顺带一提，上面的代码可以重构成以下形式：
@@ -345,28 +1168,50 @@ int dictExpand(dict *d, unsigned long size)
  *
  * T = O(N)
  */
+/* Move the rehashing index of the chained table 'ht' past the bucket it
+ * points to, that is empty. A chunk that is not allocated is skipped as a
+ * whole, and a chunk whose last bucket was passed is freed, as all its
+ * buckets were drained by the rehashing. */
+static void _dictRehashAdvance(dictht *ht, int *rehashidx) {
+    unsigned long idx = *rehashidx;
+
+    if (!dictTableIsChunked(ht)) {
+        (*rehashidx)++;
+        return;
+    }
+    if (_dictBucketAddr(ht,idx) == NULL) {
+        *rehashidx = (idx | (DICT_TABLE_CHUNK-1))+1;
+        return;
+    }
+    if ((idx & (DICT_TABLE_CHUNK-1)) == DICT_TABLE_CHUNK-1)
+        _dictChunkRelease(ht,idx);
+    (*rehashidx)++;
+}
+
 int dictRehash(dict *d, int n) {
     // 只可以在 rehash 进行中时执行
     if (!dictIsRehashing(d)) return 0;
+    if (dictIsOpenAddressing(d)) return _dictOaRehash(d,n);
 
     // 进行 N 步迁移，跳过哪些数组元素为空的位置
     // T = O(N)
     while(n--) {
-        dictEntry *de, *nextde;
+        dictEntry *de, *nextde, **bucket;
 
         /* Check if we already rehashed the whole table... */
         // 如果 0 号哈希表为空，那么表示 rehash 执行完毕；
         //那么释放0号哈希表，将原来的1号设置为0号，然后重置1号哈希表、关闭rehashidx标识
         // T = O(1)
         if (d->ht[0].used == 0) {
-            // 释放 0 号哈希表
-            zfree(d->ht[0].table);
+            // 释放 0 号哈希表（大表交给后台线程释放）
+            _dictTableRelease(d,&d->ht[0],1);
             // 将原来的 1 号哈希表设置为新的 0 号哈希表
             d->ht[0] = d->ht[1];
             // 重置旧的 1 号哈希表
             _dictReset(&d->ht[1]);
-            // 关闭 rehash 标识
+            // 关闭 rehash 标识，从登记表中删除
             d->rehashidx = -1;
+            _dictRehashingStopped(d);
             // 返回 0 ，向调用者表示 rehash 已经完成
             return 0;
         }
@@ -377,10 +1222,10 @@ int dictRehash(dict *d, int n) {
         assert(d->ht[0].size > (unsigned)d->rehashidx);
 
         // 略过数组中为空的索引，找到下一个非空索引
-        while(d->ht[0].table[d->rehashidx] == NULL) d->rehashidx++;
+        // 分块表中未分配的分块整块跳过，已迁移完的分块立即释放
+        while((de = _dictBucket(&d->ht[0],d->rehashidx)) == NULL)
+            _dictRehashAdvance(&d->ht[0],&d->rehashidx);
 
-        // 指向该索引的链表表头节点
-        de = d->ht[0].table[d->rehashidx];
         /* Move all the keys in this bucket from the old to the new hash HT */
         // 将链表中的所有节点迁移到新哈希表
         // T = O(1)
@@ -395,8 +1240,9 @@ int dictRehash(dict *d, int n) {
             h = dictHashKey(d, de->key) & d->ht[1].sizemask;
 
             // 插入节点到新哈希表
-            de->next = d->ht[1].table[h];
-            d->ht[1].table[h] = de;
+            bucket = _dictBucketRef(&d->ht[1],h);
+            de->next = *bucket;
+            *bucket = de;
 
             // 更新计数器
             d->ht[0].used--;
@@ -406,9 +1252,9 @@ int dictRehash(dict *d, int n) {
             de = nextde;
         }
         // 将刚迁移完的哈希表索引的指针设为空
-        d->ht[0].table[d->rehashidx] = NULL;
+        *_dictBucketAddr(&d->ht[0],d->rehashidx) = NULL;
         // 更新 rehash 索引
-        d->rehashidx++;
+        _dictRehashAdvance(&d->ht[0],&d->rehashidx);
     }
 
     return 1; //其实返回1也不一定还有key需要搬迁，可能这次N步搬迁恰好搬完了，留待下次搬迁时再确认了
@@ -444,6 +1290,165 @@ int dictRehashMilliseconds(dict *d, int ms) {
     return rehashes;
 }
 
+/* Return the fraction of the old table already moved by the ongoing
+ * rehashing of 'd', from 0 to 1, or 1 if 'd' is not rehashing.
+ *
+ * 返回正在进行的 rehash 的进度（0 到 1）*/
+double dictRehashProgress(dict *d) {
+    double moved = d->rehashidx;
+
+    if (!dictIsRehashing(d) || d->ht[0].size == 0) return 1;
+    if (dictIsOpenAddressing(d)) moved *= DICT_OA_GROUP;
+    return moved/d->ht[0].size;
+}
+
+/* ------------------------- Rehashing registry -----------------------------
+ *
+ * Every dict starting a rehashing is linked at the tail of a registry,
+ * and unlinked when the rehashing completes or the dict is emptied or
+ * released. dictRehashRegistered() advances the registered dicts from the
+ * head within a time budget, so that big dicts that are rarely accessed
+ * (a huge hash only rehashes one bucket per operation on it) don't stay
+ * with two tables allocated for a long time. A dict that exhausts the
+ * budget is moved to the tail: the next call starts from the next dict.
+ *
+ * The registry is owned by the thread calling dictRehashRegistered(), the
+ * only one resizing dicts. Another thread can release a dict that is no
+ * longer reachable from the owner after calling dictDetach(): this is the
+ * only operation taking the registry mutex from outside the owner, which
+ * holds it while it links, unlinks or rehashes registered dicts.
+ *
+ * 正在 rehash 的字典登记表：字典开始 rehash 时加入表尾，rehash 完成、
+ * 字典被清空或释放时删除。 dictRehashRegistered() 在给定时间内从表头开始
+ * 推进这些字典的 rehash ，用完时间的字典被移到表尾。登记表属于调用
+ * dictRehashRegistered() 的线程，其他线程释放字典前要先调用 dictDetach() 。
+ * -------------------------------------------------------------------------- */
+
+static struct {
+    dict *head, *tail;
+    unsigned long len;
+    pthread_mutex_t mutex;
+    int locked;     /* The owner holds the mutex in dictRehashRegistered(). */
+} dict_rehashing = {NULL,NULL,0,PTHREAD_MUTEX_INITIALIZER,0};
+
+/* Lock and unlock the registry from the owner thread. */
+static void _dictRegistryLock(void) {
+    if (!dict_rehashing.locked) pthread_mutex_lock(&dict_rehashing.mutex);
+}
+
+static void _dictRegistryUnlock(void) {
+    if (!dict_rehashing.locked) pthread_mutex_unlock(&dict_rehashing.mutex);
+}
+
+static void _dictRegistryLink(dict *d) {
+    d->registered = 1;
+    d->rehashing_prev = dict_rehashing.tail;
+    d->rehashing_next = NULL;
+    if (dict_rehashing.tail)
+        dict_rehashing.tail->rehashing_next = d;
+    else
+        dict_rehashing.head = d;
+    dict_rehashing.tail = d;
+    dict_rehashing.len++;
+}
+
+static void _dictRegistryUnlink(dict *d) {
+    if (d->rehashing_prev)
+        d->rehashing_prev->rehashing_next = d->rehashing_next;
+    else
+        dict_rehashing.head = d->rehashing_next;
+    if (d->rehashing_next)
+        d->rehashing_next->rehashing_prev = d->rehashing_prev;
+    else
+        dict_rehashing.tail = d->rehashing_prev;
+    d->registered = 0;
+    d->rehashing_prev = d->rehashing_next = NULL;
+    dict_rehashing.len--;
+}
+
+/* The 'registered' flag of a dict is only changed by its owner, so it can
+ * be tested before locking. */
+static void _dictRehashingStarted(dict *d) {
+    if (d->registered) return;
+    _dictRegistryLock();
+    _dictRegistryLink(d);
+    _dictRegistryUnlock();
+}
+
+static void _dictRehashingStopped(dict *d) {
+    if (!d->registered) return;
+    _dictRegistryLock();
+    _dictRegistryUnlink(d);
+    _dictRegistryUnlock();
+}
+
+/* Prepare 'd' to be released by dictRelease() in a thread other than the
+ * one owning the registry and the table statistics: 'd' is unlinked from
+ * the rehashing registry, and its tables will be freed directly. After
+ * this call 'd' can only be released.
+ *
+ * 让字典可以在其他线程中被 dictRelease() 释放：把字典移出 rehash 登记表，
+ * 之后它的表直接释放，不经过释放钩子和统计。此后字典只能被释放。 */
+void dictDetach(dict *d) {
+    pthread_mutex_lock(&dict_rehashing.mutex);
+    if (d->registered) _dictRegistryUnlink(d);
+    pthread_mutex_unlock(&dict_rehashing.mutex);
+    d->detached = 1;
+}
+
+/* Rehash the registered dicts for about 'usec' microseconds. Dicts with
+ * safe iterators are skipped. Returns 1 if some work was done.
+ *
+ * 在大约 usec 微秒内推进登记表中字典的 rehash ，跳过有安全迭代器的字典 */
+int dictRehashRegistered(long long usec) {
+    long long start = _dictUstime();
+    unsigned long visits;
+    int work_done = 0;
+
+    pthread_mutex_lock(&dict_rehashing.mutex);
+    dict_rehashing.locked = 1;
+    visits = dict_rehashing.len;
+    while(visits-- && dict_rehashing.head) {
+        dict *d = dict_rehashing.head;
+
+        if (d->iterators == 0) {
+            work_done = 1;
+            /* On completion the dict unlinks itself. */
+            while(dictRehash(d,100)) {
+                if (_dictUstime()-start >= usec) break;
+            }
+        }
+        if (d->registered) {
+            /* Out of time or blocked by an iterator: next in line. */
+            _dictRegistryUnlink(d);
+            _dictRegistryLink(d);
+        }
+        if (_dictUstime()-start >= usec) break;
+    }
+    dict_rehashing.locked = 0;
+    pthread_mutex_unlock(&dict_rehashing.mutex);
+    return work_done;
+}
+
+/* Report the number of registered dicts and the number of buckets (or
+ * groups for the open addressing layout) still to move.
+ *
+ * 返回登记表中的字典数量，以及还需要迁移的桶数量 */
+void dictGetRehashBacklog(unsigned long *dicts, unsigned long long *buckets) {
+    dict *d;
+
+    _dictRegistryLock();
+    *dicts = dict_rehashing.len;
+    *buckets = 0;
+    for (d = dict_rehashing.head; d; d = d->rehashing_next) {
+        unsigned long size = d->ht[0].size;
+
+        if (dictIsOpenAddressing(d)) size /= DICT_OA_GROUP;
+        *buckets += size-d->rehashidx;
+    }
+    _dictRegistryUnlock();
+}
+
 /* This function performs just a step of rehashing, and only if there are
  * no safe iterators bound to our hash table. When we have iterators in the
  * middle of a rehashing we can't mess with the two hash tables otherwise
@@ -510,20 +1515,30 @@ int dictAdd(dict *d, void *key, void *val)
  * T = O(N)
  */
 dictEntry *dictAddRaw(dict *d, void *key)
+{
+    return dictAddRawWithHash(d,key,dictHashKey(d, key));
+}
+
+/* Like dictAddRaw(), but 'h' is the hash of 'key' as returned by
+ * dictGetHash(), so callers touching the same key several times hash it
+ * only once. */
+// 和 dictAddRaw() 一样，但使用调用者已经计算好的哈希值 h
+dictEntry *dictAddRawWithHash(dict *d, void *key, unsigned int h)
 {
     int index;
-    dictEntry *entry;
+    dictEntry *entry, **bucket;
     dictht *ht;
 
     // 如果条件允许的话，进行单步 rehash
     // T = O(1)
     if (dictIsRehashing(d)) _dictRehashStep(d);
+    if (dictIsOpenAddressing(d)) return _dictOaAddRaw(d,key,h);
 
     /* Get the index of the new element, or -1 if
      * the element already exists. */
     // 计算键在哈希表中的索引值 如果值为 -1 ，那么表示键已经存在，如果key已存在返回NULL
     // T = O(N)
-    if ((index = _dictKeyIndex(d, key)) == -1)
+    if ((index = _dictKeyIndex(d, key, h)) == -1)
         return NULL;
 
     // T = O(1)
@@ -531,19 +1546,24 @@ dictEntry *dictAddRaw(dict *d, void *key)
     // 如果字典正在 rehash ，那么将新键添加到 1 号哈希表
     // 否则，将新键添加到 0 号哈希表
     ht = dictIsRehashing(d) ? &d->ht[1] : &d->ht[0];
-    // 为新节点分配空间
-    entry = zmalloc(sizeof(*entry));
+    // 为新节点分配空间，嵌入的键紧跟在节点之后
+    if (dictKeyIsEmbedded(d)) {
+        entry = zmalloc(sizeof(*entry)+d->type->keyEmbedLen(key));
+        entry->key = d->type->keyEmbed(entry+1,key);
+    } else {
+        entry = zmalloc(sizeof(*entry));
+        /* Set the hash entry fields. */
+        // 设置新节点的键
+        // T = O(1)
+        dictSetKey(d, entry, key);
+    }
     // 将新节点插入到哈希表的数组中的链表头部
-    entry->next = ht->table[index];
-    ht->table[index] = entry;
+    bucket = _dictBucketRef(ht,index);
+    entry->next = *bucket;
+    *bucket = entry;
     // 更新哈希表已使用节点数量
     ht->used++;
 
-    /* Set the hash entry fields. */
-    // 设置新节点的键
-    // T = O(1)
-    dictSetKey(d, entry, key);
-
     return entry;
 }
 
@@ -582,7 +1602,7 @@ int dictReplace(dict *d, void *key, void *val)
      * reverse. */
     //注意必须先设置新值，然后再释放旧值；这个顺序不能颠倒，例如 假设新的value和旧的value是同一个对象，
     //如果先释放的话可能就有问题了。
-    auxentry = *entry;
+    auxentry.v = entry->v;
     // 然后设置新的值
     // T = O(1)
     dictSetVal(d, entry, val);
@@ -622,9 +1642,10 @@ dictEntry *dictReplaceRaw(dict *d, void *key) {
  *
  * T = O(1)
  */
-static int dictGenericDelete(dict *d, const void *key, int nofree)
+static int dictGenericDelete(dict *d, const void *key, unsigned int h,
+                             int nofree)
 {
-    unsigned int h, idx;
+    unsigned int idx;
     dictEntry *he, *prevHe;
     int table;
 
@@ -633,9 +1654,7 @@ static int dictGenericDelete(dict *d, const void *key, int nofree)
 
     // 进行单步 rehash ，T = O(1)
     if (dictIsRehashing(d)) _dictRehashStep(d);
-
-    // 计算哈希值
-    h = dictHashKey(d, key);
+    if (dictIsOpenAddressing(d)) return _dictOaDelete(d,key,h,nofree);
 
     // 遍历哈希表
     // T = O(1)
@@ -644,7 +1663,7 @@ static int dictGenericDelete(dict *d, const void *key, int nofree)
         // 计算索引值 
         idx = h & d->ht[table].sizemask;
         // 指向该索引上的链表
-        he = d->ht[table].table[idx];
+        he = _dictBucket(&d->ht[table],idx);
         prevHe = NULL;
         // 遍历链表上的所有节点
         // T = O(1)
@@ -660,7 +1679,7 @@ static int dictGenericDelete(dict *d, const void *key, int nofree)
                     prevHe->next = he->next;
                 else
                     //此时目标节点就是链表的头节点
-                    d->ht[table].table[idx] = he->next;
+                    *_dictBucketAddr(&d->ht[table],idx) = he->next;
 
                 // nofree=0，那么释放键、值
                 if (!nofree) {
@@ -696,7 +1715,13 @@ static int dictGenericDelete(dict *d, const void *key, int nofree)
  * T = O(1)
  */
 int dictDelete(dict *ht, const void *key) {
-    return dictGenericDelete(ht,key,0);
+    return dictGenericDelete(ht,key,dictHashKey(ht, key),0);
+}
+
+/* Like dictDelete(), with 'h' the hash of 'key' from dictGetHash(). */
+// 和 dictDelete() 一样，但使用调用者已经计算好的哈希值 h
+int dictDeleteWithHash(dict *ht, const void *key, unsigned int h) {
+    return dictGenericDelete(ht,key,h,0);
 }
 
 /*
@@ -705,7 +1730,7 @@ int dictDelete(dict *ht, const void *key) {
  * T = O(1)
  */
 int dictDeleteNoFree(dict *ht, const void *key) {
-    return dictGenericDelete(ht,key,1);
+    return dictGenericDelete(ht,key,dictHashKey(ht, key),1);
 }
 
 /* Destroy an entire dictionary */
@@ -717,6 +1742,11 @@ int dictDeleteNoFree(dict *ht, const void *key) {
 int _dictClear(dict *d, dictht *ht, void(callback)(void *)) {
     unsigned long i;
 
+    if (dictIsOpenAddressing(d)) {
+        _dictOaClear(d,ht,callback);
+        return DICT_OK;
+    }
+
     /* Free all the elements */
     // 遍历整个哈希表
     // T = O(N)
@@ -726,7 +1756,7 @@ int _dictClear(dict *d, dictht *ht, void(callback)(void *)) {
         if (callback && (i & 65535) == 0) callback(d->privdata);
 
         // 跳过空索引
-        if ((he = ht->table[i]) == NULL) continue;
+        if ((he = _dictBucket(ht,i)) == NULL) continue;
 
         // 遍历删除链表中所有节点
         // T = O(1)
@@ -748,8 +1778,8 @@ int _dictClear(dict *d, dictht *ht, void(callback)(void *)) {
     }
 
     /* Free the table and the allocated cache structure */
-    // 释放哈希表中的数组
-    zfree(ht->table);
+    // 释放哈希表中的数组（大表交给后台线程释放）
+    _dictTableRelease(d,ht,1);
 
     /* Re-initialize the table */
     // 重置哈希表属性
@@ -769,6 +1799,7 @@ void dictRelease(dict *d)
     // 删除0号和1号哈希表中所有节点，重置各项属性
     _dictClear(d,&d->ht[0],NULL);
     _dictClear(d,&d->ht[1],NULL);
+    _dictRehashingStopped(d);
     // 释放整个词典内存
     zfree(d);
 }
@@ -778,19 +1809,15 @@ void dictRelease(dict *d)
  * 找到返回节点，找不到返回 NULL
  * T = O(1)
  */
-dictEntry *dictFind(dict *d, const void *key)
+/* Look up 'key', whose hash is 'h', in both tables. */
+// 在两个哈希表中查找哈希值为 h 的键 key
+static dictEntry *_dictFindHashed(dict *d, const void *key, unsigned int h)
 {
     dictEntry *he;
-    unsigned int h, idx, table;
+    unsigned int idx, table;
 
-    // 0号哈希表为空，直接返回NULL（不管有没有rehash，ht[0]都不应该为空，除非dict为空）
-    if (d->ht[0].size == 0) return NULL; /* We don't have a table at all */
+    if (dictIsOpenAddressing(d)) return _dictOaFind(d,key,h);
 
-    // 如果条件允许的话，进行单步 rehash
-    if (dictIsRehashing(d)) _dictRehashStep(d);
-
-    // 计算键的哈希值
-    h = dictHashKey(d, key);
     // 在字典的哈希表中查找这个键
     // T = O(1)
     for (table = 0; table <= 1; table++) {
@@ -799,7 +1826,7 @@ dictEntry *dictFind(dict *d, const void *key)
         idx = h & d->ht[table].sizemask;
 
         // 遍历给定索引上的链表的所有节点，查找 key
-        he = d->ht[table].table[idx];
+        he = _dictBucket(&d->ht[table],idx);
         // T = O(1)
         while(he) {
             //找到这个key了！
@@ -815,6 +1842,34 @@ dictEntry *dictFind(dict *d, const void *key)
     return NULL;
 }
 
+dictEntry *dictFind(dict *d, const void *key)
+{
+    // 0号哈希表为空，直接返回NULL（不管有没有rehash，ht[0]都不应该为空，除非dict为空）
+    if (d->ht[0].size == 0) return NULL; /* We don't have a table at all */
+
+    // 如果条件允许的话，进行单步 rehash
+    if (dictIsRehashing(d)) _dictRehashStep(d);
+
+    // 计算键的哈希值并查找
+    return _dictFindHashed(d,key,dictHashKey(d, key));
+}
+
+/* Like dictFind(), with 'h' the hash of 'key' from dictGetHash(). */
+// 和 dictFind() 一样，但使用调用者已经计算好的哈希值 h
+dictEntry *dictFindWithHash(dict *d, const void *key, unsigned int h)
+{
+    if (d->ht[0].size == 0) return NULL; /* We don't have a table at all */
+    if (dictIsRehashing(d)) _dictRehashStep(d);
+    return _dictFindHashed(d,key,h);
+}
+
+/* Return the hash of 'key' in 'd', to be passed to the *WithHash()
+ * functions. Dicts using the same hash function share the value. */
+// 计算 key 在字典 d 中的哈希值
+unsigned int dictGetHash(dict *d, const void *key) {
+    return dictHashKey(d, key);
+}
+
 /*
  * 获取包含给定键的节点的值（dictFind内会执行单步rehash）
  * 如果节点不为空，返回节点的值，否则返回 NULL
@@ -828,6 +1883,91 @@ void *dictFetchValue(dict *d, const void *key) {
     return he ? dictGetVal(he) : NULL;
 }
 
+/* Return the entry where the probe for hash 'h' in 'ht' starts: the head
+ * of the bucket, or the first slot with a matching tag. */
+static dictEntry *_dictCandidate(dict *d, dictht *ht, unsigned int h) {
+    if (dictIsOpenAddressing(d)) return _dictOaCandidate(ht,h);
+    return _dictBucket(ht,h & ht->sizemask);
+}
+
+/* Look up 'count' keys at once, storing in entries[j] the entry of keys[j],
+ * or NULL if the key is not in the dict.
+ *
+ * A dictFind() is a chain of dependent cache misses: bucket, entry, key.
+ * Here every key is hashed first, then each level of the chain is
+ * prefetched for all the keys before moving to the next one, so the misses
+ * of different keys overlap instead of being paid one after the other.
+ *
+ * The returned entries are valid only until the next dict operation on
+ * 'd': with the open addressing layout even a lookup can perform a step
+ * of incremental rehashing and move them (see dict.h).
+ *
+ * 批量查找 count 个键，结果保存在 entries 中。
+ * 先计算所有键的哈希值，然后逐级预取桶、节点和键，最后再逐个比对，
+ * 这样不同键的缓存未命中可以重叠。
+ * 返回的节点只在对 d 的下一次操作之前有效。
+ */
+void dictFindBatch(dict *d, void **keys, dictEntry **entries,
+                   unsigned long count)
+{
+    unsigned int h[DICT_FIND_BATCH];
+    dictEntry *he[2][DICT_FIND_BATCH];
+    unsigned long i, j, n;
+    int table, tables;
+
+    if (d->ht[0].size == 0) {
+        for (j = 0; j < count; j++) entries[j] = NULL;
+        return;
+    }
+
+    /* Rehash as much as 'count' dictFind() calls would. */
+    // 和 count 次 dictFind() 一样进行单步 rehash
+    for (j = 0; j < count && dictIsRehashing(d); j++) _dictRehashStep(d);
+    tables = dictIsRehashing(d) ? 2 : 1;
+
+    for (i = 0; i < count; i += n) {
+        n = count-i < DICT_FIND_BATCH ? count-i : DICT_FIND_BATCH;
+
+        /* Hash the keys and prefetch the buckets (or control bytes). */
+        // 计算哈希值，预取桶（或者控制字节）
+        for (j = 0; j < n; j++) {
+            h[j] = dictHashKey(d, keys[i+j]);
+            for (table = 0; table < tables; table++) {
+                dictht *ht = &d->ht[table];
+
+                if (dictIsOpenAddressing(d))
+                    dictPrefetch(ht->ctrl+(h[j] & (dictOaGroups(ht)-1))*
+                                 DICT_OA_GROUP);
+                else if (!dictTableIsChunked(ht))
+                    dictPrefetch(ht->table+(h[j] & ht->sizemask));
+                else
+                    dictPrefetch(_dictBucketAddr(ht,h[j] & ht->sizemask));
+            }
+        }
+
+        /* Prefetch the first entry of every probe. */
+        // 预取每个查找路径上的第一个节点
+        for (table = 0; table < tables; table++) {
+            for (j = 0; j < n; j++) {
+                he[table][j] = _dictCandidate(d,&d->ht[table],h[j]);
+                if (he[table][j]) dictPrefetch(he[table][j]);
+            }
+        }
+
+        /* Prefetch the keys those entries point to. */
+        // 预取节点指向的键
+        for (table = 0; table < tables; table++) {
+            for (j = 0; j < n; j++)
+                if (he[table][j]) dictPrefetch(he[table][j]->key);
+        }
+
+        /* Everything is in flight, resolve the lookups. */
+        // 逐个完成查找
+        for (j = 0; j < n; j++)
+            entries[i+j] = _dictFindHashed(d,keys[i+j],h[j]);
+    }
+}
+
 /* A fingerprint is a 64 bit number that represents the state of the dictionary
  * at a given time, it's just a few dict properties xored together.
  * When an unsafe iterator is initialized, we get the dict fingerprint, and check
@@ -839,10 +1979,10 @@ long long dictFingerprint(dict *d) {
     long long integers[6], hash = 0;
     int j;
 
-    integers[0] = (long) d->ht[0].table;
+    integers[0] = (long) d->ht[0].table ^ (long) d->ht[0].ctrl;
     integers[1] = d->ht[0].size;
     integers[2] = d->ht[0].used;
-    integers[3] = (long) d->ht[1].table;
+    integers[3] = (long) d->ht[1].table ^ (long) d->ht[1].ctrl;
     integers[4] = d->ht[1].size;
     integers[5] = d->ht[1].used;
 
@@ -907,6 +2047,8 @@ dictIterator *dictGetSafeIterator(dict *d) {
  */
 dictEntry *dictNext(dictIterator *iter)
 {
+    if (dictIsOpenAddressing(iter->d)) return _dictOaNext(iter);
+
     while (1) {
 
         // 进入这个if有两种可能：
@@ -942,7 +2084,7 @@ dictEntry *dictNext(dictIterator *iter)
             }
 
             // 如果进行到这里，说明哈希表（可能已经切换到1号哈希表了）并未迭代完，更新节点指针，指向下个索引链表的表头节点
-            iter->entry = ht->table[iter->index];
+            iter->entry = _dictBucket(ht,iter->index);
         } else {
             // 执行到这里，说明程序正在迭代某个链表
             // 将节点指针指向链表的下个节点
@@ -1003,21 +2145,23 @@ dictEntry *dictGetRandomKey(dict *d)
 
     // 进行单步 rehash
     if (dictIsRehashing(d)) _dictRehashStep(d);
+    if (dictIsOpenAddressing(d)) return _dictOaGetRandomKey(d);
 
     // 如果正在 rehash ，那么将 1 号哈希表也作为随机查找的目标。先随机找个链表
     if (dictIsRehashing(d)) {
         // T = O(N)
         do {
             h = random() % (d->ht[0].size+d->ht[1].size);
-            he = (h >= d->ht[0].size) ? d->ht[1].table[h - d->ht[0].size] :
-                                      d->ht[0].table[h];
+            he = (h >= d->ht[0].size) ?
+                 _dictBucket(&d->ht[1],h - d->ht[0].size) :
+                 _dictBucket(&d->ht[0],h);
         } while(he == NULL); //如果找到的链表为空那么重新再找下，直到不为空
     // 否则，只从 0 号哈希表中查找节点
     } else {
         // T = O(N)
         do {
             h = random() & d->ht[0].sizemask;
-            he = d->ht[0].table[h];
+            he = _dictBucket(&d->ht[0],h);
         } while(he == NULL); //如果找到的链表为空那么重新再找下，直到不为空
     }
 
@@ -1070,6 +2214,7 @@ int dictGetRandomKeys(dict *d, dictEntry **des, int count) {
     int stored = 0;
 
     if (dictSize(d) < count) count = dictSize(d); //如果字典中不足count个节点，那么只返回字典节点数个节点
+    if (dictIsOpenAddressing(d)) return _dictOaGetRandomKeys(d,des,count);
     while(stored < count) {
         for (j = 0; j < 2; j++) {
             /* Pick a random point inside the hash table 0 or 1. */
@@ -1080,7 +2225,7 @@ int dictGetRandomKeys(dict *d, dictEntry **des, int count) {
             /* Make sure to visit every bucket by iterating 'size' times. */
             //遍历完整个哈希表，确保获得足够的节点；如果仍然不够那么跳出循环后会继续从下个哈希表中查找
             while(size--) {
-                dictEntry *he = d->ht[j].table[i];
+                dictEntry *he = _dictBucket(&d->ht[j],i);
                 while (he) {
                     /* Collect all the elements of the buckets found non-empty while iterating. */
                     *des = he;
@@ -1258,6 +2403,7 @@ unsigned long dictScan(dict *d,
 
     // 跳过空字典
     if (dictSize(d) == 0) return 0;
+    if (dictIsOpenAddressing(d)) return _dictOaScan(d,v,fn,privdata);
 
     // 迭代只有一个哈希表的字典
     if (!dictIsRehashing(d)) {
@@ -1270,7 +2416,7 @@ unsigned long dictScan(dict *d,
 
         /* Emit entries at cursor */
         // 指向哈希桶
-        de = t0->table[v & m0];
+        de = _dictBucket(t0,v & m0);
         // 遍历桶中的所有节点
         while (de) {
             fn(privdata, de);
@@ -1297,7 +2443,7 @@ unsigned long dictScan(dict *d,
 
         /* Emit entries at cursor */
         // 指向桶，并迭代桶中的所有节点
-        de = t0->table[v & m0];
+        de = _dictBucket(t0,v & m0);
         while (de) {
             fn(privdata, de);
             de = de->next;
@@ -1311,7 +2457,7 @@ unsigned long dictScan(dict *d,
         do {
             /* Emit entries at cursor */
             // 指向桶，并迭代桶中的所有节点
-            de = t1->table[v & m1];
+            de = _dictBucket(t1,v & m1);
             while (de) {
                 fn(privdata, de);
                 de = de->next;
@@ -1346,6 +2492,8 @@ unsigned long dictScan(dict *d,
 static int _dictExpandIfNeeded(dict *d)
 {
     /* Incremental rehashing already in progress. Return. */
+    if (dictIsOpenAddressing(d)) return _dictOaExpandIfNeeded(d);
+
     // 渐进式 rehash 已经在进行了，直接返回
     if (dictIsRehashing(d)) return DICT_OK;
 
@@ -1405,9 +2553,9 @@ static unsigned long _dictNextPower(unsigned long size)
  *
  * T = O(N)
  */
-static int _dictKeyIndex(dict *d, const void *key)
+static int _dictKeyIndex(dict *d, const void *key, unsigned int h)
 {
-    unsigned int h, idx, table;
+    unsigned int idx, table;
     dictEntry *he;
 
     /* Expand the hash table if needed */
@@ -1416,9 +2564,6 @@ static int _dictKeyIndex(dict *d, const void *key)
     if (_dictExpandIfNeeded(d) == DICT_ERR)
         return -1;
 
-    /* Compute the key hash value */
-    // 计算 key 的哈希值
-    h = dictHashKey(d, key);
     // T = O(1)
     for (table = 0; table <= 1; table++) {
 
@@ -1428,7 +2573,7 @@ static int _dictKeyIndex(dict *d, const void *key)
         /* Search if this slot does not already contain the given key */
         // 查找 key 是否存在
         // T = O(1)
-        he = d->ht[table].table[idx];
+        he = _dictBucket(&d->ht[table],idx);
         while(he) {
             //如果存在那么返回1
             if (dictCompareKeys(d, key, he->key))
@@ -1459,6 +2604,7 @@ void dictEmpty(dict *d, void(callback)(void*)) {
     // 重置属性 
     d->rehashidx = -1;
     d->iterators = 0;
+    _dictRehashingStopped(d);
 }
 
 /*
@@ -1502,14 +2648,14 @@ static void _dictPrintStatsHt(dictht *ht) {
     for (i = 0; i < ht->size; i++) {
         dictEntry *he;
 
-        if (ht->table[i] == NULL) {
+        if (_dictBucket(ht,i) == NULL) {
             clvector[0]++;
             continue;
         }
         slots++;
         /* For each hash entry on this slot... */
         chainlen = 0;
-        he = ht->table[i];
+        he = _dictBucket(ht,i);
         while(he) {
             chainlen++;
             he = he->next;
@@ -1534,6 +2680,19 @@ static void _dictPrintStatsHt(dictht *ht) {
 }
 
 void dictPrintStats(dict *d) {
+    // 开放寻址布局没有链表，只打印槽位的使用情况
+    if (dictIsOpenAddressing(d)) {
+        int j;
+
+        for (j = 0; j < 2; j++) {
+            if (d->ht[j].size == 0) continue;
+            printf("Open addressing table %d stats:\n", j);
+            printf(" table size: %ld\n", d->ht[j].size);
+            printf(" number of elements: %ld\n", d->ht[j].used);
+            printf(" deleted slots: %ld\n", d->ht[j].deleted);
+        }
+        return;
+    }
     _dictPrintStatsHt(&d->ht[0]);
     if (dictIsRehashing(d)) {
         printf("-- Rehashing into ht[1]:\n");
@@ -1606,3 +2765,164 @@ dictType dictTypeHeapStringCopyKeyValue = {
     _dictStringDestructor,         /* val destructor */
 };
 #endif
+
+#ifdef DICT_BENCHMARK_MAIN
+/* Hash functions and dict micro benchmark. Build and run with:
+ *
+ *   make dict-benchmark
+ *   make dict-benchmark USE_XXHASH=yes
+ *
+ * Hashes several realistic key distributions with both murmur2 and
+ * xxhash64, then adds, finds and misses the same keys in a dict of every
+ * layout using the hash function selected at build time. An optional
+ * argument sets the number of keys (default 1000000).
+ *
+ * 哈希函数和字典的性能测试：对几种常见的键分布分别计算 murmur2 和 xxhash64
+ * 的耗时，然后使用编译时选择的哈希函数测试字典的添加、命中查找和未命中查找。
+ */
+#include <time.h>
+
+void _redisAssert(char *estr, char *file, int line) {
+    fprintf(stderr,"=== ASSERTION FAILED ===\n==> %s:%d '%s' is not true\n",
+        file,line,estr);
+    _exit(1);
+}
+
+static long long benchUstime(void) {
+    struct timeval tv;
+    gettimeofday(&tv,NULL);
+    return (((long long)tv.tv_sec)*1000000)+tv.tv_usec;
+}
+
+static unsigned int benchHash(const void *key) {
+    return dictGenHashFunction(key,strlen(key));
+}
+
+static int benchKeyCompare(void *privdata, const void *key1, const void *key2) {
+    DICT_NOTUSED(privdata);
+    return strcmp(key1,key2) == 0;
+}
+
+static dictType benchDictType = {
+    benchHash, NULL, NULL, benchKeyCompare, NULL, NULL, NULL, NULL
+};
+
+/* Fill 'keys' with 'count' keys of the given distribution:
+ * 0 = short counters ("key:123456"), 1 = UUIDs, 2 = long namespaced keys,
+ * 3 = a mix of the three. A non zero 'miss' changes the keys so that none
+ * of them is equal to a key generated with miss = 0. */
+static void benchGenKeys(char **keys, long count, int dist, int miss) {
+    static const char *hex = "0123456789abcdef";
+    long j;
+
+    for (j = 0; j < count; j++) {
+        char buf[128];
+        int d = dist == 3 ? (int)(j % 3) : dist;
+
+        if (d == 0) {
+            snprintf(buf,sizeof(buf),"%s:%ld",miss ? "nokey" : "key",j);
+        } else if (d == 1) {
+            int i;
+
+            /* xxxxxxxx-xxxx-4xxx-yxxx-xxxxxxxxxxxx */
+            for (i = 0; i < 36; i++) buf[i] = hex[rand() & 15];
+            buf[8] = buf[13] = buf[18] = buf[23] = '-';
+            buf[14] = miss ? 'm' : '4';
+            buf[36] = '\0';
+        } else {
+            snprintf(buf,sizeof(buf),
+                "%s:tenant:%04ld:user:%08lx:session:%08x:preferences:theme",
+                miss ? "nope" : "app", j % 1000, j, (unsigned) rand());
+        }
+        keys[j] = zstrdup(buf);
+    }
+}
+
+static void benchFreeKeys(char **keys, long count) {
+    long j;
+
+    for (j = 0; j < count; j++) zfree(keys[j]);
+}
+
+static double benchHashNs(unsigned int (*fn)(const void*, int), char **keys,
+                          int *lens, long count)
+{
+    volatile unsigned int sink = 0;
+    long long start = benchUstime();
+    long j;
+    int r;
+
+    for (r = 0; r < 5; r++)
+        for (j = 0; j < count; j++) sink += fn(keys[j],lens[j]);
+    return (double)(benchUstime()-start)*1000/(count*5);
+}
+
+static void benchDict(int layout, char **keys, char **misses, long count) {
+    dict *d = dictCreateLayout(&benchDictType,NULL,layout);
+    long long start;
+    long j, found = 0;
+
+    start = benchUstime();
+    for (j = 0; j < count; j++) dictAdd(d,keys[j],NULL);
+    printf("  %-8s add %6.1f ns",
+        layout == DICT_LAYOUT_OPEN ? "open" : "chained",
+        (double)(benchUstime()-start)*1000/count);
+
+    start = benchUstime();
+    for (j = 0; j < count; j++) found += dictFind(d,keys[j]) != NULL;
+    printf("  find %6.1f ns",(double)(benchUstime()-start)*1000/count);
+
+    start = benchUstime();
+    for (j = 0; j < count; j++) found -= dictFind(d,misses[j]) != NULL;
+    printf("  miss %6.1f ns",(double)(benchUstime()-start)*1000/count);
+    assert(found == (long)dictSize(d));
+
+    start = benchUstime();
+    for (j = 0; j+DICT_FIND_BATCH <= count; j += DICT_FIND_BATCH) {
+        dictEntry *entries[DICT_FIND_BATCH];
+        int i;
+
+        dictFindBatch(d,(void**)keys+j,entries,DICT_FIND_BATCH);
+        for (i = 0; i < DICT_FIND_BATCH; i++) found -= entries[i] != NULL;
+    }
+    printf("  batch find %6.1f ns\n",(double)(benchUstime()-start)*1000/count);
+    dictRelease(d);
+}
+
+int main(int argc, char **argv) {
+    static const char *names[] = {"short", "uuid", "long", "mixed"};
+    long count = argc > 1 ? atol(argv[1]) : 1000000;
+    char **keys = zmalloc(sizeof(char*)*count);
+    char **misses = zmalloc(sizeof(char*)*count);
+    int *lens = zmalloc(sizeof(int)*count);
+    int dist;
+
+    srand(time(NULL));
+    dictSetHashFunctionSeed(rand());
+    printf("%ld keys, dict hash function: %s\n",
+        count, dictGenHashFunctionName());
+
+    for (dist = 0; dist < 4; dist++) {
+        long j, totlen = 0;
+
+        benchGenKeys(keys,count,dist,0);
+        benchGenKeys(misses,count,dist,1);
+        for (j = 0; j < count; j++) {
+            lens[j] = strlen(keys[j]);
+            totlen += lens[j];
+        }
+        printf("%s keys (avg %ld bytes): murmur2 %.1f ns, xxhash64 %.1f ns\n",
+            names[dist], totlen/count,
+            benchHashNs(_dictMurmur2Hash,keys,lens,count),
+            benchHashNs(_dictXXHash64,keys,lens,count));
+        benchDict(DICT_LAYOUT_CHAINED,keys,misses,count);
+        benchDict(DICT_LAYOUT_OPEN,keys,misses,count);
+        benchFreeKeys(keys,count);
+        benchFreeKeys(misses,count);
+    }
+    zfree(keys);
+    zfree(misses);
+    zfree(lens);
+    return 0;
+}
+#endif
@@ -99,6 +99,11 @@ typedef struct dictType {
     // 销毁值的函数
     void (*valDestructor)(void *privdata, void *obj);
 
+    // 可选：把键的副本直接保存在节点的内存中
+    // keyEmbedLen 返回保存键所需的字节数，keyEmbed 把键写入 buf 并返回新键
+    size_t (*keyEmbedLen)(const void *key);
+    void *(*keyEmbed)(void *buf, const void *key);
+
 } dictType;
 
 
@@ -111,7 +116,12 @@ typedef struct dictType {
 typedef struct dictht {
     
     // 哈希表数组
-    dictEntry **table;
+    // 超过 DICT_TABLE_CHUNK 个桶的链地址表是分块的：table 保存的是分块指针数组，
+    // 每个分块在第一次写入时才分配
+    dictEntry **table;      /* Chained: buckets, or chunks if dictTableIsChunked */
+
+    // 开放寻址布局：每个槽位一个控制字节，槽位数组紧跟在控制字节之后
+    unsigned char *ctrl;    /* Open addressing: control bytes, then slots */
 
     // 哈希表大小
     unsigned long size;
@@ -123,6 +133,9 @@ typedef struct dictht {
     // 该哈希表已有节点的数量
     unsigned long used;
 
+    // 开放寻址布局：被删除标记（tombstone）占用的槽位数量
+    unsigned long deleted;  /* Open addressing: slots marked as deleted */
+
 } dictht;
 
 /*
@@ -146,6 +159,16 @@ typedef struct dict {
     // 目前正在运行的安全迭代器的数量
     int iterators; /* number of iterators currently running */
 
+    // 哈希表布局：链地址法或开放寻址法
+    int layout; /* DICT_LAYOUT_CHAINED or DICT_LAYOUT_OPEN */
+
+    // 是否在正在 rehash 的字典登记表中，以及表中的前后字典
+    int registered; /* In the registry of dicts being rehashed */
+    struct dict *rehashing_prev, *rehashing_next;
+
+    // 是否已交给其他线程释放，见 dictDetach()
+    int detached; /* Released by another thread, see dictDetach() */
+
 } dict;
 
 /* If safe is set to 1 this is a safe iterator, that means, you can call
@@ -189,6 +212,53 @@ typedef void (dictScanFunction)(void *privdata, const dictEntry *de);
  */
 #define DICT_HT_INITIAL_SIZE     4
 
+/* Chained tables with more than DICT_TABLE_CHUNK buckets are not allocated
+ * in one go: 'table' is an array of pointers to chunks of DICT_TABLE_CHUNK
+ * buckets, every chunk allocated the first time one of its buckets is
+ * written. Growing a huge keyspace then allocates 512KB at a time as the
+ * rehashing fills the new table, instead of gigabytes in a single call,
+ * and every chunk of the old table is freed as soon as the rehashing has
+ * drained it.
+ *
+ * 桶数量超过 DICT_TABLE_CHUNK 的链地址表分块按需分配，
+ * rehash 时旧表中被迁移完的分块会立即释放。 */
+#define DICT_TABLE_CHUNK_BITS 16
+#define DICT_TABLE_CHUNK (1UL<<DICT_TABLE_CHUNK_BITS)
+#define dictTableIsChunked(ht) ((ht)->size > DICT_TABLE_CHUNK)
+
+/* Statistics about the tables of at least DICT_TABLE_CHUNK buckets (and
+ * their chunks), that are the ones whose allocation and release can be
+ * noticed as latency. See dictGetTableStats().
+ *
+ * 大表（以及分块）的分配和释放统计信息 */
+typedef struct dictTableStats {
+    unsigned long long stall_usec;      /* Time spent allocating / freeing. */
+    long long stall_max_usec;           /* Longest single allocation / free. */
+    unsigned long long chunks;          /* Chunks allocated. */
+    unsigned long long freed_async;     /* Tables passed to the free hook. */
+} dictTableStats;
+
+/* Hash table layouts.
+ *
+ * DICT_LAYOUT_CHAINED is the classic layout: an array of buckets, every
+ * element is a separately allocated dictEntry linked in its bucket.
+ *
+ * DICT_LAYOUT_OPEN stores the key and the value of every element directly
+ * inside the table, in groups of DICT_OA_GROUP slots, each with a control
+ * byte holding 7 bits of the hash: a lookup compares all the control bytes
+ * of a group at once and only touches the slots whose tag matches. The
+ * dictEntry pointers returned by the API point inside the table, so only
+ * the key and v fields are valid (there is no 'next'), and a pointer is
+ * valid only until the next operation that can rehash or resize the dict.
+ * Safe iterators allow deleting elements, but not adding them.
+ *
+ * 哈希表布局：链地址法（默认），或者开放寻址法。
+ * 开放寻址法把键和值直接保存在表中，每 16 个槽位一组，
+ * 每个槽位有一个保存哈希值 7 位标签的控制字节，查找时一次比较一组控制字节。 */
+#define DICT_LAYOUT_CHAINED 0
+#define DICT_LAYOUT_OPEN 1
+#define DICT_OA_GROUP 16
+
 /* ------------------------------- Macros ------------------------------------*/
 // 释放给定字典节点的值
 #define dictFreeVal(d, entry) \
@@ -211,9 +281,17 @@ typedef void (dictScanFunction)(void *privdata, const dictEntry *de);
 #define dictSetUnsignedIntegerVal(entry, _val_) \
     do { entry->v.u64 = _val_; } while(0)
 
+/* Chained dicts whose type provides keyEmbed store a copy of every key in
+ * the same allocation of its entry: such keys are released together with
+ * the entry and never passed to keyDestructor. Open addressing tables have
+ * no per entry allocation and always use keyDup / keyDestructor. */
+// 键是否被嵌入在节点的内存中
+#define dictKeyIsEmbedded(d) \
+    ((d)->type->keyEmbed != NULL && !dictIsOpenAddressing(d))
+
 // 释放给定字典节点的键
 #define dictFreeKey(d, entry) \
-    if ((d)->type->keyDestructor) \
+    if ((d)->type->keyDestructor && !dictKeyIsEmbedded(d)) \
         (d)->type->keyDestructor((d)->privdata, (entry)->key)
 
 // 设置给定字典节点的键
@@ -246,18 +324,37 @@ typedef void (dictScanFunction)(void *privdata, const dictEntry *de);
 #define dictSize(d) ((d)->ht[0].used+(d)->ht[1].used)
 // 查看字典是否正在 rehash，不等于-1就是正在rehash
 #define dictIsRehashing(ht) ((ht)->rehashidx != -1)
+// 字典是否使用开放寻址布局
+#define dictIsOpenAddressing(d) ((d)->layout == DICT_LAYOUT_OPEN)
+
+/* Keys hashed and prefetched together by a single dictFindBatch() pass. */
+#define DICT_FIND_BATCH 16
+
+// 把 addr 所在的缓存行提前载入 CPU 缓存
+#if defined(__GNUC__)
+#define dictPrefetch(addr) __builtin_prefetch(addr)
+#else
+#define dictPrefetch(addr) ((void)(addr))
+#endif
 
 /* API */
 dict *dictCreate(dictType *type, void *privDataPtr);
+dict *dictCreateLayout(dictType *type, void *privDataPtr, int layout);
 int dictExpand(dict *d, unsigned long size);
 int dictAdd(dict *d, void *key, void *val);
 dictEntry *dictAddRaw(dict *d, void *key);
+dictEntry *dictAddRawWithHash(dict *d, void *key, unsigned int h);
 int dictReplace(dict *d, void *key, void *val);
 dictEntry *dictReplaceRaw(dict *d, void *key);
 int dictDelete(dict *d, const void *key);
+int dictDeleteWithHash(dict *d, const void *key, unsigned int h);
 int dictDeleteNoFree(dict *d, const void *key);
 void dictRelease(dict *d);
 dictEntry * dictFind(dict *d, const void *key);
+dictEntry *dictFindWithHash(dict *d, const void *key, unsigned int h);
+unsigned int dictGetHash(dict *d, const void *key);
+void dictFindBatch(dict *d, void **keys, dictEntry **entries,
+                   unsigned long count);
 void *dictFetchValue(dict *d, const void *key);
 int dictResize(dict *d);
 dictIterator *dictGetIterator(dict *d);
@@ -268,6 +365,7 @@ dictEntry *dictGetRandomKey(dict *d);
 int dictGetRandomKeys(dict *d, dictEntry **des, int count);
 void dictPrintStats(dict *d);
 unsigned int dictGenHashFunction(const void *key, int len);
+const char *dictGenHashFunctionName(void);
 unsigned int dictGenCaseHashFunction(const unsigned char *buf, int len);
 void dictEmpty(dict *d, void(callback)(void*));
 void dictEnableResize(void);
@@ -277,6 +375,14 @@ int dictRehashMilliseconds(dict *d, int ms);
 void dictSetHashFunctionSeed(unsigned int initval);
 unsigned int dictGetHashFunctionSeed(void);
 unsigned long dictScan(dict *d, unsigned long v, dictScanFunction *fn, void *privdata);
+double dictRehashProgress(dict *d);
+int dictRehashRegistered(long long usec);
+void dictGetRehashBacklog(unsigned long *dicts, unsigned long long *buckets);
+void dictDetach(dict *d);
+void dictSetTableFreeHook(void (*hook)(void *table, unsigned long chunks));
+void dictFreeTableMemory(void *table, unsigned long chunks);
+void dictGetTableStats(dictTableStats *stats);
+void dictResetTableStats(void);
 
 /* Hash table types */
 extern dictType dictTypeHeapStringCopyKey;
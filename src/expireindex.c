@@ -0,0 +1,197 @@
+/* Expire index: keys with an expire ordered by deadline.
+ *
+ * activeExpireCycle() normally samples random keys of db->expires, and
+ * keeps going only while more than 25% of the sampled keys are expired. When
+ * just a small share of a big keyspace is expired at a given time, the
+ * expired keys are found slowly and use memory for a long time, while the
+ * sampling still spends the time budget of the cycle.
+ *
+ * With active-expire-index enabled every database also indexes its keys with
+ * an expire by deadline, in slots of 2^REDIS_EXPIRE_INDEX_SLOT_BITS
+ * milliseconds: db->expire_index maps the slot number to the set of keys
+ * expiring in that slot. A per database cursor points to the first slot not
+ * yet processed, and the active expire cycle walks the slots from the cursor
+ * to the current time, expiring their keys. The cost is proportional to the
+ * keys actually expiring, plus a lookup for every elapsed slot.
+ *
+ * A key is always stored in the slot max(slot of its expire, cursor): keys
+ * added with an expire already in the past go to the cursor slot, as every
+ * slot before the cursor was emptied already. All the keys of the slots
+ * before the current time are expired, so the cursor only stops in the
+ * current slot (or when the time budget is over), and the slot of a key can
+ * always be computed again from its expire when it is removed.
+ *
+ * 过期索引：按过期时间排序的带过期时间的键。
+ * 每个数据库把带过期时间的键按过期时间划分到固定长度的时间槽中，
+ * db->expire_index 把槽号映射为在这个槽中过期的键的集合。
+ * 定期删除从游标所在的槽开始，依次处理到当前时间为止的所有槽，
+ * 开销只和真正过期的键的数量成正比。
+ *
+ * Copyright (c) 2009-2012, Salvatore Sanfilippo <antirez at gmail dot com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "redis.h"
+
+/* Slot numbers are relative to the slot of the server start time, so that
+ * they fit an unsigned long, used as the key of db->expire_index. */
+// 槽号相对于服务器启动时间所在的槽，这样可以直接作为字典的键
+static long long expire_index_base = 0;
+
+static unsigned int expireSlotHash(const void *key) {
+    unsigned long slot = (unsigned long)key;
+
+    return dictGenHashFunction(&slot,sizeof(slot));
+}
+
+static void expireSlotDestructor(void *privdata, void *val) {
+    REDIS_NOTUSED(privdata);
+
+    if (val) dictRelease(val);
+}
+
+/* Slot number -> dict of the keys expiring in the slot. The keys of the
+ * slot dicts are the sds strings of the main dict (keyptrDictType). */
+dictType expireIndexDictType = {
+    expireSlotHash,             /* hash function */
+    NULL,                       /* key dup */
+    NULL,                       /* val dup */
+    NULL,                       /* key compare */
+    NULL,                       /* key destructor */
+    expireSlotDestructor        /* val destructor */
+};
+
+/* Called by initServer() before the databases are created. */
+void expireIndexInit(void) {
+    expire_index_base = mstime() >> REDIS_EXPIRE_INDEX_SLOT_BITS;
+}
+
+/* Create the expire index of a database, or return NULL if the index is
+ * not enabled. */
+dict *expireIndexCreate(void) {
+    if (!server.active_expire_index) return NULL;
+    return dictCreate(&expireIndexDictType,NULL);
+}
+
+/* Return the slot of a key expiring at the unix time 'when' in
+ * milliseconds. */
+// 返回在 when 毫秒过期的键所在的槽
+static unsigned long expireIndexSlot(redisDb *db, long long when) {
+    long long slot = (when >> REDIS_EXPIRE_INDEX_SLOT_BITS) - expire_index_base;
+
+    if (slot < (long long)db->expire_index_cursor)
+        return db->expire_index_cursor;
+    if ((unsigned long long)slot > ULONG_MAX) return ULONG_MAX;
+    return slot;
+}
+
+/* Index 'key', a sds string of the main dict, expiring at 'when'. */
+// 把在 when 过期的键 key 加入索引
+void expireIndexAdd(redisDb *db, sds key, long long when) {
+    void *slot = (void*)expireIndexSlot(db,when);
+    dictEntry *de;
+
+    de = dictFind(db->expire_index,slot);
+    if (de == NULL) {
+        de = dictAddRaw(db->expire_index,slot);
+        dictSetVal(db->expire_index,de,dictCreate(&keyptrDictType,NULL));
+    }
+    dictAdd(dictGetVal(de),key,NULL);
+}
+
+/* Remove 'key', expiring at 'when', from the index. */
+// 从索引中删除在 when 过期的键 key
+void expireIndexDelete(redisDb *db, sds key, long long when) {
+    unsigned long slot = expireIndexSlot(db,when);
+    dictEntry *de;
+    dict *keys;
+
+    de = dictFind(db->expire_index,(void*)slot);
+    if (de == NULL) return;
+    keys = dictGetVal(de);
+    dictDelete(keys,key);
+
+    /* The slot of the cursor may be iterated by expireIndexCycle(): the
+     * cycle itself releases it once empty. */
+    // 游标所在的槽可能正在被遍历，由 expireIndexCycle() 释放
+    if (dictSize(keys) == 0 && slot != db->expire_index_cursor)
+        dictDelete(db->expire_index,(void*)slot);
+}
+
+/* Remove all the keys from the index, when the database is emptied. */
+void expireIndexEmpty(redisDb *db) {
+    dictEmpty(db->expire_index,NULL);
+}
+
+/* Expire the keys of 'db' whose deadline is due, in deadline order,
+ * running until 'start'+'timelimit' (in microseconds) at most. Returns
+ * REDIS_ERR if the time limit was reached, REDIS_OK if all the due keys
+ * were expired.
+ *
+ * 按过期时间的顺序删除 db 中已经过期的键，超过时间限制时返回 REDIS_ERR */
+int expireIndexCycle(redisDb *db, long long start, long long timelimit) {
+    long long now = mstime();
+    unsigned long nowslot = expireIndexSlot(db,now);
+    unsigned long checked = 0;
+
+    while(db->expire_index_cursor <= nowslot) {
+        void *slot = (void*)db->expire_index_cursor;
+        dictEntry *de, *kde;
+        dictIterator *di;
+        dict *keys;
+
+        de = dictFind(db->expire_index,slot);
+        if (de) {
+            keys = dictGetVal(de);
+
+            /* Expiring a key removes it from 'keys' through
+             * expireIndexDelete(), that the safe iterator allows. */
+            di = dictGetSafeIterator(keys);
+            while((kde = dictNext(di)) != NULL) {
+                dictEntry *ede = dictFind(db->expires,dictGetKey(kde));
+
+                redisAssert(ede != NULL);
+                activeExpireCycleTryExpire(db,ede,now);
+                if ((++checked & 0xf) == 0 && ustime()-start > timelimit) {
+                    dictReleaseIterator(di);
+                    return REDIS_ERR;
+                }
+            }
+            dictReleaseIterator(di);
+
+            /* Keys of the current slot not due yet stay there. */
+            // 当前槽中还没过期的键留在槽中，等待下次处理
+            if (dictSize(keys) != 0) break;
+            dictDelete(db->expire_index,slot);
+        }
+        if (db->expire_index_cursor == nowslot) break;
+        db->expire_index_cursor++;
+        if ((db->expire_index_cursor & 0xff) == 0 &&
+            ustime()-start > timelimit) return REDIS_ERR;
+    }
+    return REDIS_OK;
+}
@@ -0,0 +1,295 @@
+/* Release of big values in a background thread.
+ *
+ * Deleting a set, a hash, a sorted set or a list with millions of elements,
+ * or flushing a big database, takes seconds, because every element is a
+ * separate allocation. Commands like UNLINK and FLUSHALL ASYNC unlink the
+ * value from the keyspace in the main thread, that is O(1), and leave the
+ * release of the memory to the REDIS_BIO_LAZY_FREE bio thread.
+ *
+ * The elements of an aggregate value may be shared with other values, or
+ * be shared objects like the small integers: the reference count of such
+ * objects is modified by the main thread without locking, so the lazyfree
+ * thread can't decrement it. It frees the objects it holds the only
+ * references to, and hands the other references back to the main thread,
+ * that drops them in lazyfreeReleaseDeferred(). An object only referenced
+ * by the value being freed can't become reachable again, so testing its
+ * reference count without locking is safe.
+ *
+ * 在后台线程中释放大的值对象。 UNLINK 和 FLUSHALL ASYNC 等命令在主线程中
+ * 把值从键空间移除，再由 REDIS_BIO_LAZY_FREE 线程释放内存。
+ * 聚合值的元素可能被其他对象共享，后台线程只释放它持有唯一引用的元素，
+ * 其余的引用交还给主线程，由 lazyfreeReleaseDeferred() 释放。
+ *
+ * Copyright (c) 2009-2012, Salvatore Sanfilippo <antirez at gmail dot com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "redis.h"
+#include "bio.h"
+
+// 等待后台线程释放的对象数量（被清空的数据库按键的数量计算）
+static size_t lazyfree_objects = 0;
+
+// 后台线程交还给主线程的引用，以及保护它的互斥锁
+static list *lazyfree_deferred = NULL;
+static pthread_mutex_t lazyfree_deferred_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// 后台线程正在处理的任务中积累的引用，只被后台线程访问
+static list *lazyfree_bio_deferred = NULL;
+
+/* Return the number of objects (or keys of flushed databases) waiting to
+ * be released by the lazyfree thread. */
+size_t lazyfreeGetPendingObjectsCount(void) {
+    return __sync_add_and_fetch(&lazyfree_objects,0);
+}
+
+/* Return the amount of work needed to free 'o': the number of allocations
+ * for the aggregate encodings, 1 for the encodings using a single block,
+ * that are released faster in place than by a background job.
+ *
+ * 返回释放对象需要的工作量：聚合编码为分配的次数，单块内存的编码为 1 */
+size_t lazyfreeGetFreeEffort(robj *o) {
+    if (o->type == REDIS_LIST && o->encoding == REDIS_ENCODING_LINKEDLIST) {
+        return listLength((list*)o->ptr);
+    } else if (o->type == REDIS_LIST && o->encoding == REDIS_ENCODING_QUICKLIST) {
+        return quicklistNodes((quicklist*)o->ptr);
+    } else if (o->type == REDIS_SET && o->encoding == REDIS_ENCODING_HT) {
+        return dictSize((dict*)o->ptr);
+    } else if (o->type == REDIS_ZSET && o->encoding == REDIS_ENCODING_SKIPLIST){
+        return ((zset*)o->ptr)->zsl->length;
+    } else if (o->type == REDIS_HASH && o->encoding == REDIS_ENCODING_HT) {
+        return dictSize((dict*)o->ptr);
+    } else {
+        return 1;
+    }
+}
+
+/* Release the reference of the caller to 'o', an object no longer reachable
+ * from the keyspace. Big values only referenced by the caller are passed to
+ * the lazyfree thread, the others are released in place.
+ *
+ * 释放调用者对 o 的引用：调用者持有唯一引用的大对象交给后台线程释放 */
+void freeObjAsync(robj *o) {
+    if (o->refcount == 1 &&
+        lazyfreeGetFreeEffort(o) > REDIS_LAZYFREE_THRESHOLD)
+    {
+        __sync_add_and_fetch(&lazyfree_objects,1);
+        bioCreateBackgroundJob(REDIS_BIO_LAZY_FREE,o,NULL,NULL);
+    } else {
+        decrRefCount(o);
+    }
+}
+
+/* Empty 'db' replacing its dictionaries with new ones: the old ones are
+ * released by the lazyfree thread.
+ *
+ * 用新的字典替换数据库的 dict 、 expires 和过期索引，旧字典交给后台线程释放 */
+void emptyDbAsync(redisDb *db) {
+    dict *oldht = db->dict, *oldexpires = db->expires;
+
+    db->dict = dictCreateLayout(oldht->type,NULL,oldht->layout);
+    db->expires = dictCreateLayout(oldexpires->type,NULL,oldexpires->layout);
+    __sync_add_and_fetch(&lazyfree_objects,dictSize(oldht));
+    bioCreateBackgroundJob(REDIS_BIO_LAZY_FREE,NULL,oldht,oldexpires);
+
+    /* The expire index only references the keys, it is released by a job
+     * of its own. */
+    if (db->expire_index) {
+        dict *oldindex = db->expire_index;
+
+        db->expire_index = dictCreate(oldindex->type,NULL);
+        bioCreateBackgroundJob(REDIS_BIO_LAZY_FREE,NULL,oldindex,NULL);
+    }
+}
+
+/* Drop the references to objects handed back by the lazyfree thread. Called
+ * by the main thread in serverCron().
+ *
+ * 释放后台线程交还的引用，由主线程在 serverCron() 中调用 */
+void lazyfreeReleaseDeferred(void) {
+    list *deferred;
+    listIter li;
+    listNode *ln;
+
+    pthread_mutex_lock(&lazyfree_deferred_mutex);
+    deferred = lazyfree_deferred;
+    lazyfree_deferred = NULL;
+    pthread_mutex_unlock(&lazyfree_deferred_mutex);
+    if (deferred == NULL) return;
+
+    listRewind(deferred,&li);
+    while((ln = listNext(&li))) decrRefCount(listNodeValue(ln));
+    listRelease(deferred);
+}
+
+/* ---------------------- Lazyfree thread side ----------------------------- */
+
+static void lazyfreeFreeObject(robj *o);
+
+/* Drop the 'refs' references the lazyfree thread holds to 'o': free it if
+ * nobody else references it, otherwise hand the references back to the
+ * main thread. */
+// 释放后台线程持有的 refs 个引用：没有其他引用时直接释放对象，否则交还给主线程
+static void lazyfreeDropRefs(robj *o, int refs) {
+    if (o->refcount == refs) {
+        lazyfreeFreeObject(o);
+    } else {
+        if (lazyfree_bio_deferred == NULL) lazyfree_bio_deferred = listCreate();
+        while(refs--) listAddNodeTail(lazyfree_bio_deferred,o);
+    }
+}
+
+static void lazyfreeListElementFree(void *o) {
+    lazyfreeDropRefs(o,1);
+}
+
+static void lazyfreeDictObjectDestructor(void *privdata, void *o) {
+    REDIS_NOTUSED(privdata);
+
+    if (o != NULL) lazyfreeDropRefs(o,1);
+}
+
+/* Release a dict with the given destructors instead of the ones of its
+ * type, that would decrement the reference counts of its elements. */
+// 使用指定的析构函数释放字典
+static void lazyfreeReleaseDict(dict *d,
+    void (*keyDestructor)(void *privdata, void *key),
+    void (*valDestructor)(void *privdata, void *val))
+{
+    dictType type = *d->type;
+
+    type.keyDestructor = keyDestructor;
+    type.valDestructor = valDestructor;
+    dictDetach(d);
+    d->type = &type;
+    dictRelease(d);
+}
+
+/* Free 'o', whose references are all held by the lazyfree thread. */
+// 释放对象 o ，它的所有引用都由后台线程持有
+static void lazyfreeFreeObject(robj *o) {
+    zset *zs;
+    zskiplistNode *node, *next;
+
+    switch(o->type) {
+    case REDIS_STRING:
+        freeStringObject(o);
+        break;
+    case REDIS_LIST:
+        if (o->encoding == REDIS_ENCODING_LINKEDLIST) {
+            listSetFreeMethod((list*)o->ptr,lazyfreeListElementFree);
+            listRelease(o->ptr);
+        } else {
+            freeListObject(o);
+        }
+        break;
+    case REDIS_SET:
+        if (o->encoding == REDIS_ENCODING_HT)
+            lazyfreeReleaseDict(o->ptr,lazyfreeDictObjectDestructor,NULL);
+        else
+            freeSetObject(o);
+        break;
+    case REDIS_ZSET:
+        if (o->encoding == REDIS_ENCODING_SKIPLIST) {
+            /* Every element is referenced by both the dict and the
+             * skiplist: drop the two references while walking the
+             * skiplist. */
+            zs = o->ptr;
+            lazyfreeReleaseDict(zs->dict,NULL,NULL);
+            node = zs->zsl->header->level[0].forward;
+            while(node) {
+                next = node->level[0].forward;
+                lazyfreeDropRefs(node->obj,2);
+                zfree(node);
+                node = next;
+            }
+            zfree(zs->zsl->header);
+            zfree(zs->zsl);
+            zfree(zs);
+        } else {
+            freeZsetObject(o);
+        }
+        break;
+    case REDIS_HASH:
+        if (o->encoding == REDIS_ENCODING_HT)
+            lazyfreeReleaseDict(o->ptr,lazyfreeDictObjectDestructor,
+                                lazyfreeDictObjectDestructor);
+        else
+            freeHashObject(o);
+        break;
+    default:
+        redisPanic("Unknown object type");
+        break;
+    }
+    zfree(o);
+}
+
+/* Hand the references collected by the current job to the main thread. */
+// 把当前任务积累的引用交给主线程
+static void lazyfreeFlushDeferred(void) {
+    if (lazyfree_bio_deferred == NULL) return;
+    pthread_mutex_lock(&lazyfree_deferred_mutex);
+    if (lazyfree_deferred == NULL) {
+        lazyfree_deferred = lazyfree_bio_deferred;
+    } else {
+        listJoin(lazyfree_deferred,lazyfree_bio_deferred);
+        listRelease(lazyfree_bio_deferred);
+    }
+    pthread_mutex_unlock(&lazyfree_deferred_mutex);
+    lazyfree_bio_deferred = NULL;
+}
+
+/* Job of freeObjAsync(). */
+void lazyfreeFreeObjectFromBioThread(robj *o) {
+    lazyfreeFreeObject(o);
+    lazyfreeFlushDeferred();
+    __sync_sub_and_fetch(&lazyfree_objects,1);
+}
+
+static void lazyfreeExpireSlotDestructor(void *privdata, void *keys) {
+    REDIS_NOTUSED(privdata);
+
+    if (keys != NULL) lazyfreeReleaseDict(keys,NULL,NULL);
+}
+
+/* Job of emptyDbAsync() for the expire index: the slot dicts only hold
+ * pointers to the keys, the keys themselves are not accessed. */
+void lazyfreeFreeExpireIndexFromBioThread(dict *index) {
+    lazyfreeReleaseDict(index,NULL,lazyfreeExpireSlotDestructor);
+}
+
+/* Job of emptyDbAsync(). The keys are shared by the two dicts and owned by
+ * the main one. */
+void lazyfreeFreeDatabaseFromBioThread(dict *ht, dict *expires) {
+    size_t numkeys = dictSize(ht);
+
+    lazyfreeReleaseDict(expires,NULL,NULL);
+    lazyfreeReleaseDict(ht,ht->type->keyDestructor,
+                        lazyfreeDictObjectDestructor);
+    lazyfreeFlushDeferred();
+    __sync_sub_and_fetch(&lazyfree_objects,numkeys);
+}
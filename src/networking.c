@@ -32,14 +32,20 @@
 #include <math.h>
 
 static void setProtocolError(redisClient *c, int pos);
+static void logClientProtocolError(redisClient *c);
+static int postponeClientRead(redisClient *c);
+
+/* Set while processEventsWhileBlocked() runs: reads are never postponed
+ * to the I/O threads in that context. */
+static int ProcessingEventsWhileBlocked = 0;
 
 /* To evaluate the output buffer size of a client we need to get size of
  * allocated objects, however we can't used zmalloc_size() directly on sds
  * strings because of the trick they use to work (the header is before the
  * returned pointer), so we use this helper function. */
-// 计算输出缓冲区的大小：将sds前移sdshdr，然后取出前缀prefix，是分配的内存大小
+// 计算输出缓冲区的大小：sdsAllocPtr 找到头部（分配的起始地址），然后取出分配的内存大小
 size_t zmalloc_size_sds(sds s) {
-    return zmalloc_size(s-sizeof(struct sdshdr));
+    return zmalloc_size(sdsAllocPtr(s));
 }
 
 /* Return the amount of memory used by the sds string at object->ptr
@@ -73,12 +79,111 @@ int listMatchObjects(void *a, void *b) {
     return equalStringObjects(a,b);
 }
 
+/* ------------------------------ Client pool --------------------------------
+ *
+ * Closed clients are not returned to the allocator: they are reset and kept
+ * in server.client_pool (up to client-pool-size entries), together with
+ * their 16KB static reply buffer, query buffer, reply list and the other
+ * containers created with the client. createClient() takes a client from
+ * the pool when possible, so that connection churn does not cost a
+ * malloc()/free() of the whole structure for every connection.
+ *
+ * 客户端池：关闭的客户端被重置后保存在 server.client_pool 中，
+ * 连同它的回复缓冲区、查询缓冲区以及各个链表和字典一起复用，
+ * 避免大量短连接反复分配和释放客户端结构 */
+
+/* Allocate a client structure together with the containers that are
+ * preserved while the client sits in the pool. */
+// 分配一个新的客户端结构，以及它的查询缓冲区、回复链表等容器
+static redisClient *allocClient(void) {
+    redisClient *c = zmalloc(sizeof(redisClient));
+
+    // 查询缓冲区
+    c->querybuf = sdsempty();
+    // 回复链表
+    c->reply = listCreate();
+    // 回复链表的释放和复制函数
+    listSetFreeMethod(c->reply,decrRefCountVoid);//节点释放函数是减少引用计数，如果引用计数等于0了，那么根据对象类型释放相应对象
+    listSetDupMethod(c->reply,dupClientReplyValue);//节点复制函数，增加对象引用计数
+    // 造成客户端阻塞的列表键
+    c->bpop.keys = dictCreate(&setDictType,NULL);
+    // 进行事务时监视的键
+    c->watched_keys = listCreate();
+    // 订阅的频道和模式
+    c->pubsub_channels = dictCreate(&setDictType,NULL);
+    c->pubsub_patterns = listCreate();
+    listSetFreeMethod(c->pubsub_patterns,decrRefCountVoid);
+    listSetMatchMethod(c->pubsub_patterns,listMatchObjects);
+    return c;
+}
+
+/* Release a client structure and its containers. */
+// 释放客户端结构本身，以及 allocClient() 创建的容器
+static void deallocClient(redisClient *c) {
+    sdsfree(c->querybuf);
+    listRelease(c->reply);
+    dictRelease(c->bpop.keys);
+    listRelease(c->watched_keys);
+    dictRelease(c->pubsub_channels);
+    listRelease(c->pubsub_patterns);
+    zfree(c);
+}
+
+/* Return a reset client from the pool, or allocate a new one if the
+ * pool is empty. */
+// 从客户端池中取出一个客户端，池为空时分配新的客户端
+static redisClient *clientPoolGet(void) {
+    if (server.client_pool_len > 0) {
+        server.stat_client_pool_hits++;
+        return server.client_pool[--server.client_pool_len];
+    }
+    server.stat_client_pool_misses++;
+    return allocClient();
+}
+
+/* Reset the containers of a client that is no longer in use and put it
+ * back in the pool. If the pool is full the client is released. */
+// 重置客户端并放回池中，池已满时直接释放
+static void clientPoolPut(redisClient *c) {
+    if (server.client_pool_len >= server.client_pool_size) {
+        deallocClient(c);
+        return;
+    }
+
+    /* Don't keep query buffers that grew because of big arguments, the
+     * pool should retain at most a few KB per client. */
+    // 查询缓冲区太大时不保留，以免池占用过多内存
+    if (sdsAllocSize(c->querybuf) > REDIS_MBULK_BIG_ARG) {
+        sdsfree(c->querybuf);
+        c->querybuf = sdsempty();
+    } else {
+        sdsclear(c->querybuf);
+    }
+    listEmpty(c->reply);
+    dictEmpty(c->bpop.keys,NULL);
+    listEmpty(c->watched_keys);
+    dictEmpty(c->pubsub_channels,NULL);
+    listEmpty(c->pubsub_patterns);
+    server.client_pool[server.client_pool_len++] = c;
+}
+
+/* Set the max number of clients retained by the pool, releasing the
+ * clients that no longer fit. Called at startup and by CONFIG SET. */
+// 设置客户端池的容量，释放超出新容量的客户端
+void clientPoolResize(int size) {
+    while (server.client_pool_len > size)
+        deallocClient(server.client_pool[--server.client_pool_len]);
+    server.client_pool = zrealloc(server.client_pool,
+        sizeof(redisClient*)*(size ? size : 1));
+    server.client_pool_size = size;
+}
+
 /*
  * 创建一个新客户端
  */
 redisClient *createClient(int fd) {
-    // 分配空间
-    redisClient *c = zmalloc(sizeof(redisClient));
+    // 从客户端池中取出，或者分配空间
+    redisClient *c = clientPoolGet();
 
     /* passing -1 as fd it is possible to create a non connected client.
      * This is useful since all the Redis commands needs to be executed
@@ -102,12 +207,14 @@ redisClient *createClient(int fd) {
             readQueryFromClient, c) == AE_ERR)
         {
             close(fd);
-            zfree(c);
+            clientPoolPut(c);
             return NULL;
         }
     }
 
     // 初始化各个属性
+    // 查询缓冲区、回复链表、阻塞键、WATCH 键以及订阅信息
+    // 由 allocClient() 创建，从池中取出时已经是空的
 
     // 设置默认数据库，设置redisClient的db指向server的0号db
     selectDb(c,0);
@@ -117,10 +224,11 @@ redisClient *createClient(int fd) {
     c->name = NULL;
     // 回复缓冲区的偏移量
     c->bufpos = 0;
-    // 查询缓冲区
-    c->querybuf = sdsempty();
     // 查询缓冲区峰值
     c->querybuf_peak = 0;
+    // 读取查询缓冲区失败的原因
+    c->read_error = REDIS_READ_ERR_NONE;
+    c->read_errno = 0;
     // 命令请求的类型
     c->reqtype = 0;
     // 命令参数数量
@@ -133,6 +241,8 @@ redisClient *createClient(int fd) {
     c->multibulklen = 0;
     // 读入的参数的长度
     c->bulklen = -1;
+    // 查询缓冲区的 '\r' 扫描器
+    respScannerInit(&c->respscan);
     // 已发送字节数
     c->sentlen = 0;
     // 状态 FLAG
@@ -151,35 +261,21 @@ redisClient *createClient(int fd) {
     c->repl_ack_time = 0;
     // 客户端为从服务器时使用，记录了从服务器所使用的端口号
     c->slave_listening_port = 0;
-    // 回复链表
-    c->reply = listCreate();
     // 回复链表的字节量
     c->reply_bytes = 0;
     // 回复缓冲区大小达到软限制的时间
     c->obuf_soft_limit_reached_time = 0;
-    // 回复链表的释放和复制函数
-    listSetFreeMethod(c->reply,decrRefCountVoid);//节点释放函数是减少引用计数，如果引用计数等于0了，那么根据对象类型释放相应对象
-    listSetDupMethod(c->reply,dupClientReplyValue);//节点复制函数，增加对象引用计数
     // 阻塞类型
     c->btype = REDIS_BLOCKED_NONE;
     // 阻塞超时
     c->bpop.timeout = 0;
-    // 造成客户端阻塞的列表键
-    c->bpop.keys = dictCreate(&setDictType,NULL);
     // 在解除阻塞时将元素推入到 target 指定的键中
     // BRPOPLPUSH 命令时使用
     c->bpop.target = NULL;
     c->bpop.numreplicas = 0;
     c->bpop.reploffset = 0;
     c->woff = 0;
-    // 进行事务时监视的键
-    c->watched_keys = listCreate();
-    // 订阅的频道和模式
-    c->pubsub_channels = dictCreate(&setDictType,NULL);
-    c->pubsub_patterns = listCreate();
     c->peerid = NULL;
-    listSetFreeMethod(c->pubsub_patterns,decrRefCountVoid);
-    listSetMatchMethod(c->pubsub_patterns,listMatchObjects);
     // 如果不是伪客户端，那么添加到服务器的客户端链表中。server维护clients的链表
     if (fd != -1) listAddNodeTail(server.clients,c);
     // 初始化客户端的事务状态
@@ -193,11 +289,14 @@ redisClient *createClient(int fd) {
  * to the client. The behavior is the following:
  * 这个函数在每次向客户端发送数据时都会被调用。函数的行为如下：
  * If the client should receive new data (normal clients will) the function
- * returns REDIS_OK, and make sure to install the write handler in our event
- * loop so that when the socket is writable new data gets written.
+ * returns REDIS_OK, and make sure to put the client in the list of clients
+ * with pending writes: before re-entering the event loop, beforeSleep()
+ * writes the output buffers directly to the socket, and installs a write
+ * handler only if the socket buffer is full. This avoids registering and
+ * unregistering a writable event for every reply.
  * 当客户端可以接收新数据时（通常情况下都是这样），函数返回 REDIS_OK ，
- * 并将写处理器（write handler）安装到事件循环中，
- * 这样当套接字可写时，新数据就会被写入。
+ * 并将客户端加入待写链表，在 beforeSleep 中直接把回复写入套接字，
+ * 只有套接字缓冲区满了写不完时，才安装写处理器（write handler）。
  *
  * If the client should not receive new data, because it is a fake client,
  * a master, a slave not yet online, or because the setup of the write handler
@@ -225,17 +324,42 @@ int prepareClientToWrite(redisClient *c) {
     // 无连接的伪客户端总是不可写的
     if (c->fd <= 0) return REDIS_ERR; /* Fake client */
 
-    // 一般情况，为客户端套接字安装写处理器到事件循环
-    if (c->bufpos == 0 && listLength(c->reply) == 0 &&
+    /* Schedule the client to write the output buffers to the socket only
+     * if not already done (there were no pending writes already and the
+     * client was yet not flagged) and, for slaves, if the slave can
+     * actually receive writes at this stage. While the client is being
+     * parsed by an I/O thread we must not touch global state at all: the
+     * main thread will queue it once the thread is done. */
+    // 一般情况，把客户端加入待写链表，在 beforeSleep 中写出回复
+    if (!clientHasPendingReplies(c) &&
+        !(c->flags & REDIS_PENDING_READ) &&
         (c->replstate == REDIS_REPL_NONE ||
-         c->replstate == REDIS_REPL_ONLINE) &&
-        //添加fd的可写事件监控到epoll实例中，当可写时，调用sendReplyToClient函数
-        aeCreateFileEvent(server.el, c->fd, AE_WRITABLE,
-        sendReplyToClient, c) == AE_ERR) return REDIS_ERR;
+         c->replstate == REDIS_REPL_ONLINE))
+    {
+        clientInstallWriteHandler(c);
+    }
 
     return REDIS_OK;
 }
 
+/* Return true if the specified client has pending reply buffers to write to
+ * the socket. */
+// 客户端的 buf 或 reply 链表中还有未发送的内容时返回 1
+int clientHasPendingReplies(redisClient *c) {
+    return c->bufpos || listLength(c->reply);
+}
+
+/* Put the client in the queue of clients that should write their output
+ * buffers to the socket before re-entering the event loop. The write itself
+ * is performed by handleClientsWithPendingWritesUsingThreads(), that falls
+ * back to a writable event handler only when the socket buffer is full. */
+// 将客户端加入 server.clients_pending_write ，等待 beforeSleep 时写出
+void clientInstallWriteHandler(redisClient *c) {
+    if (c->flags & REDIS_PENDING_WRITE) return;
+    c->flags |= REDIS_PENDING_WRITE;
+    listAddNodeHead(server.clients_pending_write,c);
+}
+
 /* Create a duplicate of the last object in the reply list when
  * it is not exclusively owned by the reply list. */
 //  当回复列表中的最后一个对象也被其它对象引用时即引用计数大于1，创建该对象的一个复制品并让链表最后一个节点指向该对象
@@ -255,6 +379,23 @@ robj *dupLastObjectIfNeeded(list *reply) {
     return listNodeValue(ln);
 }
 
+/* Return true if 'len' more bytes can be appended to the object at the tail
+ * of a reply list.
+ *
+ * Large objects that are not exclusively owned by the reply list are
+ * usually values referenced from the keyspace (zero copy bulk replies): we
+ * never append to them, since dupLastObjectIfNeeded() would copy the whole
+ * value. The caller creates a new node instead. */
+// 判断能否把 len 字节拼接到 reply 链表的最后一个对象中
+// 被引用的大对象（通常是数据库中的值）不拼接，否则 dupLastObjectIfNeeded 会复制整个值
+static int replyTailCanAppend(robj *tail, size_t len) {
+    return tail->ptr != NULL &&
+           tail->encoding == REDIS_ENCODING_RAW &&
+           sdslen(tail->ptr)+len <= REDIS_REPLY_CHUNK_BYTES &&
+           (tail->refcount == 1 ||
+            sdslen(tail->ptr) < REDIS_REPLY_ZEROCOPY_MIN_BYTES);
+}
+
 /* -----------------------------------------------------------------------------
  * Low level functions to add more data to output buffers.
  * -------------------------------------------------------------------------- */
@@ -287,6 +428,14 @@ int _addReplyToBuffer(redisClient *c, char *s, size_t len) {
 /*
  * 将回复对象（一个 SDS ）添加到 c->reply 回复链表中（如果reply最后一个节点小于16k并且能放得下o那么拼接下，
  否则直接将o作为新的链表节点添加到reply的末尾）
+ *
+ * Objects of at least REDIS_REPLY_ZEROCOPY_MIN_BYTES are never copied: the
+ * node just takes a reference and the reply is written straight from the
+ * object memory. Commands modifying a string in place must call
+ * dbUnshareStringValue() first, that creates a private copy when the value
+ * is also referenced by a reply.
+ * 大对象不复制，链表节点直接引用该对象（增加引用计数），写回复时直接从对象的内存写出。
+ * 原地修改字符串的命令会先调用 dbUnshareStringValue() ，对象被引用时会先复制一份。
  */
 void _addReplyObjectToList(redisClient *c, robj *o) {
     robj *tail;
@@ -310,9 +459,8 @@ void _addReplyObjectToList(redisClient *c, robj *o) {
         /* Append to this object when possible. */
         // 如果表尾 SDS 的已用空间加上对象的长度，小于 REDIS_REPLY_CHUNK_BYTES（16K），那么将新对象的内容拼接到表尾 SDS 的末尾
         //如果reply链表最后一个节点的字符串对象，编码是raw并且加上o的大小小于16k
-        if (tail->ptr != NULL &&
-            tail->encoding == REDIS_ENCODING_RAW &&
-            sdslen(tail->ptr)+sdslen(o->ptr) <= REDIS_REPLY_CHUNK_BYTES)
+        if (sdslen(o->ptr) < REDIS_REPLY_ZEROCOPY_MIN_BYTES &&
+            replyTailCanAppend(tail,sdslen(o->ptr)))
         {
             //更新reply总字节数：因为sdscat可能会预分配内存，所以先减去tail节点字节数，然后sdscat，然后再累加tail节点字节数
             c->reply_bytes -= zmalloc_size_sds(tail->ptr); //先减去tail的字节数
@@ -352,8 +500,7 @@ void _addReplySdsToList(redisClient *c, sds s) {
 
         /* Append to this object when possible. */
         //最后一个节点加上sds后，小于16k，那么直接将sds拼接到最后一个节点中
-        if (tail->ptr != NULL && tail->encoding == REDIS_ENCODING_RAW &&
-            sdslen(tail->ptr)+sdslen(s) <= REDIS_REPLY_CHUNK_BYTES)
+        if (replyTailCanAppend(tail,sdslen(s)))
         {
             c->reply_bytes -= zmalloc_size_sds(tail->ptr);
             tail = dupLastObjectIfNeeded(c->reply);
@@ -382,10 +529,12 @@ void _addReplyStringToList(redisClient *c, char *s, size_t len) {
     } else {
         tail = listNodeValue(listLast(c->reply)); //拿到reply的最后一个节点
 
-        /* Append to this object when possible. */
+        /* Append to this object when possible. Protocol errors may be
+         * emitted from an I/O thread: in that case always create a new node,
+         * since dupLastObjectIfNeeded() could touch a shared refcount. */
         //如果tail的字节数+len小于16k，那么将s[0..len]拼接到tail
-        if (tail->ptr != NULL && tail->encoding == REDIS_ENCODING_RAW &&
-            sdslen(tail->ptr)+len <= REDIS_REPLY_CHUNK_BYTES)
+        if (!(c->flags & REDIS_PENDING_READ) &&
+            replyTailCanAppend(tail,len))
         {
             c->reply_bytes -= zmalloc_size_sds(tail->ptr);
             tail = dupLastObjectIfNeeded(c->reply);
@@ -424,8 +573,12 @@ void addReply(redisClient *c, robj *obj) {
      */
     //如果obj是raw|embstr编码
     if (sdsEncodedObject(obj)) {
+        /* Large objects are not copied into the static buffer: the reply
+         * list references them instead (zero copy). */
         //先尝试将obj放入c->buffer中（这样可以避免内存分配），如果不够的话，放入c->reply中
-        if (_addReplyToBuffer(c,obj->ptr,sdslen(obj->ptr)) != REDIS_OK)
+        //大对象直接由 reply 链表引用，不复制到 buffer 中
+        if (sdslen(obj->ptr) >= REDIS_REPLY_ZEROCOPY_MIN_BYTES ||
+            _addReplyToBuffer(c,obj->ptr,sdslen(obj->ptr)) != REDIS_OK)
             // 如果 c->buf 中的空间不够，就复制到 c->reply 链表中，可能会引起内存分配
             _addReplyObjectToList(c,obj);
     } else if (obj->encoding == REDIS_ENCODING_INT) {
@@ -570,8 +723,13 @@ void setDeferredMultiBulkLength(redisClient *c, void *node, long length) {
     //尝试将next节点的内容拼接到当前节点中
     if (ln->next != NULL) {
         next = listNodeValue(ln->next);
-        /* Only glue when the next node is non-NULL (an sds in this case) */
-        if (next->ptr != NULL) {
+        /* Only glue when the next node is non-NULL (an sds in this case)
+         * and owned by this reply list only: a value referenced by the
+         * node (zero copy reply) would be copied as a whole. */
+        // 只拼接回复链表独占的 sds ，被引用的值（零复制回复）保留为单独的节点
+        if (next->ptr != NULL && next->refcount == 1 &&
+            next->encoding == REDIS_ENCODING_RAW)
+        {
             c->reply_bytes -= zmalloc_size_sds(len->ptr);//先减去当前节点的字节长度
             c->reply_bytes -= getStringObjectSdsUsedMemory(next);//减去next节点的字节长度
             len->ptr = sdscatlen(len->ptr,next->ptr,sdslen(next->ptr));//将next节点的字符串拼接到当前节点中
@@ -908,26 +1066,17 @@ void freeClient(redisClient *c) {
         }
     }
 
-    /* Free the query buffer */
-    //释放查询缓冲区
-    sdsfree(c->querybuf);
-    c->querybuf = NULL;
-
     /* Deallocate structures used to block on blocking ops. */
     if (c->flags & REDIS_BLOCKED) unblockClient(c);
-    dictRelease(c->bpop.keys);
 
     /* UNWATCH all the keys */
     // 清空 WATCH 信息
     unwatchAllKeys(c);
-    listRelease(c->watched_keys);
 
     /* Unsubscribe from all the pubsub channels */
     // 退订所有频道和模式
     pubsubUnsubscribeAllChannels(c,0);
     pubsubUnsubscribeAllPatterns(c,0);
-    dictRelease(c->pubsub_channels);
-    listRelease(c->pubsub_patterns);
 
     /* Close socket, unregister events, and remove list of replies and
      * accumulated arguments. */
@@ -939,9 +1088,6 @@ void freeClient(redisClient *c) {
         close(c->fd);
     }
 
-    // 清空回复缓冲区
-    listRelease(c->reply);
-
     // 清空命令参数
     freeClientArgv(c);
 
@@ -962,6 +1108,19 @@ void freeClient(redisClient *c) {
         listDelNode(server.unblocked_clients,ln);
     }
 
+    /* Remove from the list of pending reads/writes if needed. */
+    // 从等待 I/O 线程处理的链表中删除
+    if (c->flags & REDIS_PENDING_READ) {
+        ln = listSearchKey(server.clients_pending_read,c);
+        redisAssert(ln != NULL);
+        listDelNode(server.clients_pending_read,ln);
+    }
+    if (c->flags & REDIS_PENDING_WRITE) {
+        ln = listSearchKey(server.clients_pending_write,c);
+        redisAssert(ln != NULL);
+        listDelNode(server.clients_pending_write,ln);
+    }
+
     /* Master/slave cleanup Case 1:
      * we lost the connection with a slave. */
     if (c->flags & REDIS_SLAVE) {
@@ -994,15 +1153,16 @@ void freeClient(redisClient *c) {
     }
 
     /* Release other dynamically allocated client structure fields,
-     * and finally release the client structure itself. */
+     * and finally return the client structure itself to the pool. The
+     * query buffer and the reply list are emptied there. */
     if (c->name) decrRefCount(c->name); //减少robj* name的引用计数
     // 清除参数空间
     zfree(c->argv);
     // 清除事务状态信息
     freeClientMultiState(c);
     sdsfree(c->peerid);
-    // 释放客户端 redisClient 结构本身
-    zfree(c);
+    // 清空查询缓冲区和回复链表，并把客户端结构放回池中（池满时释放）
+    clientPoolPut(c);
 }
 
 /* Schedule a client to free it at a safe time in the serverCron() function.
@@ -1031,77 +1191,112 @@ void freeClientsInAsyncFreeQueue(void) {
     }
 }
 
-/*
- * 负责传送命令回复的写处理器，将buffer和reply回复给客户端（先写buffer，写完再写reply中内容）
- */
-void sendReplyToClient(aeEventLoop *el, int fd, void *privdata, int mask) {
-    redisClient *c = privdata;
-    int nwritten = 0, totwritten = 0, objlen;
-    size_t objmem;
-    robj *o;
-    REDIS_NOTUSED(el);
-    REDIS_NOTUSED(mask);
+/* Write as much as possible of the client output buffers to the socket.
+ *
+ * The static buffer and the reply list nodes are gathered in a single
+ * writev() call of up to REDIS_IOV_MAX chunks, so that long reply lists
+ * (LRANGE, HGETALL, SMEMBERS, ...) don't need a write() per node. Partial
+ * writes are accounted by advancing c->sentlen inside the first chunk that
+ * was not fully written.
+ *
+ * This is the part of the write path that is safe to run inside an I/O
+ * thread: it never releases reply nodes nor touches any global state.
+ * Nodes that were fully sent are just counted in c->io_sent_nodes and are
+ * released later by writeToClientFinish() in the main thread. */
+// 用 writev 将 buf 和 reply 中的多个节点一次写入套接字（先写buffer，再写reply中内容）
+// 这个函数不释放 reply 节点，也不修改全局状态，所以可以在 I/O 线程中执行
+static void _writeToClient(redisClient *c) {
+    struct iovec iov[REDIS_IOV_MAX];
+    ssize_t nwritten = 0;
+    size_t totwritten = 0;
+    listNode *ln = listFirst(c->reply);
+
+    c->io_sent_nodes = 0;
+    c->io_write_errno = 0;
 
     // 一直循环，直到回复缓冲区为空 或者指定条件满足为止
-    while(c->bufpos > 0 || listLength(c->reply)) {
-        
-        //如果buffer内有内容
+    while(c->bufpos > 0 || ln) {
+        int iovcnt = 0;
+        size_t iovbytes = 0, offset = c->sentlen, remaining;
+        listNode *next = ln;
+
+        /* The static buffer always goes first. When it is not empty
+         * c->sentlen is the offset inside it, otherwise the offset inside
+         * the first node of the reply list. */
+        // c->sentlen 是用来处理 short write 的：buf 不为空时是 buf 中已写入的偏移量，
+        // 否则是 reply 第一个节点中已写入的偏移量
         if (c->bufpos > 0) {
+            iov[iovcnt].iov_base = c->buf+c->sentlen;
+            iov[iovcnt].iov_len = c->bufpos-c->sentlen;
+            iovbytes += iov[iovcnt].iov_len;
+            iovcnt++;
+            offset = 0;
+        }
 
-            // c->bufpos > 0
-            // 写入内容到套接字
-            // c->sentlen 是用来处理 short write 的
-            // 当出现 short write ，导致写入未能一次完成时，
-            // c->buf+c->sentlen 就会偏移到正确（未写入）内容的位置上。
-            nwritten = write(fd,c->buf+c->sentlen,c->bufpos-c->sentlen);
+        // 收集 reply 链表中的节点，最多 REDIS_IOV_MAX 个
+        while (next && iovcnt < REDIS_IOV_MAX &&
+               iovbytes < REDIS_MAX_WRITE_PER_EVENT)
+        {
+            robj *o = listNodeValue(next);
+            size_t objlen = sdslen(o->ptr);
+
+            // 略过空对象
+            if (objlen > offset) {
+                iov[iovcnt].iov_base = ((char*)o->ptr)+offset;
+                iov[iovcnt].iov_len = objlen-offset;
+                iovbytes += iov[iovcnt].iov_len;
+                iovcnt++;
+            }
+            offset = 0;
+            next = listNextNode(next);
+        }
+
+        if (iovcnt) {
+            nwritten = writev(c->fd,iov,iovcnt);
             // 出错则跳出
             if (nwritten <= 0) break;
-            // 成功写入则更新写入计数器变量
-            c->sentlen += nwritten; //累加sentlen，更新buffer当前已写入量
             totwritten += nwritten; //更新总的已写字节数
+        } else {
+            /* Only empty objects are left: just consume them. */
+            nwritten = 0;
+        }
+        remaining = nwritten;
 
-            /* If the buffer was sent, set bufpos to zero to continue with
-             * the remainder of the reply. */
-            // 如果buffer中的内容已经全部写入完毕，那么清空客户端的两个计数器变量
-            //sentlen是专门支持short write的
-            if (c->sentlen == c->bufpos) {
+        /* If the buffer was sent, set bufpos to zero to continue with
+         * the remainder of the reply. */
+        // 如果buffer中的内容已经全部写入完毕，那么清空客户端的两个计数器变量
+        if (c->bufpos > 0) {
+            if (remaining < (size_t)(c->bufpos-c->sentlen)) {
+                c->sentlen += remaining;
+                remaining = 0;
+            } else {
+                remaining -= c->bufpos-c->sentlen;
                 c->bufpos = 0;
-                c->sentlen = 0; //清空sentlen
-            }
-            //如果没写完，会继续while循环，然后继续写入buffer，注意写完buffer后才会写reply内容
-        } else {
-            // 走到这里说明listLength(c->reply) != 0，即reply链表里有内容
-            
-            // 取出位于链表最前面的对象
-            o = listNodeValue(listFirst(c->reply));
-            objlen = sdslen(o->ptr);//len的字节数
-            objmem = getStringObjectSdsUsedMemory(o);//占用字节数，包括len+free的字节数
-
-            // 略过空对象：当前链表节点没有字节可写，跳过
-            if (objlen == 0) {
-                listDelNode(c->reply,listFirst(c->reply));//从链表中删除
-                c->reply_bytes -= objmem; //更新reply占用的字节数
-                continue;
+                c->sentlen = 0;
             }
+        }
 
-            // 写入内容到套接字
-            // c->sentlen 是用来处理 short write 的（每次写完buffer或写完reply的一个节点时，sentlen都清零）
-            // 当出现 short write ，导致写入未能一次完成时，c->buf+c->sentlen 就会偏移到正确（未写入）内容的位置上。
-            nwritten = write(fd, ((char*)o->ptr)+c->sentlen,objlen-c->sentlen);
-            // 写入出错则跳出
-            if (nwritten <= 0) break;
-            // 成功写入则更新写入计数器变量
-            c->sentlen += nwritten; //更新reply当前链表节点的写入量
-            totwritten += nwritten; //更新总的写入量
-
-            /* If we fully sent the object on head go to the next one */
-            // 如果缓冲区内容全部写入完毕，那么删除已写入完毕的节点
-            if (c->sentlen == objlen) {
-                listDelNode(c->reply,listFirst(c->reply)); //从链表中删除该节点
-                c->sentlen = 0;//清空sentlen
-                c->reply_bytes -= objmem;
+        /* Skip the reply nodes that were fully sent, including empty
+         * ones, and remember the offset inside the first partial one.
+         * They are released later by the main thread. */
+        // 跳过已经全部写入的节点，记录部分写入的节点的偏移量
+        while (c->bufpos == 0 && ln) {
+            robj *o = listNodeValue(ln);
+            size_t left = sdslen(o->ptr)-c->sentlen;
+
+            if (left > remaining) {
+                c->sentlen += remaining;
+                break;
             }
+            remaining -= left;
+            c->sentlen = 0;
+            c->io_sent_nodes++;
+            ln = listNextNode(ln);
         }
+
+        // 套接字缓冲区已满，剩下的内容等下次再写
+        if (iovcnt && (size_t)nwritten < iovbytes) break;
+
         /* Note that we avoid to send more than REDIS_MAX_WRITE_PER_EVENT
          * bytes, in a single threaded server it's a good idea to serve
          * other clients as well, even if a very large request comes from
@@ -1110,30 +1305,46 @@ void sendReplyToClient(aeEventLoop *el, int fd, void *privdata, int mask) {
          * 为了避免一个非常大的回复独占服务器， 当写入的总数量大于 REDIS_MAX_WRITE_PER_EVENT ，
          * 临时中断写入，将处理时间让给其他客户端，剩余的内容等下次写入就绪再继续写入
          * However if we are over the maxmemory limit we ignore that and
-         * just deliver as much data as it is possible to deliver. 
+         * just deliver as much data as it is possible to deliver.
          * 不过，如果服务器的内存占用已经超过了限制， 那么为了将回复缓冲区中的内容尽快写入给客户端，
          * 然后释放回复缓冲区的空间来回收内存，这时即使写入量超过了 REDIS_MAX_WRITE_PER_EVENT ，
          * 程序也继续进行写入
          */
-        //如果当前使用内存没超过maxmemory 并且写入超过64k了，那么先不写了，下次有空再写。
         if (totwritten > REDIS_MAX_WRITE_PER_EVENT &&
             (server.maxmemory == 0 ||
              zmalloc_used_memory() < server.maxmemory)) break;
     }
 
+    // 记录写入出错的 errno ， EAGAIN 不算出错
+    if (nwritten == -1 && errno != EAGAIN) c->io_write_errno = errno;
+    c->io_written = totwritten;
+}
+
+/* Main thread half of the write path: release the reply nodes that
+ * _writeToClient() sent, handle errors and uninstall the write handler
+ * once everything was sent.
+ *
+ * Returns REDIS_ERR if the client was freed, otherwise REDIS_OK. */
+// 在主线程中处理 _writeToClient() 的结果，客户端被释放时返回 REDIS_ERR
+static int writeToClientFinish(redisClient *c, int handler_installed) {
+    // 释放已经全部发送的 reply 节点
+    while (c->io_sent_nodes) {
+        robj *o = listNodeValue(listFirst(c->reply));
+
+        c->reply_bytes -= getStringObjectSdsUsedMemory(o);
+        listDelNode(c->reply,listFirst(c->reply));
+        c->io_sent_nodes--;
+    }
+
     // 写入出错检查
-    if (nwritten == -1) {
-        if (errno == EAGAIN) {
-            nwritten = 0;
-        } else {
-            redisLog(REDIS_VERBOSE,
-                "Error writing to client: %s", strerror(errno));
-            freeClient(c);
-            return;
-        }
+    if (c->io_write_errno) {
+        redisLog(REDIS_VERBOSE,
+            "Error writing to client: %s", strerror(c->io_write_errno));
+        freeClient(c);
+        return REDIS_ERR;
     }
 
-    if (totwritten > 0) {
+    if (c->io_written > 0) {
         /* For clients representing masters we don't count sending data
          * as an interaction, since we always send REPLCONF ACK commands
          * that take some time to just fill the socket output buffer.
@@ -1142,16 +1353,38 @@ void sendReplyToClient(aeEventLoop *el, int fd, void *privdata, int mask) {
         if (!(c->flags & REDIS_MASTER)) c->lastinteraction = server.unixtime;
     }
     //如果buffer已写完，并且reply也写完了，那么不再监控fd的可写事件了（因为暂无数据可写）
-    if (c->bufpos == 0 && listLength(c->reply) == 0) {
+    if (!clientHasPendingReplies(c)) {
         c->sentlen = 0;
 
         // 删除 write handler，不再监控fd的可写事件了
-        aeDeleteFileEvent(server.el,c->fd,AE_WRITABLE);
+        if (handler_installed) aeDeleteFileEvent(server.el,c->fd,AE_WRITABLE);
 
         /* Close connection after entire reply has been sent. */
         // 如果指定了写入之后关闭客户端 FLAG ，那么关闭客户端
-        if (c->flags & REDIS_CLOSE_AFTER_REPLY) freeClient(c);
+        if (c->flags & REDIS_CLOSE_AFTER_REPLY) {
+            freeClient(c);
+            return REDIS_ERR;
+        }
     }
+    return REDIS_OK;
+}
+
+/* Write data in output buffers to client. Return REDIS_OK if the client
+ * is still valid after the call, REDIS_ERR if it was freed. */
+// 将 buf 和 reply 回复给客户端，客户端被释放时返回 REDIS_ERR
+int writeToClient(int fd, redisClient *c, int handler_installed) {
+    REDIS_NOTUSED(fd);
+    _writeToClient(c);
+    return writeToClientFinish(c,handler_installed);
+}
+
+/*
+ * 负责传送命令回复的写处理器
+ */
+void sendReplyToClient(aeEventLoop *el, int fd, void *privdata, int mask) {
+    REDIS_NOTUSED(el);
+    REDIS_NOTUSED(mask);
+    writeToClient(fd,privdata,1);
 }
 
 /* resetClient prepare the client to process the next command */
@@ -1231,6 +1464,7 @@ int processInlineBuffer(redisClient *c) {
 
     // 从缓冲区中删除已 argv 已读取的内容。剩余的内容是未读取的
     sdsrange(c->querybuf,querylen+2,-1);
+    respScannerConsume(&c->respscan,querylen+2);
 
     /* Setup argv array on client structure */
     // 为客户端的参数分配空间
@@ -1257,15 +1491,14 @@ int processInlineBuffer(redisClient *c) {
 /* Helper function. Trims query buffer to make the function that processes
  * multi bulk requests idempotent. */
 // 如果在读入协议内容时，发现内容不符合协议，那么异步地关闭这个客户端。
+// 可能在 I/O 线程中执行，所以只记录错误，由主线程输出日志
 static void setProtocolError(redisClient *c, int pos) {
-    if (server.verbosity >= REDIS_VERBOSE) {
-        sds client = catClientInfoString(sdsempty(),c);
-        redisLog(REDIS_VERBOSE,
-            "Protocol error from client: %s", client);
-        sdsfree(client);
-    }
+    /* This can run in an I/O thread: don't log here, the main thread does
+     * it with logClientProtocolError(). */
+    c->read_error = REDIS_READ_ERR_PROTOCOL;
     c->flags |= REDIS_CLOSE_AFTER_REPLY;
     sdsrange(c->querybuf,pos,-1);
+    respScannerConsume(&c->respscan,pos);
 }
 
 /* 将 c->querybuf 中的协议内容转换成 c->argv 中的参数对象
@@ -1279,6 +1512,15 @@ int processMultibulkBuffer(redisClient *c) {
     char *newline = NULL;
     int pos = 0, ok;
     long long ll;
+    respScanner *rs = &c->respscan;
+
+    /* Header lines are located with the vectorized scanner: the '\r' of
+     * 64 bytes of the request are found at once instead of one strchr()
+     * per argument. The scanner is kept in the client, so the block
+     * already scanned, often holding the next commands of a pipeline, is
+     * not scanned again by the next call. Every removal of bytes from the
+     * head of the query buffer is reported to it. */
+    // 用向量化扫描器查找各个头部行的 '\r' ，扫描器保存在客户端中
 
     // 读入命令的参数个数
     // 比如 *3\r\n$3\r\nSET\r\n... 将令 c->multibulklen = 3
@@ -1288,7 +1530,7 @@ int processMultibulkBuffer(redisClient *c) {
 
         /* Multi bulk length cannot be read without a \r\n */
         // 检查缓冲区的内容第一个 "\r\n"
-        newline = strchr(c->querybuf,'\r');
+        newline = respScannerFindCR(rs,c->querybuf,sdslen(c->querybuf),0);
         if (newline == NULL) {
             if (sdslen(c->querybuf) > REDIS_INLINE_MAX_SIZE) {
                 addReplyError(c,"Protocol error: too big mbulk count string");
@@ -1328,6 +1570,7 @@ int processMultibulkBuffer(redisClient *c) {
         // 但并没有详细说明原因
         if (ll <= 0) {
             sdsrange(c->querybuf,pos,-1);
+            respScannerConsume(rs,pos);
             return REDIS_OK;
         }
 
@@ -1348,7 +1591,8 @@ int processMultibulkBuffer(redisClient *c) {
         // 读入参数长度
         if (c->bulklen == -1) {
             // 确保 "\r\n" 存在
-            newline = strchr(c->querybuf+pos,'\r');
+            newline = respScannerFindCR(rs,c->querybuf,sdslen(c->querybuf),
+                                        pos);
             if (newline == NULL) {
                 if (sdslen(c->querybuf) > REDIS_INLINE_MAX_SIZE) {
                     addReplyError(c,
@@ -1397,12 +1641,16 @@ int processMultibulkBuffer(redisClient *c) {
                  * boundary so that we can optimize object creation
                  * avoiding a large copy of data. */
                 sdsrange(c->querybuf,pos,-1);
+                respScannerConsume(rs,pos);
                 pos = 0;
                 qblen = sdslen(c->querybuf);
                 /* Hint the sds library about the amount of bytes this string is
-                 * going to contain. */
-                if (qblen < ll+2)
-                    c->querybuf = sdsMakeRoomFor(c->querybuf,ll+2-qblen);
+                 * going to contain. The size is exact: the payload will be
+                 * read directly in this buffer, that then becomes the
+                 * argument object, so greedy preallocation is just waste. */
+                // 按参数的确切大小分配查询缓冲区，参数内容直接读入其中，之后成为参数对象
+                if (qblen < (size_t)ll+2)
+                    c->querybuf = sdsMakeRoomForNonGreedy(c->querybuf,ll+2-qblen);
             }
             // 参数的长度
             c->bulklen = ll;
@@ -1426,11 +1674,13 @@ int processMultibulkBuffer(redisClient *c) {
             {
                 c->argv[c->argc++] = createObject(REDIS_STRING,c->querybuf);
                 sdsIncrLen(c->querybuf,-2); /* remove CRLF */
+                /* Don't preallocate room for another fat argument: the next
+                 * one gets an exactly sized buffer when its header is
+                 * parsed, and a big empty buffer would just double the peak
+                 * memory and be trimmed again by clientsCron(). */
                 c->querybuf = sdsempty();
-                /* Assume that if we saw a fat argument we'll see another one
-                 * likely... */
-                c->querybuf = sdsMakeRoomFor(c->querybuf,c->bulklen+2);
                 pos = 0;
+                respScannerInit(rs);
             } else {
                 c->argv[c->argc++] =
                     createStringObject(c->querybuf+pos,c->bulklen);
@@ -1447,7 +1697,10 @@ int processMultibulkBuffer(redisClient *c) {
 
     /* Trim to pos */
     // 从 querybuf 中删除已被读取的内容
-    if (pos) sdsrange(c->querybuf,pos,-1);
+    if (pos) {
+        sdsrange(c->querybuf,pos,-1);
+        respScannerConsume(rs,pos);
+    }
 
     /* We're done when c->multibulk == 0 */
     // 如果本条命令的所有参数都已读取完，那么返回
@@ -1458,17 +1711,102 @@ int processMultibulkBuffer(redisClient *c) {
     return REDIS_ERR;
 }
 
+/* Max length of the keys prefetchPipelinedGets() considers. */
+#define REDIS_PREFETCH_KEY_LEN 64
+
+/* Parse a "<type><number>\r\n" line, the multibulk count or a bulk length,
+ * at *p. On success *p and *left are moved after the line. */
+// 解析查询缓冲区中的 "*<count>\r\n" 或 "$<len>\r\n" 行
+static int prefetchParseLen(char **p, size_t *left, char type, size_t *val) {
+    char *s = *p, *end = *p+*left;
+    size_t v = 0;
+
+    if (s == end || *s++ != type) return 0;
+    while (s < end && *s >= '0' && *s <= '9' && v <= REDIS_PREFETCH_KEY_LEN) {
+        v = v*10+(*s-'0');
+        s++;
+    }
+    if (end-s < 2 || s[0] != '\r' || s[1] != '\n') return 0;
+    *left -= (s+2)-*p;
+    *p = s+2;
+    *val = v;
+    return 1;
+}
+
+/* Look ahead in the query buffer for a run of pipelined GET and MGET
+ * commands and prefetch their keys with batched lookups, so that executing
+ * them one after the other finds the keyspace already in the CPU cache.
+ *
+ * The keys are looked up in c->db, so the scan stops at the first command
+ * that is not a GET or a MGET: any other command, like SELECT, may change
+ * the database the next ones are executed against. It also stops at the
+ * first key longer than REDIS_PREFETCH_KEY_LEN, and when DICT_FIND_BATCH
+ * keys are collected. Returns the number of commands whose keys were all
+ * collected.
+ *
+ * 在查询缓冲区中向前查找连续的 GET 和 MGET 命令，并批量预取它们的键。
+ * 遇到其他命令（比如可能改变数据库的 SELECT ）时停止。
+ */
+static int prefetchPipelinedReads(redisClient *c) {
+    long keybuf[DICT_FIND_BATCH][(REDIS_PREFETCH_KEY_LEN+16)/sizeof(long)];
+    robj keyobj[DICT_FIND_BATCH], *keys[DICT_FIND_BATCH];
+    char *p = c->querybuf;
+    size_t left = sdslen(c->querybuf), argc, len, j;
+    int n = 0, cmds = 0;
+
+    while (n < DICT_FIND_BATCH) {
+        if (!prefetchParseLen(&p,&left,'*',&argc) || argc < 2 ||
+            !prefetchParseLen(&p,&left,'$',&len)) break;
+
+        // 只处理 GET 和 MGET 命令
+        if (len == 3 && argc == 2 && left >= 5 &&
+            !strncasecmp(p,"get\r\n",5)) {
+            p += 5;
+            left -= 5;
+        } else if (len == 4 && left >= 6 && !strncasecmp(p,"mget\r\n",6)) {
+            p += 6;
+            left -= 6;
+        } else {
+            break;
+        }
+
+        for (j = 1; j < argc && n < DICT_FIND_BATCH; j++) {
+            if (!prefetchParseLen(&p,&left,'$',&len) ||
+                len > REDIS_PREFETCH_KEY_LEN || left < len+2 ||
+                p[len] != '\r' || p[len+1] != '\n' ||
+                sdsembedlen(len) > sizeof(keybuf[0])) break;
+
+            // 在栈上创建键对象
+            initStaticStringObject(keyobj[n],sdsnewembed(keybuf[n],p,len));
+            keys[n] = &keyobj[n];
+            n++;
+            p += len+2;
+            left -= len+2;
+        }
+        if (j < argc) break;
+        cmds++;
+    }
+    dbPrefetchKeys(c->db,keys,n,1);
+    return cmds;
+}
+
 // 处理客户端输入的命令内容
 void processInputBuffer(redisClient *c) {
-    /* Keep processing while there is something in the input buffer */
+    /* Commands ahead in the buffer whose keys were already prefetched. */
+    int prefetched = 0;
+
+    /* Keep processing while there is something in the input buffer, or a
+     * command parsed by an I/O thread is still waiting to be executed. */
     // 尽可能地处理查询缓冲区中的内容
     // 如果读取出现 short read ，那么可能会有内容滞留在读取缓冲区里面
     // 这些滞留内容也许不能完整构成一个符合协议的命令，
     // 需要等待下次读事件的就绪
-    while(sdslen(c->querybuf)) {
-        /* Return if clients are paused. */
+    while(sdslen(c->querybuf) || (c->flags & REDIS_PENDING_COMMAND)) {
+        /* Return if clients are paused. I/O threads only parse, so they
+         * don't need (and are not allowed) to check the pause state. */
         // 如果客户端正处于暂停状态，那么直接返回
-        if (!(c->flags & REDIS_SLAVE) && clientsArePaused()) return;
+        if (!(c->flags & (REDIS_SLAVE|REDIS_PENDING_READ)) &&
+            clientsArePaused()) return;
 
         /* Immediately abort if the client is in the middle of something. */
         // REDIS_BLOCKED 状态表示客户端正在被阻塞
@@ -1480,29 +1818,53 @@ void processInputBuffer(redisClient *c) {
         // 客户端已经设置了关闭 FLAG ，没有必要处理命令了
         if (c->flags & REDIS_CLOSE_AFTER_REPLY) return;
 
-        /* Determine request type when unknown. */
-        // 判断请求的类型
-        // 两种类型的区别可以在 Redis 的通讯协议上查到：
-        // http://redis.readthedocs.org/en/latest/topic/protocol.html
-        // 简单来说，多条查询是一般客户端发送来的，
-        // 而内联查询则是 TELNET 发送来的
-        if (!c->reqtype) {
-            if (c->querybuf[0] == '*') {
-                // 多条查询
-                c->reqtype = REDIS_REQ_MULTIBULK;
+        if (c->flags & REDIS_PENDING_COMMAND) {
+            /* The argument vector was already built by an I/O thread. */
+            // 命令已经由 I/O 线程解析好了，直接执行
+            c->flags &= ~REDIS_PENDING_COMMAND;
+        } else {
+            /* At the start of a new command in the main thread, look for a
+             * burst of pipelined GETs and MGETs to prefetch. */
+            // 在主线程中开始解析新命令时，预取后面连续的 GET / MGET 命令的键
+            if (prefetched == 0 && !c->reqtype &&
+                !(c->flags & REDIS_PENDING_READ))
+            {
+                prefetched = prefetchPipelinedReads(c);
+            }
+
+            /* Determine request type when unknown. */
+            // 判断请求的类型
+            // 两种类型的区别可以在 Redis 的通讯协议上查到：
+            // http://redis.readthedocs.org/en/latest/topic/protocol.html
+            // 简单来说，多条查询是一般客户端发送来的，
+            // 而内联查询则是 TELNET 发送来的
+            if (!c->reqtype) {
+                if (c->querybuf[0] == '*') {
+                    // 多条查询
+                    c->reqtype = REDIS_REQ_MULTIBULK;
+                } else {
+                    // 内联查询
+                    c->reqtype = REDIS_REQ_INLINE;
+                }
+            }
+
+            // 将缓冲区中的内容转换成命令，以及命令参数
+            if (c->reqtype == REDIS_REQ_INLINE) {
+                if (processInlineBuffer(c) != REDIS_OK) break;
+            } else if (c->reqtype == REDIS_REQ_MULTIBULK) {
+                if (processMultibulkBuffer(c) != REDIS_OK) break;
             } else {
-                // 内联查询
-                c->reqtype = REDIS_REQ_INLINE;
+                redisPanic("Unknown request type");
             }
-        }
 
-        // 将缓冲区中的内容转换成命令，以及命令参数
-        if (c->reqtype == REDIS_REQ_INLINE) {
-            if (processInlineBuffer(c) != REDIS_OK) break;
-        } else if (c->reqtype == REDIS_REQ_MULTIBULK) {
-            if (processMultibulkBuffer(c) != REDIS_OK) break;
-        } else {
-            redisPanic("Unknown request type");
+            /* Inside an I/O thread we stop after parsing one command: it
+             * is executed by the main thread, that will also continue
+             * parsing what is left in the query buffer. */
+            // 在 I/O 线程中只解析命令，命令交给主线程执行
+            if (c->argc && (c->flags & REDIS_PENDING_READ)) {
+                c->flags |= REDIS_PENDING_COMMAND;
+                break;
+            }
         }
 
         /* Multibulk processing could see a <= 0 length. */
@@ -1514,37 +1876,51 @@ void processInputBuffer(redisClient *c) {
             if (processCommand(c) == REDIS_OK)
                 resetClient(c);
         }
+        if (prefetched) prefetched--;
     }
+
+    /* Protocol errors met by I/O threads are logged later by
+     * handleClientsWithPendingReadsUsingThreads(). */
+    if (!(c->flags & REDIS_PENDING_READ)) logClientProtocolError(c);
 }
 
-/*
- * 读取客户端的查询缓冲区内容，当fd可读时，会调用这个函数从fd读取内容到querybuf中
- */
-void readQueryFromClient(aeEventLoop *el, int fd, void *privdata, int mask) {
-    redisClient *c = (redisClient*) privdata;
+/* Read from the client socket into the query buffer.
+ *
+ * This function can be called from I/O threads: it only writes to the
+ * client, and the only global state it reads, server.unixtime and
+ * server.client_max_querybuf_len, is written by the main thread alone,
+ * which waits for the I/O threads to finish before it runs anything else.
+ * For the same reason it does not log: when the client should be closed
+ * the cause is stored in c->read_error, and the main thread reports it
+ * with logClientReadError() before freeing the client.
+ *
+ * Returns 1 if some data was read, 0 if nothing was available (EAGAIN) and
+ * -1 if the client should be closed (EOF, read error or query buffer limit
+ * reached). */
+// 从套接字读取内容到 querybuf 中，可以在 I/O 线程中执行
+// 函数本身不写日志，关闭客户端的原因记录在 c->read_error 中，由主线程输出
+// 读到数据返回 1 ，没有数据返回 0 ，客户端需要被关闭时返回 -1
+static int readClientQueryBuffer(redisClient *c) {
     int nread, readlen;
     size_t qblen;
-    REDIS_NOTUSED(el);
-    REDIS_NOTUSED(mask);
 
-    // 设置服务器的当前客户端
-    server.current_client = c;
-    
     // 读入长度（默认为 16 KB）
     readlen = REDIS_IOBUF_LEN;
 
     /* If this is a multi bulk request, and we are processing a bulk reply
-     * that is large enough, try to maximize the probability that the query
-     * buffer contains exactly the SDS string representing the object, even
-     * at the risk of requiring more read(2) calls. This way the function
+     * that is large enough, make sure the query buffer contains exactly the
+     * SDS string representing the object: read just what is missing of the
+     * argument, but all of it at once, directly in the buffer that was
+     * already sized by processMultibulkBuffer(). This way the function
      * processMultiBulkBuffer() can avoid copying buffers to create the
      * Redis Object representing the argument. */
+    // 正在读取大参数时，一次读入参数剩余的全部内容，直接读入已经分配好的查询缓冲区
     if (c->reqtype == REDIS_REQ_MULTIBULK && c->multibulklen && c->bulklen != -1
         && c->bulklen >= REDIS_MBULK_BIG_ARG)
     {
         int remaining = (unsigned)(c->bulklen+2)-sdslen(c->querybuf);
 
-        if (remaining < readlen) readlen = remaining;
+        if (remaining > 0) readlen = remaining;
     }
 
     // 获取查询缓冲区当前内容的长度
@@ -1556,53 +1932,99 @@ void readQueryFromClient(aeEventLoop *el, int fd, void *privdata, int mask) {
     // 为查询缓冲区分配空间，分配readlen的长度
     c->querybuf = sdsMakeRoomFor(c->querybuf, readlen);
     // 读入内容到查询缓存，尝试读入16k的内容
-    nread = read(fd, c->querybuf+qblen, readlen);
+    nread = read(c->fd, c->querybuf+qblen, readlen);
 
     // 读入出错
     if (nread == -1) {
-        if (errno == EAGAIN) {
-            nread = 0;
-        } else {
-            redisLog(REDIS_VERBOSE, "Reading from client: %s",strerror(errno));
-            freeClient(c);
-            return;
-        }
-    // 遇到 EOF，释放redisClient
+        if (errno == EAGAIN) return 0;
+        c->read_error = REDIS_READ_ERR_IO;
+        c->read_errno = errno;
+        return -1;
+    // 遇到 EOF
     } else if (nread == 0) {
-        redisLog(REDIS_VERBOSE, "Client closed connection");
-        freeClient(c);
-        return;
+        c->read_error = REDIS_READ_ERR_EOF;
+        return -1;
     }
 
-    if (nread) {
-        // 根据内容，更新查询缓冲区（SDS） free 和 len 属性
-        // 并将 '\0' 正确地放到内容的最后
-        sdsIncrLen(c->querybuf,nread);//更新len和free属性
-        // 记录服务器和客户端最后一次互动的时间
-        c->lastinteraction = server.unixtime;
-        // 如果客户端是 master 的话，更新它的复制偏移量
-        if (c->flags & REDIS_MASTER) c->reploff += nread;
-    } else {
-        // 在 nread == -1 且 errno == EAGAIN 时运行
-        server.current_client = NULL;
-        return;
-    }
+    // 根据内容，更新查询缓冲区（SDS） free 和 len 属性
+    // 并将 '\0' 正确地放到内容的最后
+    sdsIncrLen(c->querybuf,nread);//更新len和free属性
+    // 记录服务器和客户端最后一次互动的时间
+    c->lastinteraction = server.unixtime;
+    // 如果客户端是 master 的话，更新它的复制偏移量
+    if (c->flags & REDIS_MASTER) c->reploff += nread;
 
     // 查询缓冲区长度超出服务器最大缓冲区长度，清空缓冲区并释放客户端
     if (sdslen(c->querybuf) > server.client_max_querybuf_len) {
+        c->read_error = REDIS_READ_ERR_QBUF_LIMIT;
+        return -1;
+    }
+    return 1;
+}
+
+/* Log why readClientQueryBuffer() asked to close the client. Must be
+ * called by the main thread, before the client is freed. */
+// 在主线程中输出客户端被关闭的原因
+static void logClientReadError(redisClient *c) {
+    if (c->read_error == REDIS_READ_ERR_IO) {
+        redisLog(REDIS_VERBOSE, "Reading from client: %s",
+            strerror(c->read_errno));
+    } else if (c->read_error == REDIS_READ_ERR_EOF) {
+        redisLog(REDIS_VERBOSE, "Client closed connection");
+    } else if (c->read_error == REDIS_READ_ERR_QBUF_LIMIT) {
         sds ci = catClientInfoString(sdsempty(),c), bytes = sdsempty();
 
         bytes = sdscatrepr(bytes,c->querybuf,64);
         redisLog(REDIS_WARNING,"Closing client that reached max query buffer length: %s (qbuf initial bytes: %s)", ci, bytes);
         sdsfree(ci);
         sdsfree(bytes);
+    }
+}
+
+/* Log the protocol error flagged by setProtocolError(), if any. Must be
+ * called by the main thread. The cause is cleared so that the error is
+ * logged just once, while the client waits for its reply to be written. */
+// 在主线程中输出 setProtocolError() 记录的协议错误（如果有的话）
+static void logClientProtocolError(redisClient *c) {
+    if (c->read_error != REDIS_READ_ERR_PROTOCOL) return;
+    c->read_error = REDIS_READ_ERR_NONE;
+
+    if (server.verbosity <= REDIS_VERBOSE) {
+        sds client = catClientInfoString(sdsempty(),c);
+        redisLog(REDIS_VERBOSE,
+            "Protocol error from client: %s", client);
+        sdsfree(client);
+    }
+}
+
+/*
+ * 读取客户端的查询缓冲区内容，当fd可读时，会调用这个函数从fd读取内容到querybuf中
+ */
+void readQueryFromClient(aeEventLoop *el, int fd, void *privdata, int mask) {
+    redisClient *c = (redisClient*) privdata;
+    int retval;
+    REDIS_NOTUSED(el);
+    REDIS_NOTUSED(fd);
+    REDIS_NOTUSED(mask);
+
+    /* Check if we want to read from the client later when exiting from
+     * the event loop. This is the case if threaded I/O is enabled. */
+    // 开启了 I/O 线程时，推迟到 beforeSleep 中由线程读取
+    if (postponeClientRead(c)) return;
+
+    // 设置服务器的当前客户端
+    server.current_client = c;
+
+    retval = readClientQueryBuffer(c);
+    if (retval == -1) {
+        logClientReadError(c);
         freeClient(c);
         return;
     }
 
     // 从查询缓存重读取内容，创建参数，并执行命令
     // 函数会执行到缓存中的所有内容都被处理完为止
-    processInputBuffer(c);
+    if (retval == 1) processInputBuffer(c);
 
     server.current_client = NULL;
 }
@@ -1913,6 +2335,9 @@ void rewriteClientCommandArgument(redisClient *c, int i, robj *newval) {
  * 注意：这个函数的速度很快，所以它可以被随意地调用多次。
  * 这个函数目前的主要作用就是用来强制客户端输出长度限制。
  */
+/* Note that objects referenced by the reply list (zero copy bulk replies)
+ * are accounted with their full size: the reply keeps them alive even if
+ * the key is modified or deleted in the meantime. */
 unsigned long getClientOutputBufferMemoryUsage(redisClient *c) {
     unsigned long list_item_size = sizeof(listNode)+sizeof(robj);//reply中每个链表节点和对象占用的字节数
 
@@ -2037,6 +2462,10 @@ void asyncCloseClientOnOutputBufferLimitReached(redisClient *c) {
     // 已经被标记了
     if (c->reply_bytes == 0 || c->flags & REDIS_CLOSE_ASAP) return;
 
+    /* Called from an I/O thread: freeClientAsync() touches global state,
+     * the main thread checks again once the thread is done. */
+    if (c->flags & REDIS_PENDING_READ) return;
+
     // 检查限制
     if (checkClientOutputBufferLimits(c)) {
         sds client = catClientInfoString(sdsempty(),c);
@@ -2062,12 +2491,14 @@ void flushSlavesOutputBuffers(void) {
         redisClient *slave = listNodeValue(ln);
         int events;
 
+        /* A slave can receive writes if it has a write handler installed
+         * or if it is queued in the pending writes list. */
         events = aeGetFileEvents(server.el,slave->fd);
-        if (events & AE_WRITABLE &&
+        if ((events & AE_WRITABLE || slave->flags & REDIS_PENDING_WRITE) &&
             slave->replstate == REDIS_REPL_ONLINE &&
-            listLength(slave->reply))
+            clientHasPendingReplies(slave))
         {
-            sendReplyToClient(server.el,slave->fd,slave,0);
+            writeToClient(slave->fd,slave,events & AE_WRITABLE);
         }
     }
 }
@@ -2140,10 +2571,443 @@ int clientsArePaused(void) {
 int processEventsWhileBlocked(void) {
     int iterations = 4; /* See the function top-comment. */
     int count = 0;
+
+    ProcessingEventsWhileBlocked = 1;
     while (iterations--) {
-        int events = aeProcessEvents(server.el, AE_FILE_EVENTS|AE_DONT_WAIT);
+        int events = 0;
+        events += aeProcessEvents(server.el, AE_FILE_EVENTS|AE_DONT_WAIT);
+        // beforeSleep 不会被调用，所以在这里写出待写客户端的回复
+        events += handleClientsWithPendingWrites();
         if (!events) break;
         count += events;
     }
+    ProcessingEventsWhileBlocked = 0;
+    return count;
+}
+
+/* ==========================================================================
+ * Threaded I/O
+ *
+ * When io-threads is greater than one, reading and parsing the query buffer
+ * and writing the output buffers of clients are performed in parallel by a
+ * pool of I/O threads. Commands are still executed by the main thread only,
+ * so the data set keeps its single threaded semantics.
+ *
+ * The main thread and the I/O threads never run on the same client at the
+ * same time: the main thread fills the per-thread lists, sets the pending
+ * counters, does its own share of the work and then busy-waits until every
+ * thread brought its counter back to zero.
+ * 多线程 I/O ：由 I/O 线程并行地读取、解析命令请求以及写回复，
+ * 命令仍然只在主线程中执行。主线程把客户端分配到各个线程的链表中，
+ * 完成自己的那一份之后等待所有线程完成。
+ * ========================================================================== */
+
+#define IO_THREADS_OP_READ 0
+#define IO_THREADS_OP_WRITE 1
+
+// 每个线程的 id ，互斥锁（主线程持有锁时线程停止），待处理数量以及客户端链表
+pthread_t io_threads[REDIS_IO_THREADS_MAX_NUM];
+pthread_mutex_t io_threads_mutex[REDIS_IO_THREADS_MAX_NUM];
+volatile unsigned long io_threads_pending[REDIS_IO_THREADS_MAX_NUM];
+int io_threads_op;      /* IO_THREADS_OP_WRITE or IO_THREADS_OP_READ. */
+list *io_threads_list[REDIS_IO_THREADS_MAX_NUM];
+
+#ifdef HAVE_ATOMIC
+static unsigned long getIOPendingCount(int i) {
+    return __sync_add_and_fetch(&io_threads_pending[i],0);
+}
+
+static void setIOPendingCount(int i, unsigned long count) {
+    __sync_synchronize();
+    io_threads_pending[i] = count;
+    __sync_synchronize();
+}
+#else
+pthread_mutex_t io_threads_pending_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static unsigned long getIOPendingCount(int i) {
+    unsigned long count;
+
+    pthread_mutex_lock(&io_threads_pending_mutex);
+    count = io_threads_pending[i];
+    pthread_mutex_unlock(&io_threads_pending_mutex);
     return count;
 }
+
+static void setIOPendingCount(int i, unsigned long count) {
+    pthread_mutex_lock(&io_threads_pending_mutex);
+    io_threads_pending[i] = count;
+    pthread_mutex_unlock(&io_threads_pending_mutex);
+}
+#endif
+
+/* Read and parse the query buffer of a client from an I/O thread. Errors
+ * are only flagged, the client is freed later by the main thread. */
+// I/O 线程中读取并解析客户端的命令请求
+static void readQueryFromClientThreaded(redisClient *c) {
+    int retval = readClientQueryBuffer(c);
+
+    if (retval == -1)
+        c->flags |= REDIS_IO_CLOSE;
+    else if (retval == 1)
+        processInputBuffer(c);
+}
+
+// I/O 线程的主函数
+void *IOThreadMain(void *myid) {
+    /* The ID is the thread number (from 0 to server.io_threads_num-1). */
+    long id = (unsigned long)myid;
+    sigset_t sigset;
+
+    /* Block SIGALRM so we are sure that only the main thread will
+     * receive the watchdog signal. */
+    sigemptyset(&sigset);
+    sigaddset(&sigset, SIGALRM);
+    if (pthread_sigmask(SIG_BLOCK, &sigset, NULL))
+        redisLog(REDIS_WARNING,
+            "Warning: can't mask SIGALRM in I/O thread: %s", strerror(errno));
+
+    while(1) {
+        listIter li;
+        listNode *ln;
+        int j;
+
+        /* Wait for start: spin for a while, then fall back to the mutex,
+         * that is held by the main thread while threaded I/O is stopped. */
+        // 先自旋等待任务，之后阻塞在互斥锁上（主线程停止 I/O 线程时会持有这个锁）
+        for (j = 0; j < 1000000; j++) {
+            if (getIOPendingCount(id) != 0) break;
+        }
+        if (getIOPendingCount(id) == 0) {
+            pthread_mutex_lock(&io_threads_mutex[id]);
+            pthread_mutex_unlock(&io_threads_mutex[id]);
+            continue;
+        }
+
+        /* Process: note that the main thread will never touch our list
+         * before we drop the pending count to 0. */
+        listRewind(io_threads_list[id],&li);
+        while((ln = listNext(&li))) {
+            redisClient *c = listNodeValue(ln);
+
+            if (io_threads_op == IO_THREADS_OP_WRITE) {
+                _writeToClient(c);
+            } else if (io_threads_op == IO_THREADS_OP_READ) {
+                readQueryFromClientThreaded(c);
+            } else {
+                redisPanic("io_threads_op value is unknown");
+            }
+        }
+        listEmpty(io_threads_list[id]);
+        setIOPendingCount(id,0);
+    }
+}
+
+/* Initialize the data structures needed for threaded I/O and spawn the
+ * I/O threads. Threads are created stopped: see startThreadedIO(). */
+// 初始化 I/O 线程，线程创建后处于停止状态
+void initThreadedIO(void) {
+    pthread_attr_t attr;
+    size_t stacksize;
+    int j;
+
+    server.io_threads_active = 0; /* We start with threads not active. */
+
+    /* Don't spawn any thread if the user selected a single thread:
+     * we'll handle I/O directly from the main thread. */
+    if (server.io_threads_num == 1) return;
+
+    if (server.io_threads_num > REDIS_IO_THREADS_MAX_NUM) {
+        redisLog(REDIS_WARNING,"Fatal: too many I/O threads configured. "
+                               "The maximum number is %d.",
+                               REDIS_IO_THREADS_MAX_NUM);
+        exit(1);
+    }
+
+    pthread_attr_init(&attr);
+    pthread_attr_getstacksize(&attr,&stacksize);
+    if (!stacksize) stacksize = 1; /* The world is full of Solaris Fixes */
+    while (stacksize < REDIS_THREAD_STACK_SIZE) stacksize *= 2;
+    pthread_attr_setstacksize(&attr, stacksize);
+
+    /* Spawn and initialize the I/O threads. */
+    for (j = 0; j < server.io_threads_num; j++) {
+        /* Things we do for all the threads including the main thread. */
+        io_threads_list[j] = listCreate();
+        if (j == 0) continue; /* Thread 0 is the main thread. */
+
+        /* Things we do only for the additional threads. */
+        pthread_t tid;
+        pthread_mutex_init(&io_threads_mutex[j],NULL);
+        setIOPendingCount(j,0);
+        pthread_mutex_lock(&io_threads_mutex[j]); /* Thread will be stopped. */
+        if (pthread_create(&tid,&attr,IOThreadMain,(void*)(long)j) != 0) {
+            redisLog(REDIS_WARNING,"Fatal: Can't initialize I/O threads.");
+            exit(1);
+        }
+        io_threads[j] = tid;
+    }
+}
+
+// 启动 I/O 线程：释放各个线程的互斥锁
+static void startThreadedIO(void) {
+    int j;
+
+    redisAssert(server.io_threads_active == 0);
+    for (j = 1; j < server.io_threads_num; j++)
+        pthread_mutex_unlock(&io_threads_mutex[j]);
+    server.io_threads_active = 1;
+}
+
+// 停止 I/O 线程：持有各个线程的互斥锁，线程会阻塞在锁上
+static void stopThreadedIO(void) {
+    int j;
+
+    /* We may have still clients with pending reads when this function
+     * is called: handle them before stopping the threads. */
+    handleClientsWithPendingReadsUsingThreads();
+    redisAssert(server.io_threads_active == 1);
+    for (j = 1; j < server.io_threads_num; j++)
+        pthread_mutex_lock(&io_threads_mutex[j]);
+    server.io_threads_active = 0;
+}
+
+/* This function checks if there are not enough pending clients to justify
+ * taking the I/O threads active: in that case I/O threads are stopped if
+ * currently active. We track the pending writes as a measure of clients
+ * we need to handle in parallel, however the I/O threads handle both reads
+ * and writes once started.
+ *
+ * The function returns 0 if the I/O threading should be used because there
+ * are enough active threads, otherwise 1 is returned and the I/O threads
+ * could be possibly stopped (if already active) as a side effect. */
+// 待写客户端太少时停止 I/O 线程，返回 1 表示不使用 I/O 线程
+static int stopThreadedIOIfNeeded(void) {
+    int pending = listLength(server.clients_pending_write);
+
+    /* Return ASAP if I/O threads are disabled (single threaded mode). */
+    if (server.io_threads_num == 1) return 1;
+
+    if (pending < (server.io_threads_num*2)) {
+        if (server.io_threads_active) stopThreadedIO();
+        return 1;
+    } else {
+        return 0;
+    }
+}
+
+/* Return 1 if we want to handle the client read later using threaded I/O.
+ * This is called by the readable handler of the event loop. As a side
+ * effect of calling this function the client is put in the pending read
+ * clients and flagged as such. */
+// 开启 I/O 线程时，把客户端加入 server.clients_pending_read ，推迟读取
+static int postponeClientRead(redisClient *c) {
+    if (c->flags & REDIS_PENDING_READ) return 1;
+    if (server.io_threads_active &&
+        !ProcessingEventsWhileBlocked &&
+        !(c->flags & (REDIS_MASTER|REDIS_SLAVE|REDIS_BLOCKED)))
+    {
+        c->flags |= REDIS_PENDING_READ;
+        listAddNodeHead(server.clients_pending_read,c);
+        return 1;
+    } else {
+        return 0;
+    }
+}
+
+/* Write the output buffers of all the clients in the pending write list
+ * from the main thread. Clients whose output could not be fully written
+ * because the socket buffer is full get a writable event handler. */
+// 在主线程中写出所有待写客户端的回复，写不完的才安装写处理器
+int handleClientsWithPendingWrites(void) {
+    int processed = listLength(server.clients_pending_write);
+
+    while (listLength(server.clients_pending_write)) {
+        listNode *ln = listFirst(server.clients_pending_write);
+        redisClient *c = listNodeValue(ln);
+
+        c->flags &= ~REDIS_PENDING_WRITE;
+        listDelNode(server.clients_pending_write,ln);
+
+        /* Try to write buffers to the client socket. */
+        if (writeToClient(c->fd,c,0) == REDIS_ERR) continue;
+
+        /* If there is nothing left, do nothing. Otherwise install
+         * the write handler. */
+        if (clientHasPendingReplies(c) &&
+            aeCreateFileEvent(server.el, c->fd, AE_WRITABLE,
+                sendReplyToClient, c) == AE_ERR)
+        {
+            freeClientAsync(c);
+        }
+    }
+    return processed;
+}
+
+/* Like handleClientsWithPendingWrites() but the writes are split among
+ * the I/O threads. Called by beforeSleep() before re-entering the event
+ * loop. */
+// 将待写客户端分配给 I/O 线程并行写出
+int handleClientsWithPendingWritesUsingThreads(void) {
+    int processed = listLength(server.clients_pending_write);
+    listIter li;
+    listNode *ln;
+    int j;
+
+    if (processed == 0) return 0; /* Return ASAP if there are no clients. */
+
+    /* If I/O threads are disabled or we have few clients to serve, don't
+     * use I/O threads, but the boring synchronous code. */
+    if (stopThreadedIOIfNeeded()) return handleClientsWithPendingWrites();
+
+    /* Start threads if needed. */
+    if (!server.io_threads_active) startThreadedIO();
+
+    /* Distribute the clients across N different lists. */
+    listRewind(server.clients_pending_write,&li);
+    int item_id = 0;
+    while((ln = listNext(&li))) {
+        redisClient *c = listNodeValue(ln);
+        c->flags &= ~REDIS_PENDING_WRITE;
+
+        /* Remove clients from the list of pending writes since
+         * they are going to be closed ASAP. */
+        if (c->flags & REDIS_CLOSE_ASAP) {
+            listDelNode(server.clients_pending_write,ln);
+            continue;
+        }
+
+        int target_id = item_id % server.io_threads_num;
+        listAddNodeTail(io_threads_list[target_id],c);
+        item_id++;
+    }
+
+    /* Give the start condition to the waiting threads, by setting the
+     * start condition atomic var. */
+    io_threads_op = IO_THREADS_OP_WRITE;
+    for (j = 1; j < server.io_threads_num; j++) {
+        int count = listLength(io_threads_list[j]);
+        setIOPendingCount(j,count);
+    }
+
+    /* Also use the main thread to process a slice of clients. */
+    listRewind(io_threads_list[0],&li);
+    while((ln = listNext(&li))) {
+        redisClient *c = listNodeValue(ln);
+        _writeToClient(c);
+    }
+    listEmpty(io_threads_list[0]);
+
+    /* Wait for all the other threads to end their work. */
+    while(1) {
+        unsigned long pending = 0;
+        for (j = 1; j < server.io_threads_num; j++)
+            pending += getIOPendingCount(j);
+        if (pending == 0) break;
+    }
+
+    /* Run the main thread half of the write on every client, and install
+     * the write handler where the socket buffer was full. */
+    while (listLength(server.clients_pending_write)) {
+        ln = listFirst(server.clients_pending_write);
+        redisClient *c = listNodeValue(ln);
+
+        listDelNode(server.clients_pending_write,ln);
+        if (writeToClientFinish(c,0) == REDIS_ERR) continue;
+
+        if (clientHasPendingReplies(c) &&
+            aeCreateFileEvent(server.el, c->fd, AE_WRITABLE,
+                sendReplyToClient, c) == AE_ERR)
+        {
+            freeClientAsync(c);
+        }
+    }
+
+    /* Update processed count on server */
+    server.stat_io_writes_processed += processed;
+
+    return processed;
+}
+
+/* When threaded I/O is active, readQueryFromClient() just queues clients
+ * in server.clients_pending_read. This function reads and parses them in
+ * parallel, then executes the parsed commands in the main thread. */
+// 由 I/O 线程并行读取、解析待读客户端，然后在主线程中执行解析好的命令
+int handleClientsWithPendingReadsUsingThreads(void) {
+    int processed = listLength(server.clients_pending_read);
+    listIter li;
+    listNode *ln;
+    int j;
+
+    if (!server.io_threads_active || processed == 0) return 0;
+
+    /* Distribute the clients across N different lists. */
+    listRewind(server.clients_pending_read,&li);
+    int item_id = 0;
+    while((ln = listNext(&li))) {
+        redisClient *c = listNodeValue(ln);
+        int target_id = item_id % server.io_threads_num;
+        listAddNodeTail(io_threads_list[target_id],c);
+        item_id++;
+    }
+
+    /* Give the start condition to the waiting threads, by setting the
+     * start condition atomic var. */
+    io_threads_op = IO_THREADS_OP_READ;
+    for (j = 1; j < server.io_threads_num; j++) {
+        int count = listLength(io_threads_list[j]);
+        setIOPendingCount(j,count);
+    }
+
+    /* Also use the main thread to process a slice of clients. */
+    listRewind(io_threads_list[0],&li);
+    while((ln = listNext(&li))) {
+        redisClient *c = listNodeValue(ln);
+        readQueryFromClientThreaded(c);
+    }
+    listEmpty(io_threads_list[0]);
+
+    /* Wait for all the other threads to end their work. */
+    while(1) {
+        unsigned long pending = 0;
+        for (j = 1; j < server.io_threads_num; j++)
+            pending += getIOPendingCount(j);
+        if (pending == 0) break;
+    }
+
+    /* Run the list of clients again to execute the parsed commands. Note
+     * that executing a command may free other clients of the list, so we
+     * always pop the first node before processing it. */
+    while(listLength(server.clients_pending_read)) {
+        ln = listFirst(server.clients_pending_read);
+        redisClient *c = listNodeValue(ln);
+
+        c->flags &= ~REDIS_PENDING_READ;
+        listDelNode(server.clients_pending_read,ln);
+
+        if (c->flags & REDIS_IO_CLOSE) {
+            logClientReadError(c);
+            freeClient(c);
+            continue;
+        }
+
+        /* Protocol errors may have been queued by the thread. */
+        asyncCloseClientOnOutputBufferLimitReached(c);
+
+        if (c->flags & REDIS_PENDING_COMMAND) {
+            server.current_client = c;
+            processInputBuffer(c);
+            server.current_client = NULL;
+        }
+        logClientProtocolError(c);
+
+        /* We may have pending replies if a thread queued a protocol error
+         * or if the command was executed with output already buffered. */
+        if (clientHasPendingReplies(c)) clientInstallWriteHandler(c);
+    }
+
+    /* Update processed count on server */
+    server.stat_io_reads_processed += processed;
+
+    return processed;
+}
@@ -43,8 +43,9 @@ robj *createObject(int type, void *ptr) {
     o->ptr = ptr;//设置object指针
     o->refcount = 1; //初始引用计数设为1
 
-    /* Set the LRU to the current lruclock (minutes resolution). */
-    o->lru = LRU_CLOCK();//设置最后一次访问的时间
+    /* Set the LRU to the current lruclock (minutes resolution), or
+     * initialize the LFU counter. */
+    initObjectLRUOrLFU(o);//设置最后一次访问的时间，或者初始化访问频率
     return o;
 }
 
@@ -63,20 +64,21 @@ robj *createRawStringObject(char *ptr, size_t len) {
 // 创建一个 REDIS_ENCODING_EMBSTR 编码的字符对，这个字符串对象中的 sds 会和字符串对象的 redisObject 结构一起分配
 // 因此这个字符也是不可修改的
 robj *createEmbeddedStringObject(char *ptr, size_t len) {
-    //sizeof(struct sdshdr)+len+1是sdshdr需要的内存大小
-    //一次把内存分配好，包括redisObject和sdshdr内存
-    robj *o = zmalloc(sizeof(robj)+sizeof(struct sdshdr)+len+1);
-    //o+1就是o向前移动sizeof(robj)字节大小，这样得到的是sdshdr的内存地址
-    struct sdshdr *sh = (void*)(o+1);
+    //sizeof(struct sdshdr8)+len+1是sdshdr8需要的内存大小，embstr 的长度不会超过 255 ，固定用 8 位头部
+    //一次把内存分配好，包括redisObject和sdshdr8内存
+    robj *o = zmalloc(sizeof(robj)+sizeof(struct sdshdr8)+len+1);
+    //o+1就是o向前移动sizeof(robj)字节大小，这样得到的是sdshdr8的内存地址
+    struct sdshdr8 *sh = (void*)(o+1);
 
     o->type = REDIS_STRING;//字符串对象
     o->encoding = REDIS_ENCODING_EMBSTR; //编码是embstr
-    o->ptr = sh+1;//sh向前走sizeof(sturct sdshdr)字节大小，指向char buf[]处，就是实际的sds处
+    o->ptr = sh+1;//sh向前走sizeof(struct sdshdr8)字节大小，指向char buf[]处，就是实际的sds处
     o->refcount = 1;
-    o->lru = LRU_CLOCK();
+    initObjectLRUOrLFU(o);
 
     sh->len = len;
-    sh->free = 0;
+    sh->alloc = len;
+    sh->flags = SDS_TYPE_8;
     if (ptr) {
 	//拷贝ptr指向的字符串到buf处
         memcpy(sh->buf,ptr,len);
@@ -87,16 +89,35 @@ robj *createEmbeddedStringObject(char *ptr, size_t len) {
     return o;
 }
 
-/* Create a string object with EMBSTR encoding if it is smaller than
- * REIDS_ENCODING_EMBSTR_SIZE_LIMIT, otherwise the RAW encoding is
- * used.
+/* Compute server.embstr_size_limit, the length of the longest string
+ * stored as EMBSTR. The limit is chosen so that the biggest EMBSTR object
+ * (16 bytes of robj, 3 bytes of sdshdr8, the string and the null term)
+ * exactly fills the allocator size class a REDIS_EMBSTR_MAX_ALLOC bytes
+ * request falls in: with jemalloc, and with glibc malloc counting the
+ * zmalloc size prefix, that is 128 bytes, for a limit of 108.
  *
- * The current limit of 39 is chosen so that the biggest string object
- * we allocate as EMBSTR will still fit into the 64 byte arena of jemalloc. */
-#define REDIS_ENCODING_EMBSTR_SIZE_LIMIT 39
-//len<=39则创建embstr编码的字符串对象，否则创建raw编码的字符串对象
+ * Until this is called the limit is REDIS_EMBSTR_MIN_SIZE_LIMIT (44), which
+ * fits the 64 bytes class of every allocator. */
+// 根据分配器的 size class 计算 EMBSTR 的长度上限，
+// 使最大的 EMBSTR 对象刚好填满 REDIS_EMBSTR_MAX_ALLOC 所属的 size class
+void initEmbstrSizeLimit(void) {
+    size_t overhead = sizeof(robj)+sizeof(struct sdshdr8)+1;
+    size_t limit = zmalloc_size_class(REDIS_EMBSTR_MAX_ALLOC)-overhead;
+
+    // EMBSTR 使用 sdshdr8 ，长度不能超过 255
+    if (limit > UINT8_MAX) limit = UINT8_MAX;
+    if (limit < REDIS_EMBSTR_MIN_SIZE_LIMIT) limit = REDIS_EMBSTR_MIN_SIZE_LIMIT;
+    server.embstr_size_limit = limit;
+}
+
+/* Create a string object with EMBSTR encoding if it is not longer than
+ * server.embstr_size_limit, otherwise the RAW encoding is used.
+ *
+ * EMBSTR objects are never modified in place: commands like APPEND and
+ * SETRANGE call dbUnshareStringValue() first, that turns them into RAW. */
+//len<=server.embstr_size_limit则创建embstr编码的字符串对象，否则创建raw编码的字符串对象
 robj *createStringObject(char *ptr, size_t len) {
-    if (len <= REDIS_ENCODING_EMBSTR_SIZE_LIMIT)
+    if (len <= server.embstr_size_limit)
         return createEmbeddedStringObject(ptr,len);
     else
         return createRawStringObject(ptr,len);
@@ -222,6 +243,16 @@ robj *createZiplistObject(void) {
     return o;
 }
 
+/*
+ * 创建一个 QUICKLIST 编码的列表对象，节点的填充因子为 list-quicklist-fill
+ */
+robj *createQuicklistObject(void) {
+    quicklist *ql = quicklistCreate(server.list_quicklist_fill);
+    robj *o = createObject(REDIS_LIST,ql);
+    o->encoding = REDIS_ENCODING_QUICKLIST;
+    return o;
+}
+
 /*
  * 创建一个 hashtable 编码的集合对象
  */
@@ -299,6 +330,10 @@ void freeListObject(robj *o) {
         zfree(o->ptr);//释放ziplist内存
         break;
 
+    case REDIS_ENCODING_QUICKLIST:
+        quicklistRelease(o->ptr); //释放 quicklist 内存
+        break;
+
     default:
         redisPanic("Unknown list encoding type");
     }
@@ -524,7 +559,7 @@ robj *tryObjectEncoding(robj *o) {
      * In this representation the object and the SDS string are allocated
      * in the same chunk of memory to save space and cache misses. */
     // 将raw编码的转换成embstr编码的字符串对象
-    if (len <= REDIS_ENCODING_EMBSTR_SIZE_LIMIT) {
+    if (len <= server.embstr_size_limit) {
         robj *emb;
 
         if (o->encoding == REDIS_ENCODING_EMBSTR) return o;//如果已经是embstr编码的，直接返回
@@ -541,7 +576,7 @@ robj *tryObjectEncoding(robj *o) {
      *
      * We do that only for relatively large strings as this branch
      * is only entered if the length of the string is greater than
-     * REDIS_ENCODING_EMBSTR_SIZE_LIMIT. */
+     * server.embstr_size_limit. */
     // 这个对象没办法进行编码，尝试从 SDS 中移除所有空余空间
     if (o->encoding == REDIS_ENCODING_RAW &&
         sdsavail(s) > len/10)
@@ -575,7 +610,7 @@ robj *getDecodedObject(robj *o) {
         char buf[32];
 
         ll2string(buf,32,(long)o->ptr);//整数写入buf中
-        dec = createStringObject(buf,strlen(buf)); //创建字符串对象（因为长度小于39，创建出来的是embstr编码的字符串对象）
+        dec = createStringObject(buf,strlen(buf)); //创建字符串对象（因为长度很短，创建出来的是embstr编码的字符串对象）
         return dec;
 
     } else {
@@ -918,6 +953,7 @@ char *strEncoding(int encoding) {
     case REDIS_ENCODING_INTSET: return "intset";
     case REDIS_ENCODING_SKIPLIST: return "skiplist";
     case REDIS_ENCODING_EMBSTR: return "embstr";
+    case REDIS_ENCODING_QUICKLIST: return "quicklist";
     default: return "unknown";
     }
 }
@@ -935,6 +971,71 @@ unsigned long long estimateObjectIdleTime(robj *o) {
     }
 }
 
+/* ----------------------------------------------------------------------------
+ * LFU (Least Frequently Used) implementation.
+ * See the layout of the lru bits of an object near REDIS_LFU_INIT_VAL.
+ * --------------------------------------------------------------------------*/
+
+/* Return the current time in minutes, just taking the least significant
+ * 16 bits. The returned time is suitable to be stored as LDT (last decrement
+ * time) for the LFU implementation. */
+// 返回当前时间（分钟）的低 16 位，作为计数器上次衰减的时间
+unsigned long LFUGetTimeInMinutes(void) {
+    return (server.unixtime/60) & 65535;
+}
+
+/* Given an object last decrement time, compute the minimum number of minutes
+ * that elapsed since the last decrement, handling the wrap of the 16 bits
+ * clock. */
+static unsigned long LFUTimeElapsed(unsigned long ldt) {
+    unsigned long now = LFUGetTimeInMinutes();
+    if (now >= ldt) return now-ldt;
+    return 65535-ldt+now;
+}
+
+/* Logarithmically increment a counter. The greater is the current counter
+ * value the less likely is that it gets really incremented: with the
+ * default lfu-log-factor of 10 the counter saturates at 255 after about one
+ * million accesses. */
+// 以对数方式增加计数器，计数器越大，增加的概率越小
+static uint8_t LFULogIncr(uint8_t counter) {
+    double r, baseval, p;
+
+    if (counter == 255) return 255;
+    r = (double)rand()/RAND_MAX;
+    baseval = counter - REDIS_LFU_INIT_VAL;
+    if (baseval < 0) baseval = 0;
+    p = 1.0/(baseval*server.lfu_log_factor+1);
+    if (r < p) counter++;
+    return counter;
+}
+
+/* Return the access counter of the object, decremented by one for every
+ * lfu-decay-time minutes elapsed since the last decrement. The object is
+ * not modified: updateLFU() stores the decayed value when the object is
+ * accessed. */
+// 返回衰减后的访问计数器，每过 lfu-decay-time 分钟减一
+unsigned long LFUDecrAndReturn(robj *o) {
+    unsigned long ldt = o->lru >> 8;
+    unsigned long counter = o->lru & 255;
+    unsigned long num_periods = server.lfu_decay_time ?
+        LFUTimeElapsed(ldt) / server.lfu_decay_time : 0;
+
+    if (num_periods)
+        counter = (num_periods > counter) ? 0 : counter - num_periods;
+    return counter;
+}
+
+/* Update the LFU data of an object that was just accessed: decay the
+ * counter, then increment it. */
+// 对象被访问时调用：衰减并增加访问计数器
+void updateLFU(robj *o) {
+    unsigned long counter = LFUDecrAndReturn(o);
+
+    counter = LFULogIncr(counter);
+    o->lru = (LFUGetTimeInMinutes()<<8) | counter;
+}
+
 /* This is a helper function for the OBJECT command. We need to lookup keys
  * without any modification of LRU or other parameters.
  * OBJECT 命令的辅助函数，用于在不修改 LRU 时间的情况下，尝试获取 key 对象
@@ -975,12 +1076,26 @@ void objectCommand(redisClient *c) {
                 == NULL) return;
         addReplyBulkCString(c,strEncoding(o->encoding));
     
-    // 返回对象的空闲时间
+    // 返回对象的空闲时间，LFU 策略下 lru 属性保存的不是访问时间
     } else if (!strcasecmp(c->argv[1]->ptr,"idletime") && c->argc == 3) {
         if ((o = objectCommandLookupOrReply(c,c->argv[2],shared.nullbulk))
                 == NULL) return;
+        if (REDIS_MAXMEMORY_POLICY_LFU(server.maxmemory_policy)) {
+            addReplyError(c,"An LFU maxmemory policy is selected, idle time not tracked. Please note that when switching between policies at runtime LRU and LFU data will take some time to adjust.");
+            return;
+        }
         addReplyLongLong(c,estimateObjectIdleTime(o)/1000);
+
+    // 返回对象的访问频率（对数计数器），只有 LFU 策略下才有
+    } else if (!strcasecmp(c->argv[1]->ptr,"freq") && c->argc == 3) {
+        if ((o = objectCommandLookupOrReply(c,c->argv[2],shared.nullbulk))
+                == NULL) return;
+        if (!REDIS_MAXMEMORY_POLICY_LFU(server.maxmemory_policy)) {
+            addReplyError(c,"An LFU maxmemory policy is not selected, access frequency not tracked. Please note that when switching between policies at runtime LRU and LFU data will take some time to adjust.");
+            return;
+        }
+        addReplyLongLong(c,LFUDecrAndReturn(o));
     } else {
-        addReplyError(c,"Syntax error. Try OBJECT (refcount|encoding|idletime)");
+        addReplyError(c,"Syntax error. Try OBJECT (refcount|encoding|idletime|freq)");
     }
 }
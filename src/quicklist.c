@@ -0,0 +1,544 @@
+/* quicklist.c - A doubly linked list of ziplists
+ *
+ * A list encoded as a linked list costs a listNode, a robj and a sds string
+ * for every element, that is about 70 bytes of overhead for small values. A
+ * ziplist stores the elements with one or two bytes of overhead, but every
+ * insertion or deletion moves the memory of the whole ziplist, so it is only
+ * used for small lists.
+ *
+ * A quicklist is a doubly linked list of ziplists of bounded size: pushes
+ * and pops only touch the ziplist at the head or the tail, and the overhead
+ * of a node (the quicklistNode and the ziplist header) is shared by all the
+ * elements of its ziplist.
+ *
+ * The fill factor of the quicklist bounds the nodes:
+ *
+ *  - A positive fill is the max number of entries of a node. A node also
+ *    stops growing at QUICKLIST_SIZE_SAFETY_LIMIT bytes, so that big
+ *    elements can't create huge ziplists.
+ *  - A fill from -1 to -5 is the max size of the ziplist of a node:
+ *    4, 8, 16, 32 or 64 kb.
+ *
+ * An element that does not fit a node alone gets a node of its own.
+ *
+ * quicklist：由 ziplist 组成的双端链表。
+ * 每个节点保存一个有大小限制的 ziplist，
+ * 节点的开销由 ziplist 中的所有元素分摊，
+ * 在表头和表尾的 push 和 pop 只需要修改表头或表尾节点的 ziplist 。
+ * 填充因子为正数时限制节点的元素数量，为 -1 到 -5 时限制节点 ziplist 的字节数。
+ *
+ * Copyright (c) 2009-2012, Salvatore Sanfilippo <antirez at gmail dot com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include "zmalloc.h"
+#include "util.h"
+#include "ziplist.h"
+#include "quicklist.h"
+
+/* Max ziplist size of a node for the fill factors -1 ... -5. */
+// 填充因子为 -1 到 -5 时节点 ziplist 的最大字节数
+static const size_t quicklistSizeLimits[] = {4096, 8192, 16384, 32768, 65536};
+
+/* Max ziplist size of a node with a positive fill factor. */
+#define QUICKLIST_SIZE_SAFETY_LIMIT 8192
+
+/* Upper bound of the bytes added to a ziplist by a new entry besides its
+ * value: a 5 bytes previous entry length, a 5 bytes string encoding, and
+ * the previous entry length of the following entry growing from 1 to 5
+ * bytes. An integer encoded entry is never larger than its string. */
+#define QUICKLIST_ENTRY_OVERHEAD 14
+
+#define quicklistNodeUpdateSz(node) ((node)->sz = ziplistBlobLen((node)->zl))
+
+/*
+ * 创建并返回一个新的 quicklist
+ */
+quicklist *quicklistCreate(int fill) {
+    quicklist *ql = zmalloc(sizeof(*ql));
+
+    ql->head = ql->tail = NULL;
+    ql->count = 0;
+    ql->len = 0;
+    if (fill < QUICKLIST_MIN_FILL) fill = QUICKLIST_MIN_FILL;
+    if (fill > QUICKLIST_MAX_FILL) fill = QUICKLIST_MAX_FILL;
+    if (fill == 0) fill = 1;
+    ql->fill = fill;
+    return ql;
+}
+
+/* Create a node holding the ziplist 'zl'. */
+static quicklistNode *quicklistCreateNode(unsigned char *zl) {
+    quicklistNode *node = zmalloc(sizeof(*node));
+
+    node->prev = node->next = NULL;
+    node->zl = zl;
+    node->count = ziplistLen(zl);
+    quicklistNodeUpdateSz(node);
+    return node;
+}
+
+/* Link 'new_node' after 'old_node', or before it if 'after' is 0.
+ * 'old_node' can only be NULL if the quicklist is empty. */
+// 将 new_node 链接到 old_node 之后（after 为 0 时链接到之前）
+static void quicklistLinkNode(quicklist *ql, quicklistNode *old_node,
+                              quicklistNode *new_node, int after) {
+    if (after) {
+        new_node->prev = old_node;
+        if (old_node) {
+            new_node->next = old_node->next;
+            if (old_node->next) old_node->next->prev = new_node;
+            old_node->next = new_node;
+        }
+        if (ql->tail == old_node) ql->tail = new_node;
+    } else {
+        new_node->next = old_node;
+        if (old_node) {
+            new_node->prev = old_node->prev;
+            if (old_node->prev) old_node->prev->next = new_node;
+            old_node->prev = new_node;
+        }
+        if (ql->head == old_node) ql->head = new_node;
+    }
+    if (ql->len == 0) ql->head = ql->tail = new_node;
+    ql->len++;
+    ql->count += new_node->count;
+}
+
+/* Unlink and free 'node' with its entries. */
+// 移除并释放节点以及节点中的所有元素
+static void quicklistDelNode(quicklist *ql, quicklistNode *node) {
+    if (node->prev) node->prev->next = node->next;
+    else ql->head = node->next;
+    if (node->next) node->next->prev = node->prev;
+    else ql->tail = node->prev;
+    ql->len--;
+    ql->count -= node->count;
+    zfree(node->zl);
+    zfree(node);
+}
+
+/* Return 1 if an entry of 'sz' bytes can be added to 'node' without
+ * exceeding the fill factor, otherwise 0 (also when 'node' is NULL). */
+// 检查节点是否还能放下一个 sz 字节的元素
+static int quicklistNodeAllowInsert(quicklist *ql, quicklistNode *node,
+                                    unsigned int sz) {
+    size_t new_sz;
+
+    if (node == NULL) return 0;
+    new_sz = (size_t)node->sz + sz + QUICKLIST_ENTRY_OVERHEAD;
+    if (ql->fill > 0)
+        return node->count < (unsigned int)ql->fill &&
+               new_sz <= QUICKLIST_SIZE_SAFETY_LIMIT;
+    return new_sz <= quicklistSizeLimits[-ql->fill-1];
+}
+
+/*
+ * 释放整个 quicklist
+ */
+void quicklistRelease(quicklist *ql) {
+    quicklistNode *node = ql->head, *next;
+
+    while (node) {
+        next = node->next;
+        zfree(node->zl);
+        zfree(node);
+        node = next;
+    }
+    zfree(ql);
+}
+
+/* Push 'value' at the head or at the tail of the quicklist, according to
+ * 'where' (QUICKLIST_HEAD or QUICKLIST_TAIL). A new node is created when
+ * the head or tail node is full.
+ *
+ * 将 value 推入 quicklist 的表头或表尾，表头或表尾节点已满时创建新节点 */
+void quicklistPush(quicklist *ql, unsigned char *value, unsigned int sz, int where) {
+    quicklistNode *node = (where == QUICKLIST_HEAD) ? ql->head : ql->tail;
+
+    if (!quicklistNodeAllowInsert(ql,node,sz)) {
+        quicklistNode *new_node = quicklistCreateNode(ziplistNew());
+
+        quicklistLinkNode(ql,node,new_node,where == QUICKLIST_TAIL);
+        node = new_node;
+    }
+    node->zl = ziplistPush(node->zl,value,sz,
+        (where == QUICKLIST_HEAD) ? ZIPLIST_HEAD : ZIPLIST_TAIL);
+    node->count++;
+    quicklistNodeUpdateSz(node);
+    ql->count++;
+}
+
+/* Append all the entries of the ziplist 'zl' at the tail of the quicklist.
+ * 'zl' is not modified. */
+// 将 ziplist 中的所有元素添加到 quicklist 的表尾
+void quicklistAppendZiplistValues(quicklist *ql, unsigned char *zl) {
+    unsigned char *p = ziplistIndex(zl,0), *vstr;
+    unsigned int vlen;
+    long long vlong;
+    char buf[32];
+
+    while (p != NULL) {
+        ziplistGet(p,&vstr,&vlen,&vlong);
+        if (vstr == NULL) {
+            vlen = ll2string(buf,sizeof(buf),vlong);
+            vstr = (unsigned char*)buf;
+        }
+        quicklistPush(ql,vstr,vlen,QUICKLIST_TAIL);
+        p = ziplistNext(zl,p);
+    }
+}
+
+/* Delete the entry at '*p' of 'node', updating '*p' like ziplistDelete().
+ * Returns 1 if the node was released as it was left empty, otherwise 0. */
+static int quicklistDelIndex(quicklist *ql, quicklistNode *node, unsigned char **p) {
+    node->zl = ziplistDelete(node->zl,p);
+    node->count--;
+    ql->count--;
+    if (node->count == 0) {
+        quicklistDelNode(ql,node);
+        return 1;
+    }
+    quicklistNodeUpdateSz(node);
+    return 0;
+}
+
+/* Lookup the entry at 'index', zero based, negative indexes counting from
+ * the tail. Returns 1 and fills 'entry' if the entry exists, otherwise
+ * returns 0.
+ *
+ * 查找索引 index 上的元素，找到时将它保存到 entry 并返回 1 ，否则返回 0 */
+int quicklistIndex(quicklist *ql, long index, quicklistEntry *entry) {
+    int forward = index >= 0;
+    unsigned long target, seen = 0;
+    quicklistNode *node;
+
+    memset(entry,0,sizeof(*entry));
+    entry->quicklist = ql;
+    target = forward ? (unsigned long)index : (unsigned long)(-(index+1));
+    if (target >= ql->count) return 0;
+
+    // 跳过不包含目标元素的节点
+    node = forward ? ql->head : ql->tail;
+    while (seen + node->count <= target) {
+        seen += node->count;
+        node = forward ? node->next : node->prev;
+    }
+
+    entry->node = node;
+    entry->offset = forward ? (long)(target-seen) :
+                              (long)(node->count-1-(target-seen));
+    entry->zi = ziplistIndex(node->zl,entry->offset);
+    ziplistGet(entry->zi,&entry->value,&entry->sz,&entry->longval);
+    return 1;
+}
+
+/* Pop the entry at the head or at the tail according to 'where'. Returns 0
+ * if the quicklist is empty. String entries are copied with 'saver' into
+ * '*data', for integer entries '*data' is set to NULL and '*sval' to the
+ * value.
+ *
+ * 弹出表头或表尾的元素。字符串元素由 saver 复制到 *data ，
+ * 整数元素的值保存在 *sval 中，同时 *data 被设为 NULL */
+int quicklistPop(quicklist *ql, int where, void **data, long long *sval,
+                 void *(*saver)(unsigned char *data, unsigned int sz)) {
+    quicklistEntry entry;
+
+    if (!quicklistIndex(ql,(where == QUICKLIST_HEAD) ? 0 : -1,&entry))
+        return 0;
+    if (entry.value) {
+        *data = saver(entry.value,entry.sz);
+    } else {
+        *data = NULL;
+        *sval = entry.longval;
+    }
+    quicklistDelIndex(ql,entry.node,&entry.zi);
+    return 1;
+}
+
+/* Insert 'value' after the entry (or before it if 'after' is 0).
+ *
+ * If the node of the entry is full and the entry is at its edge the value
+ * goes to the neighbour node, or to a new node. Otherwise the node is split
+ * at the insertion point, and the value is appended to its first half. */
+static void quicklistInsert(quicklistEntry *entry, unsigned char *value,
+                            unsigned int sz, int after) {
+    quicklist *ql = entry->quicklist;
+    quicklistNode *node = entry->node, *new_node;
+    long offset = entry->offset < 0 ? entry->offset + (long)node->count :
+                                      entry->offset;
+    int at_head = !after && offset == 0;
+    int at_tail = after && offset == (long)node->count-1;
+
+    if (quicklistNodeAllowInsert(ql,node,sz)) {
+        // 节点还有空间，直接插入到节点的 ziplist 中
+        if (after) {
+            unsigned char *next = ziplistNext(node->zl,entry->zi);
+
+            if (next == NULL)
+                node->zl = ziplistPush(node->zl,value,sz,ZIPLIST_TAIL);
+            else
+                node->zl = ziplistInsert(node->zl,next,value,sz);
+        } else {
+            node->zl = ziplistInsert(node->zl,entry->zi,value,sz);
+        }
+    } else if (at_head || at_tail) {
+        // 节点已满，元素在节点的边缘：放入相邻节点，或者新建一个节点
+        quicklistNode *neighbour = at_tail ? node->next : node->prev;
+
+        if (quicklistNodeAllowInsert(ql,neighbour,sz)) {
+            node = neighbour;
+            node->zl = ziplistPush(node->zl,value,sz,
+                at_tail ? ZIPLIST_HEAD : ZIPLIST_TAIL);
+        } else {
+            new_node = quicklistCreateNode(ziplistNew());
+            quicklistLinkNode(ql,node,new_node,at_tail);
+            node = new_node;
+            node->zl = ziplistPush(node->zl,value,sz,ZIPLIST_TAIL);
+        }
+    } else {
+        // 节点已满，元素在节点的中间：在插入位置分裂节点
+        unsigned int split = after ? offset+1 : offset;
+        unsigned char *zl = zmalloc(node->sz);
+
+        memcpy(zl,node->zl,node->sz);
+        new_node = quicklistCreateNode(ziplistDeleteRange(zl,0,split));
+        node->zl = ziplistDeleteRange(node->zl,split,node->count-split);
+        ql->count -= node->count - split;
+        node->count = split;
+        quicklistNodeUpdateSz(node);
+        quicklistLinkNode(ql,node,new_node,1);
+
+        if (!quicklistNodeAllowInsert(ql,node,sz)) {
+            new_node = quicklistCreateNode(ziplistNew());
+            quicklistLinkNode(ql,node,new_node,1);
+            node = new_node;
+        }
+        node->zl = ziplistPush(node->zl,value,sz,ZIPLIST_TAIL);
+    }
+    node->count++;
+    quicklistNodeUpdateSz(node);
+    ql->count++;
+}
+
+/* Insert 'value' before the entry returned by quicklistNext() or
+ * quicklistIndex(). The iterator of the entry can't be used anymore. */
+void quicklistInsertBefore(quicklistEntry *entry, unsigned char *value, unsigned int sz) {
+    quicklistInsert(entry,value,sz,0);
+}
+
+/* Insert 'value' after the entry, see quicklistInsertBefore(). */
+void quicklistInsertAfter(quicklistEntry *entry, unsigned char *value, unsigned int sz) {
+    quicklistInsert(entry,value,sz,1);
+}
+
+/* Replace the entry at 'index' with 'value'. Returns 0 if the index is out
+ * of range.
+ *
+ * If the new value does not fit the node of the entry it is inserted like
+ * LINSERT would do, so the node is split or the value gets a node of its
+ * own, and the fill factor still bounds the node. */
+// 将索引 index 上的元素替换为 value ，节点放不下新值时按插入的方式处理
+int quicklistReplaceAtIndex(quicklist *ql, long index, unsigned char *value, unsigned int sz) {
+    quicklistEntry entry;
+    quicklistNode *node;
+    long offset;
+
+    if (!quicklistIndex(ql,index,&entry)) return 0;
+    node = entry.node;
+    offset = entry.offset < 0 ? entry.offset + (long)node->count :
+                                entry.offset;
+    node->zl = ziplistDelete(node->zl,&entry.zi);
+    node->count--;
+    ql->count--;
+    quicklistNodeUpdateSz(node);
+
+    if (node->count == 0 || quicklistNodeAllowInsert(ql,node,sz)) {
+        node->zl = ziplistInsert(node->zl,entry.zi,value,sz);
+        node->count++;
+        quicklistNodeUpdateSz(node);
+        ql->count++;
+    } else if (offset < (long)node->count) {
+        // 插入到被替换元素的下一个元素之前
+        entry.offset = offset;
+        quicklistInsert(&entry,value,sz,0);
+    } else {
+        // 被替换的是节点的最后一个元素：插入到新的最后一个元素之后
+        entry.offset = offset-1;
+        entry.zi = ziplistIndex(node->zl,-1);
+        quicklistInsert(&entry,value,sz,1);
+    }
+    return 1;
+}
+
+/* Delete the entry just returned by quicklistNext(), updating the iterator
+ * so that the next call returns the entry following the deleted one.
+ *
+ * 删除迭代器刚返回的元素，并更新迭代器 */
+void quicklistDelEntry(quicklistIter *iter, quicklistEntry *entry) {
+    quicklistNode *prev = entry->node->prev;
+    quicklistNode *next = entry->node->next;
+    int deleted_node = quicklistDelIndex(iter->quicklist,entry->node,&entry->zi);
+
+    /* Without a node the iterator looks up iter->offset again: from the
+     * head the following entry moved to the offset of the deleted one, and
+     * from the tail (negative offsets) the preceding entry did. */
+    // 删除之后，下一个元素正好位于被删除元素的索引上
+    iter->zi = NULL;
+    if (deleted_node) {
+        if (iter->direction == QUICKLIST_START_HEAD) {
+            iter->current = next;
+            iter->offset = 0;
+        } else {
+            iter->current = prev;
+            iter->offset = -1;
+        }
+    }
+}
+
+/* Delete 'count' entries starting at 'index' (negative indexes count from
+ * the tail). Entries out of range are ignored.
+ *
+ * 从索引 start 开始删除 count 个元素 */
+void quicklistDelRange(quicklist *ql, long start, long count) {
+    quicklistEntry entry;
+    quicklistNode *node;
+    unsigned long extent;
+    long offset;
+
+    if (count <= 0 || !quicklistIndex(ql,start,&entry)) return;
+
+    // 从 start 到表尾的元素数量
+    extent = start >= 0 ? ql->count - start : (unsigned long)(-(start+1))+1;
+    if ((unsigned long)count < extent) extent = count;
+
+    node = entry.node;
+    offset = entry.offset;
+    while (extent) {
+        quicklistNode *next = node->next;
+        unsigned long del = node->count - offset;
+
+        if (del > extent) del = extent;
+        if (del == node->count) {
+            // 整个节点都被删除
+            quicklistDelNode(ql,node);
+        } else {
+            node->zl = ziplistDeleteRange(node->zl,offset,del);
+            node->count -= del;
+            ql->count -= del;
+            quicklistNodeUpdateSz(node);
+        }
+        extent -= del;
+        node = next;
+        offset = 0;
+    }
+}
+
+/* Return an iterator starting at the head (QUICKLIST_START_HEAD) or at the
+ * tail (QUICKLIST_START_TAIL) of the quicklist. */
+// 创建并返回一个 quicklist 迭代器
+quicklistIter *quicklistGetIterator(quicklist *ql, int direction) {
+    quicklistIter *iter = zmalloc(sizeof(*iter));
+
+    iter->quicklist = ql;
+    iter->direction = direction;
+    iter->zi = NULL;
+    if (direction == QUICKLIST_START_HEAD) {
+        iter->current = ql->head;
+        iter->offset = 0;
+    } else {
+        iter->current = ql->tail;
+        iter->offset = -1;
+    }
+    return iter;
+}
+
+/* Return an iterator whose first entry is the one at 'index'. If the index
+ * is out of range the iterator returns no entries. */
+// 创建一个从索引 index 开始迭代的迭代器
+quicklistIter *quicklistGetIteratorAtIdx(quicklist *ql, int direction, long index) {
+    quicklistIter *iter = quicklistGetIterator(ql,direction);
+    quicklistEntry entry;
+
+    if (quicklistIndex(ql,index,&entry)) {
+        iter->current = entry.node;
+        iter->offset = entry.offset;
+        if (direction == QUICKLIST_START_TAIL)
+            iter->offset -= (long)entry.node->count;
+    } else {
+        iter->current = NULL;
+    }
+    return iter;
+}
+
+/* Store the next entry in 'entry' and return 1, or return 0 when the
+ * iteration is over. The quicklist may only be modified during the
+ * iteration with quicklistDelEntry().
+ *
+ * 将迭代器的下一个元素保存到 entry 并返回 1 ，迭代完毕时返回 0 */
+int quicklistNext(quicklistIter *iter, quicklistEntry *entry) {
+    int forward = iter->direction == QUICKLIST_START_HEAD;
+
+    entry->quicklist = iter->quicklist;
+    while (iter->current) {
+        unsigned char *zl = iter->current->zl;
+
+        if (iter->zi == NULL) {
+            iter->zi = ziplistIndex(zl,iter->offset);
+        } else if (forward) {
+            iter->zi = ziplistNext(zl,iter->zi);
+            iter->offset++;
+        } else {
+            iter->zi = ziplistPrev(zl,iter->zi);
+            iter->offset--;
+        }
+
+        if (iter->zi) {
+            entry->node = iter->current;
+            entry->zi = iter->zi;
+            entry->offset = iter->offset;
+            ziplistGet(entry->zi,&entry->value,&entry->sz,&entry->longval);
+            return 1;
+        }
+
+        // 当前节点已经迭代完毕，继续迭代下一个节点
+        iter->current = forward ? iter->current->next : iter->current->prev;
+        iter->offset = forward ? 0 : -1;
+    }
+    return 0;
+}
+
+/* Release the iterator. */
+void quicklistReleaseIterator(quicklistIter *iter) {
+    zfree(iter);
+}
+
+/* Return 1 if the entry is equal to the string 's' of 'slen' bytes. */
+unsigned int quicklistCompare(quicklistEntry *entry, unsigned char *s, unsigned int slen) {
+    return ziplistCompare(entry->zi,s,slen);
+}
@@ -0,0 +1,164 @@
+/* quicklist.h - A doubly linked list of ziplists
+ *
+ * Copyright (c) 2009-2012, Salvatore Sanfilippo <antirez at gmail dot com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __QUICKLIST_H__
+#define __QUICKLIST_H__
+
+/*
+ * quicklist 节点，每个节点保存一个 ziplist
+ */
+typedef struct quicklistNode {
+
+    // 前置节点
+    struct quicklistNode *prev;
+
+    // 后置节点
+    struct quicklistNode *next;
+
+    // 节点保存的 ziplist
+    unsigned char *zl;
+
+    // ziplist 占用的字节数
+    unsigned int sz;             /* ziplist size in bytes */
+
+    // ziplist 中的元素数量
+    unsigned int count;          /* count of items in the ziplist */
+
+} quicklistNode;
+
+/*
+ * quicklist 结构：由 ziplist 组成的双端链表
+ */
+typedef struct quicklist {
+
+    // 表头节点
+    quicklistNode *head;
+
+    // 表尾节点
+    quicklistNode *tail;
+
+    // 所有 ziplist 中的元素总数
+    unsigned long count;         /* total count of all entries */
+
+    // 节点数量
+    unsigned long len;           /* number of quicklistNodes */
+
+    // 节点的填充因子，见 quicklist.c
+    int fill;                    /* fill factor of the nodes */
+
+} quicklist;
+
+/*
+ * quicklist 迭代器
+ */
+typedef struct quicklistIter {
+
+    // 被迭代的 quicklist
+    quicklist *quicklist;
+
+    // 当前节点
+    quicklistNode *current;
+
+    // 上次返回的元素在 ziplist 中的位置，NULL 时按 offset 定位
+    unsigned char *zi;
+
+    // 元素在当前节点中的索引，从表头迭代时为正数，从表尾迭代时为负数
+    long offset;
+
+    // 迭代的方向
+    int direction;
+
+} quicklistIter;
+
+/*
+ * quicklistNext() 和 quicklistIndex() 返回的元素
+ */
+typedef struct quicklistEntry {
+
+    // 元素所在的 quicklist
+    quicklist *quicklist;
+
+    // 元素所在的节点
+    quicklistNode *node;
+
+    // 元素在 ziplist 中的位置
+    unsigned char *zi;
+
+    // 字符串元素的值，整数元素时为 NULL
+    unsigned char *value;
+
+    // 字符串元素的长度
+    unsigned int sz;
+
+    // 整数元素的值
+    long long longval;
+
+    // 元素在节点中的索引
+    long offset;
+
+} quicklistEntry;
+
+/* Push positions. */
+#define QUICKLIST_HEAD 0
+#define QUICKLIST_TAIL 1
+
+/* Iteration directions, the same values of adlist.h. */
+#define QUICKLIST_START_HEAD 0
+#define QUICKLIST_START_TAIL 1
+
+/* Fill factor limits: a positive fill is the max number of entries of a
+ * node, a negative fill selects the max ziplist size of a node. */
+#define QUICKLIST_MIN_FILL -5
+#define QUICKLIST_MAX_FILL 32767
+
+/* Prototypes */
+quicklist *quicklistCreate(int fill);
+void quicklistRelease(quicklist *ql);
+void quicklistPush(quicklist *ql, unsigned char *value, unsigned int sz, int where);
+void quicklistAppendZiplistValues(quicklist *ql, unsigned char *zl);
+int quicklistPop(quicklist *ql, int where, void **data, long long *sval,
+                 void *(*saver)(unsigned char *data, unsigned int sz));
+int quicklistIndex(quicklist *ql, long index, quicklistEntry *entry);
+int quicklistReplaceAtIndex(quicklist *ql, long index, unsigned char *value, unsigned int sz);
+void quicklistInsertBefore(quicklistEntry *entry, unsigned char *value, unsigned int sz);
+void quicklistInsertAfter(quicklistEntry *entry, unsigned char *value, unsigned int sz);
+void quicklistDelEntry(quicklistIter *iter, quicklistEntry *entry);
+void quicklistDelRange(quicklist *ql, long start, long count);
+quicklistIter *quicklistGetIterator(quicklist *ql, int direction);
+quicklistIter *quicklistGetIteratorAtIdx(quicklist *ql, int direction, long index);
+int quicklistNext(quicklistIter *iter, quicklistEntry *entry);
+void quicklistReleaseIterator(quicklistIter *iter);
+unsigned int quicklistCompare(quicklistEntry *entry, unsigned char *s, unsigned int slen);
+
+/* Macros */
+#define quicklistCount(ql) ((ql)->count)
+#define quicklistNodes(ql) ((ql)->len)
+
+#endif /* __QUICKLIST_H__ */
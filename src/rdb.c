@@ -637,7 +637,8 @@ int rdbSaveObjectType(rio *rdb, robj *o) {
     case REDIS_LIST: //列表对象
         if (o->encoding == REDIS_ENCODING_ZIPLIST) //ziplist编码
             return rdbSaveType(rdb,REDIS_RDB_TYPE_LIST_ZIPLIST);
-        else if (o->encoding == REDIS_ENCODING_LINKEDLIST)//linkedlist编码
+        else if (o->encoding == REDIS_ENCODING_LINKEDLIST ||
+                 o->encoding == REDIS_ENCODING_QUICKLIST)//linkedlist或quicklist编码
             return rdbSaveType(rdb,REDIS_RDB_TYPE_LIST);//编码是LIST
         else
             redisPanic("Unknown list encoding");
@@ -723,6 +724,28 @@ int rdbSaveObject(rio *rdb, robj *o) {
                 if ((n = rdbSaveStringObject(rdb,eleobj)) == -1) return -1;
                 nwritten += n;
             }
+        } else if (o->encoding == REDIS_ENCODING_QUICKLIST) {
+        //quicklist编码的列表和linkedlist一样，逐个保存列表项，rdb文件和旧版本兼容
+            quicklist *ql = o->ptr;
+            quicklistIter *iter;
+            quicklistEntry entry;
+
+            if ((n = rdbSaveLen(rdb,quicklistCount(ql))) == -1) return -1;
+            nwritten += n;
+
+            iter = quicklistGetIterator(ql,QUICKLIST_START_HEAD);
+            while(quicklistNext(iter,&entry)) {
+                if (entry.value)
+                    n = rdbSaveRawString(rdb,entry.value,entry.sz);
+                else
+                    n = rdbSaveLongLongAsStringObject(rdb,entry.longval);
+                if (n == -1) {
+                    quicklistReleaseIterator(iter);
+                    return -1;
+                }
+                nwritten += n;
+            }
+            quicklistReleaseIterator(iter);
         } else {
             redisPanic("Unknown list encoding");
         }
@@ -1049,6 +1072,11 @@ int rdbSaveBackground(char *filename) {
         // 关闭网络连接 fd
         closeListeningSockets(0);
 
+        /* The child has no bio threads: release retired tables in
+         * place if a lookup completes a rehashing. */
+        // 子进程没有后台线程，rehash 完成时直接释放退役的表
+        dictSetTableFreeHook(NULL);
+
         // 设置进程的标题，方便识别
         redisSetProcTitle("redis-rdb-bgsave");
 
@@ -1135,9 +1163,10 @@ robj *rdbLoadObject(int rdbtype, rio *rdb) {
         /* Use a real list when there are too many entries 
          * 根据节点数，创建对象的编码
          */
-        //如果节点数比较多，用linkedlist编码
+        //如果节点数比较多，用linkedlist或quicklist编码
         if (len > server.list_max_ziplist_entries) {
-            o = createListObject();
+            o = listTypeLargeEncoding() == REDIS_ENCODING_QUICKLIST ?
+                createQuicklistObject() : createListObject();
         } else {
         //否则用ziplist编码
             o = createZiplistObject();
@@ -1158,7 +1187,7 @@ robj *rdbLoadObject(int rdbtype, rio *rdb) {
             if (o->encoding == REDIS_ENCODING_ZIPLIST &&
                 sdsEncodedObject(ele) &&
                 sdslen(ele->ptr) > server.list_max_ziplist_value)
-                    listTypeConvert(o,REDIS_ENCODING_LINKEDLIST);
+                    listTypeConvert(o,listTypeLargeEncoding());
 
             // ZIPLIST
             if (o->encoding == REDIS_ENCODING_ZIPLIST) {
@@ -1166,6 +1195,12 @@ robj *rdbLoadObject(int rdbtype, rio *rdb) {
                // 将字符串值推入 ZIPLIST 末尾来重建列表
                 o->ptr = ziplistPush(o->ptr,dec->ptr,sdslen(dec->ptr),REDIS_TAIL);
 
+                decrRefCount(dec);
+                decrRefCount(ele);
+            } else if (o->encoding == REDIS_ENCODING_QUICKLIST) {
+                // 将字符串值推入 QUICKLIST 末尾来重建列表
+                dec = getDecodedObject(ele);
+                quicklistPush(o->ptr,dec->ptr,sdslen(dec->ptr),QUICKLIST_TAIL);
                 decrRefCount(dec);
                 decrRefCount(ele);
             } else {
@@ -1432,9 +1467,9 @@ robj *rdbLoadObject(int rdbtype, rio *rdb) {
                 o->type = REDIS_LIST;//将o对象的类型设置为列表
                 o->encoding = REDIS_ENCODING_ZIPLIST; //编码设置为ziplist编码
 
-                // 检查是否需要转换编码。如果ziplist元素个数超过512，那么从ziplist转换成linkedlist编码
+                // 检查是否需要转换编码。如果ziplist元素个数超过512，那么从ziplist转换成linkedlist或quicklist编码
                 if (ziplistLen(o->ptr) > server.list_max_ziplist_entries)
-                    listTypeConvert(o,REDIS_ENCODING_LINKEDLIST);
+                    listTypeConvert(o,listTypeLargeEncoding());
                 break;
 
             // INTSET 编码的集合
@@ -74,6 +74,8 @@ static struct config {
     int csv;
     int loop;
     int idlemode;
+    int storm;
+    int connections_finished;
     int dbnum;
     sds dbnumstr;
     char *tests;
@@ -86,6 +88,7 @@ typedef struct _client {
     size_t randlen;         /* Number of pointers in client->randptr */
     size_t randfree;        /* Number of unused pointers in client->randptr */
     unsigned int written;   /* Bytes of 'obuf' already written */
+    long long connstart;    /* Time the connection was started */
     long long start;        /* Start time of a request */
     long long latency;      /* Request latency */
     int pending;            /* Number of pending requests (replies to consume) */
@@ -168,6 +171,7 @@ static void randomizeClientKey(client c) {
 }
 
 static void clientDone(client c) {
+    config.connections_finished += !config.keepalive;
     if (config.requests_finished == config.requests) {
         freeClient(c);
         aeStop(config.el);
@@ -255,9 +259,11 @@ static void writeHandler(aeEventLoop *el, int fd, void *privdata, int mask) {
             return;
         }
 
-        /* Really initialize: randomize keys and set start time. */
+        /* Really initialize: randomize keys and set start time. In
+         * connection storm mode the latency is measured from the start
+         * of the connection, that is the time to the first reply. */
         if (config.randomkeys) randomizeClientKey(c);
-        c->start = ustime();
+        c->start = config.storm ? c->connstart : ustime();
         c->latency = -1;
     }
 
@@ -304,6 +310,7 @@ static client createClient(char *cmd, size_t len, client from) {
     int j;
     client c = zmalloc(sizeof(struct _client));
 
+    c->connstart = ustime();
     if (config.hostsocket == NULL) {
         c->context = redisConnectNonBlock(config.hostip,config.hostport);
     } else {
@@ -402,8 +409,10 @@ static void createMissingClients(client c) {
     while(config.liveclients < config.numclients) {
         createClient(NULL,0,c);
 
-        /* Listen backlog is quite limited on most systems */
-        if (++n > 64) {
+        /* Listen backlog is quite limited on most systems. In connection
+         * storm mode we want exactly to stress the accept queue, so no
+         * pause is performed. */
+        if (!config.storm && ++n > 64) {
             usleep(50000);
             n = 0;
         }
@@ -426,6 +435,8 @@ static void showLatencyReport(void) {
         printf("  %d parallel clients\n", config.numclients);
         printf("  %d bytes payload\n", config.datasize);
         printf("  keep alive: %d\n", config.keepalive);
+        if (config.storm)
+            printf("  connection storm: latency is time to first reply\n");
         printf("\n");
 
         qsort(config.latency,config.requests,sizeof(long long),compareLatency);
@@ -436,7 +447,12 @@ static void showLatencyReport(void) {
                 printf("%.2f%% <= %d milliseconds\n", perc, curlat);
             }
         }
-        printf("%.2f requests per second\n\n", reqpersec);
+        printf("%.2f requests per second\n", reqpersec);
+        if (!config.keepalive)
+            printf("%.2f connections per second\n",
+                (float)config.connections_finished/
+                ((float)config.totlatency/1000));
+        printf("\n");
     } else if (config.csv) {
         printf("\"%s\",\"%.2f\"\n", config.title, reqpersec);
     } else {
@@ -450,6 +466,7 @@ static void benchmark(char *title, char *cmd, int len) {
     config.title = title;
     config.requests_issued = 0;
     config.requests_finished = 0;
+    config.connections_finished = 0;
 
     c = createClient(cmd,len,NULL);
     createMissingClients(c);
@@ -512,6 +529,9 @@ int parseOptions(int argc, const char **argv) {
             config.loop = 1;
         } else if (!strcmp(argv[i],"-I")) {
             config.idlemode = 1;
+        } else if (!strcmp(argv[i],"--storm")) {
+            config.storm = 1;
+            config.keepalive = 0;
         } else if (!strcmp(argv[i],"-t")) {
             if (lastarg) goto invalid;
             /* We get the list of tests to run as a string in the form
@@ -567,7 +587,11 @@ usage:
 " -l                 Loop. Run the tests forever\n"
 " -t <tests>         Only run the comma separated list of tests. The test\n"
 "                    names are the same as the ones produced as output.\n"
-" -I                 Idle mode. Just open N idle connections and wait.\n\n"
+" -I                 Idle mode. Just open N idle connections and wait.\n"
+" --storm            Connection storm mode. Every client reconnects after\n"
+"                    each request without any pause (implies -k 0), the\n"
+"                    reported latency is the time from connect() to the\n"
+"                    first reply, and the accept rate is reported.\n\n"
 "Examples:\n\n"
 " Run the benchmark with the default configuration against 127.0.0.1:6379:\n"
 "   $ redis-benchmark\n\n"
@@ -579,6 +603,8 @@ usage:
 "   $ redis-benchmark -t ping,set,get -n 100000 --csv\n\n"
 " Benchmark a specific command line:\n"
 "   $ redis-benchmark -r 10000 -n 10000 eval 'return redis.call(\"ping\")' 0\n\n"
+" Measure accept rate and time to first reply with 500 reconnecting clients:\n"
+"   $ redis-benchmark --storm -c 500 -n 100000 -t ping\n\n"
 " Fill a list with 10000 random elements:\n"
 "   $ redis-benchmark -r 10000 -n 10000 lpush mylist __rand_int__\n\n"
 " On user specified command lines __rand_int__ is replaced with a random integer\n"
@@ -639,6 +665,8 @@ int main(int argc, const char **argv) {
     config.csv = 0;
     config.loop = 0;
     config.idlemode = 0;
+    config.storm = 0;
+    config.connections_finished = 0;
     config.latency = NULL;
     config.clients = listCreate();
     config.hostip = "127.0.0.1";
@@ -744,7 +772,8 @@ int main(int argc, const char **argv) {
             test_is_selected("lrange_100") ||
             test_is_selected("lrange_300") ||
             test_is_selected("lrange_500") ||
-            test_is_selected("lrange_600"))
+            test_is_selected("lrange_600") ||
+            test_is_selected("lrange_2000"))
         {
             len = redisFormatCommand(&cmd,"LPUSH mylist %s",data);
             benchmark("LPUSH (needed to benchmark LRANGE)",cmd,len);
@@ -775,6 +804,14 @@ int main(int argc, const char **argv) {
             free(cmd);
         }
 
+        /* Large enough to overflow the static reply buffer of the client,
+         * so that the reply is sent from a long list of reply nodes. */
+        if (test_is_selected("lrange") || test_is_selected("lrange_2000")) {
+            len = redisFormatCommand(&cmd,"LRANGE mylist 0 1999");
+            benchmark("LRANGE_2000 (first 2000 elements)",cmd,len);
+            free(cmd);
+        }
+
         if (test_is_selected("mset")) {
             const char *argv[21];
             argv[0] = "MSET";
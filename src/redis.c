@@ -152,6 +152,7 @@ struct redisCommand redisCommandTable[] = {
     {"append",appendCommand,3,"wm",0,NULL,1,1,1,0,0},
     {"strlen",strlenCommand,2,"r",0,NULL,1,1,1,0,0},
     {"del",delCommand,-2,"w",0,NULL,1,-1,1,0,0},
+    {"unlink",unlinkCommand,-2,"w",0,NULL,1,-1,1,0,0},
     {"exists",existsCommand,2,"r",0,NULL,1,1,1,0,0},
     {"setbit",setbitCommand,4,"wm",0,NULL,1,1,1,0,0},
     {"getbit",getbitCommand,3,"r",0,NULL,1,1,1,0,0},
@@ -261,8 +262,8 @@ struct redisCommand redisCommandTable[] = {
     {"sync",syncCommand,1,"ars",0,NULL,0,0,0,0,0},
     {"psync",syncCommand,3,"ars",0,NULL,0,0,0,0,0},
     {"replconf",replconfCommand,-1,"arslt",0,NULL,0,0,0,0,0},
-    {"flushdb",flushdbCommand,1,"w",0,NULL,0,0,0,0,0},
-    {"flushall",flushallCommand,1,"w",0,NULL,0,0,0,0,0},
+    {"flushdb",flushdbCommand,-1,"w",0,NULL,0,0,0,0,0},
+    {"flushall",flushallCommand,-1,"w",0,NULL,0,0,0,0,0},
     {"sort",sortCommand,-2,"wm",0,sortGetKeys,1,1,1,0,0},
     {"info",infoCommand,-1,"rlt",0,NULL,0,0,0,0,0},
     {"monitor",monitorCommand,1,"ars",0,NULL,0,0,0,0,0},
@@ -306,8 +307,6 @@ struct redisCommand redisCommandTable[] = {
     {"pfdebug",pfdebugCommand,-3,"w",0,NULL,0,0,0,0,0}
 };
 
-struct evictionPoolEntry *evictionPoolAlloc(void);
-
 /*============================ Utility functions ============================ */
 
 /* Low level logging. To use only for very big messages, otherwise
@@ -482,6 +481,23 @@ void dictSdsDestructor(void *privdata, void *val)
 
     sdsfree(val);
 }
+//复制字典键sds
+void *dictSdsDup(void *privdata, const void *key)
+{
+    DICT_NOTUSED(privdata);
+
+    return sdsdup((const sds)key);
+}
+//嵌入到字典节点中的sds键所需的字节数
+size_t dictSdsEmbedLen(const void *key)
+{
+    return sdsembedlen(sdslen((const sds)key));
+}
+//在字典节点的内存中创建sds键的副本
+void *dictSdsEmbed(void *buf, const void *key)
+{
+    return sdsnewembed(buf,key,sdslen((const sds)key));
+}
 //比较2个字符串对象是否相等
 int dictObjKeyCompare(void *privdata, const void *key1,
         const void *key2)
@@ -569,13 +585,18 @@ dictType zsetDictType = {
 };
 
 /* Db->dict, keys are sds strings, vals are Redis objects. */
+/* Keys are copied by the dict itself: the chained layout embeds them in
+ * the dictEntry allocation, open addressing duplicates them with keyDup.
+ * db->expires references the very same key pointer. */
 dictType dbDictType = {
     dictSdsHash,                /* hash function */
-    NULL,                       /* key dup */
+    dictSdsDup,                 /* key dup */ //开放寻址布局下复制键
     NULL,                       /* val dup */
     dictSdsKeyCompare,          /* key compare */ //直接memcpy比较2个字符串
     dictSdsDestructor,          /* key destructor */ //sdsfree释放字符串
-    dictRedisObjectDestructor   /* val destructor */ //减少对象引用计数
+    dictRedisObjectDestructor,  /* val destructor */ //减少对象引用计数
+    dictSdsEmbedLen,            /* key embed length */
+    dictSdsEmbed                /* key embed */ //链式布局下键嵌入节点中
 };
 
 /* server.lua_scripts sha (as sds string) -> scripts (as robj) cache. */
@@ -699,31 +720,23 @@ void tryResizeHashTables(int dbid) {
 }
 
 /* Our hash table implementation performs rehashing incrementally while
- * we write/read from the hash table. Still if the server is idle, the hash
- * table will use two tables for a long time. So we try to use 1 millisecond
- * of CPU time at every call of this function to perform some rehahsing.
- * 虽然服务器在对数据库执行读取/写入命令时会对数据库进行渐进式 rehash ，
- * 但如果服务器长期没有执行命令的话，数据库字典的 rehash 就可能一直没办法完成，
- * 为了防止出现这种情况，我们需要对数据库执行主动 rehash 。
- * The function returns 1 if some rehashing was performed, otherwise 0
- * is returned. 
- * 函数在执行了主动 rehash 时返回 1 ，否则返回 0 。
+ * we write/read from the hash table. Still if the server is idle, or if a
+ * big hash, set or sorted set is rarely accessed, the dict will use two
+ * tables for a long time. So dict.c keeps a registry of all the dicts being
+ * rehashed, keyspace or not, and at every call of databasesCron() we
+ * spend up to server.active_rehashing_budget microseconds advancing them.
+ * 虽然服务器在读写字典时会对字典进行渐进式 rehash ，
+ * 但如果服务器长期空闲，或者一个很大的哈希/集合/有序集合很少被访问，
+ * rehash 就可能一直没办法完成。dict.c 登记了所有正在 rehash 的字典，
+ * 每次 databasesCron() 调用时在给定的时间预算内推进它们的 rehash 。
  */
-//对dbid的键值对字典和过期时间字典执行1ms的rehash（如果正在rehash的话，防止字典长时间没有读写操作让rehash一直没结束）
-int incrementallyRehash(int dbid) {
-    /* Keys dictionary */
-    if (dictIsRehashing(server.db[dbid].dict)) {
-        dictRehashMilliseconds(server.db[dbid].dict,1); //执行1ms的rehash
-        return 1; /* already used our millisecond for this loop... */
-    }
 
-    /* Expires */
-    if (dictIsRehashing(server.db[dbid].expires)) {
-        dictRehashMilliseconds(server.db[dbid].expires,1); //执行1ms的rehash
-        return 1; /* already used our millisecond for this loop... */
-    }
-
-    return 0;
+/* Retired hash tables of at least DICT_TABLE_CHUNK buckets are released
+ * by a bio thread, so that the end of the rehashing of a big dict, or the
+ * release of a big dict, doesn't free gigabytes in the main thread. */
+// 大的退役哈希表交给后台线程释放
+static void dictFreeTableAsync(void *table, unsigned long chunks) {
+    bioCreateBackgroundJob(REDIS_BIO_FREE_TABLE,table,(void*)chunks,NULL);
 }
 
 /* This function is called once a background process of some kind terminates,
@@ -766,7 +779,10 @@ int activeExpireCycleTryExpire(redisDb *db, dictEntry *de, long long now) {
         // 传播过期命令：添加到aof缓冲区中，已经传播给所有slave节点中
         propagateExpire(db,keyobj);
         // 从数据库中删除该键
-        dbDelete(db,keyobj);
+        if (server.lazyfree_lazy_expire)
+            dbAsyncDelete(db,keyobj);
+        else
+            dbSyncDelete(db,keyobj);
         // 发送事件
         notifyKeyspaceEvent(REDIS_NOTIFY_EXPIRED,
             "expired",keyobj,db->id);
@@ -780,6 +796,21 @@ int activeExpireCycleTryExpire(redisDb *db, dictEntry *de, long long now) {
     }
 }
 
+/* Return the expire effort to use: the configured one, or the maximum when
+ * active-expire-pressure-perc is set and the memory used is over that
+ * percentage of maxmemory, as the memory used by expired keys would
+ * otherwise cause the eviction of valid keys. */
+// 返回要使用的过期力度：启用时，内存接近 maxmemory 时使用最大力度
+static int activeExpireEffort(void) {
+    if (server.maxmemory && server.active_expire_pressure_perc &&
+        zmalloc_used_memory() >
+        server.maxmemory/100*server.active_expire_pressure_perc)
+    {
+        return ACTIVE_EXPIRE_EFFORT_MAX;
+    }
+    return server.active_expire_effort;
+}
+
 /* Try to expire a few timed out keys. The algorithm used is adaptive and
  * will use few CPU cycles if there are few expiring keys, otherwise
  * it will get more aggressive to avoid that too much memory is used by
@@ -828,15 +859,40 @@ void activeExpireCycle(int type) {
     // 函数开始的时间
     long long start = ustime(), timelimit;
 
+    /* Scale the running parameters with the expire effort: the default
+     * effort of 1 gives the classic values, every additional level samples
+     * more keys per loop, uses more CPU, runs longer and more frequent fast
+     * cycles, and accepts less expired keys in the keyspace. */
+    // 根据过期力度调整参数：力度越大，每次抽样的键越多，占用的 CPU 越多，
+    // 快速循环越长越频繁，可以接受的过期键比例越低
+    unsigned long effort = activeExpireEffort()-1; /* From 0 to 9. */
+    unsigned long keys_per_loop = ACTIVE_EXPIRE_CYCLE_LOOKUPS_PER_LOOP +
+        ACTIVE_EXPIRE_CYCLE_LOOKUPS_PER_LOOP/4*effort;
+    unsigned long fast_duration = ACTIVE_EXPIRE_CYCLE_FAST_DURATION +
+        ACTIVE_EXPIRE_CYCLE_FAST_DURATION/4*effort;
+    unsigned long fast_interval = fast_duration*(20-effort)/10;
+    unsigned long slow_time_perc = ACTIVE_EXPIRE_CYCLE_SLOW_TIME_PERC +
+        2*effort;
+    unsigned long acceptable_stale = ACTIVE_EXPIRE_CYCLE_ACCEPTABLE_STALE -
+        2*effort;
+
+    server.expire_cycle_effort = effort+1;
+
     // 快速模式
     if (type == ACTIVE_EXPIRE_CYCLE_FAST) {
         /* Don't start a fast cycle if the previous cycle did not exited
-         * for time limt. Also don't repeat a fast cycle for the same period
-         * as the fast cycle total duration itself. */
-        // 如果上次函数没有触发 timelimit_exit ，那么不执行处理
-        if (!timelimit_exit) return;
+         * for time limt. With an effort over the default one, also start
+         * it when the estimated share of expired keys is over the
+         * acceptable one. Don't repeat a fast cycle for the same period
+         * as the fast cycle total duration itself (less with a higher
+         * effort). */
+        // 如果上次函数没有触发 timelimit_exit ，那么不执行处理；
+        // 力度大于默认值时，估计的过期键比例超过可接受值也会执行处理
+        if (!timelimit_exit &&
+            (effort == 0 ||
+             server.stat_expired_stale_perc < acceptable_stale)) return;
         // 如果距离上次执行未够一定时间，那么不执行处理。即如果上次开始执行fast的时间到现在还未果2个duration，那么不执行
-        if (start < last_fast_cycle + ACTIVE_EXPIRE_CYCLE_FAST_DURATION*2) return;
+        if (start < last_fast_cycle + (long long)fast_interval) return;
         // 运行到这里，说明执行快速处理，记录当前时间
         last_fast_cycle = start;
     }
@@ -858,25 +914,30 @@ void activeExpireCycle(int type) {
     if (dbs_per_call > server.dbnum || timelimit_exit)
         dbs_per_call = server.dbnum;
 
-    /* We can use at max ACTIVE_EXPIRE_CYCLE_SLOW_TIME_PERC percentage of CPU time
+    /* With the expire index a database without due keys costs a lookup:
+     * always process all of them. */
+    // 使用过期索引时，没有到期键的数据库几乎没有开销，每次都处理所有数据库
+    if (server.active_expire_index) dbs_per_call = server.dbnum;
+
+    /* We can use at max 'slow_time_perc' percentage of CPU time
      * per iteration. Since this function gets called with a frequency of
      * server.hz times per second, the following is the max amount of
      * microseconds we can spend in this function. */
     // 函数处理的微秒时间上限
     // ACTIVE_EXPIRE_CYCLE_SLOW_TIME_PERC 默认为 25 ，也即是 25 % 的 CPU 时间
-    timelimit = 1000000*ACTIVE_EXPIRE_CYCLE_SLOW_TIME_PERC/server.hz/100;
+    timelimit = 1000000*slow_time_perc/server.hz/100;
     timelimit_exit = 0;
     if (timelimit <= 0) timelimit = 1;
 
     // 如果是运行在快速模式之下
-    // 那么最多只能运行 FAST_DURATION 微秒 
+    // 那么最多只能运行 fast_duration 微秒 
     // 默认值为 1000 （微秒）
     if (type == ACTIVE_EXPIRE_CYCLE_FAST)
-        timelimit = ACTIVE_EXPIRE_CYCLE_FAST_DURATION; /* in microseconds. */
+        timelimit = fast_duration; /* in microseconds. */
 
     // 遍历数据库
     for (j = 0; j < dbs_per_call; j++) {
-        int expired;
+        int expired, ttl_samples;
         // 指向要处理的数据库
         redisDb *db = server.db+(current_db % server.dbnum);
 
@@ -887,18 +948,30 @@ void activeExpireCycle(int type) {
         // 那么下次会直接从下个 DB 开始处理
         current_db++;
 
+        /* The expire index finds the due keys directly, in deadline
+         * order: no sampling needed. */
+        // 过期索引直接找到到期的键，不需要随机抽样
+        if (server.active_expire_index) {
+            if (expireIndexCycle(db,start,timelimit) == REDIS_ERR) {
+                timelimit_exit = 1;
+                goto done;
+            }
+            db->expired_stale_perc = 0;
+            continue;
+        }
+
         /* Continue to expire if at the end of the cycle more than 25%
          * of the keys were expired. */
         do {
             unsigned long num, slots;
             long long now, ttl_sum;
-            int ttl_samples;
 
             /* If there is nothing to expire try next DB ASAP. */
             // 获取数据库中带过期时间的键的数量
             // 如果该数量为 0 ，直接跳过这个数据库
             if ((num = dictSize(db->expires)) == 0) {
                 db->avg_ttl = 0;
+                db->expired_stale_perc = 0;
                 break;
             }
             // 获取数据库中键值对的数量
@@ -924,9 +997,8 @@ void activeExpireCycle(int type) {
             // 总共处理的键计数器
             ttl_samples = 0;
 
-            // 每次最多只能检查 LOOKUPS_PER_LOOP 个键：20
-            if (num > ACTIVE_EXPIRE_CYCLE_LOOKUPS_PER_LOOP)
-                num = ACTIVE_EXPIRE_CYCLE_LOOKUPS_PER_LOOP;
+            // 每次最多只能检查 keys_per_loop 个键：默认 20
+            if (num > keys_per_loop) num = keys_per_loop;
 
             // 开始遍历数据库，每次遍历随机扫描20个键
             while (num--) {
@@ -957,6 +1029,12 @@ void activeExpireCycle(int type) {
                 /* Smooth the value averaging with the previous one. */
                 // 取数据库的上次平均 TTL 和今次平均 TTL 的平均值
                 db->avg_ttl = (db->avg_ttl+avg_ttl)/2;
+
+                /* Running estimate of the share of keys with an expire
+                 * that are already expired. */
+                // 估计数据库中已过期但还没删除的键的比例
+                db->expired_stale_perc = (double)expired*100/ttl_samples*0.05 +
+                                         db->expired_stale_perc*0.95;
             }
 
             /* We can't block forever here even if there are many keys to
@@ -979,13 +1057,35 @@ void activeExpireCycle(int type) {
             }
 
             // 已经超时了，返回
-            if (timelimit_exit) return;
+            if (timelimit_exit) goto done;
+
+            /* We don't repeat the cycle if there are less than
+             * 'acceptable_stale' percent of a full sample of keys found
+             * expired in the current DB (5 of 20 with the default effort).
+             * The threshold is absolute, so a DB with less keys than a
+             * sample is only scanned once. */
+            // 如果过期的键不超过一次完整抽样的 acceptable_stale %，那么不再遍历
+            // 默认力度下每次在 db check 20 个随机键，超过 5 个过期则继续处理这个 db，否则跳出循环处理下个 db
+        } while (expired > keys_per_loop*acceptable_stale/100);
+    }
 
-            /* We don't repeat the cycle if there are less than 25% of keys
-             * found expired in the current DB. */
-            // 如果已删除的过期键占当前总数据库带过期时间的键数量的 25 %，那么不再遍历
-            // expired > 5则循环继续，每次在db check 20个随机键，如果超过5个过期则继续处理这个db，否则跳出循环处理下个db
-        } while (expired > ACTIVE_EXPIRE_CYCLE_LOOKUPS_PER_LOOP/4);
+done:
+    /* Update the stats: time used, and the estimated share of expired keys
+     * across the databases, weighted by their number of keys with an
+     * expire. */
+    // 更新统计：耗费的时间，以及按带过期时间的键数量加权的过期键比例
+    server.stat_expire_cycle_time_used += ustime()-start;
+    if (timelimit_exit) server.stat_expired_time_cap_reached_count++;
+    {
+        double stale = 0, total = 0;
+
+        for (j = 0; j < (unsigned)server.dbnum; j++) {
+            double num = dictSize(server.db[j].expires);
+
+            stale += server.db[j].expired_stale_perc*num;
+            total += num;
+        }
+        server.stat_expired_stale_perc = total ? stale/total : 0;
     }
 }
 
@@ -1088,6 +1188,16 @@ int clientsCronResizeQueryBuffer(redisClient *c) {
     size_t querybuf_size = sdsAllocSize(c->querybuf);
     time_t idletime = server.unixtime - c->lastinteraction;
 
+    /* Never resize while a big bulk argument is being read: the buffer was
+     * sized exactly for it and will become the argument object. */
+    // 正在读入大参数时不调整，缓冲区是按参数大小分配的
+    if (c->reqtype == REDIS_REQ_MULTIBULK && c->bulklen != -1 &&
+        c->bulklen >= REDIS_MBULK_BIG_ARG)
+    {
+        c->querybuf_peak = 0;
+        return 0;
+    }
+
     /* There are two conditions to resize the query buffer:
      * 符合以下两个条件的话，执行大小调整：
      * 1) Query buffer is > BIG_ARG and too big for latest peak.
@@ -1182,7 +1292,6 @@ void databasesCron(void) {
          * DB we'll be able to start from the successive in the next
          * cron loop iteration. */
         static unsigned int resize_db = 0;
-        static unsigned int rehash_db = 0;
         unsigned int dbs_per_call = REDIS_DBCRON_DBS_PER_CALL; //16个
         unsigned int j;
 
@@ -1198,18 +1307,9 @@ void databasesCron(void) {
         }
 
         /* Rehash */
-        // 对字典进行渐进式 rehash：对键值对字典和过期键字典进行1ms的rehash操作
-        if (server.activerehashing) {
-            for (j = 0; j < dbs_per_call; j++) {
-                int work_done = incrementallyRehash(rehash_db % server.dbnum);
-                rehash_db++;
-                if (work_done) {
-                    /* If the function did some work, stop here, we'll do
-                     * more at the next cron loop. */
-                    break;
-                }
-            }
-        }
+        // 在时间预算内对所有正在 rehash 的字典进行主动 rehash
+        if (server.activerehashing)
+            dictRehashRegistered(server.active_rehashing_budget);
     }
 }
 
@@ -1353,6 +1453,17 @@ int serverCron(struct aeEventLoop *eventLoop, long long id, void *clientData) {
     // 对数据库执行各种操作：调整键值对字典和过期键字典的大小、以及渐进式rehash
     databasesCron();
 
+    /* Drop the references to shared objects the lazyfree thread found in
+     * the values it released. */
+    // 释放后台线程交还的共享对象引用
+    lazyfreeReleaseDeferred();
+
+    /* The memory can go over maxmemory without commands being called, for
+     * instance because of the client buffers. */
+    // 内存也可能在没有命令执行时超过 maxmemory ，比如客户端缓冲区增长
+    server.eviction_stalled = 0;
+    startBackgroundEvictionIfNeeded();
+
     /* Start a scheduled AOF rewrite if this was requested by the user while
      * a BGSAVE was in progress. */
     // 如果 BGSAVE 和 BGREWRITEAOF 都没有在执行
@@ -1502,6 +1613,11 @@ int serverCron(struct aeEventLoop *eventLoop, long long id, void *clientData) {
 void beforeSleep(struct aeEventLoop *eventLoop) {
     REDIS_NOTUSED(eventLoop);
 
+    /* Read, parse and execute the commands of the clients whose read was
+     * postponed to the I/O threads. */
+    // 由 I/O 线程读取并解析待读客户端的命令，然后在主线程执行
+    handleClientsWithPendingReadsUsingThreads();
+
     /* Run a fast expire cycle (the called function will return
      * ASAP if a fast cycle is not needed). */
     // 执行一次快速的主动过期检查
@@ -1539,6 +1655,12 @@ void beforeSleep(struct aeEventLoop *eventLoop) {
     /* Call the Redis Cluster before sleep function. */
     // 在进入下个事件循环前，执行一些集群收尾工作
     if (server.cluster_enabled) clusterBeforeSleep();
+
+    /* Handle writes with pending output buffers. This must happen after
+     * the AOF buffer was written, so that replies are never sent before
+     * the write they acknowledge reached the AOF file. */
+    // 写出待写客户端的回复，必须在 AOF 缓冲区写入文件之后
+    handleClientsWithPendingWritesUsingThreads();
 }
 
 /* =========================== Server initialization ======================== */
@@ -1659,6 +1781,11 @@ void initServerConfig() {
     server.configfile = NULL;
     // 设置默认服务器频率
     server.hz = REDIS_DEFAULT_HZ;
+    server.embstr_size_limit = REDIS_EMBSTR_MIN_SIZE_LIMIT;
+    // 设置默认 I/O 线程数量
+    server.io_threads_num = REDIS_DEFAULT_IO_THREADS;
+    server.io_threads_active = 0;
+    server.client_pool_size = REDIS_DEFAULT_CLIENT_POOL_SIZE;
     // 为运行 ID 加上结尾字符
     server.runid[REDIS_RUN_ID_SIZE] = '\0';
     // 设置服务器的运行架构，看long是多大，一般是64位架构
@@ -1666,16 +1793,23 @@ void initServerConfig() {
     // 设置默认服务器端口号
     server.port = REDIS_SERVERPORT;
     server.tcp_backlog = REDIS_TCP_BACKLOG;
+    server.tcp_listeners = REDIS_DEFAULT_TCP_LISTENERS;
     server.bindaddr_count = 0;
     server.unixsocket = NULL;
     server.unixsocketperm = REDIS_DEFAULT_UNIX_SOCKET_PERM;
     server.ipfd_count = 0;
     server.sofd = -1;
     server.dbnum = REDIS_DEFAULT_DBNUM; //16个db
+    server.keyspace_layout = REDIS_DEFAULT_KEYSPACE_LAYOUT;
     server.verbosity = REDIS_DEFAULT_VERBOSITY;
     server.maxidletime = REDIS_MAXIDLETIME;
     server.tcpkeepalive = REDIS_DEFAULT_TCP_KEEPALIVE;
     server.active_expire_enabled = 1;
+    server.active_expire_index = REDIS_DEFAULT_ACTIVE_EXPIRE_INDEX;
+    server.active_expire_effort = REDIS_DEFAULT_ACTIVE_EXPIRE_EFFORT;
+    server.expire_cycle_effort = REDIS_DEFAULT_ACTIVE_EXPIRE_EFFORT;
+    server.active_expire_pressure_perc = REDIS_DEFAULT_ACTIVE_EXPIRE_PRESSURE_PERC;
+    server.stat_expired_stale_perc = 0;
     server.client_max_querybuf_len = REDIS_MAX_QUERYBUF_LEN; //1GB大小
     server.saveparams = NULL;
     server.loading = 0;
@@ -1708,16 +1842,31 @@ void initServerConfig() {
     server.rdb_checksum = REDIS_DEFAULT_RDB_CHECKSUM;
     server.stop_writes_on_bgsave_err = REDIS_DEFAULT_STOP_WRITES_ON_BGSAVE_ERROR;
     server.activerehashing = REDIS_DEFAULT_ACTIVE_REHASHING;
+    server.active_rehashing_budget = REDIS_DEFAULT_ACTIVE_REHASHING_BUDGET;
     server.notify_keyspace_events = 0;
     server.maxclients = REDIS_MAX_CLIENTS;
     server.bpop_blocked_clients = 0;
     server.maxmemory = REDIS_DEFAULT_MAXMEMORY;
     server.maxmemory_policy = REDIS_DEFAULT_MAXMEMORY_POLICY; //默认是不淘汰
     server.maxmemory_samples = REDIS_DEFAULT_MAXMEMORY_SAMPLES;
+    server.lfu_log_factor = REDIS_DEFAULT_LFU_LOG_FACTOR;
+    server.lfu_decay_time = REDIS_DEFAULT_LFU_DECAY_TIME;
+    server.maxmemory_eviction_pool_size = REDIS_DEFAULT_MAXMEMORY_EVICTION_POOL_SIZE;
+    server.maxmemory_precision_samples = REDIS_DEFAULT_MAXMEMORY_PRECISION_SAMPLES;
+    server.maxmemory_background_eviction = REDIS_DEFAULT_MAXMEMORY_BACKGROUND_EVICTION;
+    server.maxmemory_hard_limit_perc = REDIS_DEFAULT_MAXMEMORY_HARD_LIMIT_PERC;
+    server.maxmemory_eviction_budget = REDIS_DEFAULT_MAXMEMORY_EVICTION_BUDGET;
+    server.eviction_timer_id = -1;
+    server.eviction_over_since = 0;
+    server.eviction_stalled = 0;
+    server.lazyfree_lazy_eviction = REDIS_DEFAULT_LAZYFREE_LAZY_EVICTION;
+    server.lazyfree_lazy_expire = REDIS_DEFAULT_LAZYFREE_LAZY_EXPIRE;
+    server.lazyfree_lazy_server_del = REDIS_DEFAULT_LAZYFREE_LAZY_SERVER_DEL;
     server.hash_max_ziplist_entries = REDIS_HASH_MAX_ZIPLIST_ENTRIES;
     server.hash_max_ziplist_value = REDIS_HASH_MAX_ZIPLIST_VALUE;
     server.list_max_ziplist_entries = REDIS_LIST_MAX_ZIPLIST_ENTRIES;
     server.list_max_ziplist_value = REDIS_LIST_MAX_ZIPLIST_VALUE;
+    server.list_quicklist_fill = REDIS_LIST_QUICKLIST_FILL;
     server.set_max_intset_entries = REDIS_SET_MAX_INTSET_ENTRIES;
     server.zset_max_ziplist_entries = REDIS_ZSET_MAX_ZIPLIST_ENTRIES;
     server.zset_max_ziplist_value = REDIS_ZSET_MAX_ZIPLIST_VALUE;
@@ -1911,10 +2060,48 @@ void adjustOpenFilesLimit(void) {
  * impossible to bind, or no bind addresses were specified in the server
  * configuration but the function is not able to bind * for at least
  * one of the IPv4 or IPv6 protocols. */
-//让fds[count]监听端口
-int listenToPort(int port, int *fds, int *count) {
+/* Create 'listeners' sockets bound to the same address and port, storing
+ * them in fds[]. When more than one listener is requested the sockets are
+ * created with SO_REUSEPORT, so that the kernel shards incoming connections
+ * across their accept queues. Returns the number of sockets created, that
+ * is 0 if the address could not be bound (server.neterr has the error).
+ *
+ * The first socket sets SO_REUSEPORT only after its bind succeeded, so the
+ * address can't be shared with a socket of another process that was
+ * already bound to it. The other sockets join it once it is listening. */
+// 为同一个地址创建 listeners 个监听套接字，多于一个时使用 SO_REUSEPORT
+static int listenToAddress(int port, char *addr, int ipv6, int listeners,
+                           int *fds)
+{
     int j;
 
+    for (j = 0; j < listeners; j++) {
+        int fd;
+
+        if (listeners > 1)
+            fd = ipv6 ? anetTcp6ReusePortServer(server.neterr,port,addr,
+                                                server.tcp_backlog,j > 0) :
+                        anetTcpReusePortServer(server.neterr,port,addr,
+                                               server.tcp_backlog,j > 0);
+        else
+            fd = ipv6 ? anetTcp6Server(server.neterr,port,addr,
+                                       server.tcp_backlog) :
+                        anetTcpServer(server.neterr,port,addr,
+                                      server.tcp_backlog);
+        if (fd == ANET_ERR) {
+            while(j--) close(fds[j]);
+            return 0;
+        }
+        anetNonBlock(NULL,fd);
+        fds[j] = fd;
+    }
+    return listeners;
+}
+
+//让fds[count]监听端口，每个地址创建 listeners 个监听套接字
+int listenToPort(int port, int *fds, int *count, int listeners) {
+    int j, n;
+
     /* Force binding of 0.0.0.0 if no bind address is specified, always
      * entering the loop if j == 0. */
     if (server.bindaddr_count == 0) server.bindaddr[0] = NULL;
@@ -1922,40 +2109,26 @@ int listenToPort(int port, int *fds, int *count) {
         if (server.bindaddr[j] == NULL) {
             /* Bind * for both IPv6 and IPv4, we enter here only if
              * server.bindaddr_count == 0. */
-            fds[*count] = anetTcp6Server(server.neterr,port,NULL,
-                server.tcp_backlog);
-            if (fds[*count] != ANET_ERR) {
-                anetNonBlock(NULL,fds[*count]);
-                (*count)++;
-            }
-            fds[*count] = anetTcpServer(server.neterr,port,NULL,
-                server.tcp_backlog);
-            if (fds[*count] != ANET_ERR) {
-                anetNonBlock(NULL,fds[*count]);
-                (*count)++;
-            }
+            *count += listenToAddress(port,NULL,1,listeners,fds+*count);
+            *count += listenToAddress(port,NULL,0,listeners,fds+*count);
             /* Exit the loop if we were able to bind * on IPv4 or IPv6,
-             * otherwise fds[*count] will be ANET_ERR and we'll print an
-             * error and return to the caller with an error. */
+             * otherwise we'll print an error and return to the caller
+             * with an error. */
             if (*count) break;
-        } else if (strchr(server.bindaddr[j],':')) {
-            /* Bind IPv6 address. */
-            fds[*count] = anetTcp6Server(server.neterr,port,server.bindaddr[j],
-                server.tcp_backlog);
+            n = 0;
         } else {
-            /* Bind IPv4 address. */
-            fds[*count] = anetTcpServer(server.neterr,port,server.bindaddr[j],
-                server.tcp_backlog);
+            /* Bind IPv6 or IPv4 address. */
+            n = listenToAddress(port,server.bindaddr[j],
+                strchr(server.bindaddr[j],':') != NULL,listeners,fds+*count);
         }
-        if (fds[*count] == ANET_ERR) {
+        if (n == 0) {
             redisLog(REDIS_WARNING,
                 "Creating Server TCP listening socket %s:%d: %s",
                 server.bindaddr[j] ? server.bindaddr[j] : "*",
                 port, server.neterr);
             return REDIS_ERR;
         }
-        anetNonBlock(NULL,fds[*count]);
-        (*count)++;
+        *count += n;
     }
     return REDIS_OK;
 }
@@ -1971,15 +2144,29 @@ void resetServerStats(void) {
     server.stat_evictedkeys = 0;
     server.stat_keyspace_misses = 0;
     server.stat_keyspace_hits = 0;
+    server.stat_prefetched_keys = 0;
     server.stat_fork_time = 0;
     server.stat_rejected_conn = 0;
     server.stat_sync_full = 0;
     server.stat_sync_partial_ok = 0;
     server.stat_sync_partial_err = 0;
+    server.stat_io_reads_processed = 0;
+    server.stat_io_writes_processed = 0;
+    server.stat_client_pool_hits = 0;
+    server.stat_client_pool_misses = 0;
+    server.stat_eviction_inline_usec = 0;
+    server.stat_eviction_inline_max_usec = 0;
+    server.stat_eviction_background_usec = 0;
+    server.stat_eviction_pool_ghosts = 0;
+    server.stat_expire_cycle_time_used = 0;
+    server.stat_expired_time_cap_reached_count = 0;
+    server.stat_eviction_precision_samples = 0;
+    server.stat_eviction_precision_hits = 0;
     memset(server.ops_sec_samples,0,sizeof(server.ops_sec_samples));
     server.ops_sec_idx = 0;
     server.ops_sec_last_sample_time = mstime();
     server.ops_sec_last_sample_ops = 0;
+    dictResetTableStats();
 }
 
 // init server
@@ -2001,6 +2188,11 @@ void initServer() {
     server.current_client = NULL;
     server.clients = listCreate(); //创建客户端链表
     server.clients_to_close = listCreate();//为clients_to_close创建链表
+    server.clients_pending_read = listCreate();
+    server.clients_pending_write = listCreate();
+    server.client_pool = NULL;
+    server.client_pool_len = 0;
+    clientPoolResize(server.client_pool_size);
     server.slaves = listCreate(); 
     server.monitors = listCreate();
     server.slaveseldb = -1; /* Force to emit the first SELECT command. */
@@ -2010,7 +2202,8 @@ void initServer() {
     server.get_ack_from_slaves = 0;
     server.clients_paused = 0;
 
-    // 创建共享对象
+    // 根据分配器的 size class 计算 EMBSTR 的长度上限，然后创建共享对象
+    initEmbstrSizeLimit();
     createSharedObjects();
     adjustOpenFilesLimit();//调整max fd number
     server.el = aeCreateEventLoop(server.maxclients+REDIS_EVENTLOOP_FDSET_INCR);//创建epoll实例
@@ -2019,7 +2212,8 @@ void initServer() {
     /* Open the TCP listening socket for the user commands. */
     // 打开 TCP 监听端口，用于等待客户端的命令请求
     if (server.port != 0 &&
-        listenToPort(server.port,server.ipfd,&server.ipfd_count) == REDIS_ERR)
+        listenToPort(server.port,server.ipfd,&server.ipfd_count,
+                     server.tcp_listeners) == REDIS_ERR)
         exit(1);
 
     /* Open the listening Unix domain socket. */
@@ -2043,16 +2237,22 @@ void initServer() {
 
     /* Create the Redis databases, and initialize other internal state. */
     // 创建并初始化数据库结构，为每一个数据库创建相关数据结构
+    expireIndexInit();
     for (j = 0; j < server.dbnum; j++) {
-        server.db[j].dict = dictCreate(&dbDictType,NULL); //创建键值对字典
-        server.db[j].expires = dictCreate(&keyptrDictType,NULL); //创建过期键字典
+        server.db[j].dict = dictCreateLayout(&dbDictType,NULL,
+            server.keyspace_layout); //创建键值对字典
+        server.db[j].expires = dictCreateLayout(&keyptrDictType,NULL,
+            server.keyspace_layout); //创建过期键字典
         server.db[j].blocking_keys = dictCreate(&keylistDictType,NULL);
         server.db[j].ready_keys = dictCreate(&setDictType,NULL);
         server.db[j].watched_keys = dictCreate(&keylistDictType,NULL);
-        server.db[j].eviction_pool = evictionPoolAlloc();//创建eviction_poll
         server.db[j].id = j;//设置id为j
         server.db[j].avg_ttl = 0;
+        server.db[j].expire_index = expireIndexCreate();
+        server.db[j].expire_index_cursor = 0;
+        server.db[j].expired_stale_perc = 0;
     }
+    server.eviction_pool = evictionPoolAlloc(server.maxmemory_eviction_pool_size);//创建所有数据库共享的淘汰池
 
     // 创建 PUBSUB 相关结构
     server.pubsub_channels = dictCreate(&keylistDictType,NULL);
@@ -2143,6 +2343,10 @@ void initServer() {
 
     // 初始化 BIO 系统
     bioInit();
+    dictSetTableFreeHook(dictFreeTableAsync);
+
+    // 初始化 I/O 线程
+    initThreadedIO();
 }
 
 /* Populates the Redis Command Table starting from the hard coded list
@@ -2925,6 +3129,7 @@ sds genRedisInfoString(char *section) {
             "os:%s %s %s\r\n"
             "arch_bits:%d\r\n"
             "multiplexing_api:%s\r\n"
+            "hash_function:%s\r\n"
             "gcc_version:%d.%d.%d\r\n"
             "process_id:%ld\r\n"
             "run_id:%s\r\n"
@@ -2942,6 +3147,7 @@ sds genRedisInfoString(char *section) {
             name.sysname, name.release, name.machine,
             server.arch_bits,
             aeGetApiName(),
+            dictGenHashFunctionName(),
 #ifdef __GNUC__
             __GNUC__,__GNUC_MINOR__,__GNUC_PATCHLEVEL__,
 #else
@@ -2965,10 +3171,12 @@ sds genRedisInfoString(char *section) {
             "connected_clients:%lu\r\n"
             "client_longest_output_list:%lu\r\n"
             "client_biggest_input_buf:%lu\r\n"
-            "blocked_clients:%d\r\n",
+            "blocked_clients:%d\r\n"
+            "pooled_clients:%d\r\n",
             listLength(server.clients)-listLength(server.slaves),
             lol, bib,
-            server.bpop_blocked_clients);
+            server.bpop_blocked_clients,
+            server.client_pool_len);
     }
 
     /* Memory */
@@ -2996,7 +3204,9 @@ sds genRedisInfoString(char *section) {
             "used_memory_peak_human:%s\r\n"
             "used_memory_lua:%lld\r\n"
             "mem_fragmentation_ratio:%.2f\r\n"
-            "mem_allocator:%s\r\n",
+            "mem_allocator:%s\r\n"
+            "embstr_size_limit:%zu\r\n"
+            "lazyfree_pending_objects:%zu\r\n",
             zmalloc_used,
             hmem,
             server.resident_set_size,
@@ -3004,7 +3214,9 @@ sds genRedisInfoString(char *section) {
             peak_hmem,
             ((long long)lua_gc(server.lua,LUA_GCCOUNT,0))*1024LL,
             zmalloc_get_fragmentation_ratio(server.resident_set_size),
-            ZMALLOC_LIB
+            ZMALLOC_LIB,
+            server.embstr_size_limit,
+            lazyfreeGetPendingObjectsCount()
             );
     }
 
@@ -3096,6 +3308,14 @@ sds genRedisInfoString(char *section) {
 
     /* Stats */
     if (allsections || defsections || !strcasecmp(section,"stats")) {
+        dictTableStats ts;
+        double moved = 0, total = 0;
+        int rehashing = 0;
+        unsigned long backlog_dicts;
+        unsigned long long backlog_buckets;
+        size_t lag_bytes;
+        long long lag_ms;
+
         if (sections++) info = sdscat(info,"\r\n");
         info = sdscatprintf(info,
             "# Stats\r\n"
@@ -3110,10 +3330,16 @@ sds genRedisInfoString(char *section) {
             "evicted_keys:%lld\r\n"
             "keyspace_hits:%lld\r\n"
             "keyspace_misses:%lld\r\n"
+            "prefetched_keys:%lld\r\n"
             "pubsub_channels:%ld\r\n"
             "pubsub_patterns:%lu\r\n"
             "latest_fork_usec:%lld\r\n"
-            "migrate_cached_sockets:%ld\r\n",
+            "migrate_cached_sockets:%ld\r\n"
+            "io_threads_active:%d\r\n"
+            "io_threaded_reads_processed:%lld\r\n"
+            "io_threaded_writes_processed:%lld\r\n"
+            "client_pool_hits:%lld\r\n"
+            "client_pool_misses:%lld\r\n",
             server.stat_numconnections,
             server.stat_numcommands,
             getOperationsPerSecond(),
@@ -3125,10 +3351,82 @@ sds genRedisInfoString(char *section) {
             server.stat_evictedkeys,
             server.stat_keyspace_hits,
             server.stat_keyspace_misses,
+            server.stat_prefetched_keys,
             dictSize(server.pubsub_channels),
             listLength(server.pubsub_patterns),
             server.stat_fork_time,
-            dictSize(server.migrate_cached_sockets));
+            dictSize(server.migrate_cached_sockets),
+            server.io_threads_active,
+            server.stat_io_reads_processed,
+            server.stat_io_writes_processed,
+            server.stat_client_pool_hits,
+            server.stat_client_pool_misses);
+
+        /* Progress of the rehashing of the keyspace dicts, and main thread
+         * time spent allocating and freeing big hash tables. */
+        for (j = 0; j < server.dbnum; j++) {
+            dict *dicts[2] = {server.db[j].dict, server.db[j].expires};
+            int k;
+
+            for (k = 0; k < 2; k++) {
+                if (!dictIsRehashing(dicts[k])) continue;
+                rehashing++;
+                moved += dictRehashProgress(dicts[k])*dicts[k]->ht[0].size;
+                total += dicts[k]->ht[0].size;
+            }
+        }
+        dictGetTableStats(&ts);
+        dictGetRehashBacklog(&backlog_dicts,&backlog_buckets);
+        info = sdscatprintf(info,
+            "keyspace_rehashing:%d\r\n"
+            "keyspace_rehash_perc:%.2f\r\n"
+            "rehashing_dicts:%lu\r\n"
+            "rehashing_buckets_left:%llu\r\n"
+            "dict_table_stall_usec:%llu\r\n"
+            "dict_table_stall_max_usec:%lld\r\n"
+            "dict_table_chunks_allocated:%llu\r\n"
+            "dict_tables_freed_async:%llu\r\n"
+            "dict_tables_free_pending:%llu\r\n",
+            rehashing,
+            total ? moved*100/total : 100,
+            backlog_dicts,
+            backlog_buckets,
+            ts.stall_usec,
+            ts.stall_max_usec,
+            ts.chunks,
+            ts.freed_async,
+            bioPendingJobsOfType(REDIS_BIO_FREE_TABLE));
+
+        /* Time spent evicting keys, and how far behind the eviction is. */
+        // 淘汰键所花的时间，以及内存超过 maxmemory 的字节数和时长
+        evictionGetLag(&lag_bytes,&lag_ms);
+        info = sdscatprintf(info,
+            "eviction_inline_usec:%lld\r\n"
+            "eviction_inline_max_usec:%lld\r\n"
+            "eviction_background_usec:%lld\r\n"
+            "eviction_lag_bytes:%zu\r\n"
+            "eviction_lag_ms:%lld\r\n"
+            "expire_cycle_effort:%d\r\n"
+            "expire_cycle_cpu_milliseconds:%lld\r\n"
+            "expired_time_cap_reached_count:%lld\r\n"
+            "expired_stale_perc:%.2f\r\n"
+            "eviction_pool_ghosts:%lld\r\n"
+            "eviction_precision_samples:%lld\r\n"
+            "eviction_precision_perc:%.2f\r\n",
+            server.stat_eviction_inline_usec,
+            server.stat_eviction_inline_max_usec,
+            server.stat_eviction_background_usec,
+            lag_bytes,
+            lag_ms,
+            server.expire_cycle_effort,
+            server.stat_expire_cycle_time_used/1000,
+            server.stat_expired_time_cap_reached_count,
+            server.stat_expired_stale_perc,
+            server.stat_eviction_pool_ghosts,
+            server.stat_eviction_precision_samples,
+            server.stat_eviction_precision_samples ?
+                (double)server.stat_eviction_precision_hits*100/
+                server.stat_eviction_precision_samples : 100);
     }
 
     /* Replication */
@@ -3301,8 +3599,10 @@ sds genRedisInfoString(char *section) {
             vkeys = dictSize(server.db[j].expires);//过期键字典大小
             if (keys || vkeys) {
                 info = sdscatprintf(info,
-                    "db%d:keys=%lld,expires=%lld,avg_ttl=%lld\r\n",
-                    j, keys, vkeys, server.db[j].avg_ttl);
+                    "db%d:keys=%lld,expires=%lld,avg_ttl=%lld,"
+                    "stale_keys_est=%lld\r\n",
+                    j, keys, vkeys, server.db[j].avg_ttl,
+                    (long long)(vkeys*server.db[j].expired_stale_perc/100));
             }
         }
     }
@@ -3364,8 +3664,11 @@ void monitorCommand(redisClient *c) {
  * LRU approximation algorithm
  * Redis uses an approximation of the LRU algorithm that runs in constant
  * memory. Every time there is a key to expire, we sample N keys (with
- * N very small, usually in around 5) to populate a pool of best keys to
- * evict of M keys (the pool size is defined by REDIS_EVICTION_POOL_SIZE).
+ * N very small, usually in around 5) from every database to populate a
+ * pool of best keys to evict of M keys (the pool size is set by the
+ * maxmemory-eviction-pool-size option). The pool is shared by all the
+ * databases, so the best key is picked across them: a database holding
+ * only recently used keys does not lose keys because it is its turn.
  *
  * The N keys sampled are added in the pool of good keys to expire (the one
  * with an old access time) if they are better than one of the current keys
@@ -3378,22 +3681,87 @@ void monitorCommand(redisClient *c) {
  * When we try to evict a key, and all the entries in the pool don't exist
  * we populate it again. This time we'll be sure that the pool has at least
  * one key that can be evicted, if there is at least one key that can be
- * evicted in the whole database. */
-
-/* Create a new eviction pool. */
-//为evictionPoll分配内存
-struct evictionPoolEntry *evictionPoolAlloc(void) {
+ * evicted in the whole database.
+ *
+ * The LFU policies use the same pool: the "idle" score of a key is the
+ * inverse of its decayed access counter (255-counter), so the least
+ * frequently used keys are the best candidates. volatile-ttl uses it too,
+ * the score being the inverse of the expire time.
+ * LFU 和 volatile-ttl 策略使用同一个池，键的分数分别是 255 减去衰减后的
+ * 访问计数器，以及过期时间的反数。所有数据库共享一个池。 */
+
+/* Create a new eviction pool of 'size' entries. Every entry has a
+ * preallocated sds string, so that the short keys are copied without
+ * allocating memory. */
+//为evictionPoll分配内存，每个元素预先分配一个 sds 用来缓存较短的键名
+struct evictionPoolEntry *evictionPoolAlloc(int size) {
     struct evictionPoolEntry *ep;
     int j;
 
-    ep = zmalloc(sizeof(*ep)*REDIS_EVICTION_POOL_SIZE);//16个元素
-    for (j = 0; j < REDIS_EVICTION_POOL_SIZE; j++) {
+    ep = zmalloc(sizeof(*ep)*size);
+    for (j = 0; j < size; j++) {
         ep[j].idle = 0;
         ep[j].key = NULL;
+        ep[j].cached = sdsnewlen(NULL,REDIS_EVPOOL_CACHED_SDS_SIZE);
+        ep[j].dbid = 0;
     }
     return ep;
 }
 
+/* Free an eviction pool of 'size' entries. */
+void evictionPoolFree(struct evictionPoolEntry *pool, int size) {
+    int j;
+
+    for (j = 0; j < size; j++) {
+        if (pool[j].key != pool[j].cached) sdsfree(pool[j].key);
+        sdsfree(pool[j].cached);
+    }
+    zfree(pool);
+}
+
+/* Replace the eviction pool with an empty one of 'size' entries. Called
+ * when maxmemory-eviction-pool-size is changed at runtime. */
+void evictionPoolResize(int size) {
+    evictionPoolFree(server.eviction_pool,server.maxmemory_eviction_pool_size);
+    server.eviction_pool = evictionPoolAlloc(size);
+    server.maxmemory_eviction_pool_size = size;
+}
+
+/* Return the dict keys are evicted from according to the policy. */
+// 根据淘汰策略返回从中选择淘汰键的字典
+static dict *evictionDict(redisDb *db) {
+    if (server.maxmemory_policy == REDIS_MAXMEMORY_ALLKEYS_LRU ||
+        server.maxmemory_policy == REDIS_MAXMEMORY_ALLKEYS_LFU ||
+        server.maxmemory_policy == REDIS_MAXMEMORY_ALLKEYS_RANDOM)
+    {
+        return db->dict;
+    } else {
+        return db->expires;
+    }
+}
+
+/* Return the score of the key of 'de', an entry of 'sampledict': the
+ * greater the score, the better the key is as a candidate for eviction. */
+// 返回键的淘汰分数，分数越大越应该被淘汰
+static unsigned long long evictionEntryScore(redisDb *db, dict *sampledict,
+                                             dictEntry *de)
+{
+    robj *o;
+
+    if (server.maxmemory_policy == REDIS_MAXMEMORY_VOLATILE_TTL)
+        return ULLONG_MAX - (unsigned long long)dictGetSignedIntegerVal(de);
+
+    /* If the dictionary we are sampling from is not the main
+     * dictionary (but the expires one) we need to lookup the key
+     * again in the key dictionary to obtain the value object. */
+    if (sampledict != db->dict) de = dictFind(db->dict,dictGetKey(de));
+    o = dictGetVal(de);
+    if (REDIS_MAXMEMORY_POLICY_LFU(server.maxmemory_policy))
+        return 255-LFUDecrAndReturn(o);
+    else
+        return estimateObjectIdleTime(o);
+}
+
 /* This is an helper function for freeMemoryIfNeeded(), it is used in order
  * to populate the evictionPool with a few entries every time we want to
  * expire a key. Keys with idle time smaller than one of the current
@@ -3401,14 +3769,15 @@ struct evictionPoolEntry *evictionPoolAlloc(void) {
  *
  * We insert keys on place in ascending order, so keys with the smaller
  * idle time are on the left, and keys with the higher idle time on the
- * right. */
+ * right. The empty entries are always on the right. */
 //pool中的idle time从左到右 按照升序排列，左边的idle time小，右边的idle time大
 
 #define EVICTION_SAMPLES_ARRAY_SIZE 16
-void evictionPoolPopulate(dict *sampledict, dict *keydict, struct evictionPoolEntry *pool) {
-    int j, k, count;
+void evictionPoolPopulate(int dbid, dict *sampledict, struct evictionPoolEntry *pool) {
+    int j, k, count, size = server.maxmemory_eviction_pool_size;
     dictEntry *_samples[EVICTION_SAMPLES_ARRAY_SIZE];
     dictEntry **samples;
+    redisDb *db = server.db+dbid;
 
     /* Try to use a static buffer: this function is a big hit...
      * Note: it was actually measured that this helps. */
@@ -3429,18 +3798,12 @@ void evictionPoolPopulate(dict *sampledict, dict *keydict, struct evictionPoolEn
     //遍历随机取出的count个键
     for (j = 0; j < count; j++) {
         unsigned long long idle;
-        sds key;
-        robj *o;
-        dictEntry *de;
+        sds key, cached;
+        size_t klen;
 
-        de = samples[j];
-        key = dictGetKey(de); //随机取出的键
-        /* If the dictionary we are sampling from is not the main
-         * dictionary (but the expires one) we need to lookup the key
-         * again in the key dictionary to obtain the value object. */
-        if (sampledict != keydict) de = dictFind(keydict, key); //获得key对应的value
-        o = dictGetVal(de);//对应的value
-        idle = estimateObjectIdleTime(o);//获得对象o的idle时长
+        key = dictGetKey(samples[j]); //随机取出的键
+        //获得键的淘汰分数，LRU 策略下是 idle 时长
+        idle = evictionEntryScore(db,sampledict,samples[j]);
 
         /* Insert the element inside the pool.
          * First, find the first empty bucket or the first populated
@@ -3450,15 +3813,15 @@ void evictionPoolPopulate(dict *sampledict, dict *keydict, struct evictionPoolEn
         //或者在pool里找个比当前idle大的元素。就是当前键要替代pool里最小的idle time的键。
         //例如pool中从左到右的idle time分别是2,4,6，8,10，当前键idle time是7，那么需要把2给去掉
         //然后将7插入合适的位置，之后pool变成4,6,7,8,10
-        while (k < REDIS_EVICTION_POOL_SIZE &&
+        while (k < size &&
                pool[k].key &&
                pool[k].idle < idle) k++;
         //如果k==0并且poll里最后一个位置也有key，说明idle比pool里所有元素的idle都小，当前键不满足要求
-        if (k == 0 && pool[REDIS_EVICTION_POOL_SIZE-1].key != NULL) {
+        if (k == 0 && pool[size-1].key != NULL) {
             /* Can't insert if the element is < the worst element we have
              * and there are no empty buckets. */
             continue;
-        } else if (k < REDIS_EVICTION_POOL_SIZE && pool[k].key == NULL) {
+        } else if (k < size && pool[k].key == NULL) {
             //k的位置是空的，那么可以将当前键插入k位置处
             /* Inserting into empty position. No setup needed before insert. */
         } else {
@@ -3467,29 +3830,133 @@ void evictionPoolPopulate(dict *sampledict, dict *keydict, struct evictionPoolEn
             //此时k位置处有元素，并且此元素的idle大于当前键的idle，需要把当前键放入k位置处
             
             //如果右边还有空间，那么将pool+k到末尾的元素往后移一位，然后k位置处放入当前键
-            if (pool[REDIS_EVICTION_POOL_SIZE-1].key == NULL) {
+            if (pool[size-1].key == NULL) {
                 /* Free space on the right? Insert at k shifting
-                 * all the elements from k to end to the right. */
+                 * all the elements from k to end to the right. The cached
+                 * sds of the last (empty) entry moves to k. */
+                cached = pool[size-1].cached;
                 memmove(pool+k+1,pool+k,
-                    sizeof(pool[0])*(REDIS_EVICTION_POOL_SIZE-k-1));
+                    sizeof(pool[0])*(size-k-1));
+                pool[k].cached = cached;
             } else {
                 //右边没有空间的，那么k到末尾不动，把最左边的元素给干掉
                 /* No free space on right? Insert at k-1 */
                 k--;
                 /* Shift all elements on the left of k (included) to the
-                 * left, so we discard the element with smaller idle time. */
-                sdsfree(pool[0].key);//干掉最左边的元素
+                 * left, so we discard the element with smaller idle time.
+                 * Its cached sds moves to k. */
+                cached = pool[0].cached;
+                if (pool[0].key != cached) sdsfree(pool[0].key);//干掉最左边的元素
                 memmove(pool,pool+1,sizeof(pool[0])*k);//将pool+1到k-1的元素左移一位，把k位置空出来
+                pool[k].cached = cached;
             }
         }
-        pool[k].key = sdsdup(key);//将当前键放入k位置处
+
+        /* Copy the key in the cached sds of the entry when it fits, to
+         * avoid an allocation and a free for every key entering the pool. */
+        // 键名足够短时复制到预先分配的 sds 中，避免每次分配和释放内存
+        klen = sdslen(key);
+        if (klen > REDIS_EVPOOL_CACHED_SDS_SIZE) {
+            pool[k].key = sdsdup(key);
+        } else {
+            memcpy(pool[k].cached,key,klen+1);
+            sdssetlen(pool[k].cached,klen);
+            pool[k].key = pool[k].cached;
+        }
         pool[k].idle = idle;
+        pool[k].dbid = dbid;
     }
     if (samples != _samples) zfree(samples);
 }
-//如果超过maxmemory，尝试淘汰一些内存
-int freeMemoryIfNeeded(void) {
-    size_t mem_used, mem_tofree, mem_freed;
+
+/* Select the best key to evict across all the databases using the eviction
+ * pool. Returns the key, owned by the keyspace of the database stored in
+ * '*dbid', or NULL if there are no keys to evict. '*score' is set to the
+ * current score of the key. */
+// 使用淘汰池在所有数据库中选出最应该被淘汰的键
+static sds evictionPoolSelect(int *dbid, unsigned long long *score) {
+    struct evictionPoolEntry *pool = server.eviction_pool;
+    int j, k, size = server.maxmemory_eviction_pool_size;
+
+    while(1) {
+        unsigned long total_keys = 0;
+
+        for (j = 0; j < server.dbnum; j++) {
+            dict *d = evictionDict(server.db+j);
+
+            if (dictSize(d) == 0) continue;
+            evictionPoolPopulate(j,d,pool);
+            total_keys += dictSize(d);
+        }
+        if (total_keys == 0) return NULL; /* No keys to evict. */
+
+        /* Go backward from best to worst element to evict. */
+        //pool中元素从左到右的idle time递增，从右向左遍历，干掉idle time大的键值对
+        //从右向左遍历，找到第一个不为空的元素作为候选bestkey
+        //注意这里选出的bestkey未必过期了，只是采样samples的元素中是idle time是最大的
+        for (k = size-1; k >= 0; k--) {
+            dict *d;
+            dictEntry *de;
+
+            if (pool[k].key == NULL) continue;
+            d = evictionDict(server.db+pool[k].dbid);
+            de = dictFind(d,pool[k].key);
+
+            /* Remove the entry from the pool. The entries on its right
+             * are all empty, so the empty entries stay on the right. */
+            if (pool[k].key != pool[k].cached) sdsfree(pool[k].key);
+            pool[k].key = NULL;
+            pool[k].idle = 0;
+
+            /* If the key exists, is our pick. Otherwise it is
+             * a ghost and we need to try the next element. */
+            if (de) {
+                *dbid = pool[k].dbid;
+                *score = evictionEntryScore(server.db+*dbid,d,de);
+                return dictGetKey(de);
+            } else {
+                /* Ghost... */
+                server.stat_eviction_pool_ghosts++;
+            }
+        }
+    }
+}
+
+/* Sample maxmemory-precision-samples keys across all the databases, and
+ * count how many are not better candidates than the evicted key of score
+ * 'score'. With a true LRU (or LFU, or TTL) eviction all of them are. */
+// 抽样统计淘汰的键与理想 LRU 的接近程度
+static void evictionSamplePrecision(unsigned long long score) {
+    unsigned long total_keys = 0, r;
+    int j, k;
+
+    for (j = 0; j < server.dbnum; j++)
+        total_keys += dictSize(evictionDict(server.db+j));
+    if (total_keys == 0) return;
+
+    for (k = 0; k < server.maxmemory_precision_samples; k++) {
+        dict *d = NULL;
+        dictEntry *de;
+
+        /* Pick the database with a probability proportional to its size,
+         * so that every key has the same probability to be sampled. */
+        r = ((unsigned long)random()<<16 ^ random()) % total_keys;
+        for (j = 0; j < server.dbnum; j++) {
+            d = evictionDict(server.db+j);
+            if (r < dictSize(d)) break;
+            r -= dictSize(d);
+        }
+        de = dictGetRandomKey(d);
+        if (evictionEntryScore(server.db+j,d,de) <= score)
+            server.stat_eviction_precision_hits++;
+        server.stat_eviction_precision_samples++;
+    }
+}
+
+/* Return the memory used for the purpose of maxmemory: the slaves output
+ * buffers and the AOF buffers are not counted. */
+static size_t evictionGetUsedMemory(void) {
+    size_t mem_used;
     int slaves = listLength(server.slaves);
 
     /* Remove the size of slaves output buffers and AOF buffer from the
@@ -3516,166 +3983,248 @@ int freeMemoryIfNeeded(void) {
         mem_used -= sdslen(server.aof_buf);
         mem_used -= aofRewriteBufferSize();
     }
+    return mem_used;
+}
+
+/* Return values of evictKeysUntil(). */
+#define EVICT_OK 0          /* The memory is under the limit. */
+#define EVICT_RUNNING 1     /* Time is over, more keys can be evicted. */
+#define EVICT_FAIL 2        /* Over the limit, but nothing to evict. */
+
+/* Evict keys until the memory returned by evictionGetUsedMemory() is at
+ * most 'limit' bytes, spending at most 'usec' microseconds if 'usec' is not
+ * zero. Returns EVICT_OK if the memory is under the limit, EVICT_FAIL if
+ * there is nothing to evict, EVICT_RUNNING if the time is over.
+ * 淘汰键直到内存不超过 limit 字节，usec 不为 0 时最多执行 usec 微秒。 */
+static int evictKeysUntil(size_t limit, long long usec) {
+    size_t mem_used, mem_tofree, mem_freed, mem_overhead;
+    int slaves = listLength(server.slaves);
+    long long start = usec ? ustime() : 0;
+
+    mem_used = evictionGetUsedMemory();
 
     /* Check if we are over the memory limit. */
-    // 如果目前使用的内存大小比设置的 maxmemory 要小，那么无须执行进一步操作
-    if (mem_used <= server.maxmemory) return REDIS_OK;
+    // 如果目前使用的内存大小比 limit 要小，那么无须执行进一步操作
+    if (mem_used <= limit) return EVICT_OK;
 
     // 如果占用内存比 maxmemory 要大，但是 maxmemory 策略为不淘汰，那么直接返回
     //无淘汰策略的话直接返回
     if (server.maxmemory_policy == REDIS_MAXMEMORY_NO_EVICTION)
-        return REDIS_ERR; /* We need to free memory, but policy forbids. */
+        return EVICT_FAIL; /* We need to free memory, but policy forbids. */
 
     /* Compute how much memory we need to free. */
     // 计算需要释放多少字节的内存
-    mem_tofree = mem_used - server.maxmemory;
+    mem_tofree = mem_used - limit;
 
     // 初始化已释放内存的字节数为 0
     mem_freed = 0;
+    mem_overhead = zmalloc_used_memory()-mem_used;
 
     // 根据 maxmemory 策略，
     // 遍历字典，释放内存并记录被释放内存的字节数
     while (mem_freed < mem_tofree) {
-        int j, k, keys_freed = 0;
-
-        // 遍历所有数据库
-        for (j = 0; j < server.dbnum; j++) {
-            long bestval = 0; /* just to prevent warning */
-            sds bestkey = NULL;//要淘汰的键
-            dictEntry *de;
-            redisDb *db = server.db+j;
-            dict *dict; //基于什么字典来淘汰键
-            //lru淘汰或者随机淘汰策略
-            if (server.maxmemory_policy == REDIS_MAXMEMORY_ALLKEYS_LRU ||
-                server.maxmemory_policy == REDIS_MAXMEMORY_ALLKEYS_RANDOM)
-            {
-                // 如果策略是 allkeys-lru 或者 allkeys-random 
-                // 那么淘汰的目标为所有数据库键
-                dict = server.db[j].dict;
-            } else {
-                // 如果策略是 volatile-lru 、 volatile-random 或者 volatile-ttl 
-                // 那么淘汰的目标为带过期时间的数据库键
-                dict = server.db[j].expires;
+        sds bestkey = NULL; //要淘汰的键
+        int bestdbid = 0;
+        unsigned long long score;
+        redisDb *db;
+        robj *keyobj;
+        long long delta;
+
+        /* volatile-random and allkeys-random policy */
+        // 如果使用的是随机策略，那么轮流从每个数据库中随机选出键
+        if (server.maxmemory_policy == REDIS_MAXMEMORY_ALLKEYS_RANDOM ||
+            server.maxmemory_policy == REDIS_MAXMEMORY_VOLATILE_RANDOM)
+        {
+            static int next_db = 0;
+            int j;
+
+            for (j = 0; j < server.dbnum; j++) {
+                dict *d = evictionDict(server.db+next_db);
+
+                bestdbid = next_db;
+                next_db = (next_db+1) % server.dbnum;
+                if (dictSize(d) != 0) {
+                    bestkey = dictGetKey(dictGetRandomKey(d));
+                    break;
+                }
             }
+        }
 
-            // 跳过空字典
-            if (dictSize(dict) == 0) continue;
+        /* volatile-lru, allkeys-lru, volatile-lfu, allkeys-lfu and
+         * volatile-ttl */
+        // 其他策略从所有数据库共享的淘汰池中选出最好的键
+        //注意选出来的键未必过期，只是采样的samples中分数最大的键
+        else {
+            bestkey = evictionPoolSelect(&bestdbid,&score);
+            if (bestkey && server.maxmemory_precision_samples)
+                evictionSamplePrecision(score);
+        }
 
-            /* volatile-random and allkeys-random policy */
-            // 如果使用的是随机策略，那么从目标字典中随机选出键
-            if (server.maxmemory_policy == REDIS_MAXMEMORY_ALLKEYS_RANDOM ||
-                server.maxmemory_policy == REDIS_MAXMEMORY_VOLATILE_RANDOM)
-            {
-                de = dictGetRandomKey(dict);
-                bestkey = dictGetKey(de); //随机选出要淘汰的键
-            }
+        if (bestkey == NULL) return EVICT_FAIL; /* nothing to free... */
+
+        /* Finally remove the selected key. */
+        // 删除被选中的键，bestkey就是要淘汰的键
+        db = server.db+bestdbid;
+        keyobj = createStringObject(bestkey,sdslen(bestkey));
+        propagateExpire(db,keyobj);//传播过期键删除到aof和slave
+        /* We compute the amount of memory freed by dbDelete() alone.
+         * It is possible that actually the memory needed to propagate
+         * the DEL in AOF and replication link is greater than the one
+         * we are freeing removing the key, but we can't account for
+         * that otherwise we would never exit the loop.
+         *
+         * AOF and Output buffer memory will be freed eventually so
+         * we only care about memory used by the key space. */
+        // 计算删除键所释放的内存数量
+        delta = (long long) zmalloc_used_memory();
+        if (server.lazyfree_lazy_eviction)
+            dbAsyncDelete(db,keyobj);
+        else
+            dbSyncDelete(db,keyobj);
+        delta -= (long long) zmalloc_used_memory();
+        mem_freed += delta;
+        
+        // 对淘汰键的计数器增一
+        server.stat_evictedkeys++;
+
+        notifyKeyspaceEvent(REDIS_NOTIFY_EVICTED, "evicted",
+            keyobj, db->id);
+        decrRefCount(keyobj);
 
-            /* volatile-lru and allkeys-lru policy */
-            // 如果使用的是 LRU 策略，
-            // 那么从一集 sample 键中选出 IDLE 时间最长的那个键
-            //这个要干掉的元素未必过期，只是采样的samples中的idle time是最大的
-            else if (server.maxmemory_policy == REDIS_MAXMEMORY_ALLKEYS_LRU ||
-                server.maxmemory_policy == REDIS_MAXMEMORY_VOLATILE_LRU)
-            {
-                struct evictionPoolEntry *pool = db->eviction_pool;
-
-                while(bestkey == NULL) {
-                    evictionPoolPopulate(dict, db->dict, db->eviction_pool);
-                    /* Go backward from best to worst element to evict. */
-                    //pool中元素从左到右的idle time递增，从右向左遍历，干掉idle time大的键值对
-                    //从右向左遍历，找到第一个不为空的元素作为候选bestkey
-                    //注意这里选出的bestkey未必过期了，只是采样samples的元素中是idle time是最大的
-                    for (k = REDIS_EVICTION_POOL_SIZE-1; k >= 0; k--) {
-                        if (pool[k].key == NULL) continue;
-                        de = dictFind(dict,pool[k].key);
-
-                        /* Remove the entry from the pool. */
-                        sdsfree(pool[k].key);//从pool中移除元素
-                        /* Shift all elements on its right to left. */
-                        memmove(pool+k,pool+k+1,
-                            sizeof(pool[0])*(REDIS_EVICTION_POOL_SIZE-k-1));//将右边所有元素左移一位
-                        /* Clear the element on the right which is empty
-                         * since we shifted one position to the left.  */
-                        pool[REDIS_EVICTION_POOL_SIZE-1].key = NULL;
-                        pool[REDIS_EVICTION_POOL_SIZE-1].idle = 0;
-
-                        /* If the key exists, is our pick. Otherwise it is
-                         * a ghost and we need to try the next element. */
-                        if (de) {
-                            bestkey = dictGetKey(de);
-                            break;
-                        } else {
-                            /* Ghost... */
-                            continue;
-                        }
-                    }
-                }
-            }
+        /* When the memory to free starts to be big enough, we may
+         * start spending so much time here that is impossible to
+         * deliver data to the slaves fast enough, so we force the
+         * transmission here inside the loop. */
+        if (slaves) flushSlavesOutputBuffers();
 
-            /* volatile-ttl */
-            //ttl：那么从过期键字典中选取键进行淘汰
-            // 策略为 volatile-ttl ，从一集 sample 键中选出过期时间距离当前时间最接近的键
-            //注意：选出来的键可能并未过期，只是采样的samples中最快过期的那个键
-            else if (server.maxmemory_policy == REDIS_MAXMEMORY_VOLATILE_TTL) {
-                for (k = 0; k < server.maxmemory_samples; k++) {
-                    sds thiskey;
-                    long thisval;
-
-                    de = dictGetRandomKey(dict); //从过期键字典中随机选取键进行淘汰
-                    thiskey = dictGetKey(de);
-                    thisval = (long) dictGetVal(de);//获得过期时间
-
-                    /* Expire sooner (minor expire unix timestamp) is better
-                     * candidate for deletion */
-                    //如果thisval的过期到达时间小于bestval，那么更新bestkey
-                    if (bestkey == NULL || thisval < bestval) {
-                        bestkey = thiskey;
-                        bestval = thisval;
-                    }
-                }
-            }
+        /* Values released by the lazyfree thread are not accounted in
+         * 'mem_freed': stop as soon as the memory is back under the limit. */
+        // 后台释放的值不计入 mem_freed ，内存回到限制以下时就停止淘汰
+        if (server.lazyfree_lazy_eviction &&
+            zmalloc_used_memory() <= limit+mem_overhead) break;
 
-            /* Finally remove the selected key. */
-            // 删除被选中的键，bestkey就是要淘汰的键
-            if (bestkey) {
-                long long delta;
-
-                robj *keyobj = createStringObject(bestkey,sdslen(bestkey));
-                propagateExpire(db,keyobj);//传播过期键删除到aof和slave
-                /* We compute the amount of memory freed by dbDelete() alone.
-                 * It is possible that actually the memory needed to propagate
-                 * the DEL in AOF and replication link is greater than the one
-                 * we are freeing removing the key, but we can't account for
-                 * that otherwise we would never exit the loop.
-                 *
-                 * AOF and Output buffer memory will be freed eventually so
-                 * we only care about memory used by the key space. */
-                // 计算删除键所释放的内存数量
-                delta = (long long) zmalloc_used_memory();
-                dbDelete(db,keyobj);
-                delta -= (long long) zmalloc_used_memory();
-                mem_freed += delta;
-                
-                // 对淘汰键的计数器增一
-                server.stat_evictedkeys++;
-
-                notifyKeyspaceEvent(REDIS_NOTIFY_EVICTED, "evicted",
-                    keyobj, db->id);
-                decrRefCount(keyobj);
-                keys_freed++;
-
-                /* When the memory to free starts to be big enough, we may
-                 * start spending so much time here that is impossible to
-                 * deliver data to the slaves fast enough, so we force the
-                 * transmission here inside the loop. */
-                if (slaves) flushSlavesOutputBuffers();
-            }
-        }
+        // 时间用完，剩下的工作留到下次
+        if (usec && ustime()-start >= usec) return EVICT_RUNNING;
+    }
+
+    return EVICT_OK;
+}
+
+/* Memory above which commands evict keys inline when the background
+ * eviction is enabled. */
+// 启用后台淘汰时，超过这个值命令才会在执行前淘汰键
+static size_t evictionHardLimit(void) {
+    return server.maxmemory +
+           server.maxmemory/100*server.maxmemory_hard_limit_perc;
+}
 
-        if (!keys_freed) return REDIS_ERR; /* nothing to free... */
+static int evictionBackgroundEnabled(void) {
+    return server.maxmemory_background_eviction &&
+           server.maxmemory_policy != REDIS_MAXMEMORY_NO_EVICTION;
+}
+
+/* Called before processing a command when maxmemory is set. Without the
+ * background eviction the keys are evicted until the memory is under
+ * maxmemory. With the background eviction maxmemory is the soft limit: the
+ * keys are evicted by evictionTimeProc() in small slices between the
+ * event loop iterations, and the command only evicts inline if the memory
+ * is over the hard limit, down to the hard limit.
+ *
+ * 处理命令前调用。启用后台淘汰时 maxmemory 是软限制，键由 evictionTimeProc()
+ * 在事件循环的间隙分批淘汰，只有内存超过硬限制时命令才在执行前淘汰键。 */
+int freeMemoryIfNeeded(void) {
+    size_t limit = server.maxmemory;
+    long long start, elapsed;
+    int retval;
+
+    if (evictionBackgroundEnabled()) {
+        startBackgroundEvictionIfNeeded();
+        limit = evictionHardLimit();
     }
 
-    return REDIS_OK;
+    start = ustime();
+    retval = evictKeysUntil(limit,0);
+    elapsed = ustime()-start;
+    server.stat_eviction_inline_usec += elapsed;
+    if (elapsed > server.stat_eviction_inline_max_usec)
+        server.stat_eviction_inline_max_usec = elapsed;
+    return (retval == EVICT_OK) ? REDIS_OK : REDIS_ERR;
+}
+
+/* Evict keys for server.maxmemory_eviction_budget microseconds. Returns
+ * the evictKeysUntil() result. */
+static int evictionBackgroundCycle(void) {
+    long long start = ustime();
+    int retval;
+
+    retval = evictKeysUntil(server.maxmemory,
+                            server.maxmemory_eviction_budget);
+    server.stat_eviction_background_usec += ustime()-start;
+    if (retval == EVICT_OK) server.eviction_over_since = 0;
+    return retval;
+}
+
+/* Time event running a background eviction slice every millisecond until
+ * the memory is back under maxmemory. The interval lets the event loop
+ * serve the clients between the slices: a time event returning 0 would run
+ * again in the same processTimeEvents() call.
+ *
+ * When nothing can be evicted (for instance a volatile policy without
+ * volatile keys) the timer stops, and only serverCron() tries again.
+ *
+ * 时间事件：每毫秒淘汰一批键，直到内存回到 maxmemory 以下。
+ * 没有可以淘汰的键时停止，之后只由 serverCron() 重新尝试。 */
+static int evictionTimeProc(struct aeEventLoop *eventLoop, long long id,
+                            void *clientData)
+{
+    int retval = EVICT_OK;
+
+    REDIS_NOTUSED(eventLoop);
+    REDIS_NOTUSED(id);
+    REDIS_NOTUSED(clientData);
+
+    if (evictionBackgroundEnabled() && server.maxmemory)
+        retval = evictionBackgroundCycle();
+    else if (!server.maxmemory ||
+             evictionGetUsedMemory() <= server.maxmemory)
+        server.eviction_over_since = 0;
+    if (retval == EVICT_RUNNING) return 1;
+
+    server.eviction_stalled = (retval == EVICT_FAIL);
+    server.eviction_timer_id = -1;
+    return AE_NOMORE;
+}
+
+/* Start the background eviction if the memory is over maxmemory. Called
+ * by freeMemoryIfNeeded() and serverCron(), as the memory can grow without
+ * commands (client buffers, for instance). After a slice found nothing to
+ * evict the commands don't restart it: serverCron() clears
+ * server.eviction_stalled first.
+ *
+ * The memory can also go back under maxmemory without the timer (DEL or
+ * FLUSHALL after a stalled slice, or with the background eviction turned
+ * off), so the start of the episode is reset here too. */
+void startBackgroundEvictionIfNeeded(void) {
+    if (server.eviction_timer_id != -1) return;
+    if (!server.maxmemory || evictionGetUsedMemory() <= server.maxmemory) {
+        server.eviction_over_since = 0;
+        return;
+    }
+    if (!evictionBackgroundEnabled() || server.eviction_stalled) return;
+
+    if (server.eviction_over_since == 0) server.eviction_over_since = mstime();
+    server.eviction_timer_id = aeCreateTimeEvent(server.el,0,
+        evictionTimeProc,NULL,NULL);
+}
+
+/* Bytes over maxmemory, and milliseconds since the memory went over it. */
+void evictionGetLag(size_t *bytes, long long *ms) {
+    size_t mem_used = evictionGetUsedMemory();
+
+    *bytes = (server.maxmemory && mem_used > server.maxmemory) ?
+             mem_used-server.maxmemory : 0;
+    *ms = (*bytes && server.eviction_over_since) ?
+          mstime()-server.eviction_over_since : 0;
 }
 
 /* =================================== Main! ================================ */
@@ -58,7 +58,9 @@
 #include "zmalloc.h" /* total memory usage aware version of malloc/free */
 #include "anet.h"    /* Networking the easy way */
 #include "ziplist.h" /* Compact list data structure */
+#include "quicklist.h" /* Linked list of ziplists */
 #include "intset.h"  /* Compact integer set structure */
+#include "respscan.h" /* Vectorized scanning of the RESP protocol */
 #include "version.h" /* Version macro */
 #include "util.h"    /* Misc functions useful in many places */
 
@@ -73,14 +75,25 @@
 #define REDIS_MAX_HZ            500 
 #define REDIS_SERVERPORT        6379    /* TCP port */
 #define REDIS_TCP_BACKLOG       511     /* TCP listen backlog */
+#define REDIS_DEFAULT_TCP_LISTENERS 1   /* Listening sockets per address */
+#define REDIS_TCP_LISTENERS_MAX 16
 #define REDIS_MAXIDLETIME       0       /* default client timeout: infinite */
 #define REDIS_DEFAULT_DBNUM     16
+#define REDIS_DEFAULT_KEYSPACE_LAYOUT DICT_LAYOUT_CHAINED
 #define REDIS_CONFIGLINE_MAX    1024
 #define REDIS_DBCRON_DBS_PER_CALL 16
 #define REDIS_MAX_WRITE_PER_EVENT (1024*64)
+/* Max number of chunks gathered by a single writev() of the reply. */
+#ifdef IOV_MAX
+#define REDIS_IOV_MAX IOV_MAX
+#else
+#define REDIS_IOV_MAX 16
+#endif
 #define REDIS_SHARED_SELECT_CMDS 10
 #define REDIS_SHARED_INTEGERS 10000
 #define REDIS_SHARED_BULKHDR_LEN 32
+#define REDIS_EMBSTR_MAX_ALLOC 128 /* Size class EMBSTR objects may fill */
+#define REDIS_EMBSTR_MIN_SIZE_LIMIT 44 /* Fits 64 bytes with any allocator */
 #define REDIS_MAX_LOGMSG_LEN    1024 /* Default maximum length of syslog messages */
 #define REDIS_AOF_REWRITE_PERC  100
 #define REDIS_AOF_REWRITE_MIN_SIZE (64*1024*1024)
@@ -115,12 +128,36 @@
 #define REDIS_DEFAULT_REPL_DISABLE_TCP_NODELAY 0
 #define REDIS_DEFAULT_MAXMEMORY 0
 #define REDIS_DEFAULT_MAXMEMORY_SAMPLES 5
+#define REDIS_DEFAULT_LFU_LOG_FACTOR 10
+#define REDIS_DEFAULT_LFU_DECAY_TIME 1
+#define REDIS_DEFAULT_MAXMEMORY_EVICTION_POOL_SIZE 16
+#define REDIS_DEFAULT_MAXMEMORY_PRECISION_SAMPLES 0
+#define REDIS_DEFAULT_MAXMEMORY_BACKGROUND_EVICTION 0
+#define REDIS_DEFAULT_MAXMEMORY_HARD_LIMIT_PERC 10
+#define REDIS_DEFAULT_MAXMEMORY_EVICTION_BUDGET 500 /* Microseconds. */
+#define REDIS_DEFAULT_LAZYFREE_LAZY_EVICTION 0
+#define REDIS_DEFAULT_ACTIVE_EXPIRE_INDEX 0
+#define REDIS_DEFAULT_ACTIVE_EXPIRE_EFFORT 1
+#define REDIS_DEFAULT_ACTIVE_EXPIRE_PRESSURE_PERC 0 /* Disabled. */
+#define REDIS_DEFAULT_LAZYFREE_LAZY_EXPIRE 0
+#define REDIS_DEFAULT_LAZYFREE_LAZY_SERVER_DEL 0
 #define REDIS_DEFAULT_AOF_FILENAME "appendonly.aof"
 #define REDIS_DEFAULT_AOF_NO_FSYNC_ON_REWRITE 0
 #define REDIS_DEFAULT_ACTIVE_REHASHING 1
+#define REDIS_DEFAULT_ACTIVE_REHASHING_BUDGET 1000 /* Microseconds per cron. */
 #define REDIS_DEFAULT_AOF_REWRITE_INCREMENTAL_FSYNC 1
 #define REDIS_DEFAULT_MIN_SLAVES_TO_WRITE 0
 #define REDIS_DEFAULT_MIN_SLAVES_MAX_LAG 10
+#define REDIS_DEFAULT_IO_THREADS 1 /* Only the main thread does I/O. */
+#define REDIS_IO_THREADS_MAX_NUM 128
+#define REDIS_DEFAULT_CLIENT_POOL_SIZE 128 /* Closed clients kept for reuse. */
+
+/* Make sure we have enough stack to perform all the things we do in the
+ * main thread. Used by bio.c and by the I/O threads.
+ * 子线程栈大小
+ */
+#define REDIS_THREAD_STACK_SIZE (1024*1024*4) //4M
+
 #define REDIS_IP_STR_LEN INET6_ADDRSTRLEN
 #define REDIS_PEER_ID_LEN (REDIS_IP_STR_LEN+32) /* Must be enough for ip:port */
 #define REDIS_BINDADDR_MAX 16
@@ -129,6 +166,8 @@
 #define ACTIVE_EXPIRE_CYCLE_LOOKUPS_PER_LOOP 20 /* Loopkups per loop. */
 #define ACTIVE_EXPIRE_CYCLE_FAST_DURATION 1000 /* Microseconds */
 #define ACTIVE_EXPIRE_CYCLE_SLOW_TIME_PERC 25 /* CPU max % for keys collection */
+#define ACTIVE_EXPIRE_CYCLE_ACCEPTABLE_STALE 25 /* % of expired keys to stop. */
+#define ACTIVE_EXPIRE_EFFORT_MAX 10
 #define ACTIVE_EXPIRE_CYCLE_SLOW 0
 #define ACTIVE_EXPIRE_CYCLE_FAST 1
 
@@ -136,6 +175,7 @@
 #define REDIS_MAX_QUERYBUF_LEN  (1024*1024*1024) /* 1GB max query buffer. */
 #define REDIS_IOBUF_LEN         (1024*16)  /* Generic I/O buffer size */
 #define REDIS_REPLY_CHUNK_BYTES (16*1024) /* 16k output buffer */
+#define REDIS_REPLY_ZEROCOPY_MIN_BYTES (4*1024) /* Referenced, not copied */
 #define REDIS_INLINE_MAX_SIZE   (1024*64) /* Max size of inline reads */
 #define REDIS_MBULK_BIG_ARG     (1024*32)
 #define REDIS_LONGSTR_SIZE      21          /* Bytes needed for long -> str */
@@ -187,6 +227,7 @@
 #define REDIS_ENCODING_INTSET 6  /* Encoded as intset *///集合对象
 #define REDIS_ENCODING_SKIPLIST 7  /* Encoded as skiplist *///有序集合
 #define REDIS_ENCODING_EMBSTR 8  /* Embedded sds string encoding *///字符串对象
+#define REDIS_ENCODING_QUICKLIST 9 /* Encoded as linked list of ziplists */ //列表对象
 
 /* Defines related to the dump file format. To store 32 bits lengths for short
  * keys requires a lot of space, so we check the most significant 2 bits of
@@ -240,6 +281,11 @@
 #define REDIS_FORCE_REPL (1<<15)  /* Force replication of current cmd. */
 #define REDIS_PRE_PSYNC (1<<16)   /* Instance don't understand PSYNC. */
 #define REDIS_READONLY (1<<17)    /* Cluster client is in read-only state. */
+#define REDIS_PENDING_READ (1<<18) /* Queued in server.clients_pending_read. */
+#define REDIS_PENDING_COMMAND (1<<19) /* I/O thread parsed a command that
+                                         the main thread must execute. */
+#define REDIS_PENDING_WRITE (1<<20) /* Queued in server.clients_pending_write. */
+#define REDIS_IO_CLOSE (1<<21)    /* I/O thread saw EOF/error, free it. */
 
 /* Client block type (btype field in client structure)
  * if REDIS_BLOCKED flag is set. */
@@ -251,6 +297,14 @@
 #define REDIS_REQ_INLINE 1
 #define REDIS_REQ_MULTIBULK 2
 
+/* Why reading from the client asked to close it (read_error field of the
+ * client structure), logged later by the main thread. */
+#define REDIS_READ_ERR_NONE 0
+#define REDIS_READ_ERR_IO 1         /* read() failed, errno in read_errno. */
+#define REDIS_READ_ERR_EOF 2        /* The client closed the connection. */
+#define REDIS_READ_ERR_QBUF_LIMIT 3 /* client-max-querybuf-len reached. */
+#define REDIS_READ_ERR_PROTOCOL 4   /* Protocol error, close after reply. */
+
 /* Client classes for client limits, currently used only for
  * the max-client-output-buffer limit implementation. */
 #define REDIS_CLIENT_LIMIT_CLASS_NORMAL 0
@@ -315,6 +369,7 @@
 #define REDIS_HASH_MAX_ZIPLIST_VALUE 64
 #define REDIS_LIST_MAX_ZIPLIST_ENTRIES 512
 #define REDIS_LIST_MAX_ZIPLIST_VALUE 64
+#define REDIS_LIST_QUICKLIST_FILL 0 /* 0: big lists use a linked list */
 #define REDIS_SET_MAX_INTSET_ENTRIES 512
 #define REDIS_ZSET_MAX_ZIPLIST_ENTRIES 128
 #define REDIS_ZSET_MAX_ZIPLIST_VALUE 64
@@ -334,7 +389,12 @@
 #define REDIS_MAXMEMORY_ALLKEYS_LRU 3
 #define REDIS_MAXMEMORY_ALLKEYS_RANDOM 4
 #define REDIS_MAXMEMORY_NO_EVICTION 5
+#define REDIS_MAXMEMORY_VOLATILE_LFU 6
+#define REDIS_MAXMEMORY_ALLKEYS_LFU 7
 #define REDIS_DEFAULT_MAXMEMORY_POLICY REDIS_MAXMEMORY_NO_EVICTION
+// 使用 LFU 淘汰策略时，对象的 lru 属性保存的是访问频率而不是访问时间
+#define REDIS_MAXMEMORY_POLICY_LFU(p) \
+    ((p) == REDIS_MAXMEMORY_VOLATILE_LFU || (p) == REDIS_MAXMEMORY_ALLKEYS_LFU)
 
 /* Scripting */
 #define REDIS_LUA_TIME_LIMIT 5000 /* milliseconds */
@@ -399,6 +459,25 @@ typedef long long mstime_t; /* millisecond time type. */
 #define REDIS_LRU_BITS 24
 #define REDIS_LRU_CLOCK_MAX ((1<<REDIS_LRU_BITS)-1) /* Max value of obj->lru */
 #define REDIS_LRU_CLOCK_RESOLUTION 1000 /* LRU clock resolution in ms */
+
+/* With the LFU policies the 24 lru bits of an object are split in two:
+ *
+ *      16 bits      8 bits
+ * +----------------+--------+
+ * + Last decr time | LOG_C  |
+ * +----------------+--------+
+ *
+ * LOG_C is a logarithmic access counter: it is incremented with a
+ * probability that gets lower as it grows (see LFULogIncr()), so that 8
+ * bits are enough for millions of accesses. The last decrement time, in
+ * minutes, lets the counter decay by one every lfu-decay-time minutes the
+ * key is not accessed, so that keys that were hot long ago can be evicted.
+ * New objects start at REDIS_LFU_INIT_VAL so they are not evicted before
+ * having a chance to accumulate accesses.
+ *
+ * 使用 LFU 策略时，lru 的高 16 位是计数器上次衰减的时间（分钟），
+ * 低 8 位是对数访问计数器 */
+#define REDIS_LFU_INIT_VAL 5
 typedef struct redisObject {
     // 哪种对象类型，共5种类型（字符串对象、列表对象、哈希对象、集合对象、有序集合对象）
     unsigned type:4;
@@ -406,8 +485,9 @@ typedef struct redisObject {
     // 对象以哪种数据结构实现
     unsigned encoding:4;
 
-    // 对象最后一次被访问的时间，占24位
-    unsigned lru:REDIS_LRU_BITS; /* lru time (relative to server.lruclock) */ 
+    // 对象最后一次被访问的时间，占24位（LFU 策略下是访问频率，见上文）
+    unsigned lru:REDIS_LRU_BITS; /* LRU time (relative to server.lruclock) or
+                                  * LFU data (see REDIS_LFU_INIT_VAL). */
 
     // 引用计数，实现对象共享和内存释放
     int refcount;
@@ -439,11 +519,14 @@ typedef struct redisObject {
  * that are good candidate for eviction across freeMemoryIfNeeded() calls.
  * Entries inside the eviciton pool are taken ordered by idle time, putting
  * greater idle times to the right (ascending order).
- * Empty entries have the key pointer set to NULL. */
-#define REDIS_EVICTION_POOL_SIZE 16
+ * Empty entries have the key pointer set to NULL. The pool is shared by all
+ * the databases. */
+#define REDIS_EVPOOL_CACHED_SDS_SIZE 255
 struct evictionPoolEntry {
     unsigned long long idle;    /* Object idle time. */ //idle时间
     sds key;                    /* Key name. */         //键的名字
+    sds cached;                 /* Preallocated sds for short key names. */
+    int dbid;                   /* Database of the key. */ //键所在的数据库
 };
 
 /* Redis database representation. There are multiple databases identified
@@ -466,14 +549,19 @@ typedef struct redisDb {
     // 正在被 WATCH 命令监视的键
     dict *watched_keys;         /* WATCHED keys for MULTI/EXEC CAS */
 
-    struct evictionPoolEntry *eviction_pool;    /* Eviction pool of keys */
-
     // 数据库号码
     int id;                     /* Database ID */ //0~15
 
     // 数据库的键的平均 TTL ，统计信息
     long long avg_ttl;          /* Average TTL, just for stats */
 
+    // 按过期时间排序的过期索引，以及第一个还没处理的槽
+    dict *expire_index;         /* Expire slot -> keys, or NULL if disabled */
+    unsigned long expire_index_cursor; /* First slot not yet processed. */
+
+    // 估计的已过期但还没删除的键占带过期时间的键的百分比
+    double expired_stale_perc;  /* Estimated % of expired keys, for stats */
+
 } redisDb;
 
 /* Client MULTI/EXEC state */
@@ -571,6 +659,10 @@ typedef struct redisClient {
     // 查询缓冲区长度峰值
     size_t querybuf_peak;   /* Recent (100ms or more) peak of querybuf size */
 
+    // 读取查询缓冲区失败的原因，以及 read() 的 errno
+    int read_error;         /* REDIS_READ_ERR_* */
+    int read_errno;         /* errno of the failed read(). */
+
     // 参数数量
     int argc;
 
@@ -589,6 +681,9 @@ typedef struct redisClient {
     // 命令内容的长度
     long bulklen;           /* length of bulk argument in multi bulk request */
 
+    // 查询缓冲区的 '\r' 扫描器，在多次读取和多个命令之间保留
+    respScanner respscan;   /* Header lines scanner of querybuf. */
+
     // 回复链表
     list *reply;
 
@@ -665,6 +760,11 @@ typedef struct redisClient {
     list *pubsub_patterns;  /* patterns a client is interested in (SUBSCRIBE) */
     sds peerid;             /* Cached peer ID. *///客户端的名字,ip:port
 
+    // I/O 线程写回复的结果，由主线程在线程结束后处理（释放已发送的节点等）
+    size_t io_written;      /* Bytes written by the last _writeToClient(). */
+    int io_sent_nodes;      /* Reply nodes fully sent, still to be released. */
+    int io_write_errno;     /* errno of a failed write, 0 on success/EAGAIN. */
+
     /* Response buffer */
     // 回复偏移量
     int bufpos;
@@ -809,6 +909,9 @@ struct redisServer {
     // serverCron() 每秒调用的次数
     int hz;                     /* serverCron() calls frequency in hertz */
 
+    // 使用 EMBSTR 编码的字符串的最大长度，启动时根据分配器的 size class 计算
+    size_t embstr_size_limit;   /* Longest string stored as EMBSTR */
+
     // 数据库，指向哪个db 
     redisDb *db;
 
@@ -828,6 +931,7 @@ struct redisServer {
 
     // 在执行 serverCron() 时进行渐进式 rehash
     int activerehashing;        /* Incremental rehash in serverCron() */
+    long long active_rehashing_budget; /* Usec of active rehashing per cron */
 
     // 是否设置了密码
     char *requirepass;          /* Pass for AUTH command, or NULL */
@@ -854,6 +958,9 @@ struct redisServer {
 
     int tcp_backlog;            /* TCP listen() backlog */
 
+    // 每个地址的监听套接字数量，多于一个时使用 SO_REUSEPORT
+    int tcp_listeners;          /* SO_REUSEPORT listening sockets per address */
+
     // 地址
     char *bindaddr[REDIS_BINDADDR_MAX]; /* Addresses we should bind to */
     // 地址数量
@@ -864,7 +971,7 @@ struct redisServer {
     mode_t unixsocketperm;      /* UNIX socket permission */
 
     // 描述符
-    int ipfd[REDIS_BINDADDR_MAX]; /* TCP socket file descriptors */
+    int ipfd[REDIS_BINDADDR_MAX*REDIS_TCP_LISTENERS_MAX]; /* TCP socket file descriptors */
     // 描述符数量
     int ipfd_count;             /* Used slots in ipfd[] */
 
@@ -886,6 +993,14 @@ struct redisServer {
     redisClient *current_client; /* Current client, only used on crash report */
 
     int clients_paused;         /* True if clients are currently paused */
+
+    // 等待 I/O 线程读取/写入的客户端
+    list *clients_pending_read;  /* Clients with reads postponed to threads */
+    list *clients_pending_write; /* Clients with replies to flush */
+
+    // 客户端池：已关闭并重置、等待复用的客户端
+    redisClient **client_pool;  /* Reset clients ready to be reused */
+    int client_pool_len;        /* Number of clients in the pool */
     mstime_t clients_pause_end_time; /* Time when we undo clients_paused */
 
     // 网络错误
@@ -937,6 +1052,9 @@ struct redisServer {
     // 查找键失败的次数
     long long stat_keyspace_misses; /* Number of failed lookups of keys */
 
+    // 执行命令之前被批量预取的键的数量
+    long long stat_prefetched_keys; /* Keys prefetched by dbPrefetchKeys() */
+
     // 已使用内存峰值
     size_t stat_peak_memory;        /* Max used memory record */
 
@@ -955,6 +1073,30 @@ struct redisServer {
     // PSYNC 执行失败的次数
     long long stat_sync_partial_err;/* Number of unaccepted PSYNC requests. */
 
+    // 由 I/O 线程完成的读取和写入次数
+    long long stat_io_reads_processed;  /* Reads handled by I/O threads. */
+    long long stat_io_writes_processed; /* Writes handled by I/O threads. */
+
+    // 从客户端池中取到/没有取到客户端的次数
+    long long stat_client_pool_hits;    /* Clients reused from the pool. */
+    long long stat_client_pool_misses;  /* Clients allocated from scratch. */
+
+    // 在命令执行前和在后台淘汰键所花的时间
+    long long stat_eviction_inline_usec;     /* Usec evicting before commands. */
+    long long stat_eviction_inline_max_usec; /* Longest inline eviction. */
+    long long stat_eviction_background_usec; /* Usec evicting in background. */
+
+    // 淘汰池中已不存在的键的数量，以及淘汰精度的抽样统计
+    long long stat_eviction_pool_ghosts;     /* Pool keys no longer existing. */
+    long long stat_eviction_precision_samples; /* Keys sampled at eviction. */
+    long long stat_eviction_precision_hits;  /* Sampled keys not better than
+                                                the evicted one. */
+
+    // 定期删除耗费的时间，因为超时而退出的次数，以及估计的过期键比例
+    long long stat_expire_cycle_time_used;   /* Usec in activeExpireCycle(). */
+    long long stat_expired_time_cap_reached_count; /* Cycles out of time. */
+    double stat_expired_stale_perc; /* Estimated % of expired keys. */
+
 
     /* slowlog */
     // 保存了所有慢查询日志的链表
@@ -990,9 +1132,23 @@ struct redisServer {
 
     // 是否开启 SO_KEEPALIVE 选项
     int tcpkeepalive;               /* Set SO_KEEPALIVE if non-zero. */
+    // I/O 线程数量（包括主线程），1 表示不使用 I/O 线程
+    int io_threads_num;             /* Number of I/O threads, main included. */
+    int io_threads_active;          /* True if I/O threads are running. */
+    // 客户端池最多保存的客户端数量
+    int client_pool_size;           /* Max clients kept in server.client_pool */
     int active_expire_enabled;      /* Can be disabled for testing purposes. */
+    // 是否使用过期索引按过期时间顺序删除过期键
+    int active_expire_index;        /* Index the expires by deadline. */
+    // 定期删除的力度（1 到 10），以及最近一次循环实际使用的力度
+    int active_expire_effort;       /* From 1 to ACTIVE_EXPIRE_EFFORT_MAX. */
+    int expire_cycle_effort;        /* Effort used by the last cycle. */
+    // 内存用量超过 maxmemory 的这个百分比时使用最大力度，0 表示不启用
+    int active_expire_pressure_perc; /* % of maxmemory for max effort. */
     size_t client_max_querybuf_len; /* Limit for client query buffer length */
     int dbnum;                      /* Total number of configured DBs */
+    // 数据库键空间及过期字典使用的哈希表布局
+    int keyspace_layout;            /* DICT_LAYOUT_* of db->dict and db->expires */
     int daemonize;                  /* True if running as a daemon */
     // 客户端输出缓冲区大小限制
     // 数组的元素有 REDIS_CLIENT_LIMIT_NUM_CLASSES 个
@@ -1191,6 +1347,28 @@ struct redisServer {
     unsigned long long maxmemory;   /* Max number of memory bytes to use */
     int maxmemory_policy;           /* Policy for key eviction */
     int maxmemory_samples;          /* Pricision of random sampling */
+    int lfu_log_factor;             /* LFU logarithmic counter factor. */
+    int lfu_decay_time;             /* LFU counter decay time in minutes. */
+    // 所有数据库共享的淘汰池
+    struct evictionPoolEntry *eviction_pool; /* Eviction pool of keys */
+    int maxmemory_eviction_pool_size; /* Entries of the eviction pool. */
+    int maxmemory_precision_samples; /* Keys sampled to measure precision. */
+
+    /* Background eviction */
+    // 是否在事件循环的间隙分批淘汰键，以及硬限制和每批的时间预算
+    int maxmemory_background_eviction; /* Evict in background slices. */
+    int maxmemory_hard_limit_perc;  /* Inline eviction above maxmemory+perc% */
+    long long maxmemory_eviction_budget; /* Usec of every background slice. */
+    long long eviction_timer_id;    /* Background eviction time event, or -1 */
+    long long eviction_over_since;  /* Ms time memory went over maxmemory. */
+    int eviction_stalled;           /* Last slice found nothing to evict. */
+
+    /* Lazy free */
+    // 淘汰、过期以及服务器隐式删除的键是否在后台释放
+    int lazyfree_lazy_eviction;     /* Release evicted values in background */
+    int lazyfree_lazy_expire;       /* Release expired values in background */
+    int lazyfree_lazy_server_del;   /* Release implicitly deleted values
+                                       (overwrites, RENAME...) in background */
 
     /* Blocked clients */
     unsigned int bpop_blocked_clients; /* Number of clients blocked by lists */
@@ -1209,6 +1387,7 @@ struct redisServer {
     size_t hash_max_ziplist_value;
     size_t list_max_ziplist_entries;
     size_t list_max_ziplist_value;
+    int list_quicklist_fill;    /* Quicklist fill factor, 0 to disable */
     size_t set_max_intset_entries;
     size_t zset_max_ziplist_entries;
     size_t zset_max_ziplist_value;
@@ -1376,6 +1555,9 @@ typedef struct {
 
     // 链表节点的指针，迭代双端链表编码的列表时使用
     listNode *ln;
+
+    // quicklist 迭代器，迭代 quicklist 编码的列表时使用
+    quicklistIter *iter;
 } listTypeIterator;
 
 /* Structure for an entry while iterating over a list.
@@ -1391,6 +1573,9 @@ typedef struct {
 
     // 双端链表 节点指针
     listNode *ln;       /* Entry in linked list */
+
+    // quicklist 元素
+    quicklistEntry entry; /* Entry in quicklist */
 } listTypeEntry;
 
 /* Structure to hold set iteration abstraction. 
@@ -1447,6 +1632,8 @@ extern dictType zsetDictType;
 extern dictType clusterNodesDictType;
 extern dictType clusterNodesBlackListDictType;
 extern dictType dbDictType;
+extern dictType keyptrDictType;
+extern dictType expireIndexDictType;
 extern dictType shaScriptObjectDictType;
 extern double R_Zero, R_PosInf, R_NegInf, R_Nan;
 extern dictType hashDictType;
@@ -1469,6 +1656,7 @@ void redisSetProcTitle(char *title);
 redisClient *createClient(int fd);
 void closeTimedoutClients(void);
 void freeClient(redisClient *c);
+void clientPoolResize(int size);
 void freeClientAsync(redisClient *c);
 void resetClient(redisClient *c);
 void sendReplyToClient(aeEventLoop *el, int fd, void *privdata, int mask);
@@ -1509,10 +1697,17 @@ int getClientLimitClassByName(char *name);
 char *getClientLimitClassName(int class);
 void flushSlavesOutputBuffers(void);
 void disconnectSlaves(void);
-int listenToPort(int port, int *fds, int *count);
+int listenToPort(int port, int *fds, int *count, int listeners);
 void pauseClients(mstime_t duration);
 int clientsArePaused(void);
 int processEventsWhileBlocked(void);
+int writeToClient(int fd, redisClient *c, int handler_installed);
+int clientHasPendingReplies(redisClient *c);
+void clientInstallWriteHandler(redisClient *c);
+void initThreadedIO(void);
+int handleClientsWithPendingWrites(void);
+int handleClientsWithPendingReadsUsingThreads(void);
+int handleClientsWithPendingWritesUsingThreads(void);
 
 #ifdef __GNUC__
 void addReplyErrorFormat(redisClient *c, const char *fmt, ...)
@@ -1537,6 +1732,7 @@ void listTypeInsert(listTypeEntry *entry, robj *value, int where);
 int listTypeEqual(listTypeEntry *entry, robj *o);
 void listTypeDelete(listTypeEntry *entry);
 void listTypeConvert(robj *subject, int enc);
+int listTypeLargeEncoding(void);
 void unblockClientWaitingData(redisClient *c);
 void handleClientsBlockedOnLists(void);
 void popGenericCommand(redisClient *c, int where);
@@ -1565,6 +1761,7 @@ robj *createObject(int type, void *ptr);
 robj *createStringObject(char *ptr, size_t len);
 robj *createRawStringObject(char *ptr, size_t len);
 robj *createEmbeddedStringObject(char *ptr, size_t len);
+void initEmbstrSizeLimit(void);
 robj *dupStringObject(robj *o);
 int isObjectRepresentableAsLongLong(robj *o, long long *llongval);
 robj *tryObjectEncoding(robj *o);
@@ -1574,6 +1771,7 @@ robj *createStringObjectFromLongLong(long long value);
 robj *createStringObjectFromLongDouble(long double value);
 robj *createListObject(void);
 robj *createZiplistObject(void);
+robj *createQuicklistObject(void);
 robj *createSetObject(void);
 robj *createIntsetObject(void);
 robj *createHashObject(void);
@@ -1591,6 +1789,15 @@ int compareStringObjects(robj *a, robj *b);
 int collateStringObjects(robj *a, robj *b);
 int equalStringObjects(robj *a, robj *b);
 unsigned long long estimateObjectIdleTime(robj *o);
+unsigned long LFUGetTimeInMinutes(void);
+unsigned long LFUDecrAndReturn(robj *o);
+void updateLFU(robj *o);
+#define initObjectLRUOrLFU(o) do { \
+    if (REDIS_MAXMEMORY_POLICY_LFU(server.maxmemory_policy)) \
+        (o)->lru = (LFUGetTimeInMinutes()<<8) | REDIS_LFU_INIT_VAL; \
+    else \
+        (o)->lru = LRU_CLOCK(); \
+} while(0)
 #define sdsEncodedObject(objptr) (objptr->encoding == REDIS_ENCODING_RAW || objptr->encoding == REDIS_ENCODING_EMBSTR)
 
 /* Synchronous I/O with timeout */
@@ -1674,6 +1881,10 @@ unsigned long zslGetRank(zskiplist *zsl, double score, robj *o);
 
 /* Core functions */
 int freeMemoryIfNeeded(void);
+struct evictionPoolEntry *evictionPoolAlloc(int size);
+void evictionPoolResize(int size);
+void startBackgroundEvictionIfNeeded(void);
+void evictionGetLag(size_t *bytes, long long *ms);
 int processCommand(redisClient *c);
 void setupSignalHandlers(void);
 struct redisCommand *lookupCommand(sds name);
@@ -1758,6 +1969,8 @@ void rewriteConfigRewriteLine(struct rewriteConfigState *state, char *option, sd
 int rewriteConfig(char *path);
 
 /* db.c -- Keyspace access API */
+#define REDIS_EMPTYDB_NO_FLAGS 0        /* No flags. */
+#define REDIS_EMPTYDB_ASYNC (1<<0)      /* Reclaim memory in another thread. */
 int removeExpire(redisDb *db, robj *key);
 void propagateExpire(redisDb *db, robj *key);
 int expireIfNeeded(redisDb *db, robj *key);
@@ -1765,6 +1978,8 @@ long long getExpire(redisDb *db, robj *key);
 void setExpire(redisDb *db, robj *key, long long when);
 robj *lookupKey(redisDb *db, robj *key);
 robj *lookupKeyRead(redisDb *db, robj *key);
+void lookupKeysRead(redisDb *db, robj **keys, int count, robj **vals);
+void dbPrefetchKeys(redisDb *db, robj **keys, int count, int step);
 robj *lookupKeyWrite(redisDb *db, robj *key);
 robj *lookupKeyReadOrReply(redisClient *c, robj *key, robj *reply);
 robj *lookupKeyWriteOrReply(redisClient *c, robj *key, robj *reply);
@@ -1774,8 +1989,10 @@ void setKey(redisDb *db, robj *key, robj *val);
 int dbExists(redisDb *db, robj *key);
 robj *dbRandomKey(redisDb *db);
 int dbDelete(redisDb *db, robj *key);
+int dbSyncDelete(redisDb *db, robj *key);
+int dbAsyncDelete(redisDb *db, robj *key);
 robj *dbUnshareStringValue(redisDb *db, robj *key, robj *o);
-long long emptyDb(void(callback)(void*));
+long long emptyDb(int flags, void(callback)(void*));
 int selectDb(redisClient *c, int id);
 void signalModifiedKey(redisDb *db, robj *key);
 void signalFlushedDb(int dbid);
@@ -1786,6 +2003,27 @@ int verifyClusterConfigWithData(void);
 void scanGenericCommand(redisClient *c, robj *o, unsigned long cursor);
 int parseScanCursorOrReply(redisClient *c, robj *o, unsigned long *cursor);
 
+/* lazyfree.c -- Release of big values in background */
+#define REDIS_LAZYFREE_THRESHOLD 64 /* Allocations worth a background job. */
+size_t lazyfreeGetPendingObjectsCount(void);
+size_t lazyfreeGetFreeEffort(robj *o);
+void freeObjAsync(robj *o);
+void emptyDbAsync(redisDb *db);
+void lazyfreeReleaseDeferred(void);
+void lazyfreeFreeObjectFromBioThread(robj *o);
+void lazyfreeFreeDatabaseFromBioThread(dict *ht, dict *expires);
+void lazyfreeFreeExpireIndexFromBioThread(dict *index);
+
+/* expireindex.c -- Keys with an expire ordered by deadline */
+#define REDIS_EXPIRE_INDEX_SLOT_BITS 7 /* Slots of 128 milliseconds. */
+int activeExpireCycleTryExpire(redisDb *db, dictEntry *de, long long now);
+void expireIndexInit(void);
+dict *expireIndexCreate(void);
+void expireIndexAdd(redisDb *db, sds key, long long when);
+void expireIndexDelete(redisDb *db, sds key, long long when);
+void expireIndexEmpty(redisDb *db);
+int expireIndexCycle(redisDb *db, long long start, long long timelimit);
+
 /* API to get key arguments from commands */
 int *getKeysFromCommand(struct redisCommand *cmd, robj **argv, int argc, int *numkeys);
 void getKeysFreeResult(int *result);
@@ -1886,6 +2124,7 @@ void sdiffstoreCommand(redisClient *c);
 void sscanCommand(redisClient *c);
 void syncCommand(redisClient *c);
 void flushdbCommand(redisClient *c);
+void unlinkCommand(redisClient *c);
 void flushallCommand(redisClient *c);
 void sortCommand(redisClient *c);
 void lremCommand(redisClient *c);
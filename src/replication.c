@@ -1058,7 +1058,7 @@ void readSyncBulkPayload(aeEventLoop *el, int fd, void *privdata, int mask) {
         // 先清空旧数据库
         redisLog(REDIS_NOTICE, "MASTER <-> SLAVE sync: Flushing old data");
         signalFlushedDb(-1);
-        emptyDb(replicationEmptyDbCallback);//清空所有数据库，删除键值对字典和过期键字典
+        emptyDb(REDIS_EMPTYDB_NO_FLAGS,replicationEmptyDbCallback);//清空所有数据库，删除键值对字典和过期键字典
         /* Before loading the DB into memory we need to delete the readable
          * handler, otherwise it will get called recursively since
          * rdbLoad() will call the event loop to process events from time to
@@ -1768,6 +1768,17 @@ void replicationCacheMaster(redisClient *c) {
     aeDeleteFileEvent(server.el,c->fd,AE_WRITABLE);
     close(c->fd);
 
+    /* The cached master must not be flushed by beforeSleep(): remove it
+     * from the list of clients with pending writes. Pending output is
+     * handled by replicationResurrectCachedMaster(). */
+    // 从待写客户端链表中删除
+    if (c->flags & REDIS_PENDING_WRITE) {
+        ln = listSearchKey(server.clients_pending_write,c);
+        redisAssert(ln != NULL);
+        listDelNode(server.clients_pending_write,ln);
+        c->flags &= ~REDIS_PENDING_WRITE;
+    }
+
     /* Set fd to -1 so that we can safely call freeClient(c) later. */
     c->fd = -1;
 
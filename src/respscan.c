@@ -0,0 +1,393 @@
+/* Vectorized scanning of the RESP protocol.
+ *
+ * The request parser needs to find the '\r' terminating every header line
+ * of a multi bulk request ("*<count>\r\n" and "$<len>\r\n"). Instead of
+ * calling strchr() once per line, the scanner compares 64 bytes at a time
+ * against '\r' (with AVX2, SSE2, or a plain loop when no vector unit is
+ * available) and keeps the resulting bitmap. The following lookups in the
+ * same block are a shift and a count of trailing zeros, so the header
+ * lines of a pipeline of small commands cost one compare per 64 bytes.
+ *
+ * Bulk payloads are skipped: when the caller asks for a position past the
+ * scanned block, the scan restarts from there, so the content of a big
+ * argument is never examined.
+ *
+ * 向量化扫描 RESP 协议：一次比较 64 字节，保存其中 '\r' 的位图，
+ * 之后在同一块中的查找只需要位运算；参数内容会被跳过，不会被扫描。
+ *
+ * Copyright (c) 2009-2012, Salvatore Sanfilippo <antirez at gmail dot com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdint.h>
+#include "respscan.h"
+
+/* The vector implementation is selected at compile time: AVX2 is used when
+ * the compiler targets it (for instance make CFLAGS="-march=native"),
+ * otherwise SSE2, that is always available on x86_64. */
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define RESP_SCAN_AVX2
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define RESP_SCAN_SSE2
+#endif
+
+/* Return a mask with bit N set if p[N] is '\r'. Only the first 'len' bytes
+ * are examined, and 'len' is at most RESP_SCAN_BLOCK. */
+// 返回 p[0..len-1] 中 '\r' 的位图，第 N 位为 1 表示 p[N] 是 '\r'
+static uint64_t respScanBlock(const char *p, size_t len) {
+    uint64_t mask = 0;
+    size_t j;
+
+    if (len == RESP_SCAN_BLOCK) {
+#if defined(RESP_SCAN_AVX2)
+        __m256i cr = _mm256_set1_epi8('\r');
+        __m256i lo = _mm256_loadu_si256((const __m256i*)p);
+        __m256i hi = _mm256_loadu_si256((const __m256i*)(p+32));
+
+        mask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo,cr));
+        mask |= ((uint64_t)(uint32_t)
+                 _mm256_movemask_epi8(_mm256_cmpeq_epi8(hi,cr))) << 32;
+        return mask;
+#elif defined(RESP_SCAN_SSE2)
+        __m128i cr = _mm_set1_epi8('\r');
+
+        for (j = 0; j < RESP_SCAN_BLOCK; j += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(p+j));
+            mask |= ((uint64_t)(uint16_t)
+                     _mm_movemask_epi8(_mm_cmpeq_epi8(v,cr))) << j;
+        }
+        return mask;
+#endif
+    }
+
+    /* Scalar fallback, also used for the last partial block. */
+    for (j = 0; j < len; j++)
+        if (p[j] == '\r') mask |= ((uint64_t)1) << j;
+    return mask;
+}
+
+/* Index of the lowest bit set in a non zero mask. */
+static int respMaskFirst(uint64_t mask) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(mask);
+#else
+    int j = 0;
+
+    while (!(mask & 1)) {
+        mask >>= 1;
+        j++;
+    }
+    return j;
+#endif
+}
+
+/* Prepare a scanner for an empty buffer. Nothing is scanned until the
+ * first lookup. */
+// 初始化扫描器，第一次查找时才开始扫描
+void respScannerInit(respScanner *rs) {
+    rs->base = 0;
+    rs->block = 0;
+    rs->len = 0;
+    rs->mask = 0;
+}
+
+/* Return a pointer to the first '\r' at offset 'pos' of buf[0..len-1] or
+ * after it, or NULL if there is none. 'buf' may have been reallocated or
+ * have grown since the last call, but the bytes already scanned must be
+ * unchanged.
+ *
+ * The mask of the last block scanned is kept across calls: the header
+ * lines of the next commands of a pipeline, often in the same block as the
+ * current one, are found with a shift and a count of trailing zeros.
+ */
+// 返回 pos 之后（包括 pos ）第一个 '\r' 的位置，没有的话返回 NULL
+char *respScannerFindCR(respScanner *rs, const char *buf, size_t len, size_t pos) {
+    size_t p = rs->base+pos, end = rs->base+len;
+
+    while (p < end) {
+        // 在缓存的块中查找
+        if (p >= rs->block && p < rs->block+rs->len) {
+            uint64_t mask = rs->mask >> (p-rs->block);
+
+            if (mask) return (char*)buf+(p-rs->base)+respMaskFirst(mask);
+            p = rs->block+rs->len;
+            continue;
+        }
+
+        /* Scan the block starting at p: the data the caller already went
+         * past, like the payload of a bulk argument, is skipped. */
+        // 从 p 开始扫描下一块，跳过调用者已经读过的内容，比如参数的内容
+        rs->block = p;
+        rs->len = end-p < RESP_SCAN_BLOCK ? end-p : RESP_SCAN_BLOCK;
+        rs->mask = respScanBlock(buf+(p-rs->base),rs->len);
+    }
+    return NULL;
+}
+
+/* The first 'n' bytes were removed from the head of the buffer. */
+// 缓冲区头部的 n 个字节已被删除
+void respScannerConsume(respScanner *rs, size_t n) {
+    rs->base += n;
+}
+
+#ifdef RESPSCAN_TEST_MAIN
+/* Scanner tests and parser micro benchmark. Build with:
+ *
+ *   cc -O2 -DRESPSCAN_TEST_MAIN -o respscan-test respscan.c
+ *   cc -O2 -mavx2 -DRESPSCAN_TEST_MAIN -o respscan-test respscan.c
+ *
+ * After the correctness tests, pipelines of 50 commands (INCR of a single
+ * key, MGET of ten keys) are generated and walked the way
+ * processMultibulkBuffer() does, one command at a time removing it from
+ * the head of the buffer: once locating every header line with strchr()
+ * and once with the scanner. Both walkers must agree.
+ *
+ * 扫描器的正确性测试，以及请求解析的性能测试：生成 50 条命令的
+ * INCR / MGET 流水线，分别用 strchr 和扫描器遍历，比较耗时。
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <sys/time.h>
+
+#if defined(RESP_SCAN_AVX2)
+#define RESP_SCAN_IMPL "avx2"
+#elif defined(RESP_SCAN_SSE2)
+#define RESP_SCAN_IMPL "sse2"
+#else
+#define RESP_SCAN_IMPL "scalar"
+#endif
+
+#define PIPELINE_COMMANDS 50
+
+static long long usec(void) {
+    struct timeval tv;
+    gettimeofday(&tv,NULL);
+    return (((long long)tv.tv_sec)*1000000)+tv.tv_usec;
+}
+
+/* Minimal length parser, the same for both walkers. */
+static long long parseLen(const char *p, const char *end) {
+    long long v = 0;
+
+    while (p < end) v = v*10+(*p++ - '0');
+    return v;
+}
+
+/* Append a multi bulk request with the 'argc' arguments in 'argv'. */
+static size_t appendCommand(char *buf, size_t len, int argc, char **argv) {
+    int j;
+
+    len += sprintf(buf+len,"*%d\r\n",argc);
+    for (j = 0; j < argc; j++)
+        len += sprintf(buf+len,"$%d\r\n%s\r\n",(int)strlen(argv[j]),argv[j]);
+    return len;
+}
+
+/* Generate a pipeline of PIPELINE_COMMANDS INCR or MGET commands, returning
+ * its length. */
+static size_t genPipeline(char *buf, int mget) {
+    char keys[11][32];
+    char *argv[11];
+    size_t len = 0;
+    int j, k;
+
+    for (j = 0; j < PIPELINE_COMMANDS; j++) {
+        if (mget) {
+            argv[0] = "MGET";
+            for (k = 1; k <= 10; k++) {
+                snprintf(keys[k],sizeof(keys[k]),"key:%06d",j*10+k);
+                argv[k] = keys[k];
+            }
+            len = appendCommand(buf,len,11,argv);
+        } else {
+            argv[0] = "INCR";
+            snprintf(keys[1],sizeof(keys[1]),"counter:%d",j);
+            argv[1] = keys[1];
+            len = appendCommand(buf,len,2,argv);
+        }
+    }
+    buf[len] = '\0';
+    return len;
+}
+
+/* Walk all the requests in buf, returning the number of arguments seen
+ * plus the sum of their lengths, or -1 on malformed input. Every command
+ * is removed from the head of the buffer once parsed, as the server does
+ * with the query buffer. */
+static long long walkStrchr(const char *buf, size_t len) {
+    long long sum = 0;
+
+    while (len) {
+        size_t pos = 0;
+        const char *nl = strchr(buf,'\r');
+        long long argc, j;
+
+        if (nl == NULL || buf[0] != '*') return -1;
+        argc = parseLen(buf+1,nl);
+        pos = (nl-buf)+2;
+        for (j = 0; j < argc; j++) {
+            long long blen;
+
+            nl = strchr(buf+pos,'\r');
+            if (nl == NULL || buf[pos] != '$') return -1;
+            blen = parseLen(buf+pos+1,nl);
+            pos = (nl-buf)+2+blen+2;
+            sum += 1+blen;
+        }
+        if (pos > len) return -1;
+        buf += pos;
+        len -= pos;
+    }
+    return sum;
+}
+
+/* Like walkStrchr(), locating the header lines with the scanner. */
+static long long walkScanner(const char *buf, size_t len) {
+    respScanner rs;
+    long long sum = 0;
+
+    respScannerInit(&rs);
+    while (len) {
+        size_t pos = 0;
+        const char *nl = respScannerFindCR(&rs,buf,len,pos);
+        long long argc, j;
+
+        if (nl == NULL || buf[pos] != '*') return -1;
+        argc = parseLen(buf+pos+1,nl);
+        pos = (nl-buf)+2;
+        for (j = 0; j < argc; j++) {
+            long long blen;
+
+            nl = respScannerFindCR(&rs,buf,len,pos);
+            if (nl == NULL || buf[pos] != '$') return -1;
+            blen = parseLen(buf+pos+1,nl);
+            pos = (nl-buf)+2+blen+2;
+            sum += 1+blen;
+        }
+        if (pos > len) return -1;
+        respScannerConsume(&rs,pos);
+        buf += pos;
+        len -= pos;
+    }
+    return sum;
+}
+
+/* Time 'iter' walks of buf with 'walk', returning the elapsed usec. */
+static long long timeWalk(long long (*walk)(const char*,size_t),
+                          const char *buf, size_t len, int iter,
+                          long long *sum)
+{
+    long long start = usec();
+    int j;
+
+    for (j = 0; j < iter; j++) *sum += walk(buf,len);
+    return usec()-start;
+}
+
+static void bench(const char *name, const char *buf, size_t len) {
+    long long t1 = 0, t2 = 0, r1 = 0, r2 = 0, t;
+    int iter, round;
+
+    /* About 16MB of input per round, the best of five rounds for each
+     * walker. The rounds alternate so that both see the same noise. */
+    iter = (int)((16*1024*1024)/len)+1;
+    for (round = 0; round < 5; round++) {
+        t = timeWalk(walkStrchr,buf,len,iter,&r1);
+        if (round == 0 || t < t1) t1 = t;
+        t = timeWalk(walkScanner,buf,len,iter,&r2);
+        if (round == 0 || t < t2) t2 = t;
+    }
+
+    assert(r1 == r2 && r1 > 0);
+    printf("%-6s x%d %6lu bytes  strchr %6.3f ns/byte  %s %6.3f ns/byte  (%.2fx)\n",
+        name, PIPELINE_COMMANDS, (unsigned long)len,
+        (double)t1*1000/((double)len*iter), RESP_SCAN_IMPL,
+        (double)t2*1000/((double)len*iter),
+        t2 ? (double)t1/t2 : 0);
+}
+
+int main(void) {
+    /* Correctness: a '\r' exactly at every offset of a block boundary. */
+    {
+        char buf[RESP_SCAN_BLOCK*3+1];
+        respScanner rs;
+        size_t k;
+
+        for (k = 0; k < sizeof(buf)-1; k++) {
+            memset(buf,'a',sizeof(buf)-1);
+            buf[sizeof(buf)-1] = '\0';
+            buf[k] = '\r';
+            respScannerInit(&rs);
+            assert(respScannerFindCR(&rs,buf,sizeof(buf)-1,0) == buf+k);
+            assert(respScannerFindCR(&rs,buf,sizeof(buf)-1,k+1) == NULL);
+        }
+        printf("Scanner boundary test: OK\n");
+    }
+
+    /* Correctness: the cached block survives growing and consuming the
+     * buffer. */
+    {
+        char buf[RESP_SCAN_BLOCK*16];
+        respScanner rs;
+        size_t k, len, head = 0;
+
+        memset(buf,'a',sizeof(buf));
+        for (k = 0; k < sizeof(buf); k += 7) buf[k] = '\r';
+        respScannerInit(&rs);
+        for (len = 1; len <= sizeof(buf); len++) {
+            char *cr = respScannerFindCR(&rs,buf+head,len-head,0);
+
+            /* The data grows by a byte at a time, every '\r' found is
+             * consumed together with the bytes before it. */
+            for (k = head; k < len && buf[k] != '\r'; k++);
+            assert(cr == (k < len ? buf+k : NULL));
+            if (cr) {
+                respScannerConsume(&rs,k+1-head);
+                head = k+1;
+            }
+        }
+        printf("Scanner consume test: OK\n");
+    }
+
+    /* Benchmark on generated pipelines. */
+    {
+        char *buf = malloc(PIPELINE_COMMANDS*256);
+        size_t len;
+
+        len = genPipeline(buf,0);
+        bench("INCR",buf,len);
+        len = genPipeline(buf,1);
+        bench("MGET",buf,len);
+        free(buf);
+    }
+    return 0;
+}
+#endif
@@ -0,0 +1,67 @@
+/* Vectorized scanning of the RESP protocol.
+ *
+ * Copyright (c) 2009-2012, Salvatore Sanfilippo <antirez at gmail dot com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Redis nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __RESPSCAN_H
+#define __RESPSCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Bytes examined by a single vectorized step. */
+#define RESP_SCAN_BLOCK 64
+
+/*
+ * '\r' 位置缓存：保存最近扫描的一块数据中 '\r' 的位图，
+ * 之后的查找只需要位运算
+ *
+ * The scanner lives as long as the buffer it scans, across reads and
+ * commands. Offsets are counted from the start of the stream: 'base' is
+ * the number of bytes removed from the head of the buffer so far, see
+ * respScannerConsume().
+ *
+ * 偏移量从数据流的开头算起， base 是已从缓冲区头部删除的字节数
+ */
+typedef struct respScanner {
+    // 已从缓冲区头部删除的字节数
+    size_t base;
+
+    // 最近扫描的块的起始偏移量和长度，长度为 0 表示没有
+    size_t block;
+    size_t len;
+
+    // 块中 '\r' 的位图，第 N 位为 1 表示 block+N 处是 '\r'
+    uint64_t mask;
+} respScanner;
+
+void respScannerInit(respScanner *rs);
+char *respScannerFindCR(respScanner *rs, const char *buf, size_t len, size_t pos);
+void respScannerConsume(respScanner *rs, size_t n);
+
+#endif
@@ -33,9 +33,91 @@
 #include <string.h>
 #include <ctype.h>
 #include <assert.h>
+#include <limits.h>
 #include "sds.h"
 #include "zmalloc.h"
 
+/* Size of the header of the given type. */
+// 返回给定类型的头部大小
+static inline int sdsHdrSize(char type) {
+    switch(type&SDS_TYPE_MASK) {
+        case SDS_TYPE_5:
+            return sizeof(struct sdshdr5);
+        case SDS_TYPE_8:
+            return sizeof(struct sdshdr8);
+        case SDS_TYPE_16:
+            return sizeof(struct sdshdr16);
+        case SDS_TYPE_32:
+            return sizeof(struct sdshdr32);
+        case SDS_TYPE_64:
+            return sizeof(struct sdshdr64);
+    }
+    return 0;
+}
+
+/* Smallest header type able to describe a string of 'string_size'. */
+// 返回能保存长度为 string_size 的字符串的最小头部类型
+static inline char sdsReqType(size_t string_size) {
+    if (string_size < 1<<5)
+        return SDS_TYPE_5;
+    if (string_size < 1<<8)
+        return SDS_TYPE_8;
+    if (string_size < 1<<16)
+        return SDS_TYPE_16;
+#if (LONG_MAX == LLONG_MAX)
+    if (string_size < 1ll<<32)
+        return SDS_TYPE_32;
+    return SDS_TYPE_64;
+#else
+    return SDS_TYPE_32;
+#endif
+}
+
+/* Write a header of 'type' at 'sh' for a string of 'len' bytes in a buffer
+ * of 'alloc' bytes, and return the sds pointer (the buf right after the
+ * header). The caller sets the content and the null terminator. */
+// 在 sh 处写入类型为 type 的头部，返回 sds 指针
+static sds sdsInitHdr(void *sh, char type, size_t len, size_t alloc) {
+    sds s = (char*)sh+sdsHdrSize(type);
+    unsigned char *fp = ((unsigned char*)s)-1;
+
+    switch(type) {
+        case SDS_TYPE_5: {
+            *fp = type | (len << SDS_TYPE_BITS);
+            break;
+        }
+        case SDS_TYPE_8: {
+            SDS_HDR_VAR(8,s);
+            sh->len = len;
+            sh->alloc = alloc;
+            *fp = type;
+            break;
+        }
+        case SDS_TYPE_16: {
+            SDS_HDR_VAR(16,s);
+            sh->len = len;
+            sh->alloc = alloc;
+            *fp = type;
+            break;
+        }
+        case SDS_TYPE_32: {
+            SDS_HDR_VAR(32,s);
+            sh->len = len;
+            sh->alloc = alloc;
+            *fp = type;
+            break;
+        }
+        case SDS_TYPE_64: {
+            SDS_HDR_VAR(64,s);
+            sh->len = len;
+            sh->alloc = alloc;
+            *fp = type;
+            break;
+        }
+    }
+    return s;
+}
+
 /*
  * 根据给定的初始化字符串 init 和字符串长度 initlen
  * 创建一个新的 sdshdr，sdshdr的属性len=initlen, free=0, buf[0...initlen]=init?init的内容：0
@@ -63,38 +145,42 @@
  * end of the string. However the string is binary safe and can contain
  * \0 characters in the middle, as the length is stored in the sds header. */
 sds sdsnewlen(const void *init, size_t initlen) {
-
-    struct sdshdr *sh;
+    void *sh;
+    sds s;
+    // 根据长度选择头部类型
+    char type = sdsReqType(initlen);
+    /* Empty strings are usually created in order to append. Use type 8
+     * since type 5 is not good at this. */
+    // 空字符串通常是为了追加内容而创建的，类型 5 不适合追加
+    if (type == SDS_TYPE_5 && initlen == 0) type = SDS_TYPE_8;
+    int hdrlen = sdsHdrSize(type);
 
     // 根据是否有初始化内容，选择适当的内存分配方式
     //如果init为空则调用zcalloc来分配内存因为分配的内存默认都初始化为0，
     //如果init不为空则调用zmalloc来分配内存因为不对内存初始化后面会用memcpy将init内容拷贝过来
-    //这里分配的内存的指针就是sdshdr结构体的指针
     // T = O(N)
     if (init) {
         // zmalloc 不初始化所分配的内存
-        sh = zmalloc(sizeof(struct sdshdr)+initlen+1);
+        sh = zmalloc(hdrlen+initlen+1);
     } else {
         // zcalloc 将分配的内存全部初始化为 0
-        sh = zcalloc(sizeof(struct sdshdr)+initlen+1);
+        sh = zcalloc(hdrlen+initlen+1);
     }
 
     // 内存分配失败，返回
     if (sh == NULL) return NULL;
 
-    // 设置初始化长度
-    sh->len = initlen;
-    // 新 sds 不预留任何空间
-    sh->free = 0;
-    // 如果有指定初始化内容，将它们拷贝到 sdshdr 的 buf 中
+    // 设置头部：长度为 initlen ，新 sds 不预留任何空间
+    s = sdsInitHdr(sh,type,initlen,initlen);
+    // 如果有指定初始化内容，将它们拷贝到 buf 中
     // T = O(N)
     if (initlen && init)
-        memcpy(sh->buf, init, initlen);
+        memcpy(s, init, initlen);
     // 以 \0 结尾
-    sh->buf[initlen] = '\0';
+    s[initlen] = '\0';
 
-    // 返回 buf 部分，而不是整个 sdshdr
-    return (char*)sh->buf;
+    // 返回 buf 部分，而不是整个头部
+    return s;
 }
 
 /*
@@ -149,7 +235,7 @@ sds sdsdup(const sds s) {
 }
 
 /*
- * 释放给定的 sds，向前跳转8字节找到sdshdr结构体的指针，然后用free释放它
+ * 释放给定的 sds，根据 s[-1] 的类型向前跳过头部找到分配的起始地址，然后用free释放它
  *
  * 复杂度
  *  T = O(N)
@@ -157,7 +243,7 @@ sds sdsdup(const sds s) {
 /* Free an sds string. No operation is performed if 's' is NULL. */
 void sdsfree(sds s) {
     if (s == NULL) return;
-    zfree(s-sizeof(struct sdshdr));
+    zfree((char*)s-sdsHdrSize(s[-1]));
 }
 
 // 假定sds是c-string，然后重置它的属性，设置sdshdr->len=strlen(s)，更新free属性
@@ -176,10 +262,8 @@ void sdsfree(sds s) {
  * the output will be "6" as the string was modified but the logical length
  * remains 6 bytes. */
 void sdsupdatelen(sds s) {
-    struct sdshdr *sh = (void*) (s-(sizeof(struct sdshdr)));
-    int reallen = strlen(s); //重置len属性，假设s是c-string的风格，'\0'后面的内容都丢掉
-    sh->free += (sh->len-reallen);
-    sh->len = reallen;
+    size_t reallen = strlen(s); //重置len属性，假设s是c-string的风格，'\0'后面的内容都丢掉
+    sdssetlen(s, reallen);
 }
 
 /*清空sds的所有内容，注意是清空并不释放内存。更新free+=len，len=0, buf[0]='\0'
@@ -191,16 +275,50 @@ void sdsupdatelen(sds s) {
  * so that next append operations will not require allocations up to the
  * number of bytes previously available. */
 void sdsclear(sds s) {
+    // 重新计算属性，alloc 不变
+    sdssetlen(s, 0);
 
-    // 取出 sdshdr
-    struct sdshdr *sh = (void*) (s-(sizeof(struct sdshdr)));
+    // 将结束符放到最前面（相当于惰性地删除 buf 中的内容）
+    s[0] = '\0';
+}
 
-    // 重新计算属性
-    sh->free += sh->len;
-    sh->len = 0;
+/* Move 's' to a buffer able to hold 'alloc' bytes (header and null term
+ * excluded) described by a header of 'type'. When the type doesn't change
+ * the buffer is reallocated in place, otherwise the header is rewritten in
+ * a new allocation since the string has to move anyway. */
+/*
+ * 将 s 调整为可以保存 alloc 字节、头部类型为 type 的 sds
+ * 类型不变时直接 realloc ，否则头部大小变了，需要重新分配内存并拷贝内容
+ */
+static sds sdsResize(sds s, char type, size_t alloc) {
+    void *sh, *newsh;
+    char oldtype = s[-1] & SDS_TYPE_MASK;
+    int hdrlen = sdsHdrSize(type);
+    size_t len = sdslen(s);
+
+    sh = (char*)s-sdsHdrSize(oldtype);
+    if (oldtype == type) {
+        newsh = zrealloc(sh, hdrlen+alloc+1);
+        if (newsh == NULL) return NULL;
+        s = (char*)newsh+hdrlen;
+    } else {
+        newsh = zmalloc(hdrlen+alloc+1);
+        if (newsh == NULL) return NULL;
+        memcpy((char*)newsh+hdrlen, s, len+1);
+        zfree(sh);
+        s = sdsInitHdr(newsh,type,len,alloc);
+    }
+    sdssetalloc(s, alloc);
+    return s;
+}
 
-    // 将结束符放到最前面（相当于惰性地删除 buf 中的内容）
-    sh->buf[0] = '\0';
+/* Header type to use for a buffer of 'alloc' bytes that is going to be
+ * appended to: type 5 can't remember free space, so it is never used
+ * here, otherwise every append would call sdsMakeRoomFor() again. */
+// 需要预留空间时使用的头部类型，类型 5 无法记录空闲空间，所以至少使用类型 8
+static char sdsReqTypeGrow(size_t alloc) {
+    char type = sdsReqType(alloc);
+    return (type == SDS_TYPE_5) ? SDS_TYPE_8 : type;
 }
 
 /* Enlarge the free space at the end of the sds string so that the caller
@@ -221,41 +339,43 @@ void sdsclear(sds s) {
  */
 //调用这个方法后参数sds s就可能无效了，需要使用返回值sds来用了，因为内部预分配内存会调用realloc可能会换块内存
 sds sdsMakeRoomFor(sds s, size_t addlen) {
-
-    struct sdshdr *sh, *newsh;
-
-    // 获取 s 目前的空余空间长度
-    size_t free = sdsavail(s);
-
     size_t len, newlen;
 
     // s 目前的空余空间已经足够，无须再进行扩展，直接返回
-    if (free >= addlen) return s;
+    if (sdsavail(s) >= addlen) return s;
 
     // 获取 s 目前已占用空间的长度
     len = sdslen(s);
-    sh = (void*) (s-(sizeof(struct sdshdr)));
 
     // s 最少需要的内存大小
     newlen = (len+addlen);
 
-    // sdshdr需要的内存大小小于1M，那么分配2倍大小的内存，除了当前的len和addlen，多出来len+addlen预留空间会更新到free中
+    // sdshdr需要的内存大小小于1M，那么分配2倍大小的内存，除了当前的len和addlen，多出来len+addlen预留空间会成为空闲空间
     if (newlen < SDS_MAX_PREALLOC)
         newlen *= 2;
     else
-        // 否则，多分配1M内存，除了当前的len和addlen，多出来1M大小会更新到free中
+        // 否则，多分配1M内存
         newlen += SDS_MAX_PREALLOC;
-    // T = O(N)，在当前内存基础上realloc下内存，大小包括newlen+结构体字节数+1字节（末尾的'\0')
-    newsh = zrealloc(sh, sizeof(struct sdshdr)+newlen+1);
 
-    // 内存不足，分配失败，返回
-    if (newsh == NULL) return NULL;
+    // T = O(N)，长度变大后头部类型可能也要变大
+    return sdsResize(s, sdsReqTypeGrow(newlen), newlen);
+}
+
+/* Like sdsMakeRoomFor() but does not preallocate more than requested: the
+ * free space after the call is exactly addlen bytes (unless there was
+ * already enough). Useful when the caller knows the final size of the
+ * string, for instance a large bulk argument that is about to be read. */
+/*
+ * 和 sdsMakeRoomFor 一样确保 free >= addlen ，但不进行预分配，只分配刚好需要的内存
+ * 调用者已经知道字符串的最终大小时使用
+ */
+sds sdsMakeRoomForNonGreedy(sds s, size_t addlen) {
+    size_t newlen;
 
-    // len保持不变，free大小为最新的大小
-    newsh->free = newlen - len;
+    if (sdsavail(s) >= addlen) return s;
 
-    // 返回 sds
-    return newsh->buf;
+    newlen = sdslen(s)+addlen;
+    return sdsResize(s, sdsReqTypeGrow(newlen), newlen);
 }
 
 /*
@@ -274,21 +394,15 @@ sds sdsMakeRoomFor(sds s, size_t addlen) {
  * references must be substituted with the new pointer returned by the call. */
 //调用这个方法后参数sds s就可能无效了，需要使用返回值sds来用了，因为内部回收内存会调用realloc可能会换块内存
 sds sdsRemoveFreeSpace(sds s) {
-    struct sdshdr *sh;
-
-    sh = (void*) (s-(sizeof(struct sdshdr)));
-
     // 进行内存重分配，让 buf 的长度仅仅足够保存字符串内容，使得free=0
+    // 同时换成能保存 len 的最小头部
     // T = O(N)
-    sh = zrealloc(sh, sizeof(struct sdshdr)+sh->len+1);
+    size_t len = sdslen(s);
 
-    // 空余空间为 0
-    sh->free = 0;
-
-    return sh->buf;
+    return sdsResize(s, sdsReqType(len), len);
 }
 
-/*返回sdshdr分配的内存大小，len+free+sizeof(struct sdshdr)+1('\0')
+/*返回sds分配的内存大小，头部大小+alloc+1('\0')
  * 复杂度
  *  T = O(1)
  */
@@ -300,9 +414,41 @@ sds sdsRemoveFreeSpace(sds s) {
  * 4) The implicit null term.
  */
 size_t sdsAllocSize(sds s) {
-    struct sdshdr *sh = (void*) (s-(sizeof(struct sdshdr)));
+    size_t alloc = sdsalloc(s);
+
+    return sdsHdrSize(s[-1])+alloc+1;
+}
+
+/* Return the pointer of the actual SDS allocation (normally SDS strings
+ * are referenced by the start of the string buffer).
+ *
+ * 返回 sds 实际分配的内存的起始地址（也就是头部的地址）
+ */
+void *sdsAllocPtr(const sds s) {
+    return (void*) (s-sdsHdrSize(s[-1]));
+}
+
+/* Return the number of bytes sdsnewembed() needs to store a string of
+ * 'initlen' bytes, header and null term included.
+ *
+ * 返回 sdsnewembed() 保存长度为 initlen 的字符串所需的字节数
+ */
+size_t sdsembedlen(size_t initlen) {
+    return sdsHdrSize(sdsReqType(initlen))+initlen+1;
+}
 
-    return sizeof(*sh)+sh->len+sh->free+1;
+/* Create a sds string inside 'buf', a buffer of at least
+ * sdsembedlen(initlen) bytes owned by the caller. The string lives as
+ * long as the buffer: it must never be freed with sdsfree() or grown.
+ *
+ * 在调用者提供的内存 buf 中创建 sds ，这个 sds 不能被释放或者扩展
+ */
+sds sdsnewembed(void *buf, const void *init, size_t initlen) {
+    sds s = sdsInitHdr(buf,sdsReqType(initlen),initlen,initlen);
+
+    if (initlen) memcpy(s, init, initlen);
+    s[initlen] = '\0';
+    return s;
 }
 
 /* Increment the sds length and decrements the left free space at the
@@ -344,21 +490,48 @@ size_t sdsAllocSize(sds s) {
  */
 //增加len,减少free，重新设置末尾的'\0'
 void sdsIncrLen(sds s, int incr) {
-    struct sdshdr *sh = (void*) (s-(sizeof(struct sdshdr)));
-
-    // 确保 sds 空间足够
-    assert(sh->free >= incr);
-
-    // 更新属性
-    sh->len += incr;
-    sh->free -= incr;
+    unsigned char flags = s[-1];
+    size_t len;
 
-    // 这个 assert 其实可以忽略
-    // 因为前一个 assert 已经确保 sh->free - incr >= 0 了
-    assert(sh->free >= 0);
+    // 确保 sds 空间足够，然后更新属性
+    switch(flags&SDS_TYPE_MASK) {
+        case SDS_TYPE_5: {
+            unsigned char *fp = ((unsigned char*)s)-1;
+            unsigned char oldlen = SDS_TYPE_5_LEN(flags);
+            assert((incr > 0 && oldlen+incr < 32) || (incr < 0 && oldlen >= (unsigned int)(-incr)));
+            *fp = SDS_TYPE_5 | ((oldlen+incr) << SDS_TYPE_BITS);
+            len = oldlen+incr;
+            break;
+        }
+        case SDS_TYPE_8: {
+            SDS_HDR_VAR(8,s);
+            assert((incr >= 0 && sh->alloc-sh->len >= incr) || (incr < 0 && sh->len >= (unsigned int)(-incr)));
+            len = (sh->len += incr);
+            break;
+        }
+        case SDS_TYPE_16: {
+            SDS_HDR_VAR(16,s);
+            assert((incr >= 0 && sh->alloc-sh->len >= incr) || (incr < 0 && sh->len >= (unsigned int)(-incr)));
+            len = (sh->len += incr);
+            break;
+        }
+        case SDS_TYPE_32: {
+            SDS_HDR_VAR(32,s);
+            assert((incr >= 0 && sh->alloc-sh->len >= (unsigned int)incr) || (incr < 0 && sh->len >= (unsigned int)(-incr)));
+            len = (sh->len += incr);
+            break;
+        }
+        case SDS_TYPE_64: {
+            SDS_HDR_VAR(64,s);
+            assert((incr >= 0 && sh->alloc-sh->len >= (uint64_t)incr) || (incr < 0 && sh->len >= (uint64_t)(-incr)));
+            len = (sh->len += incr);
+            break;
+        }
+        default: len = 0; /* Just to avoid compilation warnings. */
+    }
 
     // 放置新的结尾符号，这个不能漏
-    s[sh->len] = '\0';
+    s[len] = '\0';
 }
 
 /* Grow the sds to have the specified length. Bytes that were not part of
@@ -375,8 +548,7 @@ void sdsIncrLen(sds s, int incr) {
  *  T = O(N)
  */
 sds sdsgrowzero(sds s, size_t len) {
-    struct sdshdr *sh = (void*)(s-(sizeof(struct sdshdr)));
-    size_t totlen, curlen = sh->len;
+    size_t curlen = sdslen(s);
 
     // 如果 len 比字符串的现有长度小，那么直接返回，啥都不做
     if (len <= curlen) return s;
@@ -390,14 +562,11 @@ sds sdsgrowzero(sds s, size_t len) {
     /* Make sure added region doesn't contain garbage */
     // 将新分配的空间用 0 填充，防止出现垃圾内容
     // T = O(N)
-    sh = (void*)(s-(sizeof(struct sdshdr))); //找到新结构体的起始地址
     //将s+curlent开始的len-curlen+1个字节都设置为0，也包括末尾的'\0'一起设置了
     memset(s+curlen,0,(len-curlen+1)); /* also set trailing \0 byte */
 
     // 更新属性
-    totlen = sh->len+sh->free; //总大小
-    sh->len = len; //更新len
-    sh->free = totlen-sh->len;
+    sdssetlen(s, len);
 
     // 返回新的 sds
     return s;
@@ -417,9 +586,6 @@ sds sdsgrowzero(sds s, size_t len) {
  * After the call, the passed sds string is no longer valid and all the
  * references must be substituted with the new pointer returned by the call. */
 sds sdscatlen(sds s, const void *t, size_t len) {
-    
-    struct sdshdr *sh;
-    
     // 原有字符串长度
     size_t curlen = sdslen(s);
 
@@ -430,14 +596,12 @@ sds sdscatlen(sds s, const void *t, size_t len) {
     // 内存不足？直接返回
     if (s == NULL) return NULL;
 
-    //找到sdshdr结构体的起始地址，将len个字节拷贝到s+curlen处
+    // 将len个字节拷贝到s+curlen处
     // T = O(N)
-    sh = (void*) (s-(sizeof(struct sdshdr)));
     memcpy(s+curlen, t, len);
 
     // 更新属性
-    sh->len = curlen+len;
-    sh->free = sh->free-len;
+    sdssetlen(s, curlen+len);
 
     // 添加新结尾符号
     s[curlen+len] = '\0';
@@ -487,19 +651,11 @@ sds sdscatsds(sds s, const sds t) {
 /* Destructively modify the sds string 's' to hold the specified binary
  * safe string pointed by 't' of length 'len' bytes. */
 sds sdscpylen(sds s, const char *t, size_t len) {
-
-    struct sdshdr *sh = (void*) (s-(sizeof(struct sdshdr)));
-
-    // sds 现有 buf 的内存大小：free+len
-    size_t totlen = sh->free+sh->len;
-
-    // 如果现有内存大侠不够，那么扩展下
-    if (totlen < len) {
-        // T = O(N) 多分配len-sh->len的空闲空间大小
-        s = sdsMakeRoomFor(s,len-sh->len);
+    // 如果现有 buf 的内存大小 alloc 不够，那么扩展下
+    if (sdsalloc(s) < len) {
+        // T = O(N) 多分配len-sdslen(s)的空闲空间大小
+        s = sdsMakeRoomFor(s,len-sdslen(s));
         if (s == NULL) return NULL;
-        sh = (void*) (s-(sizeof(struct sdshdr))); //更新结构体的地址
-        totlen = sh->free+sh->len; //总大小是sh->len+sh->free
     }
 
     // 复制内容，将len长度的字符串复制到s处
@@ -510,8 +666,7 @@ sds sdscpylen(sds s, const char *t, size_t len) {
     s[len] = '\0';
 
     // 更新属性
-    sh->len = len;
-    sh->free = totlen-len;
+    sdssetlen(s, len);
 
     // 返回新的 sds
     return s;
@@ -706,7 +861,6 @@ sds sdscatprintf(sds s, const char *fmt, ...) {
  * %% - Verbatim "%" character.
  */
 sds sdscatfmt(sds s, char const *fmt, ...) {
-    struct sdshdr *sh = (void*) (s-(sizeof(struct sdshdr)));
     size_t initlen = sdslen(s);
     const char *f = fmt;
     int i;
@@ -722,9 +876,8 @@ sds sdscatfmt(sds s, char const *fmt, ...) {
         unsigned long long unum;
 
         /* Make sure there is always space for at least 1 char. */
-        if (sh->free == 0) {
+        if (sdsavail(s)==0) {
             s = sdsMakeRoomFor(s,1);
-            sh = (void*) (s-(sizeof(struct sdshdr)));
         }
 
         switch(*f) {
@@ -736,13 +889,11 @@ sds sdscatfmt(sds s, char const *fmt, ...) {
             case 'S':
                 str = va_arg(ap,char*);
                 l = (next == 's') ? strlen(str) : sdslen(str);
-                if (sh->free < l) {
+                if (sdsavail(s) < l) {
                     s = sdsMakeRoomFor(s,l);
-                    sh = (void*) (s-(sizeof(struct sdshdr)));
                 }
                 memcpy(s+i,str,l);
-                sh->len += l;
-                sh->free -= l;
+                sdsinclen(s,l);
                 i += l;
                 break;
             case 'i':
@@ -754,13 +905,11 @@ sds sdscatfmt(sds s, char const *fmt, ...) {
                 {
                     char buf[SDS_LLSTR_SIZE];
                     l = sdsll2str(buf,num);
-                    if (sh->free < l) {
+                    if (sdsavail(s) < l) {
                         s = sdsMakeRoomFor(s,l);
-                        sh = (void*) (s-(sizeof(struct sdshdr)));
                     }
                     memcpy(s+i,buf,l);
-                    sh->len += l;
-                    sh->free -= l;
+                    sdsinclen(s,l);
                     i += l;
                 }
                 break;
@@ -773,27 +922,23 @@ sds sdscatfmt(sds s, char const *fmt, ...) {
                 {
                     char buf[SDS_LLSTR_SIZE];
                     l = sdsull2str(buf,unum);
-                    if (sh->free < l) {
+                    if (sdsavail(s) < l) {
                         s = sdsMakeRoomFor(s,l);
-                        sh = (void*) (s-(sizeof(struct sdshdr)));
                     }
                     memcpy(s+i,buf,l);
-                    sh->len += l;
-                    sh->free -= l;
+                    sdsinclen(s,l);
                     i += l;
                 }
                 break;
             default: /* Handle %% and generally %<unknown>. */
                 s[i++] = next;
-                sh->len += 1;
-                sh->free -= 1;
+                sdsinclen(s,1);
                 break;
             }
             break;
         default:
             s[i++] = *f;
-            sh->len += 1;
-            sh->free -= 1;
+            sdsinclen(s,1);
             break;
         }
         f++;
@@ -828,7 +973,6 @@ sds sdscatfmt(sds s, char const *fmt, ...) {
  * Output will be just "Hello World".
  */
 sds sdstrim(sds s, const char *cset) {
-    struct sdshdr *sh = (void*) (s-(sizeof(struct sdshdr)));
     char *start, *end, *sp, *ep;
     size_t len;
 
@@ -844,16 +988,15 @@ sds sdstrim(sds s, const char *cset) {
     // 计算 trim 完毕之后剩余的字符串长度
     len = (sp > ep) ? 0 : ((ep-sp)+1);
     
-    // 如果有需要，前移字符串内容，将sp处开始的len个字符移动到sh->buf处
+    // 如果有需要，前移字符串内容，将sp处开始的len个字符移动到s处
     // T = O(N)
-    if (sh->buf != sp) memmove(sh->buf, sp, len);
+    if (s != sp) memmove(s, sp, len);
 
     // 添加终结符
-    sh->buf[len] = '\0'; 
+    s[len] = '\0';
 
-    // 更新属性
-    sh->free = sh->free+(sh->len-len);
-    sh->len = len; //长度就是剩下的len
+    // 更新属性，长度就是剩下的len
+    sdssetlen(s,len);
 
     // 返回修剪后的 sds
     return s;
@@ -881,7 +1024,6 @@ sds sdstrim(sds s, const char *cset) {
  * sdsrange(s,1,-1); => "ello World"
  */
 void sdsrange(sds s, int start, int end) {
-    struct sdshdr *sh = (void*) (s-(sizeof(struct sdshdr)));
     size_t newlen, len = sdslen(s);
 
     if (len == 0) return;
@@ -910,14 +1052,13 @@ void sdsrange(sds s, int start, int end) {
 
     // 如果有需要，对字符串进行移动，将buf+start处开始的newlen个字节移动到buf处
     // T = O(N)
-    if (start && newlen) memmove(sh->buf, sh->buf+start, newlen);
+    if (start && newlen) memmove(s, s+start, newlen);
 
     // 添加终结符
-    sh->buf[newlen] = 0;
+    s[newlen] = 0;
 
     // 更新属性
-    sh->free = sh->free+(sh->len-newlen);
-    sh->len = newlen; 
+    sdssetlen(s,newlen);
 }
 
 /*
@@ -1382,7 +1523,6 @@ sds sdsjoin(char **argv, int argc, char *sep) {
 
 int main(void) {
     {
-        struct sdshdr *sh;
         sds x = sdsnew("foo"), y;
 
         test_cond("Create a string and obtain the length",
@@ -1493,21 +1633,36 @@ int main(void) {
             memcmp(y,"\"\\a\\n\\x00foo\\r\"",15) == 0)
 
         {
-            int oldfree;
+            size_t oldfree;
 
             sdsfree(x);
             x = sdsnew("0");
-            sh = (void*) (x-(sizeof(struct sdshdr)));
-            test_cond("sdsnew() free/len buffers", sh->len == 1 && sh->free == 0);
+            test_cond("sdsnew() free/len buffers",
+                sdslen(x) == 1 && sdsavail(x) == 0 &&
+                (x[-1] & SDS_TYPE_MASK) == SDS_TYPE_5);
             x = sdsMakeRoomFor(x,1);
-            sh = (void*) (x-(sizeof(struct sdshdr)));
-            test_cond("sdsMakeRoomFor()", sh->len == 1 && sh->free > 0);
-            oldfree = sh->free;
+            test_cond("sdsMakeRoomFor()",
+                sdslen(x) == 1 && sdsavail(x) > 0 &&
+                (x[-1] & SDS_TYPE_MASK) == SDS_TYPE_8);
+            oldfree = sdsavail(x);
             x[1] = '1';
             sdsIncrLen(x,1);
             test_cond("sdsIncrLen() -- content", x[0] == '0' && x[1] == '1');
-            test_cond("sdsIncrLen() -- len", sh->len == 2);
-            test_cond("sdsIncrLen() -- free", sh->free == oldfree-1);
+            test_cond("sdsIncrLen() -- len", sdslen(x) == 2);
+            test_cond("sdsIncrLen() -- free", sdsavail(x) == oldfree-1);
+
+            x = sdsgrowzero(x,300);
+            test_cond("sdsgrowzero() moves to a bigger header",
+                sdslen(x) == 300 && (x[-1] & SDS_TYPE_MASK) == SDS_TYPE_16 &&
+                x[0] == '0' && x[1] == '1' && x[299] == 0);
+            sdsrange(x,0,9);
+            x = sdsRemoveFreeSpace(x);
+            test_cond("sdsRemoveFreeSpace() moves to a smaller header",
+                sdslen(x) == 10 && sdsavail(x) == 0 &&
+                (x[-1] & SDS_TYPE_MASK) == SDS_TYPE_5 &&
+                memcmp(x,"01",2) == 0 &&
+                sdsAllocSize(x) == sizeof(struct sdshdr5)+10+1);
+            sdsfree(x);
         }
     }
     test_report()
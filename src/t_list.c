@@ -50,8 +50,17 @@ void listTypeTryConversion(robj *subject, robj *value) {
     if (sdsEncodedObject(value) &&
         // 看字符串是否过长
         sdslen(value->ptr) > server.list_max_ziplist_value)
-            // 将编码转换为双端链表
-            listTypeConvert(subject,REDIS_ENCODING_LINKEDLIST);
+            // 将编码转换为双端链表或 quicklist
+            listTypeConvert(subject,listTypeLargeEncoding());
+}
+
+/* Return the encoding of the lists too big for a ziplist: a quicklist if
+ * list-quicklist-fill is set, otherwise a linked list.
+ *
+ * 返回 ziplist 放不下的列表所使用的编码 */
+int listTypeLargeEncoding(void) {
+    return server.list_quicklist_fill ? REDIS_ENCODING_QUICKLIST :
+                                        REDIS_ENCODING_LINKEDLIST;
 }
 
 /* The function pushes an element to the specified list object 'subject',
@@ -70,10 +79,10 @@ void listTypePush(robj *subject, robj *value, int where) {
     // 是否需要转换编码？从ziplist转到linkedlist
     listTypeTryConversion(subject,value);
 
-    //如果是ziplist编码，并且ziplist元素个数大于512，那么也从ziplist转码到linkedlist
+    //如果是ziplist编码，并且ziplist元素个数大于512，那么也从ziplist转码到linkedlist或quicklist
     if (subject->encoding == REDIS_ENCODING_ZIPLIST &&
         ziplistLen(subject->ptr) >= server.list_max_ziplist_entries)
-            listTypeConvert(subject,REDIS_ENCODING_LINKEDLIST);
+            listTypeConvert(subject,listTypeLargeEncoding());
 
     // ZIPLIST编码
     if (subject->encoding == REDIS_ENCODING_ZIPLIST) {
@@ -95,12 +104,24 @@ void listTypePush(robj *subject, robj *value, int where) {
         //添加引用计数（因为value被链入链表中）
         incrRefCount(value);
 
+    // QUICKLIST编码
+    } else if (subject->encoding == REDIS_ENCODING_QUICKLIST) {
+        int pos = (where == REDIS_HEAD) ? QUICKLIST_HEAD : QUICKLIST_TAIL;
+        value = getDecodedObject(value);
+        quicklistPush(subject->ptr,value->ptr,sdslen(value->ptr),pos);
+        decrRefCount(value);
+
     // 未知编码
     } else {
         redisPanic("Unknown list encoding");
     }
 }
 
+/* Copy a string popped from a quicklist into a string object. */
+static void *listPopSaver(unsigned char *data, unsigned int sz) {
+    return createStringObject((char*)data,sz);
+}
+
 /*
  * 从列表的表头或表尾中弹出一个元素。
  * 参数 where 决定了弹出元素的位置： 
@@ -154,6 +175,17 @@ robj *listTypePop(robj *subject, int where) {
             //因为删除链表节点会减少节点的引用计数，所以调用incrRefCount来增加下引用计数（因为函数返回值
             //会用到这个对象），这样value的引用计数其实没变。
         }
+
+    // QUICKLIST
+    } else if (subject->encoding == REDIS_ENCODING_QUICKLIST) {
+        int pos = (where == REDIS_HEAD) ? QUICKLIST_HEAD : QUICKLIST_TAIL;
+        long long vlong;
+
+        // 整数元素由 vlong 返回，需要创建字符串对象
+        if (quicklistPop(subject->ptr,pos,(void**)&value,&vlong,listPopSaver) &&
+            value == NULL)
+            value = createStringObjectFromLongLong(vlong);
+
     // 未知编码
     } else {
         redisPanic("Unknown list encoding");
@@ -173,6 +205,9 @@ unsigned long listTypeLength(robj *subject) {
     // 双端链表
     } else if (subject->encoding == REDIS_ENCODING_LINKEDLIST) {
         return listLength((list*)subject->ptr);
+    // QUICKLIST
+    } else if (subject->encoding == REDIS_ENCODING_QUICKLIST) {
+        return quicklistCount((quicklist*)subject->ptr);
     // 未知编码
     } else {
         redisPanic("Unknown list encoding");
@@ -191,6 +226,7 @@ listTypeIterator *listTypeInitIterator(robj *subject, long index, unsigned char
     li->subject = subject;
     li->encoding = subject->encoding;
     li->direction = direction;
+    li->iter = NULL;
 
     // ZIPLIST
     if (li->encoding == REDIS_ENCODING_ZIPLIST) {
@@ -199,7 +235,13 @@ listTypeIterator *listTypeInitIterator(robj *subject, long index, unsigned char
     // 双端链表
     } else if (li->encoding == REDIS_ENCODING_LINKEDLIST) {
         li->ln = listIndex(subject->ptr,index);
-        
+
+    // QUICKLIST：REDIS_TAIL 表示从表头向表尾迭代
+    } else if (li->encoding == REDIS_ENCODING_QUICKLIST) {
+        int iter_direction = (direction == REDIS_TAIL) ?
+            QUICKLIST_START_HEAD : QUICKLIST_START_TAIL;
+        li->iter = quicklistGetIteratorAtIdx(subject->ptr,iter_direction,index);
+
     // 未知编码
     } else {
         redisPanic("Unknown list encoding");
@@ -212,6 +254,7 @@ listTypeIterator *listTypeInitIterator(robj *subject, long index, unsigned char
  * 释放列表迭代器内存
  */
 void listTypeReleaseIterator(listTypeIterator *li) {
+    if (li->iter) quicklistReleaseIterator(li->iter);
     zfree(li);
 }
 
@@ -253,6 +296,10 @@ int listTypeNext(listTypeIterator *li, listTypeEntry *entry) {
             return 1;
         }
 
+    // 迭代 QUICKLIST
+    } else if (li->encoding == REDIS_ENCODING_QUICKLIST) {
+        return quicklistNext(li->iter,&entry->entry);
+
     // 未知编码
     } else {
         redisPanic("Unknown list encoding");
@@ -291,6 +338,15 @@ robj *listTypeGet(listTypeEntry *entry) {
         value = listNodeValue(entry->ln); //获得链表节点指向的value
         incrRefCount(value); //会被外部使用，所以增加引用计数
 
+    // 从 QUICKLIST 中取出节点的值
+    } else if (li->encoding == REDIS_ENCODING_QUICKLIST) {
+        if (entry->entry.value) {
+            value = createStringObject((char*)entry->entry.value,
+                                       entry->entry.sz);
+        } else {
+            value = createStringObjectFromLongLong(entry->entry.longval);
+        }
+
     } else {
         redisPanic("Unknown list encoding");
     }
@@ -341,6 +397,16 @@ void listTypeInsert(listTypeEntry *entry, robj *value, int where) {
         //增加value的引用计数，因为链表节点的value指针也连向value
         incrRefCount(value);
 
+    // 插入到 QUICKLIST
+    } else if (entry->li->encoding == REDIS_ENCODING_QUICKLIST) {
+        value = getDecodedObject(value);
+        if (where == REDIS_TAIL) {
+            quicklistInsertAfter(&entry->entry,value->ptr,sdslen(value->ptr));
+        } else {
+            quicklistInsertBefore(&entry->entry,value->ptr,sdslen(value->ptr));
+        }
+        decrRefCount(value);
+
     } else {
         redisPanic("Unknown list encoding");
     }
@@ -361,6 +427,10 @@ int listTypeEqual(listTypeEntry *entry, robj *o) {
     } else if (li->encoding == REDIS_ENCODING_LINKEDLIST) {
         return equalStringObjects(o,listNodeValue(entry->ln));
 
+    } else if (li->encoding == REDIS_ENCODING_QUICKLIST) {
+        redisAssertWithInfo(NULL,o,sdsEncodedObject(o));
+        return quicklistCompare(&entry->entry,o->ptr,sdslen(o->ptr));
+
     } else {
         redisPanic("Unknown list encoding");
     }
@@ -399,13 +469,17 @@ void listTypeDelete(listTypeEntry *entry) {
         // 删除节点之后，更新迭代器的指针
         li->ln = next;
 
+    // QUICKLIST：删除节点之后由 quicklist 更新迭代器
+    } else if (li->encoding == REDIS_ENCODING_QUICKLIST) {
+        quicklistDelEntry(li->iter,&entry->entry);
+
     } else {
         redisPanic("Unknown list encoding");
     }
 }
 
 /*
- * 将列表的底层编码从 ziplist 转换成双端链表
+ * 将列表的底层编码从 ziplist 转换成双端链表或 quicklist
  */
 void listTypeConvert(robj *subject, int enc) {
     listTypeIterator *li;
@@ -432,6 +506,17 @@ void listTypeConvert(robj *subject, int enc) {
         // 更新对象值指针
         subject->ptr = l;
 
+    // 目标是转换成 quicklist
+    } else if (enc == REDIS_ENCODING_QUICKLIST) {
+        quicklist *ql = quicklistCreate(server.list_quicklist_fill);
+
+        redisAssertWithInfo(NULL,subject,
+            subject->encoding == REDIS_ENCODING_ZIPLIST);
+        quicklistAppendZiplistValues(ql,subject->ptr);
+        subject->encoding = REDIS_ENCODING_QUICKLIST;
+        zfree(subject->ptr);
+        subject->ptr = ql;
+
     } else {
         redisPanic("Unsupported list conversion");
     }
@@ -534,10 +619,10 @@ void pushxGenericCommand(redisClient *c, robj *refval, robj *val, int where) {
         //如果插入成功
         if (inserted) {
             /* Check if the length exceeds the ziplist length threshold. */
-            // 查看插入之后是否需要将编码转换为双端链表。看看列表元素个数有没有超过512个
+            // 查看插入之后是否需要转换编码。看看列表元素个数有没有超过512个
             if (subject->encoding == REDIS_ENCODING_ZIPLIST &&
                 ziplistLen(subject->ptr) > server.list_max_ziplist_entries)
-                    listTypeConvert(subject,REDIS_ENCODING_LINKEDLIST);
+                    listTypeConvert(subject,listTypeLargeEncoding());
 
             signalModifiedKey(c->db,c->argv[1]);
             notifyKeyspaceEvent(REDIS_NOTIFY_LIST,"linsert",
@@ -645,6 +730,20 @@ void lindexCommand(redisClient *c) {
         } else {
             addReply(c,shared.nullbulk);//不存在添加null回复
         }
+
+    // 根据索引，跳过不包含该元素的 quicklist 节点，直到指定位置
+    } else if (o->encoding == REDIS_ENCODING_QUICKLIST) {
+        quicklistEntry entry;
+
+        if (quicklistIndex(o->ptr,index,&entry)) {
+            if (entry.value) {
+                addReplyBulkCBuffer(c,entry.value,entry.sz);
+            } else {
+                addReplyBulkLongLong(c,entry.longval);
+            }
+        } else {
+            addReply(c,shared.nullbulk);
+        }
     } else {
         redisPanic("Unknown list encoding");
     }
@@ -706,6 +805,23 @@ void lsetCommand(redisClient *c) {
             notifyKeyspaceEvent(REDIS_NOTIFY_LIST,"lset",c->argv[1],c->db->id);
             server.dirty++;
         }
+
+    // 设置到 quicklist
+    } else if (o->encoding == REDIS_ENCODING_QUICKLIST) {
+        int replaced;
+
+        value = getDecodedObject(value);
+        replaced = quicklistReplaceAtIndex(o->ptr,index,value->ptr,
+                                           sdslen(value->ptr));
+        decrRefCount(value);
+        if (!replaced) {
+            addReply(c,shared.outofrangeerr);
+        } else {
+            addReply(c,shared.ok);
+            signalModifiedKey(c->db,c->argv[1]);
+            notifyKeyspaceEvent(REDIS_NOTIFY_LIST,"lset",c->argv[1],c->db->id);
+            server.dirty++;
+        }
     } else {
         redisPanic("Unknown list encoding");
     }
@@ -817,8 +933,23 @@ void lrangeCommand(redisClient *c) {
             ln = ln->next;
         }
 
+    } else if (o->encoding == REDIS_ENCODING_QUICKLIST) {
+        quicklistIter *iter = quicklistGetIteratorAtIdx(o->ptr,
+            QUICKLIST_START_HEAD,start);
+        quicklistEntry entry;
+
+        // 从 start 开始迭代 quicklist ，将 rangelen 个元素添加到回复中
+        while(rangelen-- && quicklistNext(iter,&entry)) {
+            if (entry.value) {
+                addReplyBulkCBuffer(c,entry.value,entry.sz);
+            } else {
+                addReplyBulkLongLong(c,entry.longval);
+            }
+        }
+        quicklistReleaseIterator(iter);
+
     } else {
-        redisPanic("List encoding is not LINKEDLIST nor ZIPLIST!");
+        redisPanic("Unknown list encoding");
     }
 }
 
@@ -878,6 +1009,11 @@ void ltrimCommand(redisClient *c) {
             listDelNode(list,ln);
         }
 
+    } else if (o->encoding == REDIS_ENCODING_QUICKLIST) {
+        // 删除左端和右端元素
+        quicklistDelRange(o->ptr,0,ltrim);
+        quicklistDelRange(o->ptr,-rtrim,rtrim);
+
     } else {
         redisPanic("Unknown list encoding");
     }
@@ -913,10 +1049,11 @@ void lremCommand(redisClient *c) {
     subject = lookupKeyWriteOrReply(c,c->argv[1],shared.czero);
     if (subject == NULL || checkType(c,subject,REDIS_LIST)) return;
 
-    /* Make sure obj is raw when we're dealing with a ziplist */
-    //当列表是ziplist编码时，obj必须是embstr或raw编码（如果是int编码，则转换成embstr|raw编码）
-    if (subject->encoding == REDIS_ENCODING_ZIPLIST)
-        obj = getDecodedObject(obj);
+    /* Make sure obj is raw when we're dealing with a ziplist or quicklist */
+    //当列表是ziplist或quicklist编码时，obj必须是embstr或raw编码（如果是int编码，则转换成embstr|raw编码）
+    int decoded = subject->encoding == REDIS_ENCODING_ZIPLIST ||
+                  subject->encoding == REDIS_ENCODING_QUICKLIST;
+    if (decoded) obj = getDecodedObject(obj);
 
     listTypeIterator *li;
 
@@ -943,7 +1080,7 @@ void lremCommand(redisClient *c) {
     listTypeReleaseIterator(li);//释放迭代器
 
     /* Clean up raw encoded object */
-    if (subject->encoding == REDIS_ENCODING_ZIPLIST)
+    if (decoded)
         //减少对象的引用
         decrRefCount(obj);
 
@@ -1280,7 +1280,8 @@ void sdiffCommand(redisClient *c) {
     sunionDiffGenericCommand(c,c->argv+1,c->argc-1,NULL,REDIS_OP_DIFF);
 }
 //将第一个集合和其它所有集合的差集放入c->argv[1]中（某个元素只存在于第一个集合，不存在于任何其它集合）
-//Returns the members of the set resulting from the difference between the first set and all the successive setsvoid sdiffstoreCommand(redisClient *c) {
+//Returns the members of the set resulting from the difference between the first set and all the successive sets
+void sdiffstoreCommand(redisClient *c) {
     sunionDiffGenericCommand(c,c->argv+2,c->argc-2,c->argv[1],REDIS_OP_DIFF);
 }
 
@@ -363,28 +363,44 @@ void getrangeCommand(redisClient *c) {
 
 //依次查找key是否存在，如果存在将值字符串添加到回复中
 void mgetCommand(redisClient *c) {
-    int j;
+    robj *vals[DICT_FIND_BATCH];
+    int i, j, n;
 
     addReplyMultiBulkLen(c,c->argc-1);
-    // 查找并返回所有输入键的值，依次查找key
-    for (j = 1; j < c->argc; j++) {
-        // 查找键 c->argc[j] 的值
-        robj *o = lookupKeyRead(c->db,c->argv[j]);
-        if (o == NULL) {
-            // 值不存在，向客户端发送空回复
-            addReply(c,shared.nullbulk);
-        } else {
-            if (o->type != REDIS_STRING) {
-                // 值存在，但不是字符串类型，添加空回复
+    // 查找并返回所有输入键的值，每次批量查找 DICT_FIND_BATCH 个key
+    for (i = 1; i < c->argc; i += n) {
+        n = c->argc-i < DICT_FIND_BATCH ? c->argc-i : DICT_FIND_BATCH;
+        lookupKeysRead(c->db,c->argv+i,n,vals);
+
+        for (j = 0; j < n; j++) {
+            robj *o = vals[j];
+            if (o == NULL) {
+                // 值不存在，向客户端发送空回复
                 addReply(c,shared.nullbulk);
             } else {
-                // 值存在，并且是字符串，添加到client的回复中
-                addReplyBulk(c,o);
+                if (o->type != REDIS_STRING) {
+                    // 值存在，但不是字符串类型，添加空回复
+                    addReply(c,shared.nullbulk);
+                } else {
+                    // 值存在，并且是字符串，添加到client的回复中
+                    addReplyBulk(c,o);
+                }
             }
         }
     }
 }
 
+/* Prefetch the keys of the next DICT_FIND_BATCH pairs when the key at
+ * argv[j] starts a new batch. */
+// 每 DICT_FIND_BATCH 个键值对批量预取一次键
+static void msetPrefetchKeys(redisClient *c, int j) {
+    int pairs = (c->argc-j)/2;
+
+    if (((j-1)/2) % DICT_FIND_BATCH == 0)
+        dbPrefetchKeys(c->db,c->argv+j,
+                       pairs < DICT_FIND_BATCH ? pairs : DICT_FIND_BATCH,2);
+}
+
 //依次添加键值对 ，nx=1表示启用nx
 void msetGenericCommand(redisClient *c, int nx) {
     int j, busykeys = 0;
@@ -400,6 +416,7 @@ void msetGenericCommand(redisClient *c, int nx) {
     // 只要有一个键是存在的，那么就向客户端发送空回复，并放弃执行接下来的设置操作
     if (nx) {
         for (j = 1; j < c->argc; j += 2) {
+            msetPrefetchKeys(c,j);
             if (lookupKeyWrite(c->db,c->argv[j]) != NULL) {
                 busykeys++;
                 //这里可以优化下，来个break！！！
@@ -414,6 +431,8 @@ void msetGenericCommand(redisClient *c, int nx) {
 
     // 依次设置所有键值对
     for (j = 1; j < c->argc; j += 2) {
+        msetPrefetchKeys(c,j);
+
         // 对值对象进行解码，尝试用int或embstr进行字符串编码
         c->argv[j+1] = tryObjectEncoding(c->argv[j+1]);
 
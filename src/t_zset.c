@@ -1718,7 +1718,7 @@ void zaddGenericCommand(redisClient *c, int incr) {
                     zsetConvert(zobj,REDIS_ENCODING_SKIPLIST);
 
                 // 查看新添加元素的长度，是否超过阈值，超过的话需要从ziplist转换成skiplist
-]                if (sdslen(ele->ptr) > server.zset_max_ziplist_value)
+                if (sdslen(ele->ptr) > server.zset_max_ziplist_value)
                     zsetConvert(zobj,REDIS_ENCODING_SKIPLIST);
 
                 server.dirty++;
@@ -3067,7 +3067,7 @@ void genericZrangebyscoreCommand(redisClient *c, int reverse) {
             }
 
             /* We know the element exists, so ziplistGet should always succeed */
-            redisAssertWithInfo(c,zobj,ziplistGet(eptr,&vstr,&vlen,&vlong))
+            redisAssertWithInfo(c,zobj,ziplistGet(eptr,&vstr,&vlen,&vlong));
             rangelen++;
             if (vstr == NULL) {
                 addReplyBulkLongLong(c,vlong);
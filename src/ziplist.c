@@ -407,13 +407,13 @@ static unsigned int zipEncodeLength(unsigned char *p, unsigned char encoding, un
     /* 如果是字符串编码 */                                                           \
     if ((encoding) < ZIP_STR_MASK) {                                           \
         if ((encoding) == ZIP_STR_06B) {                                       \
-            (lensize) = 1; //encoding需要的字节数是1                                                    \
-            (len) = (ptr)[0] & 0x3f; //字节数组长度                                  \
+            (lensize) = 1;                                                    \
+            (len) = (ptr)[0] & 0x3f;                                  \
         } else if ((encoding) == ZIP_STR_14B) {                                \
-            (lensize) = 2;//encoding需要的字节数是2                                              \
-            (len) = (((ptr)[0] & 0x3f) << 8) | (ptr)[1]; //字节数组长度                      \
+            (lensize) = 2;                                              \
+            (len) = (((ptr)[0] & 0x3f) << 8) | (ptr)[1];                      \
         } else if (encoding == ZIP_STR_32B) {                                  \
-            (lensize) = 5;//encoding需要的字节数是5                                                     \
+            (lensize) = 5;                                                     \
             (len) = ((ptr)[1] << 24) |                                         \
                     ((ptr)[2] << 16) |                                         \
                     ((ptr)[3] <<  8) |                                         \
@@ -424,8 +424,8 @@ static unsigned int zipEncodeLength(unsigned char *p, unsigned char encoding, un
                                                                                \
     /* 整数编码 */                                                             \
     } else {                                                                   \
-        (lensize) = 1; //整数编码那么encoding只需要1字节即可                                                        \
-        (len) = zipIntSize(encoding); //保存这个整数content需要的字节数                                         \
+        (lensize) = 1;                                                        \
+        (len) = zipIntSize(encoding);                                         \
     }                                                                          \
 } while(0);
 
@@ -484,7 +484,7 @@ static void zipPrevEncodeLengthForceLarge(unsigned char *p, unsigned int len) {
  * T = O(1)
  */
 #define ZIP_DECODE_PREVLENSIZE(ptr, prevlensize) do {                          \
-    if ((ptr)[0] < ZIP_BIGLEN) { 小于254字节                                              \
+    if ((ptr)[0] < ZIP_BIGLEN) {                                                          \
         (prevlensize) = 1;                                                     \
     } else {                                                                   \
         (prevlensize) = 5;                                                     \
@@ -505,11 +505,11 @@ static void zipPrevEncodeLengthForceLarge(unsigned char *p, unsigned int len) {
     ZIP_DECODE_PREVLENSIZE(ptr, prevlensize);                                  \
                                                                                \
     /* 再根据编码字节数来取出长度值 */                                         \
-    if ((prevlensize) == 1) {    //如果是1字节，那么直接取出并赋值给prevlen                                              \
+    if ((prevlensize) == 1) {                                              \
         (prevlen) = (ptr)[0];                                                  \
     } else if ((prevlensize) == 5) {                                           \
         assert(sizeof((prevlensize)) == 4);           \
-        memcpy(&(prevlen), ((char*)(ptr)) + 1, 4);  //如果是5字节，那么从ptr+1取出4字节并赋值给prevlen（因为ptr[0]被设置成254了）                           \
+        memcpy(&(prevlen), ((char*)(ptr)) + 1, 4);                           \
         memrev32ifbe(&prevlen);                                                \
     }                                                                          \
 } while(0);
@@ -880,7 +880,7 @@ static unsigned char *__ziplistCascadeUpdate(unsigned char *zl, unsigned char *p
                 // 但是程序不会对 next 进行缩小，
                 // 所以这里只将 rawlen 写入 5 字节的 header 中就算了。
                 // T = O(1)
-                zipPrevEncodeLenghLarge(p+rawlen,rawlen);
+                zipPrevEncodeLengthForceLarge(p+rawlen,rawlen);
             } else {
                 // 运行到这里，
                 // 说明 cur 节点的长度正好可以编码到 next 节点的 header 中
@@ -41,6 +41,9 @@ void zlibc_free(void *ptr) {
 
 #include <string.h>
 #include <pthread.h>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
 #include "config.h"
 #include "zmalloc.h"
 
@@ -93,9 +96,8 @@ void zlibc_free(void *ptr) {
 //例如如果n=13，那么n会变成16即round up to 8的倍数
 #define update_zmalloc_stat_alloc(__n) do { \
     size_t _n = (__n); \
-    if (_n&(sizeof(long)-1)) _n += sizeof(long)-(_n&(sizeof(long)-1)); \ //向上对齐n
-    if (zmalloc_thread_safe) { \  
-    ////如果要求线程安全的话，加锁
+    if (_n&(sizeof(long)-1)) _n += sizeof(long)-(_n&(sizeof(long)-1)); \
+    if (zmalloc_thread_safe) { \
         update_zmalloc_stat_add(_n); \
     } else { \
         used_memory += _n; \
@@ -220,6 +222,38 @@ void zfree(void *ptr) {
 #endif
 }
 
+/* Return the number of usable bytes zmalloc() really reserves for a request
+ * of 'size' bytes, that is the size class of the allocator 'size' falls in.
+ * Callers use it to size objects so that they fill their size class. The
+ * allocator is probed with a real allocation, so this is not meant for hot
+ * paths: compute it once and cache the result. */
+// 返回申请 size 字节时分配器实际保留的可用字节数（也就是 size 所属的 size class ）
+// 通过一次真实的分配来探测，不要在热路径上调用
+size_t zmalloc_size_class(size_t size) {
+#ifdef HAVE_MALLOC_SIZE
+    void *ptr = malloc(size);
+    size_t usable;
+
+    if (!ptr) zmalloc_oom_handler(size);
+    usable = zmalloc_size(ptr);
+    free(ptr);
+    return usable;
+#elif defined(__GLIBC__)
+    /* The libc allocator still rounds the request (and our size prefix)
+     * up to its own chunk size: ask for the real usable size. */
+    void *ptr = malloc(size+PREFIX_SIZE);
+    size_t usable;
+
+    if (!ptr) zmalloc_oom_handler(size);
+    usable = malloc_usable_size(ptr);
+    free(ptr);
+    return usable-PREFIX_SIZE;
+#else
+    if (size&(sizeof(long)-1)) size += sizeof(long)-(size&(sizeof(long)-1));
+    return size;
+#endif
+}
+
 //拷贝字符串，每次先获得字符串大小，时间O(N)
 char *zstrdup(const char *s) {
     size_t l = strlen(s)+1;
@@ -15,9 +15,10 @@ start_server {tags {"aofrw"}} {
     }
 
     foreach d {string int} {
-        foreach e {ziplist linkedlist} {
+        foreach e {ziplist linkedlist quicklist} {
             test "AOF rewrite of list with $e encoding, $d data" {
                 r flushall
+                r config set list-quicklist-fill [expr {$e eq {quicklist} ? -2 : 0}]
                 if {$e eq {ziplist}} {set len 10} else {set len 1000}
                 for {set j 0} {$j < $len} {incr j} {
                     if {$d eq {string}} {
@@ -39,6 +40,7 @@ start_server {tags {"aofrw"}} {
             }
         }
     }
+    r config set list-quicklist-fill 0
 
     foreach d {string int} {
         foreach e {intset hashtable} {
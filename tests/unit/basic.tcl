@@ -26,6 +26,49 @@ start_server {tags {"basic"}} {
         list [r del foo1 foo2 foo3 foo4] [r mget foo1 foo2 foo3]
     } {3 {{} {} {}}}
 
+    test {UNLINK can reclaim memory in background} {
+        set args {}
+        for {set j 0} {$j < 1000} {incr j} {lappend args elem:$j}
+        r sadd myset {*}$args
+        r hmset myhash {*}$args
+        list [r unlink myset myhash nokey] [r exists myset] [r exists myhash]
+    } {2 0 0}
+
+    test {UNLINK of values sharing elements with other keys} {
+        set args {}
+        for {set j 0} {$j < 500} {incr j} {lappend args $j elem:$j}
+        r zadd myzset {*}$args
+        r sadd myset {*}$args
+        r rpush mylist {*}$args
+        r zunionstore zcopy 1 myzset
+        r sunionstore scopy myset
+        r sort mylist by nosort store lcopy
+        r unlink myzset myset mylist
+        wait_for_condition 50 100 {
+            [s lazyfree_pending_objects] == 0
+        } else {
+            fail "Values not released by the lazyfree thread"
+        }
+        # Shared references are dropped by the cron.
+        after 200
+        list [r zcard zcopy] [r scard scopy] [r llen lcopy] \
+             [r zscore zcopy elem:499] [r sismember scopy 250] \
+             [expr {[lsort [r lrange lcopy 0 -1]] eq [lsort $args]}]
+    } {500 1000 1000 499 1 1}
+
+    test {FLUSHDB ASYNC can reclaim memory in background} {
+        r sadd bigset {*}[lrange $args 0 199]
+        r debug populate 1000
+        r flushdb async
+        set dbsize [r dbsize]
+        wait_for_condition 50 100 {
+            [s lazyfree_pending_objects] == 0
+        } else {
+            fail "Database not released by the lazyfree thread"
+        }
+        list $dbsize [r dbsize] [catch {r flushdb sync} err] $err
+    } {0 0 1 {ERR syntax error}}
+
     test {KEYS with pattern} {
         foreach key {key_x key_y key_z foo_a foo_b foo_c} {
             r set $key hello
@@ -438,6 +481,77 @@ start_server {tags {"basic"}} {
         r mget foo baazz bar myset
     } {BAR {} FOO {}}
 
+    test {MSET, MGET and DEL with more keys than a lookup batch} {
+        r flushdb
+        set args {}
+        set keys {}
+        for {set j 0} {$j < 50} {incr j} {
+            lappend args key:$j val:$j
+            lappend keys key:$j
+        }
+        r mset {*}$args
+        r pexpire key:7 1
+        after 10
+        set res [r mget {*}$keys missing]
+        assert_equal 51 [llength $res]
+        assert_equal {} [lindex $res 7]
+        assert_equal val:49 [lindex $res 49]
+        assert_equal 0 [r exists key:7]
+        assert_equal 10 [r del {*}[lrange $keys 0 10]]
+        r dbsize
+    } {39}
+
+    test {Pipelined GETs return the right values} {
+        r flushdb
+        set long [string repeat x 100]
+        r set short 1
+        r set $long 2
+        set fd [r channel]
+        set cmds {}
+        for {set j 0} {$j < 40} {incr j} {
+            foreach k [list short missing $long] {
+                append cmds "*2\r\n\$3\r\nget\r\n\$[string length $k]\r\n$k\r\n"
+            }
+        }
+        puts -nonewline $fd $cmds
+        flush $fd
+        set res {}
+        for {set j 0} {$j < 40} {incr j} {
+            lappend res [r read] [r read] [r read]
+        }
+        lsort -unique $res
+    } {{} 1 2}
+
+    test {Pipelined GETs and MGETs are prefetched up to the first other command} {
+        r flushdb
+        r mset a 1 b 2 c 3
+        r select 10
+        r set a 10
+        r select 9
+        set prefetched [s prefetched_keys]
+        set fd [r channel]
+        set cmds {}
+        foreach cmd {{get a} {mget b c} {get missing} {select 10} {get a}
+                     {select 9}} {
+            append cmds "*[llength $cmd]\r\n"
+            foreach arg $cmd {
+                append cmds "\$[string length $arg]\r\n$arg\r\n"
+            }
+        }
+        puts -nonewline $fd $cmds
+        flush $fd
+        set res {}
+        for {set j 0} {$j < 6} {incr j} {
+            lappend res [r read]
+        }
+        # Only the four keys before the SELECT are looked up in db 9.
+        set prefetched [expr {[s prefetched_keys]-$prefetched}]
+        r select 10
+        r del a
+        r select 9
+        list $res $prefetched
+    } {{1 {2 3} {} OK 10 OK} 4}
+
     test {RANDOMKEY} {
         r flushdb
         r set foo x
@@ -769,4 +883,46 @@ start_server {tags {"basic"}} {
         r keys *
         r keys *
     } {dlskeriewrioeuwqoirueioqwrueoqwrueqw}
+
+    test {Keys of any length survive RENAME, MOVE and DEBUG RELOAD} {
+        r flushdb
+        r select 10
+        r flushdb
+        r select 9
+        # Keys live in the same allocation of their keyspace entry, and
+        # the expires dict points to them: exercise every sds header size.
+        set keys {}
+        foreach len {0 1 31 32 255 256 1000 65535 65536 70000} {
+            lappend keys [string range "\x00a\r\n[string repeat k $len]" 4 [expr {$len+3}]]
+        }
+        lset keys 3 "bin\x00[string repeat k 28]"
+        foreach k $keys {
+            r set $k [string length $k] ex 1000
+        }
+        assert_equal [llength $keys] [r dbsize]
+        foreach k $keys {
+            r rename $k renamed:$k
+            assert_equal 0 [r exists $k]
+            assert_equal [string length $k] [r get renamed:$k]
+            assert {[r ttl renamed:$k] > 900}
+        }
+        foreach k $keys {
+            r rename renamed:$k $k
+        }
+        r debug reload
+        foreach k $keys {
+            assert_equal [string length $k] [r get $k]
+            assert {[r ttl $k] > 900}
+            assert_equal 1 [r move $k 10]
+        }
+        assert_equal 0 [r dbsize]
+        r select 10
+        set res [lsort [r keys *]]
+        foreach k $keys {
+            assert_equal [string length $k] [r get $k]
+            r del $k
+        }
+        r select 9
+        string equal $res [lsort $keys]
+    } {1}
 }
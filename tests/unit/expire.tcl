@@ -198,4 +198,127 @@ start_server {tags {"expire"}} {
         r set foo b
         lsort [r keys *]
     } {a e foo s t}
+
+    test {Active expire effort and stats} {
+        assert_error "*Invalid argument*" {r config set active-expire-effort 11}
+        r config set active-expire-effort 10
+        r flushdb
+        for {set j 0} {$j < 1000} {incr j} {r psetex key:$j 100 x}
+        r set persistent x
+        wait_for_condition 50 100 {
+            [r dbsize] == 1
+        } else {
+            fail "Keys not expired"
+        }
+        assert {[s expire_cycle_effort] == 10}
+        r config set active-expire-effort 1
+        assert {[s expire_cycle_cpu_milliseconds] >= 0}
+        assert_match {*expired_stale_perc:*} [r info stats]
+        r psetex foo 100000 x
+        assert_match {*db9:keys=2,expires=1,avg_ttl=*,stale_keys_est=*} \
+            [r info keyspace]
+    }
+
+    test {Max expire effort under memory pressure is opt-in} {
+        assert_error "*Invalid argument*" \
+            {r config set active-expire-pressure-perc 101}
+        r config set maxmemory [expr {[s used_memory]*2}]
+        after 300
+        assert {[s expire_cycle_effort] == 1}
+        r config set active-expire-pressure-perc 10
+        wait_for_condition 50 100 {
+            [s expire_cycle_effort] == 10
+        } else {
+            fail "Max effort not used under memory pressure"
+        }
+        r config set active-expire-pressure-perc 0
+        r config set maxmemory 0
+    }
+
+    test {Keyspace and expires stay in sync while both are rehashing} {
+        assert_match {*hash_function:*} [r info server]
+        r flushdb
+        # A key is hashed once and the hash is used for both db->dict and
+        # db->expires, which grow and rehash at different times.
+        r eval {
+            for i=1,20000 do
+                local k = 'sync:'..i
+                redis.call('set',k,i,'ex',1000)
+                if i % 3 == 0 then redis.call('persist',k) end
+                if i % 5 == 0 then redis.call('set',k,'over') end
+                if i % 7 == 0 then redis.call('del','sync:'..(i-1)) end
+                if i % 11 == 0 then redis.call('rename',k,'renamed:'..i) end
+            end
+        } 0
+        set err {}
+        set keys 0
+        set volatile 0
+        for {set i 1} {$i <= 20000} {incr i} {
+            if {$i % 11 == 0} {
+                set k renamed:$i
+            } elseif {($i+1) % 7 == 0} {
+                if {[r exists sync:$i] && $err eq {}} {set err "sync:$i exists"}
+                continue
+            } else {
+                set k sync:$i
+            }
+            incr keys
+            set ttl [r ttl $k]
+            if {$i % 3 == 0 || $i % 5 == 0} {
+                if {$ttl != -1 && $err eq {}} {set err "$k: TTL $ttl"}
+            } else {
+                incr volatile
+                if {$ttl < 900 && $err eq {}} {set err "$k: TTL $ttl"}
+            }
+        }
+        assert_equal {} $err
+        assert_match "*db9:keys=$keys,expires=$volatile,*" [r info keyspace]
+        r dbsize
+    } {17403}
+}
+
+start_server {tags {"expire"} overrides {active-expire-index yes}} {
+    test {Expire index - due keys are reclaimed among many volatile ones} {
+        r flushdb
+        for {set j 0} {$j < 1000} {incr j} {
+            r setex long:$j 1000 x
+        }
+        for {set j 0} {$j < 100} {incr j} {
+            r psetex short:$j 100 x
+        }
+        # Keys whose expire is changed, removed or reset.
+        r psetex moved 100 x
+        r pexpire moved 100000
+        r psetex persisted 100 x
+        r persist persisted
+        r psetex overwritten 100 x
+        r set overwritten y
+        r psetex renamed 100 x
+        r rename renamed renamed2
+        after 1000
+        list [r dbsize] [r exists moved] [r exists persisted] \
+             [r exists overwritten] [r exists renamed2]
+    } {1003 1 1 1 0}
+
+    test {Expire index - keys expiring in the past and FLUSHALL ASYNC} {
+        r flushall async
+        r debug set-active-expire 0
+        r psetex a 10 x
+        r psetex b 10 x
+        after 100
+        r debug set-active-expire 1
+        r setex c 1000 x
+        wait_for_condition 50 100 {
+            [r dbsize] == 1
+        } else {
+            fail "Expired keys not reclaimed"
+        }
+        r flushall async
+        r psetex d 100 x
+        wait_for_condition 50 100 {
+            [r dbsize] == 0
+        } else {
+            fail "Expired keys not reclaimed after FLUSHALL ASYNC"
+        }
+    }
 }
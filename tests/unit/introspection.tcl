@@ -56,4 +56,96 @@ start_server {tags {"introspection"}} {
             fail "Client still listed in CLIENT LIST after SETNAME."
         }
     }
+
+    test {Closed clients are reused from the client pool} {
+        set rd [redis_deferring_client]
+        $rd client setname pooled
+        assert_equal [$rd read] "OK"
+        $rd close
+        wait_for_condition 50 100 {
+            [status r pooled_clients] > 0
+        } else {
+            fail "Closed client was not returned to the pool."
+        }
+        set hits [status r client_pool_hits]
+        set rd [redis_deferring_client]
+        # A reused client must not retain the state of the old connection
+        $rd client getname
+        assert_equal [$rd read] {}
+        $rd close
+        assert {[status r client_pool_hits] > $hits}
+    }
+
+    test {Clients killed in the middle of a transaction are reused clean} {
+        set rd [redis_deferring_client]
+        $rd client setname killme
+        $rd read
+        $rd subscribe chan
+        $rd read
+        $rd psubscribe pat*
+        $rd read
+        set rd2 [redis_deferring_client]
+        $rd2 client setname killme2
+        $rd2 read
+        $rd2 select 3
+        $rd2 read
+        $rd2 multi
+        $rd2 read
+        $rd2 set foo bar
+        $rd2 read
+        $rd2 write "*3\r\n\$3\r\nSET\r\n\$3\r\nfoo\r\n\$100\r\nabc"
+        $rd2 flush
+        foreach cname {killme killme2} {
+            regexp "addr=(\[^ \]+) \[^\n\]*name=$cname " [r client list] - addr
+            r client kill $addr
+        }
+        wait_for_condition 50 100 {
+            ![string match {*name=killme*} [r client list]]
+        } else {
+            fail "Killed clients still listed"
+        }
+        catch {$rd close}
+        catch {$rd2 close}
+
+        set hits [status r client_pool_hits]
+        set rd [redis_deferring_client]
+        set rd2 [redis_deferring_client]
+        assert {[status r client_pool_hits] >= $hits+2}
+        $rd2 exec
+        assert_error {*EXEC without MULTI*} {$rd2 read}
+        $rd publish chan hello
+        assert_equal 0 [$rd read]
+        $rd client setname reused
+        $rd read
+        $rd2 client setname reused2
+        $rd2 read
+        set list [r client list]
+        $rd close
+        $rd2 close
+        foreach cname {reused reused2} {
+            assert_match "*name=$cname *flags=N db=9 sub=0 psub=0 multi=-1 qbuf=0 *" \
+                [lsearch -inline [split $list "\n"] "*name=$cname *"]
+        }
+    }
+
+    test {The client pool is bounded by client-pool-size} {
+        r config set client-pool-size 2
+        set connected [status r connected_clients]
+        set clients {}
+        for {set j 0} {$j < 5} {incr j} {
+            set rd [redis_deferring_client]
+            $rd ping
+            $rd read
+            lappend clients $rd
+        }
+        foreach rd $clients {$rd close}
+        wait_for_condition 50 100 {
+            [status r connected_clients] == $connected
+        } else {
+            fail "Closed clients still listed"
+        }
+        set pooled [status r pooled_clients]
+        r config set client-pool-size 128
+        set pooled
+    } {2}
 }
@@ -0,0 +1,109 @@
+proc start_write_load {host port seconds} {
+    set tclsh [info nameofexecutable]
+    exec $tclsh tests/helpers/gen_write_load.tcl $host $port $seconds &
+}
+
+proc stop_write_load {handle} {
+    catch {exec /bin/kill -9 $handle}
+}
+
+start_server {tags {"io-threads"} overrides {io-threads 4}} {
+    # The I/O threads are started only when enough clients are waiting
+    # for their replies, and stopped as soon as they are few. Keep some
+    # clients busy for the whole unit, so that the reads of the tests
+    # below are performed and parsed by the threads.
+    set load_handles {}
+    for {set j 0} {$j < 16} {incr j} {
+        lappend load_handles [start_write_load [srv 0 host] [srv 0 port] 120]
+    }
+
+    test {I/O threads are started under load} {
+        wait_for_condition 50 100 {
+            [s io_threads_active] == 1 &&
+            [s io_threaded_reads_processed] > 0
+        } else {
+            fail "I/O threads were not started"
+        }
+    }
+
+    test {Pipelined commands from several clients} {
+        set clients {}
+        for {set j 0} {$j < 8} {incr j} {
+            set rd [redis_deferring_client]
+            $rd del iothreads:$j
+            $rd read
+            lappend clients $rd
+        }
+        set reads [s io_threaded_reads_processed]
+        for {set j 0} {$j < 8} {incr j} {
+            set cmds {}
+            for {set i 0} {$i < 100} {incr i} {
+                append cmds "*2\r\n\$4\r\nincr\r\n"
+                append cmds "\$[string length iothreads:$j]\r\niothreads:$j\r\n"
+            }
+            [lindex $clients $j] write $cmds
+            [lindex $clients $j] flush
+        }
+        set err {}
+        for {set j 0} {$j < 8} {incr j} {
+            for {set i 1} {$i <= 100} {incr i} {
+                set res [[lindex $clients $j] read]
+                if {$res != $i && $err eq {}} {
+                    set err "client $j: got $res instead of $i"
+                }
+            }
+            [lindex $clients $j] close
+        }
+        assert_equal {} $err
+        assert {[s io_threaded_reads_processed] > $reads}
+        set res {}
+        for {set j 0} {$j < 8} {incr j} {
+            lappend res [r get iothreads:$j]
+        }
+        lsort -unique $res
+    } {100}
+
+    test {Large multibulk argument} {
+        set rd [redis_deferring_client]
+        set big [string repeat abcdefghij 100000]
+        $rd set iothreads:big $big
+        assert_equal OK [$rd read]
+        $rd get iothreads:big
+        assert_equal $big [$rd read]
+        $rd close
+        r strlen iothreads:big
+    } {1000000}
+
+    test {Protocol error is replied and the connection closed} {
+        set rd [redis_deferring_client]
+        $rd write "*3\r\n\$3\r\nSET\r\n\$1\r\nx\r\nfooz\r\n"
+        $rd flush
+        assert_error "*expected '$', got 'f'*" {$rd read}
+        # The server closes the connection once the error is written.
+        set fd [$rd channel]
+        assert_equal {} [read $fd]
+        assert {[eof $fd]}
+        $rd close
+        r ping
+    } {PONG}
+
+    test {Client that disconnects in the middle of a request} {
+        set rd [redis_deferring_client]
+        $rd client setname iothreads-partial
+        assert_equal OK [$rd read]
+        $rd write "*3\r\n\$3\r\nSET\r\n\$15\r\niothreads:cut\r\n"
+        $rd write "\$100000\r\n[string repeat x 5000]"
+        $rd flush
+        $rd close
+        wait_for_condition 50 100 {
+            ![string match {*name=iothreads-partial*} [r client list]]
+        } else {
+            fail "Client that disconnected was not freed"
+        }
+        list [r exists iothreads:cut] [r ping]
+    } {0 PONG}
+
+    foreach handle $load_handles {
+        stop_write_load $handle
+    }
+}
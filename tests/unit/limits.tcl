@@ -14,3 +14,24 @@ start_server {tags {"limits"} overrides {maxclients 10}} {
         set e
     } {*ERR max*reached*}
 }
+
+start_server {tags {"limits"} overrides {tcp-listeners 4}} {
+    test {Connections are accepted with several SO_REUSEPORT listeners} {
+        assert_equal [lindex [r config get tcp-listeners] 1] 4
+        set clients {}
+        for {set j 0} {$j < 20} {incr j} {
+            set rd [redis_deferring_client]
+            $rd ping
+            assert_equal [$rd read] PONG
+            lappend clients $rd
+        }
+        foreach rd $clients {$rd close}
+        r ping
+    } {PONG}
+
+    test {SO_REUSEPORT listeners can't share the port of another server} {
+        catch {exec src/redis-server --bind [srv 0 host] --port [srv 0 port] \
+            --tcp-listeners 4} e
+        set e
+    } {*Address already in use*}
+}
@@ -1,6 +1,7 @@
 start_server {tags {"maxmemory"}} {
     foreach policy {
-        allkeys-random allkeys-lru volatile-lru volatile-random volatile-ttl
+        allkeys-random allkeys-lru allkeys-lfu volatile-lru volatile-lfu
+        volatile-random volatile-ttl
     } {
         test "maxmemory - is the memory limit honoured? (policy $policy)" {
             # make sure to start with a blank instance
@@ -32,7 +33,8 @@ start_server {tags {"maxmemory"}} {
     }
 
     foreach policy {
-        allkeys-random allkeys-lru volatile-lru volatile-random volatile-ttl
+        allkeys-random allkeys-lru allkeys-lfu volatile-lru volatile-lfu
+        volatile-random volatile-ttl
     } {
         test "maxmemory - only allkeys-* should remove non-volatile keys ($policy)" {
             # make sure to start with a blank instance
@@ -74,7 +76,7 @@ start_server {tags {"maxmemory"}} {
     }
 
     foreach policy {
-        volatile-lru volatile-random volatile-ttl
+        volatile-lru volatile-lfu volatile-random volatile-ttl
     } {
         test "maxmemory - policy $policy should only remove volatile keys." {
             # make sure to start with a blank instance
@@ -117,4 +119,138 @@ start_server {tags {"maxmemory"}} {
             }
         }
     }
+
+    test "maxmemory - the eviction pool is shared by all the databases" {
+        r flushall
+        r config set maxmemory 0
+        r config set maxmemory-policy allkeys-lru
+        r config set maxmemory-precision-samples 10
+        r config resetstat
+        set before [s used_memory]
+        # Every generation is written by a single script, so serverCron()
+        # can't advance the LRU clock in the middle of it and all its keys
+        # have the same idle time.
+        set script {
+            for i=0,1999 do
+                redis.call('set',ARGV[1]..i,string.rep('x',100))
+            end
+        }
+        r select 10
+        r eval $script 0 old:
+        set perkey [expr {([s used_memory]-$before)/2000}]
+        # The LRU clock has a resolution of one second.
+        after 2100
+        r select 9
+        r eval $script 0 new:
+        r config set maxmemory [expr {[s used_memory]-1000*$perkey}]
+        set new [r dbsize]
+        r select 10
+        set old [r dbsize]
+        r select 9
+        r config set maxmemory 0
+        r config set maxmemory-precision-samples 0
+        assert {[s evicted_keys] > 0}
+        assert {[s eviction_precision_perc] == 100}
+        list $new [expr {$old < 2000}]
+    } {2000 1}
+
+    test "maxmemory - background eviction brings memory under maxmemory" {
+        r flushall
+        r config set maxmemory 0
+        r config set maxmemory-policy allkeys-lru
+        r config set maxmemory-background-eviction yes
+        r config resetstat
+        for {set j 0} {$j < 20000} {incr j} {r set key:$j [string repeat x 100]}
+        set used [s used_memory]
+        # Shrinking maxmemory well under the hard limit leaves all the
+        # eviction to the background.
+        set limit [expr {$used-1024*1024}]
+        r config set maxmemory-hard-limit-perc 1000
+        r config set maxmemory $limit
+        assert {[s eviction_inline_usec] < 1000}
+        # The INFO output itself takes some memory.
+        wait_for_condition 100 50 {
+            [s eviction_lag_bytes] < 4096
+        } else {
+            fail "Background eviction didn't reach maxmemory"
+        }
+        assert {[s evicted_keys] > 0}
+        assert {[s eviction_background_usec] > 0}
+        assert {[s used_memory] < ($limit+4096)}
+        r config set maxmemory 0
+        r config set maxmemory-hard-limit-perc 10
+        r config set maxmemory-background-eviction no
+    }
+
+    test "maxmemory - clients are served during background eviction" {
+        r flushall
+        r config set maxmemory 0
+        r config set maxmemory-policy allkeys-lru
+        r config set maxmemory-background-eviction yes
+        r config set maxmemory-hard-limit-perc 1000
+        r config set maxmemory-eviction-budget 100
+        r eval {
+            for i=1,100000 do redis.call('set','key:'..i,string.rep('x',100)) end
+        } 0
+        r config set maxmemory [expr {[s used_memory]/2}]
+        # Every slice evicts for 100 microseconds, then the event loop
+        # serves the clients: the eviction is still in progress here.
+        assert_equal PONG [r ping]
+        assert {[s eviction_lag_bytes] > 4096}
+        wait_for_condition 200 50 {
+            [s eviction_lag_bytes] < 4096
+        } else {
+            fail "Background eviction didn't reach maxmemory"
+        }
+        r config set maxmemory 0
+        r config set maxmemory-eviction-budget 500
+        r config set maxmemory-hard-limit-perc 10
+        r config set maxmemory-background-eviction no
+    }
+
+    test "maxmemory - background eviction with nothing to evict" {
+        r flushall
+        r config set maxmemory 0
+        r config set maxmemory-policy volatile-lru
+        r config set maxmemory-background-eviction yes
+        r config resetstat
+        r eval {
+            for i=1,50000 do redis.call('set','key:'..i,string.rep('x',100)) end
+        } 0
+        r config set maxmemory [expr {[s used_memory]-500*1024}]
+        # No volatile keys: the background eviction stops instead of
+        # spinning, and the server keeps serving the clients.
+        assert_equal PONG [r ping]
+        after 200
+        assert_equal PONG [r ping]
+        assert {[s eviction_lag_bytes] > 0}
+        assert_equal 0 [s evicted_keys]
+        assert_equal 50000 [r dbsize]
+        r config set maxmemory 0
+        r config set maxmemory-policy allkeys-lru
+        r config set maxmemory-background-eviction no
+    }
+
+    test "OBJECT FREQ reports the LFU access counter" {
+        r flushall
+        r config set maxmemory 0
+        r config set maxmemory-policy allkeys-lru
+        r set foo bar
+        assert_error "*LFU maxmemory policy is not selected*" {r object freq foo}
+        r config set maxmemory-policy allkeys-lfu
+        # No decay, or a minute clock tick after the SET lowers the counter.
+        set decay_time [lindex [r config get lfu-decay-time] 1]
+        r config set lfu-decay-time 0
+        set err [catch {
+            r set foo bar
+            set initial [r object freq foo]
+            for {set j 0} {$j < 100} {incr j} {r get foo}
+            set hot [r object freq foo]
+            assert_error "*LFU maxmemory policy is selected*" {r object idletime foo}
+        } e]
+        r config set lfu-decay-time $decay_time
+        r config set maxmemory-policy noeviction
+        if {$err} {error $e}
+        list $initial [expr {$hot > $initial}]
+    } {5 1}
 }
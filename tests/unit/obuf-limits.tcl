@@ -70,4 +70,41 @@ start_server {tags {"obuf-limits"}} {
         assert {$omem >= 100000 && $time_elapsed < 6}
         $rd1 close
     }
+
+    test {Pending replies of a big value survive changes to the key} {
+        r config set client-output-buffer-limit {normal 0 0 0}
+        set val [string repeat "0123456789" 100000]
+        r set bigval $val
+        set rd1 [redis_deferring_client]
+        $rd1 client setname slowreader
+        assert_equal OK [$rd1 read]
+
+        # Fill the output buffer of a client that doesn't read: big values
+        # are referenced by the reply list instead of being copied.
+        r config resetstat
+        for {set j 0} {$j < 20} {incr j} {
+            $rd1 get bigval
+        }
+        $rd1 flush
+        wait_for_condition 50 100 {
+            [string match {*cmdstat_get:calls=20,*} [r info commandstats]]
+        } else {
+            fail "GETs of the slow reader not executed"
+        }
+        assert {[regexp {name=slowreader .*omem=[1-9]} [r client list]]}
+
+        r append bigval x
+        r setrange bigval 0 Z
+        r del bigval
+        r set bigval other
+
+        set err {}
+        for {set j 0} {$j < 20} {incr j} {
+            if {![string equal $val [$rd1 read]] && $err eq {}} {
+                set err "reply $j does not match the original value"
+            }
+        }
+        $rd1 close
+        set err
+    } {}
 }
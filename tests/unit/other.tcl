@@ -227,6 +227,121 @@ start_server {tags {"other"}} {
         set _ $err
     } {}
 
+    test {APPEND and SETRANGE against the longest EMBSTR values} {
+        set limit [s embstr_size_limit]
+        assert {$limit >= 44}
+        r set foo [string repeat x $limit]
+        assert_encoding embstr foo
+        r set bar [string repeat x [expr {$limit+1}]]
+        assert_encoding raw bar
+        r append foo y
+        r setrange foo 0 z
+        assert_encoding raw foo
+        list [r strlen foo] [string range [r get foo] 0 1] \
+             [string index [r get foo] end]
+    } [list [expr {[s embstr_size_limit]+1}] zx y]
+
+    test {APPEND and SETRANGE across the sds header sizes} {
+        set err {}
+        foreach b {32 256 65536} {
+            # Grow one byte at a time over the largest length of a header.
+            set val [string repeat a [expr {$b-3}]]
+            r set foo $val
+            for {set j 0} {$j < 5} {incr j} {
+                append val [expr {$j%10}]
+                r append foo [expr {$j%10}]
+                if {![string equal $val [r get foo]] && $err eq {}} {
+                    set err "APPEND to [string length $val] bytes"
+                }
+            }
+            # SETRANGE past the end, from below the boundary to above it.
+            r set bar [string repeat b [expr {$b-1}]]
+            r setrange bar [expr {$b+10}] xyz
+            set exp "[string repeat b [expr {$b-1}]][string repeat \x00 11]xyz"
+            if {![string equal $exp [r get bar]] && $err eq {}} {
+                set err "SETRANGE to [string length $exp] bytes"
+            }
+            if {[r getrange bar [expr {$b-2}] [expr {$b+13}]] ne
+                [string range $exp [expr {$b-2}] [expr {$b+13}]] && $err eq {}} {
+                set err "GETRANGE around $b"
+            }
+            # redis.call() reuses the sds of its argv objects across calls.
+            foreach len [list [expr {$b-1}] $b [expr {$b+1}] 3] {
+                set arg [string repeat c $len]
+                set script {
+                    redis.call('set',KEYS[1],ARGV[1])
+                    return redis.call('get',KEYS[1])
+                }
+                if {[r eval $script 1 foo $arg] ne $arg && $err eq {}} {
+                    set err "Lua argument of $len bytes"
+                }
+            }
+        }
+        r del foo bar
+        set err
+    } {}
+
+    test {Keyspace bigger than a hash table chunk} {
+        r select 9
+        r flushdb
+        r debug populate 200000
+        assert {[s dict_table_chunks_allocated] > 0}
+        assert_equal 200000 [r dbsize]
+        assert_equal value:0 [r get key:0]
+        assert_equal value:199999 [r get key:199999]
+        r flushdb
+        wait_for_condition 50 100 {
+            [s dict_tables_freed_async] > 0 &&
+            [s dict_tables_free_pending] == 0
+        } else {
+            fail "Retired hash tables not released"
+        }
+    }
+
+    test {Hash and set growing past a hash table chunk} {
+        r flushdb
+        set chunks [s dict_table_chunks_allocated]
+        # Grow a single hash and a single set one element at a time, so
+        # that they rehash into chunked tables while being modified.
+        r eval {
+            for i=1,150000 do
+                redis.call('hset','bighash','f'..i,i)
+                redis.call('sadd','bigset',i)
+            end
+        } 0
+        assert {[s dict_table_chunks_allocated] > $chunks}
+        assert_equal 150000 [r hlen bighash]
+        assert_equal 150000 [r scard bigset]
+        assert_equal 1 [r hget bighash f1]
+        assert_equal 150000 [r hget bighash f150000]
+        assert_equal 1 [r sismember bigset 150000]
+        assert_equal 0 [r sismember bigset 150001]
+
+        # SCAN must return every field once across the chunks.
+        set cursor 0
+        set fields {}
+        while 1 {
+            set res [r hscan bighash $cursor count 1000]
+            set cursor [lindex $res 0]
+            foreach {f v} [lindex $res 1] {dict set fields $f $v}
+            if {$cursor == 0} break
+        }
+        assert_equal 150000 [dict size $fields]
+
+        # Random elements and deletions while the tables shrink back.
+        assert {[r srandmember bigset] <= 150000}
+        r eval {
+            for i=1,140000 do
+                redis.call('hdel','bighash','f'..i)
+                redis.call('srem','bigset',i)
+            end
+        } 0
+        assert_equal 10000 [r hlen bighash]
+        assert_equal 10000 [r scard bigset]
+        assert_equal 140001 [r hget bighash f140001]
+        list [r sismember bigset 1] [r sismember bigset 150000]
+    } {0 1}
+
     # Leave the user with a clean DB before to exit
     test {FLUSHDB} {
         set aux {}
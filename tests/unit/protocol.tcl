@@ -68,6 +68,181 @@ start_server {tags {"protocol"}} {
         assert_error "*unbalanced*" {r read}
     }
 
+    test "Big bulk argument sent in several partial writes" {
+        reconnect
+        set fd [r channel]
+        # Carriage returns and newlines inside the payload must not matter.
+        set payload [string repeat "0123456789abc\r\n" 10000]
+        set len [string length $payload]
+        puts -nonewline $fd "*3\r\n\$3\r\nSET\r\n\$7\r\nbigarg1\r\n"
+        puts -nonewline $fd "\$$len\r\n"
+        flush $fd
+        # Split the payload in uneven chunks, then the trailing CRLF in two.
+        set pos 0
+        foreach chunk {1 5000 33000 60000} {
+            puts -nonewline $fd [string range $payload $pos [expr {$pos+$chunk-1}]]
+            flush $fd
+            incr pos $chunk
+            after 20
+        }
+        puts -nonewline $fd "[string range $payload $pos end]\r"
+        flush $fd
+        after 20
+        puts -nonewline $fd "\n"
+        flush $fd
+        assert_equal OK [r read]
+        assert_equal $len [r strlen bigarg1]
+        string equal $payload [r get bigarg1]
+    } {1}
+
+    test "Big bulk arguments pipelined in a single write" {
+        reconnect
+        set fd [r channel]
+        set a [string repeat "a\r\n" 20000]
+        set b [string repeat "b" 100000]
+        set c [string repeat "c\n" 40000]
+        set cmds {}
+        foreach {key val} [list bigarg2 $a bigarg3 $b] {
+            append cmds "*3\r\n\$3\r\nSET\r\n"
+            append cmds "\$[string length $key]\r\n$key\r\n"
+            append cmds "\$[string length $val]\r\n$val\r\n"
+        }
+        append cmds "*5\r\n\$4\r\nMSET\r\n"
+        foreach {key val} [list bigarg4 $c bigarg5 $a] {
+            append cmds "\$[string length $key]\r\n$key\r\n"
+            append cmds "\$[string length $val]\r\n$val\r\n"
+        }
+        append cmds "*1\r\n\$4\r\nPING\r\n"
+        puts -nonewline $fd $cmds
+        flush $fd
+        assert_equal {OK OK OK PONG} [list [r read] [r read] [r read] [r read]]
+        list [string equal $a [r get bigarg2]] \
+             [string equal $b [r get bigarg3]] \
+             [string equal $c [r get bigarg4]] \
+             [string equal $a [r get bigarg5]]
+    } {1 1 1 1}
+
+    test "Big replies to a client that stops reading are all delivered" {
+        reconnect
+        set rd [redis_deferring_client]
+        for {set j 0} {$j < 10} {incr j} {
+            r set slowreply:$j [string repeat $j 500000]
+        }
+        # The socket buffer fills up while the client is not reading, so
+        # the rest of the replies must be sent by the writable handler.
+        for {set j 0} {$j < 10} {incr j} {
+            $rd get slowreply:$j
+        }
+        $rd flush
+        after 500
+        set err {}
+        for {set j 0} {$j < 10} {incr j} {
+            if {![string equal [string repeat $j 500000] [$rd read]] &&
+                $err eq {}} {
+                set err "reply $j is wrong"
+            }
+        }
+        $rd ping
+        lappend err [$rd read]
+        $rd close
+        set err
+    } {PONG}
+
+    test "Pipelined replies mixing small and big ones" {
+        reconnect
+        r del mixedlist
+        for {set j 0} {$j < 2000} {incr j} {
+            r rpush mixedlist $j
+        }
+        set list [r lrange mixedlist 0 -1]
+        set big [string repeat x 40000]
+        r set mixedbig $big
+        # Small replies stay in the static buffer, the others go to the
+        # reply list: a single write covers both.
+        set cmds {}
+        for {set j 0} {$j < 100} {incr j} {
+            append cmds "*2\r\n\$4\r\nECHO\r\n\$[string length $j]\r\n$j\r\n"
+            append cmds "*4\r\n\$6\r\nLRANGE\r\n\$9\r\nmixedlist\r\n"
+            append cmds "\$1\r\n0\r\n\$2\r\n-1\r\n"
+            append cmds "*2\r\n\$3\r\nGET\r\n\$8\r\nmixedbig\r\n"
+        }
+        r write $cmds
+        r flush
+        set err {}
+        for {set j 0} {$j < 100 && $err eq {}} {incr j} {
+            if {[r read] ne $j} {set err "ECHO $j"}
+            if {[r read] ne $list} {set err "LRANGE $j"}
+            if {![string equal $big [r read]]} {set err "GET $j"}
+        }
+        set err
+    } {}
+
+    test "RESP headers at every offset of the scanned blocks" {
+        reconnect
+        # Payloads of growing size move the following header lines across
+        # the boundaries of the 64 bytes blocks and of a whole refill.
+        # Carriage returns inside the payloads must be skipped.
+        set cmds {}
+        for {set j 0} {$j < 300} {incr j} {
+            set val [string range [string repeat "\r\n\r" 100] 0 $j]
+            append cmds "*3\r\n\$3\r\nSET\r\n"
+            append cmds "\$[string length scan:$j]\r\nscan:$j\r\n"
+            append cmds "\$[string length $val]\r\n$val\r\n"
+        }
+        r write $cmds
+        r flush
+        for {set j 0} {$j < 300} {incr j} {
+            assert_equal OK [r read]
+        }
+        set err {}
+        for {set j 0} {$j < 300} {incr j} {
+            set val [string range [string repeat "\r\n\r" 100] 0 $j]
+            if {![string equal $val [r get scan:$j]] && $err eq {}} {
+                set err "scan:$j is wrong"
+            }
+        }
+        set err
+    } {}
+
+    test "RESP headers split across reads" {
+        reconnect
+        set fd [r channel]
+        set args {}
+        set cmd "*21\r\n\$5\r\nRPUSH\r\n\$9\r\nsplitlist\r\n"
+        for {set j 0} {$j < 19} {incr j} {
+            set val [string repeat $j [expr {$j*3+1}]]
+            lappend args $val
+            append cmd "\$[string length $val]\r\n$val\r\n"
+        }
+        r del splitlist
+        # Uneven chunks, so that every kind of header is cut somewhere,
+        # including between the CR and the LF.
+        set pos 0
+        set chunk 1
+        while {$pos < [string length $cmd]} {
+            puts -nonewline $fd [string range $cmd $pos [expr {$pos+$chunk-1}]]
+            flush $fd
+            incr pos $chunk
+            set chunk [expr {$chunk % 7 + 1}]
+            after 2
+        }
+        assert_equal 19 [r read]
+        string equal $args [r lrange splitlist 0 -1]
+    } {1}
+
+    test "Deep pipeline of small commands" {
+        reconnect
+        r del deeppipe
+        set cmds [string repeat "*2\r\n\$4\r\nINCR\r\n\$8\r\ndeeppipe\r\n" 20000]
+        r write $cmds
+        r flush
+        set err {}
+        for {set j 1} {$j <= 20000} {incr j} {
+            if {[r read] != $j && $err eq {}} {set err "reply $j is wrong"}
+        }
+        list $err [r get deeppipe]
+    } {{} 20000}
+
     set c 0
     foreach seq [list "\x00" "*\x00" "$\x00"] {
         incr c
@@ -227,3 +227,29 @@ start_server {tags {"scan"}} {
         lsort -unique [lindex $res 1]
     }
 }
+
+start_server {tags {"scan"} overrides {keyspace-layout open-addressing}} {
+    test "SCAN with open addressing keyspace while deleting keys" {
+        r flushdb
+        r debug populate 2000
+        for {set j 0} {$j < 2000} {incr j 2} {r del key:$j}
+        r expire key:1 100
+
+        set cur 0
+        set keys {}
+        while 1 {
+            set res [r scan $cur count 7]
+            set cur [lindex $res 0]
+            lappend keys {*}[lindex $res 1]
+            if {$cur == 0} break
+        }
+
+        assert_equal 1000 [llength [lsort -unique $keys]]
+        assert_equal 1000 [r dbsize]
+        assert {[r ttl key:1] > 0}
+        assert_equal {value:3} [r get key:3]
+        r debug reload
+        assert_equal 1000 [r dbsize]
+        r config get keyspace-layout
+    } {keyspace-layout open-addressing}
+}
@@ -467,4 +467,41 @@ start_server {tags {"hash"}} {
             assert {[r object encoding myhash] eq {hashtable}}
         }
     }
+
+    test {Big hash is rehashed in the background} {
+        set script {
+            for i=ARGV[1],ARGV[1]+999 do redis.call('hset',KEYS[1],i,i) end
+        }
+        # The first call also adds the script to the scripts dict.
+        r del bighash
+        r eval $script 1 bighash 0
+        set fields 1000
+        wait_for_condition 50 100 {
+            [s rehashing_dicts] == 0
+        } else {
+            fail "Rehashing of other dicts not completed"
+        }
+        r config set activerehashing no
+        # Add fields until the table grows: then nothing but the inserts
+        # themselves and the cron advance the rehashing. Turn the active
+        # rehashing on again even if an assertion fails.
+        set err [catch {
+            while {[s rehashing_dicts] == 0 && $fields < 200000} {
+                r eval $script 1 bighash $fields
+                incr fields 1000
+            }
+            assert {[s rehashing_dicts] == 1}
+            assert {[s rehashing_buckets_left] > 0}
+        } e]
+        r config set activerehashing yes
+        if {$err} {error $e}
+        wait_for_condition 50 100 {
+            [s rehashing_dicts] == 0 && [s rehashing_buckets_left] == 0
+        } else {
+            fail "Hash rehashing not completed by the cron"
+        }
+        assert_equal $fields [r hlen bighash]
+        assert_equal 777 [r hget bighash 777]
+        r del bighash
+    }
 }
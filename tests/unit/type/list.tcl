@@ -871,3 +871,103 @@ start_server {
         r ping
     } {PONG}
 }
+
+start_server {
+    tags {"list"}
+    overrides {
+        "list-max-ziplist-entries" 16
+        "list-quicklist-fill" 4
+    }
+} {
+    test {Quicklist encoding: LINSERT, LSET, LREM, LTRIM across nodes} {
+        r del ql
+        set model {}
+        for {set j 0} {$j < 200} {incr j} {
+            r rpush ql $j
+            lappend model $j
+        }
+        assert_encoding quicklist ql
+        assert_match {*ql_nodes:50} [r debug object ql]
+
+        # Inserting in the middle of full nodes splits them, big values
+        # get a node of their own.
+        set big [string repeat x 10000]
+        r linsert ql before 101 a
+        set model [linsert $model [lsearch $model 101] a]
+        r linsert ql after 150 $big
+        set model [linsert $model [expr {[lsearch $model 150]+1}] $big]
+        r lset ql 10 b
+        lset model 10 b
+        r lset ql -1 $big
+        lset model end $big
+        r lpush ql c
+        set model [linsert $model 0 c]
+        assert_equal [llength $model] [r llen ql]
+        assert_equal $model [r lrange ql 0 -1]
+        assert_equal $big [r lindex ql -1]
+
+        assert_equal 2 [r lrem ql 0 $big]
+        assert_equal 1 [r lrem ql -1 a]
+        set model [lsearch -all -inline -not -exact $model $big]
+        set model [lsearch -all -inline -not -exact $model a]
+        r ltrim ql 7 -30
+        set model [lrange $model 7 end-29]
+        assert_equal $model [r lrange ql 0 -1]
+        assert_equal [lrange $model 60 80] [r lrange ql 60 80]
+        assert_equal [lindex $model end-5] [r lindex ql -6]
+
+        r debug reload
+        assert_encoding quicklist ql
+        assert_equal $model [r lrange ql 0 -1]
+    }
+
+    test {Quicklist encoding: LSET of a big value keeps the fill limits} {
+        r del ql
+        set model {}
+        for {set j 0} {$j < 20} {incr j} {
+            r rpush ql $j
+            lappend model $j
+        }
+        assert_match {*ql_nodes:5} [r debug object ql]
+
+        # In the middle of a node the node is split, at the edges the big
+        # value gets a node of its own.
+        set big [string repeat x 10000]
+        foreach {index model_index} {5 5 0 0 -1 end} {
+            r lset ql $index $big
+            lset model $model_index $big
+        }
+        assert_match {*ql_nodes:9} [r debug object ql]
+        assert_equal $model [r lrange ql 0 -1]
+    }
+
+    test {Quicklist encoding: lists are converted on load} {
+        r config set list-quicklist-fill 0
+        r del ql
+        for {set j 0} {$j < 100} {incr j} {r rpush ql $j}
+        assert_encoding linkedlist ql
+        r config set list-quicklist-fill -2
+        r debug reload
+        assert_encoding quicklist ql
+        assert_match {*ql_nodes:1} [r debug object ql]
+        assert_equal [r lrange ql 0 -1] [r sort ql]
+    }
+
+    test {Quicklist encoding: blocking pops} {
+        r del src dst
+        for {set j 0} {$j < 100} {incr j} {r rpush dst $j}
+        assert_encoding quicklist dst
+        set rd [redis_deferring_client]
+        $rd brpoplpush src dst 0
+        after 100
+        r rpush src foo
+        assert_equal foo [$rd read]
+        assert_equal foo [r lindex dst 0]
+        $rd blpop dst 0
+        assert_equal {dst foo} [$rd read]
+        $rd brpop dst 0
+        assert_equal {dst 99} [$rd read]
+        $rd close
+        r llen dst
+    } {99}
+}
@@ -0,0 +1,63 @@
+#!/usr/bin/env tclsh8.5
+# Memory and GET throughput of string values around the EMBSTR size limit.
+#
+# Start the server to measure, then from the utils directory run:
+#
+#   ./embstr-benchmark.tcl [port] [keys]
+#
+# For every value size the keyspace is filled with 'keys' strings of that
+# size and read back at random with redis-benchmark. Run it against two
+# builds to evaluate a change of the EMBSTR sizing (see initEmbstrSizeLimit()
+# in object.c). The server is flushed several times: don't use it on a
+# server holding data you care about.
+
+source ../tests/support/redis.tcl
+set ::port [expr {$argc > 0 ? [lindex $argv 0] : 6379}]
+set ::keys [expr {$argc > 1 ? [lindex $argv 1] : 200000}]
+set ::sizes {16 32 44 64 80 100 108 120 200}
+set ::benchmark ../src/redis-benchmark
+
+proc info_field {r field} {
+    if {[regexp "\r\n$field:(.*?)\r\n" [$r info] -> value]} {
+        return $value
+    }
+    return "n/a"
+}
+
+# Keys are named like redis-benchmark names the keys it replaces
+# __rand_int__ with, so that the GET benchmark only hits existing keys.
+proc fill {r size} {
+    $r eval {
+        local val = string.rep('x',tonumber(ARGV[2]))
+        for i=0,tonumber(ARGV[1])-1 do
+            redis.call('set',string.format('key:%012d',i),val)
+        end
+    } 0 $::keys $size
+}
+
+proc get_rate {} {
+    set output [exec $::benchmark -p $::port -n [expr {$::keys*10}] \
+        -r $::keys -c 4 -P 16 -q get key:__rand_int__]
+    if {[regexp {([0-9.]+) requests per second} $output -> rate]} {
+        return $rate
+    }
+    return "n/a"
+}
+
+set r [redis 127.0.0.1 $::port]
+puts "mem_allocator: [info_field $r mem_allocator]"
+puts "embstr_size_limit: [info_field $r embstr_size_limit]"
+puts [format "%6s %9s %10s %12s" size encoding bytes/key GET/sec]
+foreach size $::sizes {
+    $r flushall
+    # Big hash tables are released in background.
+    while {[info_field $r dict_tables_free_pending] > 0} { after 10 }
+    set before [info_field $r used_memory]
+    fill $r $size
+    set after [info_field $r used_memory]
+    set encoding [$r object encoding key:000000000000]
+    set perkey [expr {($after-$before)/$::keys}]
+    puts [format "%6d %9s %10d %12s" $size $encoding $perkey [get_rate]]
+}
+$r flushall
+$r close
@@ -0,0 +1,133 @@
+#!/usr/bin/env tclsh8.5
+# Replay a cache workload against a Redis server and report the hit ratio
+# obtained with each maxmemory policy.
+#
+# The workload alternates skewed "hot" traffic, where a small set of keys
+# gets most of the accesses, with scans reading a range of cold keys once,
+# like a batch job would do. Every GET miss is followed by a SET of the key,
+# like a cache does. maxmemory is set so that only a part of the keys fits.
+#
+# Start the server to measure, then from the utils/lru directory run:
+#
+#   tclsh hit-ratio.tcl [port] [--dbs n] [--pool-size n] [policy ...]
+#
+# --dbs spreads the hot keys over the first n-1 databases and puts the
+# scanned keys in the last one. --pool-size sets maxmemory-eviction-pool-size.
+# The "precision%" column is eviction_precision_perc, the percentage of
+# random keys that were not better candidates than the evicted keys (100 is
+# the ideal algorithm), when the server supports it.
+#
+# The server is flushed and its maxmemory settings changed: don't use it on
+# a server holding data you care about.
+
+source ../../tests/support/redis.tcl
+set ::port 6379
+set ::dbs 1
+set ::pool_size {}
+set ::policies {}
+for {set j 0} {$j < [llength $argv]} {incr j} {
+    set arg [lindex $argv $j]
+    if {$arg eq {--dbs}} {
+        set ::dbs [lindex $argv [incr j]]
+    } elseif {$arg eq {--pool-size}} {
+        set ::pool_size [lindex $argv [incr j]]
+    } elseif {$j == 0 && [string is integer -strict $arg]} {
+        set ::port $arg
+    } else {
+        lappend ::policies $arg
+    }
+}
+if {[llength $::policies] == 0} {
+    set ::policies {allkeys-lru allkeys-lfu allkeys-random}
+}
+
+set ::cache_keys 5000   ;# Keys fitting in maxmemory.
+set ::hot_keys 2000     ;# Keys of the hot traffic.
+set ::hot_ops 20000     ;# Hot accesses between two scans.
+set ::scan_keys 10000   ;# Cold keys read by every scan.
+set ::rounds 5
+set ::value [string repeat x 100]
+
+proc info_field {r field} {
+    if {[regexp "\r\n$field:(.*?)\r\n" [$r info] -> value]} {
+        return $value
+    }
+    return 0
+}
+
+# Access a key of database 'db' like a cache: return 1 on hit, otherwise
+# store it and return 0.
+proc access {r db key} {
+    if {$db != $::selected} {
+        $r select $db
+        set ::selected $db
+    }
+    if {[$r get $key] ne {}} {return 1}
+    $r set $key $::value
+    return 0
+}
+
+# Memory needed by 'cache_keys' keys, plus the memory used by an empty
+# server.
+proc compute_maxmemory r {
+    $r config set maxmemory 0
+    $r flushall
+    set before [info_field $r used_memory]
+    for {set j 0} {$j < 10000} {incr j} {$r set sizing:$j $::value}
+    set perkey [expr {([info_field $r used_memory]-$before)/10000.0}]
+    $r flushall
+    return [expr {int($before+$perkey*$::cache_keys)}]
+}
+
+proc replay {r policy maxmemory} {
+    $r flushall
+    $r config set maxmemory-policy $policy
+    $r config set maxmemory $maxmemory
+    catch {$r config set maxmemory-precision-samples 10}
+    $r config resetstat
+    expr {srand(1234)}
+    set hot_dbs [expr {$::dbs > 1 ? $::dbs-1 : 1}]
+
+    set hot_hits 0
+    set scan_hits 0
+    set cold 0
+    for {set round 0} {$round < $::rounds} {incr round} {
+        # Skewed traffic: the square of a uniform random number favors the
+        # keys with a low id.
+        for {set j 0} {$j < $::hot_ops} {incr j} {
+            set id [expr {int(pow(rand(),2)*$::hot_keys)}]
+            incr hot_hits [access $r [expr {$id % $hot_dbs}] hot:$id]
+        }
+        for {set j 0} {$j < $::scan_keys} {incr j} {
+            incr scan_hits [access $r [expr {$::dbs-1}] cold:$cold]
+            incr cold
+        }
+    }
+    set hot_ratio [expr {100.0*$hot_hits/($::hot_ops*$::rounds)}]
+    set total_ratio [expr {100.0*($hot_hits+$scan_hits)/
+                          (($::hot_ops+$::scan_keys)*$::rounds)}]
+    set precision [info_field $r eviction_precision_perc]
+    catch {$r config set maxmemory-precision-samples 0}
+    $r select 0
+    set ::selected 0
+    list $hot_ratio $total_ratio [info_field $r evicted_keys] $precision
+}
+
+set r [redis 127.0.0.1 $::port]
+set ::selected 0
+if {$::pool_size ne {}} {
+    $r config set maxmemory-eviction-pool-size $::pool_size
+}
+set maxmemory [compute_maxmemory $r]
+puts "maxmemory $maxmemory bytes, about $::cache_keys keys, $::dbs databases"
+puts [format "%-16s %10s %10s %10s %11s" policy hot-hit% total-hit% evicted \
+    precision%]
+foreach policy $::policies {
+    lassign [replay $r $policy $maxmemory] hot total evicted precision
+    puts [format "%-16s %10.2f %10.2f %10d %11s" $policy $hot $total $evicted \
+        $precision]
+}
+$r config set maxmemory 0
+$r config set maxmemory-policy noeviction
+$r flushall
+$r close